@@ -0,0 +1,201 @@
+"""Extract the metadata from an ADM BW64 file into a JSON stream or binary
+metadata file for bear-offline-render.
+
+The stream has one entry per renderer channel (or HOA stream), containing the
+input track and a list of blocks already converted to the form used by
+visr_bear.api; see bear-offline-render for the renderer side, and
+metadata_file.py for the binary format.
+"""
+import argparse
+import json
+from fractions import Fraction
+from ear.core.metadata_input import (
+    ObjectRenderingItem,
+    DirectSpeakersRenderingItem,
+    HOARenderingItem,
+    DirectTrackSpec,
+    SilentTrackSpec,
+)
+from ear.fileio import openBw64Adm
+from ear.fileio.adm.elements import ObjectPolarPosition
+from . import metadata_file
+from .render_cli import OfflineRenderDriver, get_start_duration
+
+
+def convert_time(t):
+    if t is None:
+        return None
+    t = Fraction(t)
+    return [t.numerator, t.denominator]
+
+
+def convert_track_spec(track_spec):
+    if isinstance(track_spec, DirectTrackSpec):
+        return track_spec.track_index
+    elif isinstance(track_spec, SilentTrackSpec):
+        return None
+    else:
+        raise NotImplementedError(
+            f"track spec {track_spec!r} is not supported; only direct and "
+            "silent tracks can be extracted"
+        )
+
+
+def iter_blocks(item):
+    while True:
+        block = item.metadata_source.get_next_block()
+        if block is None:
+            break
+        yield block
+
+
+def convert_objects_block(otm):
+    start, duration = get_start_duration(otm)
+    bf = otm.block_format
+
+    if not isinstance(bf.position, ObjectPolarPosition):
+        raise NotImplementedError("only polar object positions are supported")
+
+    block = dict(
+        rtime=convert_time(start),
+        duration=convert_time(duration),
+        position=dict(
+            azimuth=bf.position.azimuth,
+            elevation=bf.position.elevation,
+            distance=bf.position.distance,
+        ),
+        gain=bf.gain,
+        width=bf.width,
+        height=bf.height,
+        depth=bf.depth,
+        diffuse=bf.diffuse,
+    )
+
+    if bf.jumpPosition.flag:
+        block["interpolationLength"] = convert_time(
+            bf.jumpPosition.interpolationLength or Fraction(0)
+        )
+
+    absolute_distance = getattr(otm.extra_data, "pack_absoluteDistance", None)
+    if absolute_distance is not None:
+        block["absoluteDistance"] = absolute_distance
+
+    return block
+
+
+def convert_direct_speakers_block(dstm):
+    bf = dstm.block_format
+    block = dict(
+        rtime=convert_time(bf.rtime),
+        duration=convert_time(bf.duration),
+        position=dict(
+            azimuth=bf.position.azimuth,
+            elevation=bf.position.elevation,
+            distance=bf.position.distance,
+        ),
+        speakerLabels=list(bf.speakerLabel),
+    )
+    if dstm.audioPackFormats:
+        block["audioPackFormatID"] = dstm.audioPackFormats[-1].id
+    return block
+
+
+def convert_hoa_block(hoa_tm):
+    return dict(
+        rtime=convert_time(hoa_tm.rtime),
+        duration=convert_time(hoa_tm.duration),
+        orders=list(hoa_tm.orders),
+        degrees=list(hoa_tm.degrees),
+        normalization=hoa_tm.normalization,
+    )
+
+
+def rendering_items_to_stream(rendering_items):
+    """Convert a list of rendering items into a JSON-compatible dict."""
+    stream = dict(version=0, objects=[], direct_speakers=[], hoa=[])
+
+    for item in rendering_items:
+        if isinstance(item, ObjectRenderingItem):
+            stream["objects"].append(
+                dict(
+                    track=convert_track_spec(item.track_spec),
+                    blocks=[convert_objects_block(b) for b in iter_blocks(item)],
+                )
+            )
+        elif isinstance(item, DirectSpeakersRenderingItem):
+            stream["direct_speakers"].append(
+                dict(
+                    track=convert_track_spec(item.track_spec),
+                    blocks=[
+                        convert_direct_speakers_block(b) for b in iter_blocks(item)
+                    ],
+                )
+            )
+        elif isinstance(item, HOARenderingItem):
+            stream["hoa"].append(
+                dict(
+                    tracks=[convert_track_spec(ts) for ts in item.track_specs],
+                    blocks=[convert_hoa_block(b) for b in iter_blocks(item)],
+                )
+            )
+        else:
+            raise NotImplementedError(f"unknown rendering item type {item!r}")
+
+    return stream
+
+
+def make_parser():
+    parser = argparse.ArgumentParser(
+        description="extract ADM metadata for bear-offline-render"
+    )
+    parser.add_argument("input_file")
+    parser.add_argument("output_file")
+    parser.add_argument(
+        "--format",
+        choices=["json", "binary"],
+        default="json",
+        help="output format; binary files are faster to load for long programmes",
+    )
+    parser.add_argument(
+        "--enable-block-duration-fix",
+        action="store_true",
+        help="automatically try to fix faulty block format durations",
+    )
+    parser.add_argument(
+        "--programme", metavar="id", help="select an audioProgramme to render by ID"
+    )
+    parser.add_argument(
+        "--comp-object",
+        metavar="id",
+        action="append",
+        default=[],
+        help="select an audioObject by ID from a complementary group",
+    )
+    return parser
+
+
+def main():
+    args = make_parser().parse_args()
+
+    # item selection is shared with bear-render
+    driver = OfflineRenderDriver(
+        input_file=args.input_file,
+        output_file=args.output_file,
+        enable_block_duration_fix=args.enable_block_duration_fix,
+        programme_id=args.programme,
+        complementary_object_ids=args.comp_object,
+    )
+
+    with openBw64Adm(args.input_file, args.enable_block_duration_fix) as infile:
+        stream = rendering_items_to_stream(driver.get_rendering_items(infile.adm))
+
+    if args.format == "binary":
+        with open(args.output_file, "wb") as f:
+            metadata_file.write(f, stream)
+    else:
+        with open(args.output_file, "w") as f:
+            json.dump(stream, f)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+"""Binary metadata files for bear-offline-render and visr_bear.MetadataFile.
+
+These hold the same information as the JSON metadata streams written by
+bear-extract-metadata, but store the blocks in flat arrays in a tensorfile
+(see tensorfile.py), so that they can be memory-mapped by the C++ reader and
+used without being parsed or copied.
+
+The file contains a JSON structure with "format": "bear_metadata",
+"version": 0, and one section for each channel type: "objects",
+"direct_speakers" and "hoa". Each section contains:
+
+- "tracks": int64 array of the input track of each channel, or -1 for silent
+  channels
+
+- "block_offsets": int64 array with one more entry than the number of
+  channels (or HOA streams); the blocks of channel i are rows
+  block_offsets[i] to block_offsets[i + 1] of times and values
+
+- "times": int64 array with one row per block, containing numerator and
+  denominator pairs for rtime, duration and (for objects)
+  interpolationLength; times which are not set have a denominator of 0
+
+- "values": float64 array with one row per block; absoluteDistance is NaN if
+  it is not set:
+  - objects: azimuth, elevation, distance, gain, width, height, depth,
+    diffuse, absoluteDistance
+  - direct_speakers: azimuth, elevation, distance, absoluteDistance
+  - hoa: absoluteDistance
+
+direct_speakers also contains "speaker_labels" and "audio_pack_format_ids",
+lists of the speakerLabels and audioPackFormatID (or null) of each block.
+
+hoa also contains:
+
+- "track_offsets": int64 array; the tracks of stream i are
+  tracks[track_offsets[i]:track_offsets[i + 1]]
+
+- "orders", "degrees": int32 arrays of the orders and degrees of all blocks,
+  with one entry per channel in the stream of each block
+
+- "normalizations": list of the normalization of each block
+"""
+import numpy as np
+from . import tensorfile
+
+FORMAT = "bear_metadata"
+VERSION = 0
+
+
+def _track(track):
+    return -1 if track is None else track
+
+
+def _offsets(lengths):
+    return np.cumsum([0] + lengths).astype(np.int64)
+
+
+def _times(blocks, keys):
+    times = np.zeros((len(blocks), 2 * len(keys)), dtype=np.int64)
+    for i, block in enumerate(blocks):
+        for j, key in enumerate(keys):
+            t = block.get(key)
+            if t is not None:
+                times[i, 2 * j : 2 * j + 2] = t
+    return times
+
+
+def _values(blocks, get_row, num_columns):
+    values = np.array([get_row(block) for block in blocks], dtype=np.float64)
+    return values.reshape(len(blocks), num_columns)
+
+
+def _absolute_distance(block):
+    absolute_distance = block.get("absoluteDistance")
+    return np.nan if absolute_distance is None else absolute_distance
+
+
+def _objects_row(block):
+    position = block["position"]
+    return [
+        position["azimuth"],
+        position["elevation"],
+        position.get("distance", 1.0),
+        block.get("gain", 1.0),
+        block.get("width", 0.0),
+        block.get("height", 0.0),
+        block.get("depth", 0.0),
+        block.get("diffuse", 0.0),
+        _absolute_distance(block),
+    ]
+
+
+def _direct_speakers_row(block):
+    position = block["position"]
+    return [
+        position["azimuth"],
+        position["elevation"],
+        position.get("distance", 1.0),
+        _absolute_distance(block),
+    ]
+
+
+def _hoa_row(block):
+    return [_absolute_distance(block)]
+
+
+def _section(tracks, items, keys, get_row, num_columns):
+    blocks = [block for item in items for block in item["blocks"]]
+    return dict(
+        tracks=np.array([_track(track) for track in tracks], dtype=np.int64),
+        block_offsets=_offsets([len(item["blocks"]) for item in items]),
+        times=_times(blocks, keys),
+        values=_values(blocks, get_row, num_columns),
+    )
+
+
+def convert_stream(stream):
+    """Convert a JSON-compatible metadata stream (as produced by
+    extract_metadata.rendering_items_to_stream) into the structure stored in a
+    binary metadata file."""
+    assert stream["version"] == 0, "unsupported metadata stream version"
+
+    objects = stream.get("objects", [])
+    objects_section = _section(
+        [item["track"] for item in objects],
+        objects,
+        ["rtime", "duration", "interpolationLength"],
+        _objects_row,
+        9,
+    )
+
+    direct_speakers = stream.get("direct_speakers", [])
+    direct_speakers_blocks = [b for item in direct_speakers for b in item["blocks"]]
+    direct_speakers_section = _section(
+        [item["track"] for item in direct_speakers],
+        direct_speakers,
+        ["rtime", "duration"],
+        _direct_speakers_row,
+        4,
+    )
+    direct_speakers_section.update(
+        speaker_labels=[
+            list(b.get("speakerLabels", [])) for b in direct_speakers_blocks
+        ],
+        audio_pack_format_ids=[
+            b.get("audioPackFormatID") for b in direct_speakers_blocks
+        ],
+    )
+
+    # HOA streams have one track per channel, and one order and degree per
+    # channel in each block
+    hoa = stream.get("hoa", [])
+    hoa_blocks = [b for item in hoa for b in item["blocks"]]
+    for item in hoa:
+        for block in item["blocks"]:
+            assert len(block["orders"]) == len(item["tracks"])
+            assert len(block["degrees"]) == len(item["tracks"])
+    hoa_section = _section(
+        [track for item in hoa for track in item["tracks"]],
+        hoa,
+        ["rtime", "duration"],
+        _hoa_row,
+        1,
+    )
+    hoa_section.update(
+        track_offsets=_offsets([len(item["tracks"]) for item in hoa]),
+        orders=np.array([o for b in hoa_blocks for o in b["orders"]], dtype=np.int32),
+        degrees=np.array([d for b in hoa_blocks for d in b["degrees"]], dtype=np.int32),
+        normalizations=[b.get("normalization", "SN3D") for b in hoa_blocks],
+    )
+
+    return dict(
+        format=FORMAT,
+        version=VERSION,
+        objects=objects_section,
+        direct_speakers=direct_speakers_section,
+        hoa=hoa_section,
+    )
+
+
+def write(f, stream):
+    """Write a JSON-compatible metadata stream to f, a file opened in binary
+    mode."""
+    tensorfile.write(f, convert_stream(stream), version=1)
@@ -36,6 +36,21 @@ def parse_args():
         help="apply window to impulse responses (for BRIRs)",
     )
 
+    parser.add_argument(
+        "--precision",
+        choices=("float32", "float16", "int16"),
+        default="float32",
+        help="precision to store the BRIRs, decorrelation filters, HOA decoder and "
+        "gain normalisation factors in; int16 is stored with a per-array scale",
+    )
+
+    parser.add_argument(
+        "--huge-page-alignment",
+        action="store_true",
+        help="align large arrays to 2MiB, so that the renderer can back them with "
+        "transparent huge pages",
+    )
+
     parser.add_argument("--end-win-start", default=0.007, type=float)
     parser.add_argument("--end-win-end", default=0.06, type=float)
 
@@ -257,6 +272,46 @@ def calc_factor_matrix_manual(brirs, decorrelation_filters, delays, dec_delay, f
     return factors
 
 
+def reduce_precision(data, precision):
+    """convert a float32 array to the given precision, returning something
+    that can be written by bear.tensorfile"""
+    if precision == "float32":
+        return data
+    elif precision == "float16":
+        return data.astype(np.float16)
+    elif precision == "int16":
+        return bear.tensorfile.quantise(data, np.int16)
+    else:
+        assert False, "unknown precision"
+
+
+def decode_precision(data):
+    """get the float32 array represented by the output of reduce_precision"""
+    if isinstance(data, bear.tensorfile.ScaledArray):
+        return data.decode()
+    else:
+        return data.astype(np.float32)
+
+
+def precision_error_report(name, original, reduced):
+    """print the error caused by reducing the precision of an array
+
+    The renderer output is linear in these arrays, so for white noise input
+    the rendering error relative to the float32 file is the same as the error
+    in the array.
+    """
+    error = decode_precision(reduced) - original
+    signal_energy = np.sum(np.square(original, dtype=np.float64))
+    error_energy = np.sum(np.square(error, dtype=np.float64))
+    snr = (
+        10 * np.log10(signal_energy / error_energy) if error_energy > 0 else np.inf
+    )
+    print(
+        f"{name}: max abs error {np.max(np.abs(error)):.3g}, "
+        f"max abs value {np.max(np.abs(original)):.3g}, SNR {snr:.1f} dB"
+    )
+
+
 def design_decorrelators(layout):
     size = 128
 
@@ -427,6 +482,9 @@ def main(args):
         f = load_hdf5(args.hoa_decoder)
         decoder = np.array(f["Data.IR"]).astype(np.float32)
         hoa["irs"] = make_hoa_dec_symmetrical(decoder)
+        # allows the renderer to convolve each channel once, rather than once
+        # per ear
+        hoa["symmetric"] = True
         hoa["delay"] = float(
             get_hoa_delay(
                 output["brirs"],
@@ -437,8 +495,28 @@ def main(args):
             )
         )
 
+    if args.precision != "float32":
+        print(f"reducing precision to {args.precision}")
+
+        def reduce(container, key, name):
+            original = container[key]
+            container[key] = reduce_precision(original, args.precision)
+            precision_error_report(name, original, container[key])
+
+        reduce(output, "brirs", "brirs")
+        reduce(output, "decorrelation_filters", "decorrelation filters")
+        if "gain_norm_quick" in output:
+            reduce(output["gain_norm_quick"], "factors", "gain normalisation factors")
+        if "hoa" in output:
+            reduce(output["hoa"], "irs", "HOA decoder")
+
     with open(args.tf_out, "wb") as f:
-        bear.tensorfile.write(f, output)
+        bear.tensorfile.write(
+            f,
+            output,
+            version=1,
+            large_alignment=2 << 20 if args.huge_page_alignment else 4096,
+        )
 
     if args.extra_out is not None:
         with open(args.extra_out, "wb") as f:
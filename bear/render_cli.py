@@ -1,7 +1,8 @@
 import argparse
+import queue
 import sys
+import threading
 from attr import attrs, attrib, Factory
-from itertools import chain
 import bear.data_file
 from ear.core.monitor import PeakMonitor
 from ear.core.metadata_processing import (
@@ -29,7 +30,7 @@ from fractions import Fraction
 
 import warnings
 
-fft_implementations = ["default", "ffts"]
+fft_implementations = ["default", "ffts", "auto"]
 
 try:
     import visr_fftw  # noqa: F401
@@ -64,6 +65,10 @@ class OfflineRenderDriver(object):
     conversion_mode = attrib(default=None)
 
     blocksize = 512
+    # number of blocks in each chunk passed between pipeline threads
+    chunk_blocks = 16
+    # number of chunks allocated for the pipeline
+    pipeline_chunks = 4
 
     @classmethod
     def make_parser(cls):
@@ -201,19 +206,22 @@ class OfflineRenderDriver(object):
 
         return selected_items
 
-    def get_output_blocks(self, infile, renderer):
-        for input_samples in chain(infile.iter_sample_blocks(self.blocksize), [None]):
-            if input_samples is None:
-                output_samples = renderer.get_tail(infile.sampleRate, infile.channels)
-            else:
-                output_samples = renderer.render(infile.sampleRate, input_samples)
+    def run(self):
+        """Render input_file to output_file.
 
-            output_samples *= self.output_gain_linear
+        This runs as a pipeline of three threads connected by bounded queues,
+        so that reading and writing do not stall rendering:
 
-            yield output_samples
+        - read: read chunks of samples from input_file and prepare them for
+          the renderer using renderer.prepare, which includes track
+          processing and metadata conversion
+        - render: render prepared chunks with renderer.process
+        - write: apply the output gain, monitor peaks and write to
+          output_file
 
-    def run(self):
-        """Render input_file to output_file."""
+        Chunks are allocated once with renderer.make_chunk, and passed back
+        to the read thread once they have been written.
+        """
 
         with openBw64Adm(self.input_file, self.enable_block_duration_fix) as infile:
             renderer, n_channels = self.make_renderer(
@@ -228,15 +236,115 @@ class OfflineRenderDriver(object):
                 bitsPerSample=infile.bitdepth,
             )
             with openBw64(self.output_file, "w", formatInfo=formatInfo) as outfile:
-                for output_block in self.get_output_blocks(infile, renderer):
-                    output_monitor.process(output_block)
-                    outfile.write(output_block)
+                pipeline = Pipeline()
+                free_chunks = queue.Queue()
+                for _ in range(self.pipeline_chunks):
+                    free_chunks.put(renderer.make_chunk())
+                prepared_chunks = queue.Queue(self.pipeline_chunks)
+                rendered_chunks = queue.Queue(self.pipeline_chunks)
+
+                def read():
+                    for input_samples in infile.iter_sample_blocks(renderer.chunk_size):
+                        chunk = pipeline.get(free_chunks)
+                        renderer.prepare(infile.sampleRate, input_samples, chunk)
+                        pipeline.put(prepared_chunks, chunk)
+                    pipeline.put(prepared_chunks, None)
+
+                def render():
+                    while True:
+                        chunk = pipeline.get(prepared_chunks)
+                        if chunk is not None:
+                            renderer.process(chunk)
+                        pipeline.put(rendered_chunks, chunk)
+                        if chunk is None:
+                            break
+
+                def write(output_samples):
+                    output_samples *= self.output_gain_linear
+                    output_monitor.process(output_samples)
+                    outfile.write(output_samples)
+
+                def write_chunks():
+                    while True:
+                        chunk = pipeline.get(rendered_chunks)
+                        if chunk is None:
+                            break
+                        write(chunk.output[:, : chunk.n_samples].T)
+                        pipeline.put(free_chunks, chunk)
+
+                    write(renderer.get_tail(infile.sampleRate, infile.channels))
+
+                pipeline.run(read, render, write_chunks)
 
         output_monitor.warn_overloaded()
         if self.fail_on_overload and output_monitor.has_overloaded():
             sys.exit("error: output overloaded")
 
 
+class PipelineStopped(Exception):
+    """Raised in a pipeline thread when another thread has failed."""
+
+
+class Pipeline:
+    """Run functions in separate threads which pass items between them through
+    queues, stopping all of them if any fails."""
+
+    poll_interval = 0.1
+
+    def __init__(self):
+        self.stopped = threading.Event()
+
+    def put(self, q, item):
+        """Put item into q, raising PipelineStopped if another thread fails
+        while waiting."""
+        while True:
+            if self.stopped.is_set():
+                raise PipelineStopped()
+            try:
+                q.put(item, timeout=self.poll_interval)
+                return
+            except queue.Full:
+                pass
+
+    def get(self, q):
+        """Get an item from q, raising PipelineStopped if another thread fails
+        while waiting."""
+        while True:
+            if self.stopped.is_set():
+                raise PipelineStopped()
+            try:
+                return q.get(timeout=self.poll_interval)
+            except queue.Empty:
+                pass
+
+    def run(self, *targets):
+        """Call each target in a separate thread, and wait for them to finish.
+        If any raise an exception, the others are stopped, and the first
+        exception is re-raised."""
+        errors = []
+
+        def run_target(target):
+            try:
+                target()
+            except PipelineStopped:
+                pass
+            except BaseException as e:
+                errors.append(e)
+                self.stopped.set()
+
+        threads = [
+            threading.Thread(target=run_target, args=(target,), daemon=True)
+            for target in targets
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        if errors:
+            raise errors[0]
+
+
 class MyMultiTrackProcessor(MultiTrackProcessor):
     """Does the same thing as MultiTrackProcessor but handles zero processors"""
 
@@ -348,15 +456,48 @@ def convert_hoa(ear_block: HOATypeMetadata, start_channel: int):
     return bear_block
 
 
+class RenderChunk:
+    """Buffers for one chunk of samples passing through the rendering
+    pipeline, which are allocated once and reused."""
+
+    def __init__(
+        self, n_objects, n_direct_speakers, n_hoa, n_output_channels, chunk_size
+    ):
+        def buffer(n_channels):
+            return np.zeros((n_channels, chunk_size), np.float32, order="C")
+
+        self.objects_input = buffer(n_objects)
+        self.direct_speakers_input = buffer(n_direct_speakers)
+        self.hoa_input = buffer(n_hoa)
+        self.output = buffer(n_output_channels)
+
+        # number of samples in this chunk, padded to the block size
+        self.n_samples = 0
+
+        # lists of (channel, block) for this chunk
+        self.objects_blocks = []
+        self.direct_speakers_blocks = []
+        self.hoa_blocks = []
+
+
 class BEARRenderer:
+    """Renders chunks of samples from rendering items with visr_bear.
+
+    prepare (which does track processing and metadata conversion) and process
+    (which does the rendering) may be called from separate threads, as long as
+    each is only ever called from one thread.
+    """
+
     def __init__(
         self,
         bear_data,
         block_size,
         rendering_items,
         fft_implementation=fft_implementations[0],
+        chunk_blocks=1,
     ):
         self.block_size = block_size
+        self.chunk_size = block_size * chunk_blocks
 
         self.objects_items = [
             item for item in rendering_items if isinstance(item, ObjectRenderingItem)
@@ -364,7 +505,6 @@ class BEARRenderer:
         self.objects_track_processor = MyMultiTrackProcessor(
             [item.track_spec for item in self.objects_items]
         )
-        self.next_objects_block = [None] * len(self.objects_items)
 
         self.direct_speakers_items = [
             item
@@ -374,7 +514,6 @@ class BEARRenderer:
         self.direct_speakers_track_processor = MyMultiTrackProcessor(
             [item.track_spec for item in self.direct_speakers_items]
         )
-        self.next_direct_speakers_block = [None] * len(self.direct_speakers_items)
 
         self.hoa_items = [
             item for item in rendering_items if isinstance(item, HOARenderingItem)
@@ -383,86 +522,133 @@ class BEARRenderer:
             track_spec for item in self.hoa_items for track_spec in item.track_specs
         ]
         self.hoa_track_processor = MyMultiTrackProcessor(hoa_track_specs)
-        self.next_hoa_block = [None] * len(self.hoa_items)
+        self.n_hoa_channels = len(hoa_track_specs)
+
+        # state used by prepare: the number of samples read so far, and the
+        # start time of the last block read for each item, or None if no more
+        # blocks are needed
+        self.read_samples = 0
+        self.objects_last_start = [-np.inf] * len(self.objects_items)
+        self.direct_speakers_last_start = [-np.inf] * len(self.direct_speakers_items)
+        self.hoa_last_start = [-np.inf] * len(self.hoa_items)
+
+        # state used by process: blocks which the renderer has not accepted yet
+        self.pending_objects_blocks = []
+        self.pending_direct_speakers_blocks = []
+        self.pending_hoa_blocks = []
 
         config = visr_bear.api.Config()
         config.num_objects_channels = len(self.objects_items)
         config.num_direct_speakers_channels = len(self.direct_speakers_items)
-        config.num_hoa_channels = len(hoa_track_specs)
+        config.num_hoa_channels = self.n_hoa_channels
         config.period_size = block_size
         config.data_path = bear.data_file.get_path(bear_data)
         config.fft_implementation = fft_implementation
 
         self.renderer = visr_bear.api.Renderer(config)
 
-    def render(self, sample_rate, input_samples):
-        def get_n_channels_default(item):
-            return 1
-
-        def get_n_channels_hoa(item):
-            return len(item.track_specs)
-
-        def push_single_channel(
-            items, next_blocks, convert, add_func, n_channels=get_n_channels_default
-        ):
-            start_channel = 0
-            for i, item in enumerate(items):
-                while True:
-                    if next_blocks[i] is None:
-                        block = item.metadata_source.get_next_block()
-                        if block is not None:
-                            next_blocks[i] = convert(block, start_channel)
-                    if next_blocks[i] is not None:
-                        if add_func(i, next_blocks[i]):
-                            next_blocks[i] = None
-                            continue
+    def make_chunk(self):
+        return RenderChunk(
+            len(self.objects_items),
+            len(self.direct_speakers_items),
+            self.n_hoa_channels,
+            2,
+            self.chunk_size,
+        )
+
+    @staticmethod
+    def read_blocks(items, convert, end_time, last_start, n_channels):
+        """Read and convert blocks from each item in items, until a block which
+        starts at or after end_time has been read, as the renderer may need it
+        before the end of the chunk.
+
+        Blocks without a start time last until the end of the item, so no more
+        blocks are read after one of those.
+
+        Returns a list of (item index, block) tuples.
+        """
+        blocks = []
+        start_channel = 0
+        for i, item in enumerate(items):
+            while last_start[i] is not None and last_start[i] < end_time:
+                block = item.metadata_source.get_next_block()
+                if block is None:
+                    last_start[i] = None
                     break
-                start_channel += n_channels(item)
 
-        push_single_channel(
+                bear_block = convert(block, start_channel)
+                blocks.append((i, bear_block))
+                last_start[i] = (
+                    None if bear_block.rtime is None else from_time(bear_block.rtime)
+                )
+            start_channel += n_channels(item)
+        return blocks
+
+    def prepare(self, sample_rate, input_samples, chunk):
+        """Do track processing and metadata conversion for input_samples,
+        storing the results in chunk."""
+        n_input_samples = input_samples.shape[0]
+        assert n_input_samples <= self.chunk_size
+
+        # pad to the block size; only happens in the last chunk
+        n_samples = -(-n_input_samples // self.block_size) * self.block_size
+        chunk.n_samples = n_samples
+
+        for buffer, track_processor in [
+            (chunk.objects_input, self.objects_track_processor),
+            (chunk.direct_speakers_input, self.direct_speakers_track_processor),
+            (chunk.hoa_input, self.hoa_track_processor),
+        ]:
+            buffer[:, :n_input_samples] = track_processor.process(
+                sample_rate, input_samples
+            ).T
+            buffer[:, n_input_samples:n_samples] = 0.0
+
+        self.read_samples += n_samples
+        end_time = Fraction(self.read_samples, sample_rate)
+
+        chunk.objects_blocks = self.read_blocks(
             self.objects_items,
-            self.next_objects_block,
             convert_objects,
-            self.renderer.add_objects_block,
+            end_time,
+            self.objects_last_start,
+            lambda item: 1,
         )
-
-        push_single_channel(
+        chunk.direct_speakers_blocks = self.read_blocks(
             self.direct_speakers_items,
-            self.next_direct_speakers_block,
             convert_direct_speakers,
-            self.renderer.add_direct_speakers_block,
+            end_time,
+            self.direct_speakers_last_start,
+            lambda item: 1,
         )
-
-        push_single_channel(
+        chunk.hoa_blocks = self.read_blocks(
             self.hoa_items,
-            self.next_hoa_block,
             convert_hoa,
-            self.renderer.add_hoa_block,
-            get_n_channels_hoa,
+            end_time,
+            self.hoa_last_start,
+            lambda item: len(item.track_specs),
         )
 
-        # pad to the block size; only happens in the last block
-        if input_samples.shape[0] < self.block_size:
-            new_input_samples = np.zeros((self.block_size, input_samples.shape[1]))
-            new_input_samples[: input_samples.shape[0]] = input_samples
-            input_samples = new_input_samples
-
-        objects_input = self.objects_track_processor.process(
-            sample_rate, input_samples
-        ).T.astype(np.float32, order="C")
-
-        direct_speakers_input = self.direct_speakers_track_processor.process(
-            sample_rate, input_samples
-        ).T.astype(np.float32, order="C")
-
-        hoa_input = self.hoa_track_processor.process(
-            sample_rate, input_samples
-        ).T.astype(np.float32, order="C")
-
-        output = np.zeros((2, len(input_samples)), np.float32, order="C")
-        self.renderer.process(objects_input, direct_speakers_input, hoa_input, output)
-
-        return output.T
+    def process(self, chunk):
+        """Render a chunk which has been through prepare into chunk.output.
+
+        The GIL is released while rendering, so this can run in parallel with
+        prepare and writing."""
+        n = chunk.n_samples
+        (
+            self.pending_objects_blocks,
+            self.pending_direct_speakers_blocks,
+            self.pending_hoa_blocks,
+        ) = self.renderer.process_blocks(
+            chunk.objects_input[:, :n],
+            chunk.direct_speakers_input[:, :n],
+            chunk.hoa_input[:, :n],
+            chunk.output[:, :n],
+            objects_blocks=self.pending_objects_blocks + chunk.objects_blocks,
+            direct_speakers_blocks=self.pending_direct_speakers_blocks
+            + chunk.direct_speakers_blocks,
+            hoa_blocks=self.pending_hoa_blocks + chunk.hoa_blocks,
+        )
 
     def get_tail(self, sample_rate, n_channels):
         return np.zeros((0, 2))
@@ -507,6 +693,7 @@ class BEAROfflineRenderDriver(OfflineRenderDriver):
                 self.blocksize,
                 rendering_items,
                 fft_implementation=self.fft_implementation,
+                chunk_blocks=self.chunk_blocks,
             ),
             2,
         )
@@ -1,6 +1,7 @@
 import numpy as np
 import struct
 import json
+import zlib
 
 """
 A tensorfile is an alternative to things like HDF5 for storing
@@ -21,12 +22,38 @@ found in ../visr_bear/src/tensorfile.{cpp,hpp} .
 
 A tensorfile consists of:
 - 4 byte tag: TENF
-- 4 byte version number, currently always 0 (unsigned LE)
+- 4 byte version number, 0 or 1 (unsigned LE)
 - 8 byte data size (unsigned LE)
 - 8 byte metadata size (unsigned LE)
+- version 1 only: 8 byte index size (unsigned LE)
 - 'data size' bytes of data indexed by json metadata
 - 'metadata size' bytes of JSON metadata, storing a user-defined structure
   with arrays represented as offsets into the file with sizes and strides
+- version 1 only: 'index size' bytes of index
+
+In version 1, the start of each array is aligned to at least 64 bytes (a
+cache line), and arrays of at least 64kB are aligned to 4096 bytes (a page) or
+more, so that readers never have to copy arrays to align them. Large arrays
+can be aligned to 2MiB so that they can be backed by transparent huge pages
+without sharing them with other arrays.
+
+The index is a binary directory of the arrays, containing:
+- 8 byte number of arrays (unsigned LE)
+- one 32 byte entry per array, in the order that they were written,
+  containing:
+  - 8 byte base (unsigned LE), as in the JSON metadata
+  - 8 byte length in bytes (unsigned LE)
+  - 4 byte CRC-32 of the array bytes (as in zlib, unsigned LE)
+  - 4 byte offset of the array name in the name table (unsigned LE)
+  - 8 byte dtype, as in the JSON metadata, padded with zero bytes
+- the name table: the name of each array, UTF-8 encoded and terminated by a
+  zero byte
+
+The name of an array is the JSON pointer (RFC 6901) to it in the metadata,
+for example "/views/0/brirs" for data["views"][0]["brirs"].
+
+This allows readers to find arrays by name and check their checksums without
+parsing the JSON metadata.
 
 Arrays are stored in the JSON metadata as objects with the following keys:
 
@@ -40,7 +67,9 @@ Arrays are stored in the JSON metadata as objects with the following keys:
     types which have no endianness.
   - The data type; i for signed integers, u for unsigned integers, or f for
     floats.
-  - The number of bytes, e.g. 8 for double precision floating point.
+  - The number of bytes, e.g. 8 for double precision floating point. Floats
+    may be 2 (half precision), 4 or 8 bytes; the C++ reader converts half
+    precision arrays to float32 on load.
 
 - "shape": list of integers, the number of elements in each dimension
 
@@ -50,6 +79,13 @@ Arrays are stored in the JSON metadata as objects with the following keys:
 - "base": the position of the first byte of the first element in the file
   (relative to the start of the file, not the start of the data)
 
+- "index" (version 1 only): the index of the entry for this array in the
+  binary index
+
+- "scale" (optional): if present, the array represents the stored values
+  multiplied by this number, and is read as a float32 array. This is used to
+  store quantised arrays, normally with the "<i2" type; see ScaledArray.
+
 Therefore an element with a given index can be found at byte:
 
     base + sum(i * s for i, s in zip(index, stride))
@@ -61,21 +97,61 @@ structure along with non-array data.
 _TAG = b"TENF"
 _TYPE_KEY = "_tenf_type"
 
+_V1_MIN_ALIGNMENT = 64
+_V1_LARGE_ALIGNMENT = 4096
+_V1_LARGE_THRESHOLD = 65536
+_INDEX_COUNT = struct.Struct("<Q")
+_INDEX_ENTRY = struct.Struct("<QQII8s")
+
+
+class ScaledArray(object):
+    """An integer array which represents data * scale.
+
+    This is written as an array with a "scale" key, and read back as a float32
+    array.
+    """
+
+    def __init__(self, data, scale):
+        self.data = np.asarray(data)
+        assert np.issubdtype(self.data.dtype, np.integer)
+        self.scale = float(scale)
+
+    def decode(self):
+        """get the float32 array that this represents"""
+        return self.data.astype(np.float32) * np.float32(self.scale)
 
-def _write_array(f, data, byte_order, alignment):
+
+def quantise(data, dtype=np.int16):
+    """Quantise a floating point array to a ScaledArray of integer type dtype,
+    using the full range of dtype."""
+    data = np.asarray(data)
+    max_abs = np.max(np.abs(data)) if data.size else 0.0
+    scale = max_abs / np.iinfo(dtype).max if max_abs > 0 else 1.0
+    return ScaledArray(np.round(data / scale).astype(dtype), scale)
+
+
+def _write_array(
+    f, data, byte_order, alignment, index=None, large_alignment=None, name=""
+):
     dtype = data.dtype.newbyteorder(byte_order)
     arr = np.ascontiguousarray(data, dtype)
 
     assert all(stride % dtype.itemsize == 0 for stride in arr.strides)
 
+    arr_bytes = arr.data.tobytes()
+
+    if index is not None:
+        alignment = max(alignment, _V1_MIN_ALIGNMENT)
+        if len(arr_bytes) >= _V1_LARGE_THRESHOLD:
+            alignment = max(alignment, large_alignment)
+
     padding = (alignment - f.tell() % alignment) % alignment
     f.write(b"\0" * padding)
 
     base = f.tell()
-    arr_bytes = arr.data.tobytes()
     f.write(arr_bytes)
 
-    return {
+    metadata = {
         _TYPE_KEY: "array",
         "dtype": dtype.str,
         "strides": arr.strides,
@@ -83,6 +159,30 @@ def _write_array(f, data, byte_order, alignment):
         "base": base,
     }
 
+    if index is not None:
+        metadata["index"] = len(index)
+        index.append(
+            (name, base, len(arr_bytes), zlib.crc32(arr_bytes), dtype.str)
+        )
+
+    return metadata
+
+
+def _write_scaled_array(
+    f, data, byte_order, alignment, index=None, large_alignment=None, name=""
+):
+    metadata = _write_array(
+        f,
+        data.data,
+        byte_order,
+        alignment,
+        index=index,
+        large_alignment=large_alignment,
+        name=name,
+    )
+    metadata["scale"] = data.scale
+    return metadata
+
 
 def _read_array(metadata, data_bytes):
     strides, shape = metadata["strides"], metadata["shape"]
@@ -92,16 +192,22 @@ def _read_array(metadata, data_bytes):
         sum(stride_i * (shape_i - 1) for stride_i, shape_i in zip(strides, shape))
         + dtype.itemsize
     )
-    return np.lib.stride_tricks.as_strided(
+    arr = np.lib.stride_tricks.as_strided(
         np.frombuffer(data_bytes[base : base + length], dtype=dtype),
         shape=shape,
         strides=strides,
         writeable=False,
     )
 
+    if "scale" in metadata:
+        return arr.astype(np.float32) * np.float32(metadata["scale"])
+    else:
+        return arr
+
 
 _writers = [
     (np.ndarray, _write_array),
+    (ScaledArray, _write_scaled_array),
 ]
 
 _readers = {
@@ -109,45 +215,135 @@ _readers = {
 }
 
 
-def _pack_data(f, data, byte_order, alignment):
-    def do_call(func, data):
+def _pointer_token(key):
+    """escape a key or list index for use in a JSON pointer"""
+    return str(key).replace("~", "~0").replace("/", "~1")
+
+
+def _pack_data(
+    f, data, byte_order, alignment, index=None, large_alignment=None, name=""
+):
+    def do_call(func, data, name):
         """call wrapper to keep non-data arguments the same"""
-        return func(f, data, byte_order=byte_order, alignment=alignment)
+        return func(
+            f,
+            data,
+            byte_order=byte_order,
+            alignment=alignment,
+            index=index,
+            large_alignment=large_alignment,
+            name=name,
+        )
 
     for types, write_func in _writers:
         if isinstance(data, types):
-            return do_call(write_func, data)
+            return do_call(write_func, data, name)
 
     if isinstance(data, dict):
-        return {key: do_call(_pack_data, value) for key, value in data.items()}
+        return {
+            key: do_call(_pack_data, value, name + "/" + _pointer_token(key))
+            for key, value in data.items()
+        }
     elif isinstance(data, (list, tuple)):
-        return [do_call(_pack_data, value) for value in data]
+        return [
+            do_call(_pack_data, value, name + "/" + _pointer_token(i))
+            for i, value in enumerate(data)
+        ]
     else:
         return data
 
 
-def write(f, data, byte_order="<", alignment=32):
+def _pack_index(index):
+    """pack the binary index from (name, base, length, crc, dtype) tuples"""
+    entries = []
+    names = []
+    names_len = 0
+    for name, base, length, crc, dtype in index:
+        name_bytes = name.encode("utf8")
+        assert b"\0" not in name_bytes, "array names must not contain zero bytes"
+        entries.append(
+            _INDEX_ENTRY.pack(base, length, crc, names_len, dtype.encode("ascii"))
+        )
+        names.append(name_bytes + b"\0")
+        names_len += len(name_bytes) + 1
+
+    return _INDEX_COUNT.pack(len(index)) + b"".join(entries) + b"".join(names)
+
+
+def _unpack_index(index_bytes):
+    """unpack the binary index to a list of (name, base, length, crc, dtype)
+    tuples"""
+    index_bytes = bytes(index_bytes)
+    (count,) = _INDEX_COUNT.unpack_from(index_bytes, 0)
+    names_start = _INDEX_COUNT.size + count * _INDEX_ENTRY.size
+
+    index = []
+    for i in range(count):
+        base, length, crc, name_offset, dtype = _INDEX_ENTRY.unpack_from(
+            index_bytes, _INDEX_COUNT.size + i * _INDEX_ENTRY.size
+        )
+        name_start = names_start + name_offset
+        name_end = index_bytes.index(b"\0", name_start)
+        name = index_bytes[name_start:name_end].decode("utf8")
+        index.append((name, base, length, crc, dtype.rstrip(b"\0").decode("ascii")))
+    return index
+
+
+def write(
+    f,
+    data,
+    byte_order="<",
+    alignment=32,
+    version=0,
+    large_alignment=_V1_LARGE_ALIGNMENT,
+):
     """Write a data structure to a file.
     Parameters:
         f (file-like): file to write, opened in binary mode
         data (dictionary, list or array): data structure to write to f
         byte_order ('<' or '>'): byte order to write in
         alignment: alignment of the start of arrays relative to the start of
-        the file
+        the file; in version 1 this is increased to at least 64 bytes, or
+        4096 for large arrays
+        version (0 or 1): file format version; version 1 files have aligned
+        arrays and a binary index with names and checksums, but can not be read
+        by older readers
+        large_alignment: alignment of arrays of 64kB and over in version 1
+        files; use 2MiB to allow these arrays to use transparent huge pages
     """
+    assert version in (0, 1)
     f.write(_TAG)
-    f.write(struct.pack("<IQQ", 0, 0, 0))
+    if version == 0:
+        f.write(struct.pack("<IQQ", 0, 0, 0))
+    else:
+        f.write(struct.pack("<IQQQ", 1, 0, 0, 0))
+
+    index = [] if version == 1 else None
 
     data_start = f.tell()
-    json_data = _pack_data(f, data, byte_order=byte_order, alignment=alignment)
+    json_data = _pack_data(
+        f,
+        data,
+        byte_order=byte_order,
+        alignment=alignment,
+        index=index,
+        large_alignment=large_alignment,
+    )
     data_len = f.tell() - data_start
 
     json_binary = json.dumps(json_data).encode("utf8")
     json_len = len(json_binary)
     f.write(json_binary)
 
+    if version == 1:
+        index_binary = _pack_index(index)
+        f.write(index_binary)
+
     f.seek(8)
-    f.write(struct.pack("<QQ", data_len, json_len))
+    if version == 0:
+        f.write(struct.pack("<QQ", data_len, json_len))
+    else:
+        f.write(struct.pack("<QQQ", data_len, json_len, len(index_binary)))
 
 
 def _unpack_data(metadata, data_bytes):
@@ -170,18 +366,40 @@ def _unpack_data(metadata, data_bytes):
         return metadata
 
 
-def read(f):
+def _verify(f_bytes, index_bytes):
+    for name, base, length, crc, _dtype in _unpack_index(index_bytes):
+        if zlib.crc32(f_bytes[base : base + length]) != crc:
+            raise ValueError(f"checksum mismatch for array {name}")
+
+
+def read(f, verify=False):
+    """Read a data structure from a file.
+    Parameters:
+        f (file-like or path): file to read
+        verify (bool): check the checksums of all arrays (version 1 only)
+    """
     f_bytes = np.memmap(f, mode="r").data
     assert f_bytes[:4] == _TAG
 
     (version,) = struct.unpack("<I", f_bytes[4:8])
-    assert version == 0
+    assert version in (0, 1), "unknown version number"
 
-    data_size, metadata_size = struct.unpack("<QQ", f_bytes[8:24])
+    if version == 0:
+        header_size = 24
+        data_size, metadata_size = struct.unpack("<QQ", f_bytes[8:24])
+        index_size = 0
+    else:
+        header_size = 32
+        data_size, metadata_size, index_size = struct.unpack("<QQQ", f_bytes[8:32])
 
-    metadata_bytes = f_bytes[24 + data_size : 24 + data_size + metadata_size]
+    metadata_start = header_size + data_size
+    metadata_bytes = f_bytes[metadata_start : metadata_start + metadata_size]
     metadata = json.loads(bytes(metadata_bytes).decode("utf8"))
 
+    if verify and version == 1:
+        index_start = metadata_start + metadata_size
+        _verify(f_bytes, f_bytes[index_start : index_start + index_size])
+
     return _unpack_data(metadata, f_bytes)
 
 
@@ -0,0 +1,89 @@
+import queue
+import random
+import time
+import pytest
+from .render_cli import Pipeline
+
+
+def run_pipeline(n_items, read_item=None, write_item=None, n_chunks=2):
+    """Run items through a read/render/write pipeline with the same structure
+    as OfflineRenderDriver.run, with a random delay in each stage. Items are
+    numbered, and read_item and write_item are called with the item number
+    in the read and write stages. Returns the items in the order written."""
+    rng = random.Random(0)
+
+    def delay():
+        time.sleep(rng.uniform(0, 0.002))
+
+    pipeline = Pipeline()
+    free_chunks = queue.Queue()
+    for _ in range(n_chunks):
+        free_chunks.put([None])
+    prepared_chunks = queue.Queue(n_chunks)
+    rendered_chunks = queue.Queue(n_chunks)
+    written = []
+
+    def read():
+        for i in range(n_items):
+            chunk = pipeline.get(free_chunks)
+            delay()
+            if read_item is not None:
+                read_item(i)
+            chunk[0] = i
+            pipeline.put(prepared_chunks, chunk)
+        pipeline.put(prepared_chunks, None)
+
+    def render():
+        while True:
+            chunk = pipeline.get(prepared_chunks)
+            if chunk is not None:
+                delay()
+                chunk[0] = ("rendered", chunk[0])
+            pipeline.put(rendered_chunks, chunk)
+            if chunk is None:
+                break
+
+    def write_chunks():
+        while True:
+            chunk = pipeline.get(rendered_chunks)
+            if chunk is None:
+                break
+            delay()
+            if write_item is not None:
+                write_item(chunk[0][1])
+            written.append(chunk[0])
+            pipeline.put(free_chunks, chunk)
+
+    pipeline.run(read, render, write_chunks)
+    return written
+
+
+def test_pipeline_order():
+    n_items = 100
+    assert run_pipeline(n_items) == [("rendered", i) for i in range(n_items)]
+
+
+class StageError(Exception):
+    pass
+
+
+def fail_at(n):
+    def check(i):
+        if i == n:
+            raise StageError(i)
+
+    return check
+
+
+@pytest.mark.parametrize("n", [0, 10])
+def test_pipeline_read_error(n):
+    with pytest.raises(StageError):
+        run_pipeline(100, read_item=fail_at(n))
+
+
+@pytest.mark.parametrize("n", [0, 10])
+def test_pipeline_write_error(n):
+    # the read thread is blocked waiting for a free chunk when the write
+    # thread fails, so this also checks that waiting threads are stopped
+    with pytest.raises(StageError):
+        run_pipeline(100, write_item=fail_at(n))
@@ -17,6 +17,7 @@ setup(
     entry_points={
         "console_scripts": [
             "bear-render = bear.render_cli:main",
+            "bear-extract-metadata = bear.extract_metadata:main",
         ]
     },
 )
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "ear/metadata.hpp"
 
@@ -46,9 +47,118 @@ class Config {
   const std::string &get_data_path() const;
 
   /// set the FFT implementation to use (default: a built-in implementation)
+  ///
+  /// "auto" selects the fastest available implementation for the period
+  /// size, by timing them the first time it is used in a process; see
+  /// FFTCache
   void set_fft_implementation(const std::string &fft_implementation);
   const std::string &get_fft_implementation() const;
 
+  /// set the maximum number of BRIR views to hold in the convolver at once;
+  /// other views are loaded on a background thread when the listener turns
+  /// towards them (default 0: all views are loaded on construction); this
+  /// requires binaural_convolver, so that views can be loaded without
+  /// allocating on the audio thread
+  void set_brir_view_cache_size(size_t num_views);
+  size_t get_brir_view_cache_size() const;
+
+  /// set the maximum rate in Hz at which listener changes are applied to the
+  /// gains, delays and BRIR selection (default 0: once per period)
+  void set_listener_update_rate(double rate);
+  double get_listener_update_rate() const;
+
+  /// set the minimum change in listener orientation in radians which causes
+  /// the rendering to be updated (default 0)
+  void set_listener_orientation_hysteresis(double angle);
+  double get_listener_orientation_hysteresis() const;
+
+  /// set the minimum change in listener position in metres which causes the
+  /// rendering to be updated (default 0)
+  void set_listener_position_hysteresis(double distance);
+  double get_listener_position_hysteresis() const;
+
+  /// set the maximum HOA order to render; higher orders in the input and the
+  /// decoder are discarded, reducing the number of convolutions (default -1:
+  /// use the order of the decoder in the data file)
+  void set_max_hoa_order(int order);
+  int get_max_hoa_order() const;
+
+  /// use a dedicated binaural convolver for the BRIRs, which accumulates in
+  /// the frequency domain to need only two inverse FFTs per period (default
+  /// false: use the generic VISR convolver)
+  void set_binaural_convolver(bool binaural_convolver);
+  bool get_binaural_convolver() const;
+
+  /// set how the data file will be accessed, which controls read-ahead:
+  /// "normal", "sequential" or "willneed", which starts reading the whole
+  /// file when it is opened (default "normal")
+  void set_data_file_advice(const std::string &advice);
+  const std::string &get_data_file_advice() const;
+
+  /// back the data file mapping with transparent huge pages where supported
+  /// (default false)
+  void set_data_file_huge_pages(bool huge_pages);
+  bool get_data_file_huge_pages() const;
+
+  /// lock the data file in memory so that it can not be paged out; this is
+  /// intended for real-time hosts, and construction fails if the memory lock
+  /// limit is too low (default false)
+  void set_data_file_lock(bool lock);
+  bool get_data_file_lock() const;
+
+  /// read all pages of the data file on a background thread during
+  /// construction, so that the first periods do not wait for page faults
+  /// (default false)
+  void set_data_file_prefault(bool prefault);
+  bool get_data_file_prefault() const;
+
+  /// set the maximum BRIR length in samples; longer BRIRs are truncated,
+  /// with a short fade-out at the end, reducing the cost of convolution
+  /// (default 0: no truncation)
+  void set_max_brir_length(size_t num_samples);
+  size_t get_max_brir_length() const;
+
+  /// enable gain normalisation, if the data file contains gain normalisation
+  /// factors (default true)
+  void set_enable_gain_norm(bool enable);
+  bool get_enable_gain_norm() const;
+
+  /// enable the rendering of extent (width, height and depth) of Objects;
+  /// if disabled, objects are rendered as points (default true)
+  void set_enable_extent(bool enable);
+  bool get_enable_extent() const;
+
+  /// set the maximum number of clusters that Objects channels are grouped
+  /// into (default 0: no clustering)
+  ///
+  /// If there are more Objects channels than this, channels with similar
+  /// gains and delays are mixed together and share one set of delays and
+  /// gains in the DSP, which reduces the cost of rendering many objects at
+  /// the expense of accuracy. Channels are reassigned between clusters each
+  /// period, with crossfades. Whenever no more channels are active than
+  /// there are clusters, each is rendered exactly.
+  void set_max_object_clusters(size_t num_clusters);
+  size_t get_max_object_clusters() const;
+
+  /// set a limit on the memory used by a renderer, in bytes (default 0: no
+  /// limit)
+  ///
+  /// This is checked against Renderer::get_memory_report before the large
+  /// buffers are allocated: heap allocations are counted, as is the mapped
+  /// data file if data_file_lock is enabled (otherwise its pages can be
+  /// evicted). If the limit is exceeded, construction throws
+  /// std::runtime_error, unless adapt_to_memory_budget is enabled.
+  void set_memory_budget(size_t num_bytes);
+  size_t get_memory_budget() const;
+
+  /// if the memory budget would be exceeded, reduce brir_view_cache_size
+  /// until it fits (down to 2 views, and only if binaural_convolver is
+  /// enabled), rather than failing straight away;
+  /// this does not change the rendering once views are loaded, but makes
+  /// head-tracked view switches slower (default false)
+  void set_adapt_to_memory_budget(bool adapt);
+  bool get_adapt_to_memory_budget() const;
+
   /// check that the configuration is valid; raises exceptions for missing or
   /// incorrect values
   void validate() const;
@@ -152,6 +262,51 @@ class Listener {
   std::unique_ptr<ListenerImpl> impl;
 };
 
+/// statistics about the construction of a Renderer
+struct ConstructionStats {
+  /// number of page faults on the constructing thread which did not require
+  /// I/O; faults on the background prefault thread are not included
+  long minor_page_faults = 0;
+  /// number of page faults on the constructing thread which required I/O
+  long major_page_faults = 0;
+};
+
+/// memory used by one component of a Renderer, see MemoryReport
+struct ComponentMemory {
+  /// name of the component, for example "brir_convolver", or
+  /// "data_file.brirs" for an array from the data file
+  std::string name;
+  /// bytes allocated on the heap; nearly all of these are written during
+  /// construction, so are resident
+  size_t allocated_bytes = 0;
+  /// bytes of the data file mapped into memory
+  size_t mapped_bytes = 0;
+  /// bytes of mapped_bytes which are currently resident; always 0 on
+  /// platforms without mincore
+  size_t resident_bytes = 0;
+};
+
+/// memory used by a Renderer, broken down by component
+///
+/// The sizes of buffers which belong to VISR components (gain matrices, the
+/// HOA convolver, and the BRIR convolver if binaural_convolver is disabled)
+/// are estimated from their parameters, as are the audio buffers between
+/// components and the per-object state in the control path. Allocations
+/// smaller than one audio buffer are not counted.
+///
+/// The data_file.* components are counted in full in the report of every
+/// renderer using the data file, even when it is shared with other
+/// renderers (as in a RenderService, where renderers with the same data
+/// file share one loaded copy), so reports from such renderers should not
+/// be added together.
+struct MemoryReport {
+  std::vector<ComponentMemory> components;
+  /// totals over all components
+  size_t allocated_bytes = 0;
+  size_t mapped_bytes = 0;
+  size_t resident_bytes = 0;
+};
+
 class Renderer {
  public:
   Renderer(const Config &config);
@@ -242,19 +397,67 @@ class Renderer {
   /// get the delay added by the renderer
   Time get_delay() const;
 
+  /// number of samples of input which can affect each output sample. A
+  /// renderer started this many samples (rounded up to a whole period) before
+  /// some time, and given the same metadata, produces the same output as one
+  /// which was running continuously from that time on.
+  size_t get_preroll_samples() const;
+
   /// set the listener position and orientation in the next frame. If
-  /// interpolation_time is specified, then the change will possibly be
-  /// interpolated over more than one frame; this may be useful if the head
-  /// position update rate is slower than the frame rate.
+  /// interpolation_time is specified, then the change will be interpolated
+  /// from the current listener over this time, starting in the next frame;
+  /// this may be useful if the head position update rate is slower than the
+  /// frame rate.
   ///
   /// note that we don't keep a reference to Listener; you should call this
   /// every frame (or so).
   void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time = {});
 
+  /// get statistics about the construction of this renderer
+  ConstructionStats get_construction_stats() const;
+
+  /// get the memory used by this renderer; the resident part of the data
+  /// file is measured on each call
+  MemoryReport get_memory_report() const;
+
  private:
   std::unique_ptr<RendererImpl> impl;
 };
 
+/// Process-wide cache of the FFT wrappers (which hold the FFT plans) used by
+/// renderers.
+///
+/// When a renderer is destroyed its FFT wrappers are kept, and are reused by
+/// renderers constructed later with the same FFT implementation and period
+/// size, so that they don't have to be planned again. FFT wrappers are only
+/// used by one renderer at a time. This applies to the BRIR convolver (if
+/// binaural_convolver is enabled) and decorrelators; the HOA convolver (and
+/// the BRIR convolver if binaural_convolver is disabled) make their own.
+class FFTCache {
+ public:
+  FFTCache() = delete;
+
+  /// Load FFTW wisdom from path if it exists, and save all wisdom to it
+  /// whenever a new FFTW plan is made by the cache, so that later processes
+  /// can skip planning. This is only useful with the "fftw" implementation
+  /// if it uses the same FFTW library as BEAR.
+  ///
+  /// Throws std::runtime_error if BEAR was built without BEAR_FFTW_WISDOM,
+  /// or if path exists but could not be read. Errors writing the file are
+  /// ignored.
+  static void set_fftw_wisdom_file(const std::string &path);
+
+  /// get the implementation used for "auto" with a given period size,
+  /// timing the available implementations if this has not been done yet
+  static std::string get_auto_implementation(size_t period_size);
+
+  /// number of FFT wrappers which are held but not in use
+  static size_t get_num_idle();
+
+  /// free the FFT wrappers which are not in use
+  static void clear();
+};
+
 class DataFileMetadataImpl;
 
 /// metadata contained in a BEAR data file
@@ -0,0 +1,56 @@
+#pragma once
+#include "api.hpp"
+
+namespace bear {
+
+class MultiListenerRendererImpl;
+
+/// Renderer for several listeners of the same programme.
+///
+/// This produces the same output as num_listeners Renderers given the same
+/// configuration, input audio and metadata, each with its own listener. The
+/// listeners share one Panner (so the data file is loaded once), and the
+/// metadata timing, input routing and rendering of all listeners is done in
+/// single calls.
+class MultiListenerRenderer {
+ public:
+  MultiListenerRenderer(const Config &config, size_t num_listeners);
+  MultiListenerRenderer(MultiListenerRenderer &&r);
+  MultiListenerRenderer();
+  ~MultiListenerRenderer();
+
+  MultiListenerRenderer &operator=(MultiListenerRenderer &&r);
+
+  size_t get_num_listeners() const;
+
+  /// process period_size samples for all listeners
+  ///
+  /// The inputs are the same as Renderer::process. output contains
+  /// 2 * num_listeners pointers to period_size samples; the left and right
+  /// output for listener i are written to output[2 * i] and
+  /// output[2 * i + 1].
+  void process(const Sample *const *objects_input,
+               const Sample *const *direct_speakers_input,
+               const Sample *const *hoa_input,
+               Sample *const *output);
+
+  /// add metadata for all listeners; see Renderer::add_objects_block etc.
+  bool add_objects_block(size_t channel, ObjectsInput metadata);
+  bool add_direct_speakers_block(size_t channel, DirectSpeakersInput metadata);
+  bool add_hoa_block(size_t stream, HOAInput metadata);
+
+  Time get_block_start_time() const;
+  void set_block_start_time(const Time &time);
+  size_t get_preroll_samples() const;
+
+  /// set the position and orientation of one listener; see
+  /// Renderer::set_listener
+  void set_listener(size_t listener,
+                    const Listener &l,
+                    const boost::optional<Time> &interpolation_time = {});
+
+ private:
+  std::unique_ptr<MultiListenerRendererImpl> impl;
+};
+
+}  // namespace bear
@@ -6,6 +6,7 @@
 #include "array_conversion.hpp"
 #include "boost_variant.hpp"
 #include "config_impl.hpp"
+#include "process_blocks.hpp"
 
 namespace bear {
 namespace python {
@@ -39,6 +40,36 @@ namespace python {
         .def_property("sample_rate", &Config::get_sample_rate, &Config::set_sample_rate)
         .def_property("data_path", &Config::get_data_path, &Config::set_data_path)
         .def_property("fft_implementation", &Config::get_fft_implementation, &Config::set_fft_implementation)
+        .def_property("brir_view_cache_size",
+                      &Config::get_brir_view_cache_size,
+                      &Config::set_brir_view_cache_size)
+        .def_property(
+            "listener_update_rate", &Config::get_listener_update_rate, &Config::set_listener_update_rate)
+        .def_property("listener_orientation_hysteresis",
+                      &Config::get_listener_orientation_hysteresis,
+                      &Config::set_listener_orientation_hysteresis)
+        .def_property("listener_position_hysteresis",
+                      &Config::get_listener_position_hysteresis,
+                      &Config::set_listener_position_hysteresis)
+        .def_property("max_hoa_order", &Config::get_max_hoa_order, &Config::set_max_hoa_order)
+        .def_property(
+            "binaural_convolver", &Config::get_binaural_convolver, &Config::set_binaural_convolver)
+        .def_property(
+            "data_file_advice", &Config::get_data_file_advice, &Config::set_data_file_advice)
+        .def_property(
+            "data_file_huge_pages", &Config::get_data_file_huge_pages, &Config::set_data_file_huge_pages)
+        .def_property("data_file_lock", &Config::get_data_file_lock, &Config::set_data_file_lock)
+        .def_property(
+            "data_file_prefault", &Config::get_data_file_prefault, &Config::set_data_file_prefault)
+        .def_property("max_brir_length", &Config::get_max_brir_length, &Config::set_max_brir_length)
+        .def_property("enable_gain_norm", &Config::get_enable_gain_norm, &Config::set_enable_gain_norm)
+        .def_property("enable_extent", &Config::get_enable_extent, &Config::set_enable_extent)
+        .def_property(
+            "max_object_clusters", &Config::get_max_object_clusters, &Config::set_max_object_clusters)
+        .def_property("memory_budget", &Config::get_memory_budget, &Config::set_memory_budget)
+        .def_property("adapt_to_memory_budget",
+                      &Config::get_adapt_to_memory_budget,
+                      &Config::set_adapt_to_memory_budget)
         .def("validate", &Config::validate);
 
     py::class_<DistanceBehaviour, PyDistanceBehaviour, std::shared_ptr<DistanceBehaviour>>(
@@ -122,6 +153,22 @@ namespace python {
         .def_property_readonly("right", &Listener::right)
         .def_property_readonly("up", &Listener::up);
 
+    py::class_<ConstructionStats>(m, "ConstructionStats")
+        .def_readonly("minor_page_faults", &ConstructionStats::minor_page_faults)
+        .def_readonly("major_page_faults", &ConstructionStats::major_page_faults);
+
+    py::class_<ComponentMemory>(m, "ComponentMemory")
+        .def_readonly("name", &ComponentMemory::name)
+        .def_readonly("allocated_bytes", &ComponentMemory::allocated_bytes)
+        .def_readonly("mapped_bytes", &ComponentMemory::mapped_bytes)
+        .def_readonly("resident_bytes", &ComponentMemory::resident_bytes);
+
+    py::class_<MemoryReport>(m, "MemoryReport")
+        .def_readonly("components", &MemoryReport::components)
+        .def_readonly("allocated_bytes", &MemoryReport::allocated_bytes)
+        .def_readonly("mapped_bytes", &MemoryReport::mapped_bytes)
+        .def_readonly("resident_bytes", &MemoryReport::resident_bytes);
+
     py::class_<Renderer>(m, "RendererBase");
 
     struct RendererWrapper : public Renderer {
@@ -162,9 +209,65 @@ namespace python {
             py::arg("direct_speakers_input").noconvert(true),
             py::arg("hoa_input").noconvert(true),
             py::arg("output").noconvert(true))
+        .def(
+            "process_blocks",
+            [](RendererWrapper &r,
+               py::array_t<float, 0> objects_input,
+               py::array_t<float, 0> direct_speakers_input,
+               py::array_t<float, 0> hoa_input,
+               py::array_t<float, 0> output,
+               BlockList<ObjectsInput> objects_blocks,
+               BlockList<DirectSpeakersInput> direct_speakers_blocks,
+               BlockList<HOAInput> hoa_blocks,
+               MetadataPlayer<MetadataFile> *player) {
+              size_t period_size = r.config.period_size;
+              size_t num_periods = get_num_periods(output, period_size, "output");
+              size_t num_samples = num_periods * period_size;
+
+              std::vector<float *> objects_input_ptrs = py_array_to_pointers(
+                  objects_input, r.config.num_objects_channels, num_samples, "objects_input");
+              std::vector<float *> direct_speakers_input_ptrs =
+                  py_array_to_pointers(direct_speakers_input,
+                                       r.config.num_direct_speakers_channels,
+                                       num_samples,
+                                       "direct_speakers_input");
+              std::vector<float *> hoa_input_ptrs =
+                  py_array_to_pointers(hoa_input, r.config.num_hoa_channels, num_samples, "hoa_input");
+              std::vector<float *> output_ptrs = py_array_to_pointers(output, 2, num_samples, "output");
+
+              return process_blocks(
+                  r,
+                  period_size,
+                  num_periods,
+                  objects_input_ptrs,
+                  direct_speakers_input_ptrs,
+                  hoa_input_ptrs,
+                  output_ptrs,
+                  std::move(objects_blocks),
+                  std::move(direct_speakers_blocks),
+                  std::move(hoa_blocks),
+                  player,
+                  [&](std::vector<float *> &objects,
+                      std::vector<float *> &direct_speakers,
+                      std::vector<float *> &hoa,
+                      std::vector<float *> &out) {
+                    r.process(objects.data(), direct_speakers.data(), hoa.data(), out.data());
+                  });
+            },
+            py::arg("objects_input").noconvert(true),
+            py::arg("direct_speakers_input").noconvert(true),
+            py::arg("hoa_input").noconvert(true),
+            py::arg("output").noconvert(true),
+            py::arg("objects_blocks") = BlockList<ObjectsInput>{},
+            py::arg("direct_speakers_blocks") = BlockList<DirectSpeakersInput>{},
+            py::arg("hoa_blocks") = BlockList<HOAInput>{},
+            py::arg("player") = nullptr)
         .def("get_block_start_time", &Renderer::get_block_start_time)
         .def("set_block_start_time", &Renderer::set_block_start_time)
-        .def("set_listener", &Renderer::set_listener);
+        .def("set_listener", &Renderer::set_listener)
+        .def("get_preroll_samples", &Renderer::get_preroll_samples)
+        .def("get_construction_stats", &Renderer::get_construction_stats)
+        .def("get_memory_report", &Renderer::get_memory_report);
 
     py::class_<Time>(m, "Time")
         .def(py::init<int64_t>())
@@ -178,6 +281,12 @@ namespace python {
         .def_property_readonly("label", &DataFileMetadata::get_label)
         .def_property_readonly("description", &DataFileMetadata::get_description)
         .def_property_readonly("is_released", &DataFileMetadata::is_released);
+
+    py::class_<FFTCache>(m, "FFTCache")
+        .def_static("set_fftw_wisdom_file", &FFTCache::set_fftw_wisdom_file)
+        .def_static("get_auto_implementation", &FFTCache::get_auto_implementation)
+        .def_static("get_num_idle", &FFTCache::get_num_idle)
+        .def_static("clear", &FFTCache::clear);
   }
 
 }  // namespace python
@@ -10,6 +10,8 @@ void export_api(pybind11::module &m);
 void export_debug_sink(pybind11::module &m);
 void export_internals(pybind11::module &m);
 void export_dynamic_renderer(pybind11::module &m);
+void export_metadata_file(pybind11::module &m);
+void export_multi_listener_renderer(pybind11::module &m);
 } // namespace python
 } // namespace bear
 
@@ -28,4 +30,6 @@ PYBIND11_MODULE(visr_bear, m)
   export_debug_sink(m);
   export_internals(m);
   export_dynamic_renderer(m);
+  export_metadata_file(m);
+  export_multi_listener_renderer(m);
 }
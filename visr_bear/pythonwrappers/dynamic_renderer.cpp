@@ -6,6 +6,7 @@
 #include "array_conversion.hpp"
 #include "boost_variant.hpp"
 #include "config_impl.hpp"
+#include "process_blocks.hpp"
 
 namespace bear {
 namespace python {
@@ -24,6 +25,29 @@ namespace python {
       size_t block_size;
     };
 
+    py::class_<GovernorOptions>(m, "GovernorOptions")
+        .def(py::init<>())
+        .def_readonly_static("max_level", &GovernorOptions::max_level)
+        .def_readwrite("enabled", &GovernorOptions::enabled)
+        .def_readwrite("time_constant", &GovernorOptions::time_constant)
+        .def_readwrite("high_load", &GovernorOptions::high_load)
+        .def_readwrite("overload_time", &GovernorOptions::overload_time)
+        .def_readwrite("low_load", &GovernorOptions::low_load)
+        .def_readwrite("recovery_time", &GovernorOptions::recovery_time)
+        .def_readwrite("truncated_brir_length", &GovernorOptions::truncated_brir_length)
+        .def_readwrite("reduced_hoa_order", &GovernorOptions::reduced_hoa_order)
+        .def_readwrite("reduced_listener_update_rate", &GovernorOptions::reduced_listener_update_rate);
+
+    py::enum_<ReconfigureMode>(m, "ReconfigureMode")
+        .value("FADE", ReconfigureMode::FADE)
+        .value("CROSSFADE", ReconfigureMode::CROSSFADE);
+
+    py::class_<CrossfadeStats>(m, "CrossfadeStats")
+        .def_readonly("num_crossfades", &CrossfadeStats::num_crossfades)
+        .def_readonly("num_overlap_periods", &CrossfadeStats::num_overlap_periods)
+        .def_readonly("overlap_time", &CrossfadeStats::overlap_time)
+        .def_readonly("max_overlap_load", &CrossfadeStats::max_overlap_load);
+
     py::class_<RendererWrapper>(m, "DynamicRenderer")
         .def(py::init<size_t, size_t>())
         .def("set_config", &RendererWrapper::set_config)
@@ -67,9 +91,76 @@ namespace python {
             py::arg("direct_speakers_input").noconvert(true),
             py::arg("hoa_input").noconvert(true),
             py::arg("output").noconvert(true))
+        .def(
+            "process_blocks",
+            [](RendererWrapper &r,
+               py::array_t<float, 0> objects_input,
+               py::array_t<float, 0> direct_speakers_input,
+               py::array_t<float, 0> hoa_input,
+               py::array_t<float, 0> output,
+               BlockList<ObjectsInput> objects_blocks,
+               BlockList<DirectSpeakersInput> direct_speakers_blocks,
+               BlockList<HOAInput> hoa_blocks,
+               MetadataPlayer<MetadataFile> *player) {
+              size_t num_periods = get_num_periods(output, r.block_size, "output");
+              size_t num_samples = num_periods * r.block_size;
+
+              std::vector<float *> objects_input_ptrs =
+                  py_array_to_pointers_var(objects_input, num_samples, "objects_input");
+              std::vector<float *> direct_speakers_input_ptrs =
+                  py_array_to_pointers_var(direct_speakers_input, num_samples, "direct_speakers_input");
+              std::vector<float *> hoa_input_ptrs =
+                  py_array_to_pointers_var(hoa_input, num_samples, "hoa_input");
+              std::vector<float *> output_ptrs = py_array_to_pointers(output, 2, num_samples, "output");
+
+              return process_blocks(
+                  r,
+                  r.block_size,
+                  num_periods,
+                  objects_input_ptrs,
+                  direct_speakers_input_ptrs,
+                  hoa_input_ptrs,
+                  output_ptrs,
+                  std::move(objects_blocks),
+                  std::move(direct_speakers_blocks),
+                  std::move(hoa_blocks),
+                  player,
+                  [&](std::vector<float *> &objects,
+                      std::vector<float *> &direct_speakers,
+                      std::vector<float *> &hoa,
+                      std::vector<float *> &out) {
+                    r.process(objects.size(),
+                              objects.data(),
+                              direct_speakers.size(),
+                              direct_speakers.data(),
+                              hoa.size(),
+                              hoa.data(),
+                              out.data());
+                  });
+            },
+            py::arg("objects_input").noconvert(true),
+            py::arg("direct_speakers_input").noconvert(true),
+            py::arg("hoa_input").noconvert(true),
+            py::arg("output").noconvert(true),
+            py::arg("objects_blocks") = BlockList<ObjectsInput>{},
+            py::arg("direct_speakers_blocks") = BlockList<DirectSpeakersInput>{},
+            py::arg("hoa_blocks") = BlockList<HOAInput>{},
+            py::arg("player") = nullptr)
         .def("get_block_start_time", &RendererWrapper::get_block_start_time)
         .def("set_block_start_time", &RendererWrapper::set_block_start_time)
-        .def("set_listener", &RendererWrapper::set_listener);
+        .def("set_listener", &RendererWrapper::set_listener)
+        // the level callback would be called from the audio thread, so it is
+        // not exposed; use get_quality_level instead
+        .def("set_governor",
+             [](RendererWrapper &r, const GovernorOptions &options) { r.set_governor(options); })
+        .def("get_quality_level", &RendererWrapper::get_quality_level)
+        .def("get_num_quality_changes", &RendererWrapper::get_num_quality_changes)
+        .def("set_background_preroll", &RendererWrapper::set_background_preroll)
+        .def("get_background_preroll", &RendererWrapper::get_background_preroll)
+        .def("set_reconfigure_mode", &RendererWrapper::set_reconfigure_mode)
+        .def("get_reconfigure_mode", &RendererWrapper::get_reconfigure_mode)
+        .def("get_crossfade_stats", &RendererWrapper::get_crossfade_stats)
+        .def("get_memory_report", &RendererWrapper::get_memory_report);
     ;
   }
 }  // namespace python
@@ -6,9 +6,12 @@
 
 #include "boost_variant.hpp"
 #include "direct_speakers_gain_calc.hpp"
+#include "direct_speakers_path.hpp"
 #include "gain_calc_hoa.hpp"
 #include "gain_calc_objects.hpp"
+#include "listener_smoother.hpp"
 #include "parameters.hpp"
+#include "per_ear_delay.hpp"
 #include "select_brir.hpp"
 
 namespace bear {
@@ -53,6 +56,7 @@ namespace python {
     pybind11::class_<ListenerParameter, ParameterBase>(m, "ListenerParameter")
         .def(py::init<>())
         .def_readwrite("position", &ListenerParameter::position)
+        .def_readwrite("interpolation_time", &ListenerParameter::interpolation_time)
         .def_property(
             "orientation",
             [](const ListenerParameter &lp) {
@@ -63,6 +67,9 @@ namespace python {
               lp.orientation = {v(0), v(1), v(2), v(3)};
             });
 
+    py::class_<ListenerSmoother, visr::AtomicComponent>(m, "ListenerSmoother")
+        .def(py::init<const SignalFlowContext &, const char *, CompositeComponent *, const ConfigImpl &>());
+
     py::class_<SelectBRIR, visr::AtomicComponent>(m, "SelectBRIR")
         .def(py::init<const SignalFlowContext &,
                       const char *,
@@ -79,6 +86,24 @@ namespace python {
 
     pybind11::class_<ADMParameter<HOAInput>, ParameterBase>(m, "ADMParameterHOA")
         .def(py::init<size_t, HOAInput>());
+
+    py::class_<DirectSpeakersPath, visr::AtomicComponent>(m, "DirectSpeakersPath")
+        .def(py::init<const SignalFlowContext &,
+                      const char *,
+                      CompositeComponent *,
+                      std::size_t,
+                      std::size_t,
+                      double,
+                      double>());
+
+    py::class_<PerEarDelay, visr::CompositeComponent>(m, "PerEarDelay")
+        .def(py::init<const SignalFlowContext &,
+                      const char *,
+                      CompositeComponent *,
+                      std::size_t,
+                      std::size_t,
+                      double,
+                      double>());
   }
 
 }  // namespace python
@@ -0,0 +1,43 @@
+#include "metadata_file.hpp"
+
+#include <pybind11/pybind11.h>
+
+#include "boost_variant.hpp"
+
+namespace bear {
+namespace python {
+
+  namespace py = pybind11;
+
+  void export_metadata_file(pybind11::module &m)
+  {
+    py::class_<MetadataFile>(m, "MetadataFile")
+        .def(py::init<const std::string &>())
+        .def_property_readonly("num_objects_channels", &MetadataFile::num_objects_channels)
+        .def("objects_track", &MetadataFile::objects_track)
+        .def("num_objects_blocks", &MetadataFile::num_objects_blocks)
+        .def("objects_block", &MetadataFile::objects_block)
+        .def_property_readonly("num_direct_speakers_channels", &MetadataFile::num_direct_speakers_channels)
+        .def("direct_speakers_track", &MetadataFile::direct_speakers_track)
+        .def("num_direct_speakers_blocks", &MetadataFile::num_direct_speakers_blocks)
+        .def("direct_speakers_block", &MetadataFile::direct_speakers_block)
+        .def_property_readonly("num_hoa_streams", &MetadataFile::num_hoa_streams)
+        .def_property_readonly("num_hoa_channels", &MetadataFile::num_hoa_channels)
+        .def("hoa_tracks", &MetadataFile::hoa_tracks)
+        .def("num_hoa_blocks", &MetadataFile::num_hoa_blocks)
+        .def("hoa_block", &MetadataFile::hoa_block);
+
+    using Player = MetadataPlayer<MetadataFile>;
+
+    // the player refers to the file, so keep it alive
+    py::class_<Player>(m, "MetadataFilePlayer")
+        .def(py::init<const MetadataFile &, const Time &>(),
+             py::arg("file"),
+             py::arg("start") = Time{0},
+             py::keep_alive<1, 2>())
+        .def("push", &Player::push<Renderer>)
+        .def("done", &Player::done);
+  }
+
+}  // namespace python
+}  // namespace bear
@@ -0,0 +1,66 @@
+#include "bear/multi_listener_renderer.hpp"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include "array_conversion.hpp"
+#include "boost_variant.hpp"
+#include "config_impl.hpp"
+
+namespace bear {
+namespace python {
+
+  namespace py = pybind11;
+
+  void export_multi_listener_renderer(pybind11::module &m)
+  {
+    struct RendererWrapper : public MultiListenerRenderer {
+      RendererWrapper(const Config &config, size_t num_listeners)
+          : MultiListenerRenderer(config, num_listeners), config(config.get_impl())
+      {
+      }
+      ConfigImpl config;
+    };
+
+    py::class_<RendererWrapper>(m, "MultiListenerRenderer")
+        .def(py::init<const Config &, size_t>())
+        .def_property_readonly("num_listeners", &RendererWrapper::get_num_listeners)
+        .def("add_objects_block", &RendererWrapper::add_objects_block)
+        .def("add_direct_speakers_block", &RendererWrapper::add_direct_speakers_block)
+        .def("add_hoa_block", &RendererWrapper::add_hoa_block)
+        .def(
+            "process",
+            [](RendererWrapper &r,
+               py::array_t<float, 0> objects_input,
+               py::array_t<float, 0> direct_speakers_input,
+               py::array_t<float, 0> hoa_input,
+               py::array_t<float, 0> output) {
+              std::vector<float *> objects_input_ptrs = py_array_to_pointers(
+                  objects_input, r.config.num_objects_channels, r.config.period_size, "objects_input");
+              std::vector<float *> direct_speakers_input_ptrs =
+                  py_array_to_pointers(direct_speakers_input,
+                                       r.config.num_direct_speakers_channels,
+                                       r.config.period_size,
+                                       "direct_speakers_input");
+              std::vector<float *> hoa_input_ptrs = py_array_to_pointers(
+                  hoa_input, r.config.num_hoa_channels, r.config.period_size, "hoa_input");
+              std::vector<float *> output_ptrs =
+                  py_array_to_pointers(output, 2 * r.get_num_listeners(), r.config.period_size, "output");
+
+              r.process(objects_input_ptrs.data(),
+                        direct_speakers_input_ptrs.data(),
+                        hoa_input_ptrs.data(),
+                        output_ptrs.data());
+            },
+            py::arg("objects_input").noconvert(true),
+            py::arg("direct_speakers_input").noconvert(true),
+            py::arg("hoa_input").noconvert(true),
+            py::arg("output").noconvert(true))
+        .def("get_block_start_time", &RendererWrapper::get_block_start_time)
+        .def("set_block_start_time", &RendererWrapper::set_block_start_time)
+        .def("set_listener", &RendererWrapper::set_listener)
+        .def("get_preroll_samples", &RendererWrapper::get_preroll_samples);
+  }
+
+}  // namespace python
+}  // namespace bear
@@ -0,0 +1,141 @@
+#pragma once
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "bear/api.hpp"
+#include "boost_variant.hpp"
+#include "metadata_file.hpp"
+
+namespace bear {
+namespace python {
+
+  /// list of (channel, block) pairs, as passed to process_blocks
+  template <typename Input>
+  using BlockList = std::vector<std::pair<size_t, Input>>;
+
+  /// metadata blocks for one type of channel, which are added to a renderer as
+  /// it accepts them; blocks for each channel are added in order, but a
+  /// channel which is not ready does not hold up the others
+  template <typename Input>
+  class BlockSchedule {
+   public:
+    explicit BlockSchedule(BlockList<Input> blocks_)
+        : blocks(std::move(blocks_)), added(blocks.size(), false)
+    {
+    }
+
+    /// add blocks with add(channel, block), which returns false if the block
+    /// can not be added yet
+    template <typename Add>
+    void push(Add add)
+    {
+      while (first_pending < blocks.size() && added[first_pending]) first_pending++;
+
+      std::set<size_t> blocked;
+      for (size_t i = first_pending; i < blocks.size(); i++) {
+        size_t channel = blocks[i].first;
+        if (added[i] || blocked.count(channel)) continue;
+
+        if (add(channel, blocks[i].second))
+          added[i] = true;
+        else
+          blocked.insert(channel);
+      }
+    }
+
+    /// blocks which have not been added, in the original order
+    BlockList<Input> remaining() const
+    {
+      BlockList<Input> result;
+      for (size_t i = first_pending; i < blocks.size(); i++)
+        if (!added[i]) result.push_back(blocks[i]);
+      return result;
+    }
+
+   private:
+    BlockList<Input> blocks;
+    std::vector<bool> added;
+    size_t first_pending = 0;
+  };
+
+  /// number of periods of period_size samples in a (channels, samples) array
+  inline size_t get_num_periods(const pybind11::array_t<float, 0> &arr,
+                                size_t period_size,
+                                const std::string &name)
+  {
+    if (arr.ndim() != 2) throw pybind11::value_error(name + " must have 2 dimensions");
+    size_t num_samples = static_cast<size_t>(arr.shape(1));
+    if (num_samples % period_size != 0)
+      throw pybind11::value_error(name + " length must be a multiple of the period size");
+    return num_samples / period_size;
+  }
+
+  /// Render num_periods periods, with the GIL released.
+  ///
+  /// The pointer vectors point at the start of each channel of the input and
+  /// output arrays, which have num_periods * period_size samples. Before each
+  /// period, blocks from the schedules and the player (if not null) are added
+  /// as the renderer accepts them, then process(objects, direct_speakers,
+  /// hoa, output) is called with pointers to that period.
+  ///
+  /// Returns the blocks which were not added, as a tuple of three BlockLists.
+  template <typename R, typename Process>
+  pybind11::tuple process_blocks(R &renderer,
+                                 size_t period_size,
+                                 size_t num_periods,
+                                 const std::vector<float *> &objects_input,
+                                 const std::vector<float *> &direct_speakers_input,
+                                 const std::vector<float *> &hoa_input,
+                                 const std::vector<float *> &output,
+                                 BlockList<ObjectsInput> objects_blocks,
+                                 BlockList<DirectSpeakersInput> direct_speakers_blocks,
+                                 BlockList<HOAInput> hoa_blocks,
+                                 MetadataPlayer<MetadataFile> *player,
+                                 Process process)
+  {
+    BlockSchedule<ObjectsInput> objects_schedule(std::move(objects_blocks));
+    BlockSchedule<DirectSpeakersInput> direct_speakers_schedule(std::move(direct_speakers_blocks));
+    BlockSchedule<HOAInput> hoa_schedule(std::move(hoa_blocks));
+
+    {
+      pybind11::gil_scoped_release release;
+
+      // pointers to the current period, updated in place
+      std::vector<float *> objects_period(objects_input.size());
+      std::vector<float *> direct_speakers_period(direct_speakers_input.size());
+      std::vector<float *> hoa_period(hoa_input.size());
+      std::vector<float *> output_period(output.size());
+      auto offset = [&](const std::vector<float *> &start, std::vector<float *> &period, size_t i) {
+        for (size_t ch = 0; ch < start.size(); ch++) period[ch] = start[ch] + i * period_size;
+      };
+
+      for (size_t i = 0; i < num_periods; i++) {
+        objects_schedule.push([&](size_t channel, const ObjectsInput &block) {
+          return renderer.add_objects_block(channel, block);
+        });
+        direct_speakers_schedule.push([&](size_t channel, const DirectSpeakersInput &block) {
+          return renderer.add_direct_speakers_block(channel, block);
+        });
+        hoa_schedule.push(
+            [&](size_t stream, const HOAInput &block) { return renderer.add_hoa_block(stream, block); });
+        if (player) player->push(renderer);
+
+        offset(objects_input, objects_period, i);
+        offset(direct_speakers_input, direct_speakers_period, i);
+        offset(hoa_input, hoa_period, i);
+        offset(output, output_period, i);
+
+        process(objects_period, direct_speakers_period, hoa_period, output_period);
+      }
+    }
+
+    return pybind11::make_tuple(
+        objects_schedule.remaining(), direct_speakers_schedule.remaining(), hoa_schedule.remaining());
+  }
+
+}  // namespace python
+}  // namespace bear
@@ -10,6 +10,7 @@
 #include "config_impl.hpp"
 #include "data_file.hpp"
 #include "listener_impl.hpp"
+#include "page_faults.hpp"
 #include "parameters.hpp"
 #include "top.hpp"
 #include "utils.hpp"
@@ -65,10 +66,79 @@ void Config::set_fft_implementation(const std::string &fft_implementation)
 }
 const std::string &Config::get_fft_implementation() const { return impl->fft_implementation; }
 
+void Config::set_brir_view_cache_size(size_t num_views) { impl->brir_view_cache_size = num_views; }
+size_t Config::get_brir_view_cache_size() const { return impl->brir_view_cache_size; }
+
+void Config::set_listener_update_rate(double rate) { impl->listener_update_rate = rate; }
+double Config::get_listener_update_rate() const { return impl->listener_update_rate; }
+
+void Config::set_listener_orientation_hysteresis(double angle)
+{
+  impl->listener_orientation_hysteresis = angle;
+}
+double Config::get_listener_orientation_hysteresis() const { return impl->listener_orientation_hysteresis; }
+
+void Config::set_listener_position_hysteresis(double distance)
+{
+  impl->listener_position_hysteresis = distance;
+}
+double Config::get_listener_position_hysteresis() const { return impl->listener_position_hysteresis; }
+
+void Config::set_max_hoa_order(int order) { impl->max_hoa_order = order; }
+int Config::get_max_hoa_order() const { return impl->max_hoa_order; }
+
+void Config::set_binaural_convolver(bool binaural_convolver)
+{
+  impl->binaural_convolver = binaural_convolver;
+}
+bool Config::get_binaural_convolver() const { return impl->binaural_convolver; }
+
+void Config::set_data_file_advice(const std::string &advice) { impl->data_file_advice = advice; }
+const std::string &Config::get_data_file_advice() const { return impl->data_file_advice; }
+
+void Config::set_data_file_huge_pages(bool huge_pages) { impl->data_file_huge_pages = huge_pages; }
+bool Config::get_data_file_huge_pages() const { return impl->data_file_huge_pages; }
+
+void Config::set_data_file_lock(bool lock) { impl->data_file_lock = lock; }
+bool Config::get_data_file_lock() const { return impl->data_file_lock; }
+
+void Config::set_data_file_prefault(bool prefault) { impl->data_file_prefault = prefault; }
+bool Config::get_data_file_prefault() const { return impl->data_file_prefault; }
+
+void Config::set_max_brir_length(size_t num_samples) { impl->max_brir_length = num_samples; }
+size_t Config::get_max_brir_length() const { return impl->max_brir_length; }
+
+void Config::set_enable_gain_norm(bool enable) { impl->enable_gain_norm = enable; }
+bool Config::get_enable_gain_norm() const { return impl->enable_gain_norm; }
+
+void Config::set_enable_extent(bool enable) { impl->enable_extent = enable; }
+bool Config::get_enable_extent() const { return impl->enable_extent; }
+
+void Config::set_max_object_clusters(size_t num_clusters) { impl->max_object_clusters = num_clusters; }
+size_t Config::get_max_object_clusters() const { return impl->max_object_clusters; }
+
+void Config::set_memory_budget(size_t num_bytes) { impl->memory_budget = num_bytes; }
+size_t Config::get_memory_budget() const { return impl->memory_budget; }
+
+void Config::set_adapt_to_memory_budget(bool adapt) { impl->adapt_to_memory_budget = adapt; }
+bool Config::get_adapt_to_memory_budget() const { return impl->adapt_to_memory_budget; }
+
 void Config::validate() const
 {
   if (impl->period_size == 0) throw std::invalid_argument("Config: period size must be set");
   if (impl->data_path.empty()) throw std::invalid_argument("Config: data path must be set");
+  if (impl->brir_view_cache_size == 1)
+    throw std::invalid_argument("Config: BRIR view cache size must be 0 or at least 2");
+  if (impl->brir_view_cache_size != 0 && !impl->binaural_convolver)
+    throw std::invalid_argument("Config: BRIR view cache requires the binaural convolver");
+  if (impl->listener_update_rate < 0.0)
+    throw std::invalid_argument("Config: listener update rate must not be negative");
+  if (impl->listener_orientation_hysteresis < 0.0 || impl->listener_position_hysteresis < 0.0)
+    throw std::invalid_argument("Config: listener hysteresis must not be negative");
+  if (impl->max_hoa_order < -1) throw std::invalid_argument("Config: max HOA order must be -1 or more");
+  if (impl->data_file_advice != "normal" && impl->data_file_advice != "sequential" &&
+      impl->data_file_advice != "willneed")
+    throw std::invalid_argument("Config: data file advice must be normal, sequential or willneed");
 }
 
 ConfigImpl &Config::get_impl() { return *impl; }
@@ -211,15 +281,18 @@ class RendererImpl {
 
   void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time)
   {
-    // currently interpolation is ignored, but it's not clear if interpolating
-    // without some delay compensation would be a good idea anyway
-    (void)interpolation_time;
-
     auto &data = dynamic_cast<ListenerParameter &>(listener_in.data());
     data = l.get_impl();
+    data.interpolation_time = interpolation_time ? boost::rational_cast<double>(*interpolation_time) : 0.0;
     listener_in.swapBuffers();
   }
 
+  size_t get_preroll_samples() const { return top.preroll_samples(); }
+
+  MemoryReport get_memory_report() const { return top.memory_report(); }
+
+  ConstructionStats construction_stats;
+
  private:
   ConfigImpl config;
   const SignalFlowContext ctx;
@@ -243,7 +316,12 @@ Renderer::Renderer(const Config &config)
 
   config.validate();
 
+  PageFaults faults_before = get_page_faults();
   impl = std::make_unique<RendererImpl>(config.get_impl());
+  PageFaults faults_after = get_page_faults();
+
+  impl->construction_stats.minor_page_faults = faults_after.minor - faults_before.minor;
+  impl->construction_stats.major_page_faults = faults_after.major - faults_before.major;
 }
 
 Renderer::Renderer(Renderer &&r) = default;
@@ -282,6 +360,12 @@ void Renderer::set_listener(const Listener &l, const boost::optional<Time> &inte
   impl->set_listener(l, interpolation_time);
 }
 
+size_t Renderer::get_preroll_samples() const { return impl->get_preroll_samples(); }
+
+ConstructionStats Renderer::get_construction_stats() const { return impl->construction_stats; }
+
+MemoryReport Renderer::get_memory_report() const { return impl->get_memory_report(); }
+
 Renderer::~Renderer() = default;
 
 class DataFileMetadataImpl {
@@ -338,8 +422,8 @@ DataFileMetadata DataFileMetadata::read_from_file(const std::string &path)
 
   auto impl = std::make_unique<DataFileMetadataImpl>();
 
-  auto it = tf.metadata.FindMember("metadata");
-  if (it != tf.metadata.MemberEnd()) {
+  auto it = tf.metadata().FindMember("metadata");
+  if (it != tf.metadata().MemberEnd()) {
     if (!it->value.IsObject()) throw std::runtime_error("data file metadata should be object");
 
     impl->has_metadata = true;
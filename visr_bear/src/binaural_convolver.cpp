@@ -0,0 +1,261 @@
+#include "binaural_convolver.hpp"
+
+#include <algorithm>
+#include <libvisr/constants.hpp>
+#include <stdexcept>
+
+#include "fft_cache.hpp"
+#include "fft_utils.hpp"
+
+namespace bear {
+
+BinauralConvolver::BinauralConvolver(const SignalFlowContext &ctx,
+                                     const char *name,
+                                     CompositeComponent *parent,
+                                     std::size_t num_inputs_,
+                                     std::size_t filter_length_,
+                                     std::size_t max_filters,
+                                     const efl::BasicMatrix<SampleType> &filters,
+                                     const rbbl::InterpolationParameterSet &initial_interpolants,
+                                     const rbbl::FilterRoutingList &routing_list,
+                                     bool filter_input_,
+                                     const std::string &fft_implementation_)
+    : AtomicComponent(ctx, name, parent),
+      num_inputs(num_inputs_),
+      filter_length(filter_length_),
+      num_partitions((filter_length_ + period() - 1) / period()),
+      in("in", *this, num_inputs_),
+      out("out", *this, 2),
+      interpolant_input("interpolantInput", *this, pml::EmptyParameterConfig()),
+      filter_input(filter_input_
+                       ? std::make_unique<ParameterInput<pml::MessageQueueProtocol, FilterParameter>>(
+                             "filterInput", *this, pml::EmptyParameterConfig())
+                       : nullptr),
+      fft_implementation(resolve_fft_implementation(fft_implementation_, 2 * period())),
+      fft(get_cached_fft(fft_implementation, 2 * period())),
+      fft_scale(overlap_save_scale(*fft, period())),
+      filter_spectra(max_filters * num_partitions, period() + 1, cVectorAlignmentSamples),
+      input_spectra(num_inputs_ * num_partitions, period() + 1, cVectorAlignmentSamples),
+      last_input(num_inputs_, period(), cVectorAlignmentSamples),
+      acc(4, period() + 1, cVectorAlignmentSamples),
+      time_buf(1, 2 * period(), cVectorAlignmentSamples),
+      previous_out(1, period(), cVectorAlignmentSamples)
+{
+  filter_spectra.zeroFill();
+  input_spectra.zeroFill();
+  last_input.zeroFill();
+
+  if (filters.numberOfRows() > max_filters)
+    throw std::invalid_argument("BinauralConvolver: more initial filters than max_filters");
+  for (std::size_t i = 0; i < filters.numberOfRows(); i++)
+    set_filter(i, filters.row(i), filters.numberOfColumns());
+
+  for (const rbbl::FilterRouting &routing : routing_list) {
+    if (routing.inputIndex >= num_inputs)
+      throw std::invalid_argument("BinauralConvolver: routing input out of range");
+    if (routing.outputIndex >= 2)
+      throw std::invalid_argument("BinauralConvolver: routing output out of range");
+
+    // the interpolant id is the routing's filter index
+    if (routing.filterIndex >= routings.size()) routings.resize(routing.filterIndex + 1);
+    Routing &r = routings[routing.filterIndex];
+    r.input = routing.inputIndex;
+    r.output = routing.outputIndex;
+    r.gain = static_cast<SampleType>(routing.gainLinear);
+  }
+
+  for (const rbbl::InterpolationParameter &interpolant : initial_interpolants) {
+    if (!valid_interpolant(interpolant))
+      throw std::invalid_argument("BinauralConvolver: interpolant does not match a routing and filters");
+    Routing &r = routings[interpolant.id()];
+    r.current.indices.assign(interpolant.indices().begin(), interpolant.indices().end());
+    r.current.weights.assign(interpolant.weights().begin(), interpolant.weights().end());
+    // make sure that changing interpolants does not allocate
+    r.previous.indices.reserve(r.current.indices.size());
+    r.previous.weights.reserve(r.current.weights.size());
+  }
+}
+
+bool BinauralConvolver::valid_filter(std::size_t index, std::size_t length) const
+{
+  return index * num_partitions < filter_spectra.numberOfRows() && length <= filter_length;
+}
+
+template <typename Parameter>
+bool BinauralConvolver::valid_interpolant(const Parameter &interpolant) const
+{
+  if (interpolant.id() >= routings.size()) return false;
+  if (interpolant.indices().size() != interpolant.weights().size()) return false;
+  for (std::size_t index : interpolant.indices())
+    if (index * num_partitions >= filter_spectra.numberOfRows()) return false;
+  return true;
+}
+
+void BinauralConvolver::set_filter(std::size_t index, const SampleType *filter, std::size_t length)
+{
+  if (index * num_partitions >= filter_spectra.numberOfRows())
+    throw std::invalid_argument("BinauralConvolver: filter index out of range");
+  if (length > filter_length) throw std::invalid_argument("BinauralConvolver: filter is too long");
+
+  for (std::size_t partition = 0; partition < num_partitions; partition++)
+    transform_filter_partition(*fft,
+                               filter,
+                               length,
+                               period(),
+                               partition,
+                               fft_scale,
+                               time_buf.row(0),
+                               filter_spectra.row(index * num_partitions + partition));
+}
+
+BinauralConvolver::FilterTransform BinauralConvolver::make_filter_transform() const
+{
+  // the transform runs on another thread, so needs its own FFT and buffer,
+  // and copies of everything else it uses
+  std::shared_ptr<rbbl::FftWrapperBase<SampleType>> transform_fft =
+      get_cached_fft(fft_implementation, 2 * period());
+  auto time = std::make_shared<efl::BasicMatrix<SampleType>>(1, 2 * period(), cVectorAlignmentSamples);
+  std::size_t B = period(), partitions = num_partitions, max_length = filter_length;
+  SampleType scale = fft_scale;
+
+  return [transform_fft, time, B, partitions, max_length, scale](const SampleType *filter,
+                                                                 std::size_t length) {
+    if (length > max_length) throw std::invalid_argument("BinauralConvolver: filter is too long");
+
+    auto spectra = std::make_unique<FilterSpectra>(partitions, B + 1, cVectorAlignmentSamples);
+    for (std::size_t partition = 0; partition < partitions; partition++)
+      transform_filter_partition(
+          *transform_fft, filter, length, B, partition, scale, time->row(0), spectra->row(partition));
+    return spectra;
+  };
+}
+
+void BinauralConvolver::load_filter_spectra(std::size_t index, const FilterSpectra &spectra)
+{
+  for (std::size_t partition = 0; partition < num_partitions; partition++)
+    std::copy(spectra.row(partition),
+              spectra.row(partition) + period() + 1,
+              filter_spectra.row(index * num_partitions + partition));
+}
+
+void BinauralConvolver::accumulate(const Routing &routing,
+                                   const Interpolant &interpolant,
+                                   SampleType *acc_row)
+{
+  for (std::size_t i = 0; i < interpolant.indices.size(); i++) {
+    SampleType weight = interpolant.weights[i] * routing.gain;
+    if (weight == 0.0f) continue;
+
+    std::size_t filter = interpolant.indices[i];
+    for (std::size_t partition = 0; partition < num_partitions; partition++) {
+      std::size_t input_partition = (spectrum_pos + num_partitions - partition) % num_partitions;
+      const std::complex<SampleType> *x = input_spectra.row(routing.input * num_partitions + input_partition);
+      const std::complex<SampleType> *h = filter_spectra.row(filter * num_partitions + partition);
+      complex_mac(acc_row,
+                  reinterpret_cast<const SampleType *>(x),
+                  reinterpret_cast<const SampleType *>(h),
+                  weight,
+                  period() + 1);
+    }
+  }
+}
+
+void BinauralConvolver::inverse_transform(std::complex<SampleType> *acc_row)
+{
+  check_fft(fft->inverseTransform(acc_row, time_buf.row(0)));
+}
+
+void BinauralConvolver::process()
+{
+  const std::size_t B = period();
+
+  if (filter_input) {
+    while (!filter_input->empty()) {
+      const FilterParameter &filter = filter_input->front();
+      if (valid_filter(filter.index(), filter.value().size()))
+        set_filter(filter.index(), filter.value().data(), filter.value().size());
+      filter_input->pop();
+    }
+  }
+
+  // invalid messages are dropped rather than throwing on the audio thread;
+  // BRIRInterpolationController only sends valid ones
+  while (!interpolant_input.empty()) {
+    const pml::InterpolationParameter &interpolant = interpolant_input.front();
+    if (!valid_interpolant(interpolant)) {
+      interpolant_input.pop();
+      continue;
+    }
+    Routing &r = routings[interpolant.id()];
+
+    // if there are several changes in one period, fade from the filters which
+    // were last used
+    if (!r.transitioning) {
+      r.previous.indices.assign(r.current.indices.begin(), r.current.indices.end());
+      r.previous.weights.assign(r.current.weights.begin(), r.current.weights.end());
+      r.transitioning = true;
+    }
+    r.current.indices.assign(interpolant.indices().begin(), interpolant.indices().end());
+    r.current.weights.assign(interpolant.weights().begin(), interpolant.weights().end());
+
+    interpolant_input.pop();
+  }
+
+  // transform inputs
+  for (std::size_t input = 0; input < num_inputs; input++) {
+    const SampleType *in_block = in.at(input);
+    std::copy(last_input.row(input), last_input.row(input) + B, time_buf.row(0));
+    std::copy(in_block, in_block + B, time_buf.row(0) + B);
+    std::copy(in_block, in_block + B, last_input.row(input));
+
+    check_fft(
+        fft->forwardTransform(time_buf.row(0), input_spectra.row(input * num_partitions + spectrum_pos)));
+  }
+
+  auto acc_row = [&](std::size_t row) { return reinterpret_cast<SampleType *>(acc.row(row)); };
+  for (std::size_t row = 0; row < 2; row++) std::fill(acc_row(row), acc_row(row) + 2 * (B + 1), 0.0f);
+
+  // routings which are not changing contribute equally to the old and new
+  // outputs, so accumulate them first
+  bool any_transitioning = false;
+  for (const Routing &r : routings) {
+    if (r.transitioning)
+      any_transitioning = true;
+    else
+      accumulate(r, r.current, acc_row(r.output));
+  }
+
+  if (any_transitioning) {
+    for (std::size_t row = 0; row < 2; row++)
+      std::copy(acc_row(row), acc_row(row) + 2 * (B + 1), acc_row(row + 2));
+
+    for (const Routing &r : routings)
+      if (r.transitioning) {
+        accumulate(r, r.current, acc_row(r.output));
+        accumulate(r, r.previous, acc_row(r.output + 2));
+      }
+  }
+
+  for (std::size_t ear = 0; ear < 2; ear++) {
+    SampleType *out_block = out.at(ear);
+
+    inverse_transform(acc.row(ear));
+    std::copy(time_buf.row(0) + B, time_buf.row(0) + 2 * B, out_block);
+
+    if (any_transitioning) {
+      inverse_transform(acc.row(ear + 2));
+      std::copy(time_buf.row(0) + B, time_buf.row(0) + 2 * B, previous_out.row(0));
+
+      const SampleType *old_block = previous_out.row(0);
+      for (std::size_t i = 0; i < B; i++) {
+        SampleType ramp = static_cast<SampleType>(i + 1) / static_cast<SampleType>(B);
+        out_block[i] = old_block[i] + ramp * (out_block[i] - old_block[i]);
+      }
+    }
+  }
+
+  for (Routing &r : routings) r.transitioning = false;
+  spectrum_pos = (spectrum_pos + 1) % num_partitions;
+}
+
+}  // namespace bear
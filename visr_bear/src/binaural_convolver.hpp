@@ -0,0 +1,140 @@
+#pragma once
+#include <complex>
+#include <functional>
+#include <libefl/basic_matrix.hpp>
+#include <libpml/indexed_value_parameter.hpp>
+#include <libpml/interpolation_parameter.hpp>
+#include <libpml/message_queue_protocol.hpp>
+#include <librbbl/fft_wrapper_base.hpp>
+#include <librbbl/filter_routing.hpp>
+#include <librbbl/interpolation_parameter.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/audio_input.hpp>
+#include <libvisr/audio_output.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bear {
+using namespace visr;
+
+/// Many-to-two convolver for the BRIRs; a replacement for
+/// rcl::InterpolatingFirFilterMatrix for the case where every input is
+/// routed to one of two outputs, with the same ports (in, out,
+/// interpolantInput and optionally filterInput).
+///
+/// This uses uniformly-partitioned convolution with a partition size of one
+/// period, like InterpolatingFirFilterMatrix, but the products of the input
+/// and filter spectra are accumulated per output in the frequency domain, so
+/// each period needs one forward FFT per input and only two inverse FFTs.
+///
+/// When an interpolant changes, the outputs are computed with the old and new
+/// filters and crossfaded over one period; only the routings which changed
+/// are computed twice, and four inverse FFTs are needed in that period.
+class BinauralConvolver : public AtomicComponent {
+ public:
+  using FilterParameter = pml::IndexedValueParameter<std::size_t, std::vector<SampleType>>;
+  /// the spectra of one filter, with one row of period() + 1 bins per
+  /// partition
+  using FilterSpectra = efl::BasicMatrix<std::complex<SampleType>>;
+  using FilterTransform = std::function<std::unique_ptr<FilterSpectra>(const SampleType *, std::size_t)>;
+
+  /// routings maps each input to an output (0 or 1), with the filterIndex
+  /// being the interpolant id for that routing; filters has max_filters rows
+  /// of length filter_length, and the interpolants select (weighted sums of)
+  /// filters for each routing
+  explicit BinauralConvolver(const SignalFlowContext &ctx,
+                             const char *name,
+                             CompositeComponent *parent,
+                             std::size_t num_inputs,
+                             std::size_t filter_length,
+                             std::size_t max_filters,
+                             const efl::BasicMatrix<SampleType> &filters,
+                             const rbbl::InterpolationParameterSet &initial_interpolants,
+                             const rbbl::FilterRoutingList &routings,
+                             bool filter_input,
+                             const std::string &fft_implementation);
+
+  void process() override;
+
+  /// make a function which calculates the spectra of a filter for
+  /// load_filter_spectra; it has its own FFT, so can be used on another
+  /// thread (but only one at a time)
+  FilterTransform make_filter_transform() const;
+
+  /// replace the filter at index with spectra from a FilterTransform; this
+  /// only copies, so it is cheap enough to use on the audio thread before
+  /// process, as an alternative to filterInput
+  void load_filter_spectra(std::size_t index, const FilterSpectra &spectra);
+
+ private:
+  struct Interpolant {
+    std::vector<std::size_t> indices;
+    std::vector<SampleType> weights;
+  };
+
+  /// routings are indexed by interpolant id; ids without a routing have zero
+  /// gain
+  struct Routing {
+    std::size_t input = 0;
+    std::size_t output = 0;
+    SampleType gain = 0.0f;
+    Interpolant current;
+    /// interpolant before the last change; only used while transitioning
+    Interpolant previous;
+    bool transitioning = false;
+  };
+
+  /// can a filter with this index and length be loaded?
+  bool valid_filter(std::size_t index, std::size_t length) const;
+  /// does an interpolant refer to a routing and existing filters? this is
+  /// used for rbbl and pml InterpolationParameters
+  template <typename Parameter>
+  bool valid_interpolant(const Parameter &interpolant) const;
+
+  /// calculate the spectra of filter index from filter_length samples
+  void set_filter(std::size_t index, const SampleType *filter, std::size_t length);
+
+  /// acc += sum over partitions and interpolants of input spectra * filter
+  /// spectra for one routing
+  void accumulate(const Routing &routing, const Interpolant &interpolant, SampleType *acc);
+
+  /// inverse transform acc into the second half of time_buf
+  void inverse_transform(std::complex<SampleType> *acc);
+
+  std::size_t num_inputs;
+  std::size_t filter_length;
+  std::size_t num_partitions;
+
+  AudioInput in;
+  AudioOutput out;
+  ParameterInput<pml::MessageQueueProtocol, pml::InterpolationParameter> interpolant_input;
+  std::unique_ptr<ParameterInput<pml::MessageQueueProtocol, FilterParameter>> filter_input;
+
+  /// resolved name of the FFT implementation
+  std::string fft_implementation;
+  /// from the FFT cache
+  std::shared_ptr<rbbl::FftWrapperBase<SampleType>> fft;
+  /// scale folded into the filter spectra to correct for the FFT scaling
+  SampleType fft_scale;
+
+  std::vector<Routing> routings;
+
+  /// filter spectra; row filter * num_partitions + partition
+  efl::BasicMatrix<std::complex<SampleType>> filter_spectra;
+  /// spectra of the last num_partitions input blocks; row
+  /// input * num_partitions + partition, with partition offset by
+  /// spectrum_pos
+  efl::BasicMatrix<std::complex<SampleType>> input_spectra;
+  std::size_t spectrum_pos = 0;
+  efl::BasicMatrix<SampleType> last_input;
+
+  /// accumulators for each output: rows 0 and 1 are the current filters,
+  /// and rows 2 and 3 are the previous filters during transitions
+  efl::BasicMatrix<std::complex<SampleType>> acc;
+  efl::BasicMatrix<SampleType> time_buf;
+  efl::BasicMatrix<SampleType> previous_out;
+};
+
+}  // namespace bear
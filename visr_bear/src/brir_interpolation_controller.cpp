@@ -1,29 +1,60 @@
 #include "brir_interpolation_controller.hpp"
 
 namespace bear {
+
 BRIRInterpolationController::BRIRInterpolationController(const SignalFlowContext &ctx,
                                                          const char *name,
                                                          CompositeComponent *parent,
-                                                         const ConfigImpl &,
-                                                         std::shared_ptr<Panner> panner_)
+                                                         const ConfigImpl &config,
+                                                         std::shared_ptr<Panner> panner_,
+                                                         BinauralConvolver *binaural_convolver_)
     : AtomicComponent(ctx, name, parent),
       panner(std::move(panner_)),
       convolver_index(panner->num_virtual_loudspeakers(), 2u),
-      brir_index(panner->num_views(), panner->num_virtual_loudspeakers(), 2u),
+      brir_index(num_brir_slots(config, *panner), panner->num_virtual_loudspeakers(), 2u),
       brir_index_in("brir_index_in", *this, pml::EmptyParameterConfig()),
-      interpolants_out("interpolants_out", *this, InterpolationParameterConfig(1))
+      interpolants_out("interpolants_out", *this, InterpolationParameterConfig(1)),
+      binaural_convolver(binaural_convolver_)
 {
+  size_t num_slots = num_brir_slots(config, *panner);
+  size_t brir_length = brir_render_length(config, panner->brir_length());
+  if (num_slots < panner->num_views()) {
+    // the generic convolver would have to be sent filters as messages, which
+    // allocates, and transforms them on the audio thread
+    bear_assert(binaural_convolver != nullptr, "BRIR view cache requires the binaural convolver");
+    // loading spectra is just a copy, so load a whole view per period
+    view_cache = std::make_unique<BRIRViewCache>(panner,
+                                                 num_slots,
+                                                 brir_length,
+                                                 2 * panner->num_virtual_loudspeakers(),
+                                                 binaural_convolver->make_filter_transform());
+  }
 }
 
 void BRIRInterpolationController::process()
 {
   if (brir_index_in.changed()) {
-    unsigned int idx = brir_index_in.data().value();
-    for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++)
-      for (size_t ear = 0; ear < 2; ear++)
-        interpolants_out.enqueue(
-            pml::InterpolationParameter(convolver_index(vs, ear), {brir_index(idx, vs, ear)}, {1.0f}));
+    requested_view = brir_index_in.data().value();
     brir_index_in.resetChanged();
+
+    if (!view_cache) switch_to(requested_view);
+  }
+
+  if (view_cache) {
+    auto load_filter = [&](const BRIRViewCache::Filter &filter) {
+      binaural_convolver->load_filter_spectra(filter.index, *filter.spectra);
+    };
+    boost::optional<size_t> slot = view_cache->update(requested_view, load_filter);
+
+    if (slot && *slot != active_slot) switch_to(*slot);
   }
 }
+void BRIRInterpolationController::switch_to(size_t slot)
+{
+  for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++)
+    for (size_t ear = 0; ear < 2; ear++)
+      interpolants_out.enqueue(
+          pml::InterpolationParameter(convolver_index(vs, ear), {brir_index(slot, vs, ear)}, {1.0f}));
+  active_slot = slot;
+}
 }  // namespace bear
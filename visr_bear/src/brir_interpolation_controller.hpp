@@ -9,6 +9,8 @@
 #include <memory>
 
 #include "bear/api.hpp"
+#include "binaural_convolver.hpp"
+#include "brir_view_cache.hpp"
 #include "panner.hpp"
 #include "utils.hpp"
 
@@ -16,21 +18,37 @@ namespace bear {
 using namespace visr;
 using namespace visr::pml;
 
+/// Switches the BRIR convolver to the selected view.
+///
+/// If the convolver does not hold all views (see num_brir_slots), the views
+/// are paged in using a BRIRViewCache, and the switch happens once the
+/// requested view is resident. This needs a BinauralConvolver (see
+/// Config::validate): the filter spectra are calculated on the cache thread
+/// and loaded into the convolver directly (so this must run before it, which
+/// is ensured by interpolants_out), a view per period.
 class BRIRInterpolationController : public AtomicComponent {
  public:
   explicit BRIRInterpolationController(const SignalFlowContext &ctx,
                                        const char *name,
                                        CompositeComponent *parent,
                                        const ConfigImpl &config,
-                                       std::shared_ptr<Panner> panner);
+                                       std::shared_ptr<Panner> panner,
+                                       BinauralConvolver *binaural_convolver = nullptr);
 
   void process() override;
 
  private:
+  void switch_to(size_t slot);
+
   std::shared_ptr<Panner> panner;
   Indexer<2> convolver_index;
   Indexer<3> brir_index;
   ParameterInput<DoubleBufferingProtocol, ScalarParameter<unsigned int>> brir_index_in;
   ParameterOutput<MessageQueueProtocol, InterpolationParameter> interpolants_out;
+
+  BinauralConvolver *binaural_convolver;
+  std::unique_ptr<BRIRViewCache> view_cache;
+  size_t requested_view = 0;
+  size_t active_slot = 0;
 };
 }  // namespace bear
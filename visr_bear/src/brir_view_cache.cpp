@@ -0,0 +1,167 @@
+#include "brir_view_cache.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace bear {
+
+BRIRViewCache::BRIRViewCache(std::shared_ptr<Panner> panner_,
+                             size_t num_slots,
+                             size_t brir_length_,
+                             size_t max_filters_per_update_,
+                             Transform transform_)
+    : panner(std::move(panner_)),
+      brir_length(brir_length_),
+      max_filters_per_update(max_filters_per_update_),
+      transform(std::move(transform_)),
+      brir_index(num_slots, panner->num_virtual_loudspeakers(), 2u),
+      slots(num_slots)
+{
+  bear_assert(num_slots >= 2, "BRIR view cache must have at least two slots");
+  bear_assert(num_slots <= panner->num_views(), "BRIR view cache has more slots than views");
+  bear_assert(max_filters_per_update > 0, "BRIR view cache must load at least one filter per update");
+  bear_assert(static_cast<bool>(transform), "BRIR view cache needs a transform");
+
+  Eigen::MatrixX3d views = panner->get_views().rowwise().normalized();
+  for (size_t view = 0; view < panner->num_views(); view++) {
+    Eigen::VectorXd similarity = views * views.row(view).transpose();
+
+    std::vector<size_t> others;
+    for (size_t other = 0; other < panner->num_views(); other++)
+      if (other != view) others.push_back(other);
+
+    std::stable_sort(others.begin(), others.end(), [&](size_t a, size_t b) {
+      return similarity(a) > similarity(b);
+    });
+    neighbours.push_back(std::move(others));
+  }
+
+  // the convolver is initialised with the first views
+  for (size_t slot = 0; slot < num_slots; slot++) {
+    slots[slot].state = SlotState::RESIDENT;
+    slots[slot].view = slot;
+  }
+
+  thread = std::thread(&BRIRViewCache::thread_fn, this);
+}
+
+BRIRViewCache::~BRIRViewCache()
+{
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    should_exit = true;
+    cv.notify_one();
+  }
+
+  thread.join();
+}
+
+boost::optional<size_t> BRIRViewCache::slot_containing(size_t view) const
+{
+  for (size_t i = 0; i < slots.size(); i++)
+    if (slots[i].state != SlotState::EMPTY && slots[i].view == view) return i;
+  return boost::none;
+}
+
+boost::optional<size_t> BRIRViewCache::find_free_slot(size_t view)
+{
+  boost::optional<size_t> best;
+  for (size_t i = 0; i < slots.size(); i++) {
+    const Slot &slot = slots[i];
+    if (slot.state != SlotState::EMPTY && (slot.view == active_view || slot.view == view)) continue;
+
+    if (slot.state == SlotState::EMPTY) return i;
+    if (!best || slot.last_used < slots[*best].last_used) best = i;
+  }
+  return best;
+}
+
+void BRIRViewCache::request(size_t view)
+{
+  auto ensure_loaded = [&](size_t v) {
+    boost::optional<size_t> slot_idx = slot_containing(v);
+    if (!slot_idx) {
+      slot_idx = find_free_slot(view);
+      if (!slot_idx) return;
+
+      Slot &slot = slots[*slot_idx];
+      slot.state = SlotState::LOADING;
+      slot.view = v;
+      slot.generation++;
+    }
+    slots[*slot_idx].last_used = ++use_counter;
+  };
+
+  ensure_loaded(view);
+
+  // leave one slot for the active view, and one for the requested view
+  for (size_t i = 0; i < neighbours[view].size() && i + 2 < slots.size(); i++)
+    ensure_loaded(neighbours[view][i]);
+
+  cv.notify_one();
+}
+
+void BRIRViewCache::thread_fn()
+{
+  std::unique_lock<std::mutex> lk(mut);
+
+  auto is_loading = [](const Slot &slot) { return slot.state == SlotState::LOADING; };
+  auto needs_free = [](const Slot &slot) {
+    return (slot.state == SlotState::SENT || slot.state == SlotState::RESIDENT) && !slot.filters.empty();
+  };
+
+  while (true) {
+    cv.wait(lk, [&]() {
+      return should_exit || std::any_of(slots.begin(), slots.end(), is_loading) ||
+             std::any_of(slots.begin(), slots.end(), needs_free);
+    });
+
+    if (should_exit) return;
+
+    // filters which have been sent are freed here rather than on the audio
+    // thread
+    std::vector<std::vector<Filter>> to_free;
+    for (auto &slot : slots)
+      if (needs_free(slot)) to_free.push_back(std::move(slot.filters));
+
+    auto loading_it = std::find_if(slots.begin(), slots.end(), is_loading);
+    if (loading_it == slots.end()) {
+      lk.unlock();
+      to_free.clear();
+      lk.lock();
+      continue;
+    }
+
+    size_t slot_idx = loading_it - slots.begin();
+    size_t view = loading_it->view;
+    size_t generation = loading_it->generation;
+
+    // copying the filters may page them in from the data file, so don't hold
+    // the lock while doing it
+    lk.unlock();
+    to_free.clear();
+
+    std::vector<Filter> filters(2 * panner->num_virtual_loudspeakers());
+    std::vector<visr::SampleType> samples(brir_length);
+    for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++)
+      for (size_t ear = 0; ear < 2; ear++) {
+        const float *brir = panner->get_brir(view, vs, ear);
+        Filter &filter = filters[vs * 2 + ear];
+        filter.index = brir_index(slot_idx, vs, ear);
+        truncate_brir(brir, panner->brir_length(), brir_length, samples.data());
+        filter.spectra = transform(samples.data(), brir_length);
+      }
+
+    lk.lock();
+
+    // the slot may have been re-assigned while loading
+    Slot &slot = slots[slot_idx];
+    if (slot.state == SlotState::LOADING && slot.generation == generation) {
+      slot.filters = std::move(filters);
+      slot.num_sent = 0;
+      slot.state = SlotState::LOADED;
+    }
+  }
+}
+
+}  // namespace bear
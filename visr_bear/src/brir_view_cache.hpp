@@ -0,0 +1,172 @@
+#pragma once
+#include <boost/optional.hpp>
+#include <complex>
+#include <condition_variable>
+#include <functional>
+#include <libefl/basic_matrix.hpp>
+#include <libvisr/constants.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "panner.hpp"
+#include "utils.hpp"
+
+namespace bear {
+
+/// number of views held in the BRIR convolver; if this is less than the
+/// number of views in the BRIR set, a BRIRViewCache is needed to page views
+/// in and out
+inline size_t num_brir_slots(const ConfigImpl &config, const Panner &panner)
+{
+  if (config.brir_view_cache_size == 0 || config.brir_view_cache_size >= panner.num_views())
+    return panner.num_views();
+  else
+    return config.brir_view_cache_size;
+}
+
+// design notes:
+// - the BRIR convolver holds a fixed number of slots, each containing the
+//   filters for one view; this class decides which view lives in which slot
+// - copying the filters for a view out of the data file may cause page faults,
+//   so it happens on a background thread, which also transforms them to the
+//   spectra used by BinauralConvolver, so that the audio thread only copies
+// - all methods used on the audio thread only try to take the lock, like
+//   ConstructorThread, so the worst case is that a view switch is delayed by
+//   a period
+// - filters can be handed over a few at a time, to limit the time spent
+//   copying in one period
+
+/// Pages views of a BRIR set into a fixed number of convolver slots on demand,
+/// so that the whole BRIR set does not need to be resident at once.
+///
+/// Whenever a view is requested, its nearest neighbours are loaded too, so
+/// that they are likely to be resident by the time the listener turns towards
+/// them.
+class BRIRViewCache {
+ public:
+  using FilterSpectra = visr::efl::BasicMatrix<std::complex<visr::SampleType>>;
+  /// converts a filter (of the given length) on the background thread
+  using Transform =
+      std::function<std::unique_ptr<FilterSpectra>(const visr::SampleType *filter, std::size_t length)>;
+
+  /// a filter to be loaded into the convolver
+  struct Filter {
+    std::size_t index;
+    std::unique_ptr<FilterSpectra> spectra;
+  };
+
+  /// num_slots views are held in the convolver; slot i initially contains
+  /// view i, and filters are numbered brir_index(slot, virtual loudspeaker,
+  /// ear), with brir_index as in DSP; filters are truncated to brir_length
+  ///
+  /// at most max_filters_per_update filters are passed to load_filter in each
+  /// call to update; transform is applied to each filter on the background
+  /// thread
+  BRIRViewCache(std::shared_ptr<Panner> panner,
+                size_t num_slots,
+                size_t brir_length,
+                size_t max_filters_per_update,
+                Transform transform);
+  ~BRIRViewCache();
+
+  BRIRViewCache(const BRIRViewCache &) = delete;
+  BRIRViewCache &operator=(const BRIRViewCache &) = delete;
+
+  /// Called once per period on the audio thread with the view which should be
+  /// rendered.
+  ///
+  /// Filters which have finished loading are passed to load_filter (with a
+  /// const Filter &, which is only valid during the call), and the slot
+  /// containing view is returned once all of its filters were passed to
+  /// load_filter in a previous call. This never blocks or allocates, and
+  /// returns boost::none if the view is not yet available.
+  template <typename LoadFilter>
+  boost::optional<size_t> update(size_t view, LoadFilter load_filter);
+
+  size_t num_slots() const { return slots.size(); }
+
+ private:
+  enum class SlotState { EMPTY, LOADING, LOADED, SENT, RESIDENT };
+
+  struct Slot {
+    SlotState state = SlotState::EMPTY;
+    size_t view = 0;
+    size_t last_used = 0;
+    /// incremented whenever the slot is re-assigned, so that the thread can
+    /// tell if a slot was re-used while it was loading
+    size_t generation = 0;
+    std::vector<Filter> filters;
+    /// number of filters passed to load_filter while LOADED
+    size_t num_sent = 0;
+  };
+
+  /// make sure that view and its neighbours are in a slot or being loaded;
+  /// must be called with mut held
+  void request(size_t view);
+  /// find a slot to load a view into, not evicting the active view or view
+  boost::optional<size_t> find_free_slot(size_t view);
+  boost::optional<size_t> slot_containing(size_t view) const;
+
+  void thread_fn();
+
+  std::shared_ptr<Panner> panner;
+  size_t brir_length;
+  size_t max_filters_per_update;
+  Transform transform;
+  Indexer<3> brir_index;
+  /// for each view, the other views sorted by decreasing similarity
+  std::vector<std::vector<size_t>> neighbours;
+
+  std::mutex mut;  // everything below is protected by this
+  std::condition_variable cv;
+
+  std::vector<Slot> slots;
+  size_t active_view = 0;
+  boost::optional<size_t> requested_view;
+  size_t use_counter = 0;
+
+  bool should_exit = false;
+
+  std::thread thread;
+};
+
+template <typename LoadFilter>
+boost::optional<size_t> BRIRViewCache::update(size_t view, LoadFilter load_filter)
+{
+  std::unique_lock<std::mutex> lk(mut, std::try_to_lock);
+  if (!lk) return boost::none;
+
+  size_t filters_remaining = max_filters_per_update;
+  for (auto &slot : slots) {
+    if (slot.state == SlotState::SENT)
+      slot.state = SlotState::RESIDENT;
+    else if (slot.state == SlotState::LOADED) {
+      for (; slot.num_sent < slot.filters.size() && filters_remaining > 0; filters_remaining--)
+        load_filter(slot.filters[slot.num_sent++]);
+
+      if (slot.num_sent == slot.filters.size()) {
+        // filters are freed on the thread
+        slot.state = SlotState::SENT;
+        cv.notify_one();
+      }
+    }
+  }
+
+  if (requested_view != view) {
+    request(view);
+    requested_view = view;
+  }
+
+  boost::optional<size_t> slot_idx = slot_containing(view);
+  if (slot_idx && slots[*slot_idx].state == SlotState::RESIDENT) {
+    active_view = view;
+    slots[*slot_idx].last_used = ++use_counter;
+    return slot_idx;
+  } else
+    return boost::none;
+}
+
+}  // namespace bear
@@ -0,0 +1,46 @@
+#include "cluster_mix.hpp"
+
+#include <algorithm>
+
+namespace bear {
+ClusterMix::ClusterMix(const SignalFlowContext &ctx,
+                       const char *name,
+                       CompositeComponent *parent,
+                       std::size_t num_inputs_,
+                       std::size_t num_outputs_)
+    : AtomicComponent(ctx, name, parent),
+      num_inputs(num_inputs_),
+      num_outputs(num_outputs_),
+      in("in", *this, num_inputs_),
+      out("out", *this, num_outputs_),
+      gains_in("gains_in", *this, pml::MatrixParameterConfig(num_outputs_, num_inputs_)),
+      last_gains(num_inputs_ * num_outputs_, 0.0f)
+{
+}
+
+void ClusterMix::process()
+{
+  const size_t B = period();
+
+  for (size_t output = 0; output < num_outputs; output++) {
+    SampleType *out_p = out.at(output);
+    std::fill_n(out_p, B, 0.0f);
+
+    for (size_t input = 0; input < num_inputs; input++) {
+      float &last_gain = last_gains[output * num_inputs + input];
+      float gain = gains_in.data()(output, input);
+      if (gain == 0.0f && last_gain == 0.0f) continue;
+
+      const SampleType *in_p = in.at(input);
+      if (gain == last_gain)
+        for (size_t i = 0; i < B; i++) out_p[i] += gain * in_p[i];
+      else {
+        float step = (gain - last_gain) / B;
+        for (size_t i = 0; i < B; i++) out_p[i] += (last_gain + step * (i + 1)) * in_p[i];
+        last_gain = gain;
+      }
+    }
+  }
+}
+
+}  // namespace bear
@@ -0,0 +1,41 @@
+#pragma once
+#include <libpml/matrix_parameter.hpp>
+#include <libpml/shared_data_protocol.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/audio_input.hpp>
+#include <libvisr/audio_output.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <vector>
+
+namespace bear {
+using namespace visr;
+
+/// Mixes num_inputs channels into num_outputs clusters, with gains (rows are
+/// outputs, columns are inputs) from the gains_in port; see ObjectClustering.
+///
+/// This is like rcl::GainMatrix, but the gains are expected to be sparse, so
+/// only non-zero gains are applied. When a gain changes it is ramped linearly
+/// to the new value over one period.
+class ClusterMix : public AtomicComponent {
+ public:
+  explicit ClusterMix(const SignalFlowContext &ctx,
+                      const char *name,
+                      CompositeComponent *parent,
+                      std::size_t num_inputs,
+                      std::size_t num_outputs);
+
+  void process() override;
+
+ private:
+  std::size_t num_inputs;
+  std::size_t num_outputs;
+
+  AudioInput in;
+  AudioOutput out;
+  ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>> gains_in;
+
+  /// gains at the end of the last period, index output * num_inputs + input
+  std::vector<float> last_gains;
+};
+
+}  // namespace bear
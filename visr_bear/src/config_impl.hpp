@@ -1,8 +1,11 @@
 #pragma once
 #include <cstddef>
+#include <memory>
 #include <string>
 
 namespace bear {
+class PannerCache;
+
 struct ConfigImpl {
   size_t num_objects_channels = 0;
   size_t num_direct_speakers_channels = 0;
@@ -11,5 +14,24 @@ struct ConfigImpl {
   size_t sample_rate = 48000;
   std::string data_path = "";
   std::string fft_implementation = "default";
+  size_t brir_view_cache_size = 0;
+  double listener_update_rate = 0.0;
+  double listener_orientation_hysteresis = 0.0;
+  double listener_position_hysteresis = 0.0;
+  int max_hoa_order = -1;
+  bool binaural_convolver = false;
+  std::string data_file_advice = "normal";
+  bool data_file_huge_pages = false;
+  bool data_file_lock = false;
+  bool data_file_prefault = false;
+  size_t max_brir_length = 0;
+  bool enable_gain_norm = true;
+  bool enable_extent = true;
+  size_t max_object_clusters = 0;
+  size_t memory_budget = 0;
+  bool adapt_to_memory_budget = false;
+  /// if set, the Panner is shared with other renderers using the same cache;
+  /// this is not exposed in Config, and is used by the render service
+  std::shared_ptr<PannerCache> panner_cache;
 };
 };  // namespace bear
@@ -1,9 +1,29 @@
 #include "constructor_thread.hpp"
 
+#include <vector>
+
 #include "config_impl.hpp"
 
 namespace bear {
 
+namespace {
+  /// process renderer with silent input for its preroll length
+  void preroll_renderer(Renderer &renderer, const ConfigImpl &config)
+  {
+    std::vector<Sample> zeros(config.period_size, 0.0f);
+    std::vector<const Sample *> objects_input(config.num_objects_channels, zeros.data());
+    std::vector<const Sample *> direct_speakers_input(config.num_direct_speakers_channels, zeros.data());
+    std::vector<const Sample *> hoa_input(config.num_hoa_channels, zeros.data());
+
+    std::vector<Sample> output(2 * config.period_size);
+    Sample *output_p[2] = {output.data(), output.data() + config.period_size};
+
+    size_t num_periods = (renderer.get_preroll_samples() + config.period_size - 1) / config.period_size;
+    for (size_t i = 0; i < num_periods; i++)
+      renderer.process(objects_input.data(), direct_speakers_input.data(), hoa_input.data(), output_p);
+  }
+}  // namespace
+
 ConstructorThread::ConstructorThread() : thread(&ConstructorThread::thread_fn, this) {}
 
 ConstructorThread::~ConstructorThread()
@@ -21,13 +41,13 @@ ConstructorThread::~ConstructorThread()
 ///
 /// This does not block -- it will return true if it was successful, and you
 /// should try again later if it returns false.
-bool ConstructorThread::start(const ConfigImpl &config)
+bool ConstructorThread::start(std::shared_ptr<const ConfigImpl> config, bool preroll)
 {
   std::unique_lock<std::mutex> lk(mut, std::try_to_lock);
 
   if (lk) {
-    next_config.get_impl() = config;
-    next_config_set = true;
+    next_config = std::move(config);
+    next_preroll = preroll;
     // ensure that a call to get_result or get_construction_error immediately
     // after doesn't retrieve an old result
     result_set = false;
@@ -39,7 +59,10 @@ bool ConstructorThread::start(const ConfigImpl &config)
     return false;
 }
 
-bool ConstructorThread::start(const Config &config) { return start(config.get_impl()); }
+bool ConstructorThread::start(const Config &config, bool preroll)
+{
+  return start(std::make_shared<const ConfigImpl>(config.get_impl()), preroll);
+}
 
 /// Get the result of a previous call to start.
 ///
@@ -57,7 +80,7 @@ boost::optional<Renderer> ConstructorThread::get_result()
     return boost::none;
 }
 
-bool ConstructorThread::try_swap_result(boost::optional<Renderer> &to_swap)
+bool ConstructorThread::try_swap_result(boost::optional<Renderer> &to_swap, bool *prerolled)
 {
   std::unique_lock<std::mutex> lk(mut, std::try_to_lock);
 
@@ -69,6 +92,21 @@ bool ConstructorThread::try_swap_result(boost::optional<Renderer> &to_swap)
 
     to_swap = std::move(result);
     result_set = false;
+    if (prerolled) *prerolled = result_prerolled;
+
+    cv.notify_one();
+    return true;
+  } else
+    return false;
+}
+
+bool ConstructorThread::try_destroy(Renderer &renderer)
+{
+  std::unique_lock<std::mutex> lk(mut, std::try_to_lock);
+
+  if (lk && !to_destroy_set) {
+    to_destroy = std::move(renderer);
+    to_destroy_set = true;
 
     cv.notify_one();
     return true;
@@ -88,10 +126,13 @@ std::exception_ptr ConstructorThread::get_construction_error()
 
 void ConstructorThread::thread_fn()
 {
+  // Renderer is constructed from a Config, so next_config is copied into this
+  Config config;
+
   while (true) {
     std::unique_lock<std::mutex> lk(mut);
 
-    cv.wait(lk, [&]() { return next_config_set || to_destroy_set || should_exit; });
+    cv.wait(lk, [&]() { return next_config || to_destroy_set || should_exit; });
 
     if (should_exit) return;
 
@@ -100,15 +141,18 @@ void ConstructorThread::thread_fn()
       to_destroy_set = false;
     }
 
-    if (next_config_set) {
+    if (next_config) {
+      config.get_impl() = *next_config;
+      next_config = nullptr;
+
       try {
-        result = Renderer(next_config);
+        result = Renderer(config);
+        if (next_preroll) preroll_renderer(result, config.get_impl());
+        result_prerolled = next_preroll;
         result_set = true;
       } catch (std::exception &e) {
         construction_error = std::current_exception();
       }
-
-      next_config_set = false;
     }
   }
 }
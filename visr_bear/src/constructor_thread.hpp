@@ -1,6 +1,7 @@
 #pragma once
 #include <condition_variable>
 #include <exception>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -16,6 +17,8 @@ namespace bear {
 // - mut remains locked while constructing -- we can't do anything useful in
 //   this state anyway, and it simplifies the thread code as next_config does not
 //   need to be copied
+// - the config is passed by shared_ptr so that start does not copy it, and
+//   can therefore be called on the audio thread without allocating
 
 /// Utility to construct Renderer instances on a background thread without
 /// waiting.
@@ -27,10 +30,18 @@ class ConstructorThread {
 
   /// Start the construction of a Renderer from the given Config on the thread.
   ///
+  /// If preroll is true, the renderer is then processed with silent input for
+  /// its preroll length (see Renderer::get_preroll_samples), so that the first
+  /// process calls after it is retrieved are not slowed by page faults or
+  /// cold caches, and its output is usable straight away.
+  ///
   /// This does not block -- it will return true if it was successful, and you
   /// should try again later if it returns false.
-  bool start(const Config &config);
-  bool start(const ConfigImpl &config);
+  ///
+  /// The shared_ptr overload does not allocate; config must not be modified
+  /// until construction has finished.
+  bool start(const Config &config, bool preroll = false);
+  bool start(std::shared_ptr<const ConfigImpl> config, bool preroll = false);
 
   /// Get the result of a previous call to start.
   ///
@@ -53,7 +64,16 @@ class ConstructorThread {
   /// This does not block -- if returns false and has no effect on to_swap if
   /// there's no result, or there's nowhere to store the old contents of
   /// to_swap.
-  bool try_swap_result(boost::optional<Renderer> &to_swap);
+  ///
+  /// If prerolled is not null, it is set to whether the result was prerolled
+  /// (see start).
+  bool try_swap_result(boost::optional<Renderer> &to_swap, bool *prerolled = nullptr);
+
+  /// Move renderer to the thread to be destructed.
+  ///
+  /// This does not block -- it returns false and has no effect on renderer
+  /// if the thread is busy, or is still destructing another renderer.
+  bool try_destroy(Renderer &renderer);
 
  private:
   /// function to be ran in thread
@@ -62,11 +82,12 @@ class ConstructorThread {
   std::mutex mut;  // everything below is protected by this
   std::condition_variable cv;
 
-  bool next_config_set = false;
-  Config next_config;
+  std::shared_ptr<const ConfigImpl> next_config;
+  bool next_preroll = false;
 
   bool result_set = false;
   Renderer result;
+  bool result_prerolled = false;
   std::exception_ptr construction_error;
 
   bool to_destroy_set = false;
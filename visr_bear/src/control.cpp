@@ -2,40 +2,75 @@
 
 namespace bear {
 using namespace visr;
+
+namespace {
+  bool use_gain_norm(const ConfigImpl &config, const Panner &panner)
+  {
+    return config.enable_gain_norm && panner.has_gain_compensation();
+  }
+}  // namespace
+
 Control::Control(const SignalFlowContext &ctx,
                  const char *name,
                  CompositeComponent *parent,
                  const ConfigImpl &config,
-                 std::shared_ptr<Panner> panner_)
+                 std::shared_ptr<Panner> panner_,
+                 bool external_objects_gains)
     : CompositeComponent(ctx, name, parent),
       panner(std::move(panner_)),
-      gain_calc(ctx, "gain_calc", this, config, panner),
+      listener_smoother(ctx, "listener_smoother", this, config),
+      gain_calc(external_objects_gains
+                    ? std::unique_ptr<GainCalcObjects>()
+                    : std::make_unique<GainCalcObjects>(ctx, "gain_calc", this, config, panner)),
       direct_diffuse_split(ctx, "direct_diffuse_split", this, config, panner),
       direct_delay_calc(ctx, "direct_delay_calc", this, config, panner),
       static_delay_calc(ctx, "static_delay_calc", this, config, panner),
       select_brir(ctx, "select_brir", this, config, panner),
-      gain_norm(panner->has_gain_compensation()
+      gain_norm(use_gain_norm(config, *panner)
                     ? std::make_unique<GainNorm>(ctx, "gain_norm", this, config, panner)
                     : std::unique_ptr<GainNorm>()),
+      object_clustering(use_object_clustering(config) ? std::make_unique<ObjectClustering>(
+                                                            ctx, "object_clustering", this, config, panner)
+                                                      : std::unique_ptr<ObjectClustering>()),
       direct_speakers_gain_calc(ctx, "direct_speakers_gain_calc", this, config, panner),
       direct_speakers_delay_calc(ctx, "direct_speakers_delay_calc", this, config, panner),
-      direct_speakers_gain_norm(panner->has_gain_compensation()
+      direct_speakers_gain_norm(use_gain_norm(config, *panner)
                                     ? std::make_unique<DirectSpeakersGainNorm>(
                                           ctx, "direct_speakers_gain_norm", this, config, panner)
                                     : std::unique_ptr<DirectSpeakersGainNorm>()),
       gain_calc_hoa(ctx, "gain_calc_hoa", this, config, panner),
-      metadata_in("metadata_in", *this, pml::EmptyParameterConfig()),
+      metadata_in(external_objects_gains
+                      ? nullptr
+                      : std::make_unique<ObjectsMetadataInput>(
+                            "metadata_in", *this, pml::EmptyParameterConfig())),
+      objects_gains_in(external_objects_gains
+                           ? std::make_unique<ObjectsGainsInput>(
+                                 "objects_gains_in",
+                                 *this,
+                                 pml::MatrixParameterConfig(2 * panner->num_gains(),
+                                                            config.num_objects_channels))
+                           : nullptr),
+      listener_out(external_objects_gains
+                       ? std::make_unique<ListenerOutput>("listener_out", *this, pml::EmptyParameterConfig())
+                       : nullptr),
       direct_gains_out("direct_gains_out",
                        *this,
-                       pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels)),
+                       pml::MatrixParameterConfig(panner->num_gains(), num_object_paths(config))),
       diffuse_gains_out("diffuse_gains_out",
                         *this,
-                        pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels)),
-      direct_delays_out(
-          "direct_delays_out", *this, pml::VectorParameterConfig(2 * config.num_objects_channels)),
+                        pml::MatrixParameterConfig(panner->num_gains(), num_object_paths(config))),
+      direct_delays_out("direct_delays_out", *this, pml::VectorParameterConfig(2 * num_object_paths(config))),
       static_delays_out(
           "static_delays_out", *this, pml::VectorParameterConfig(2 * panner->num_virtual_loudspeakers())),
       brir_index_out("brir_index_out", *this, pml::EmptyParameterConfig()),
+      cluster_gains_out(use_object_clustering(config)
+                            ? std::make_unique<ParameterOutput<pml::SharedDataProtocol,
+                                                               pml::MatrixParameter<float>>>(
+                                  "cluster_gains_out",
+                                  *this,
+                                  pml::MatrixParameterConfig(num_object_paths(config),
+                                                             config.num_objects_channels))
+                            : nullptr),
       direct_speakers_metadata_in("direct_speakers_metadata_in", *this, pml::EmptyParameterConfig()),
       direct_speakers_gains_out("direct_speakers_gains_out",
                                 *this,
@@ -47,36 +82,51 @@ Control::Control(const SignalFlowContext &ctx,
       hoa_metadata_in("hoa_metadata_in", *this, pml::EmptyParameterConfig()),
       hoa_gains_out("hoa_gains_out",
                     *this,
-                    pml::MatrixParameterConfig(panner->n_hoa_channels(), config.num_hoa_channels)),
+                    pml::MatrixParameterConfig(hoa_render_channels(config, panner->hoa_order()),
+                                               config.num_hoa_channels)),
       listener_in("listener_in", *this, pml::EmptyParameterConfig())
 {
-  // objects
-  parameterConnection(metadata_in, gain_calc.parameterPort("metadata_in"));
+  // objects; objects_gains is either from gain_calc or objects_gains_in
+  if (gain_calc) parameterConnection(*metadata_in, gain_calc->parameterPort("metadata_in"));
+  ParameterPortBase &objects_gains =
+      gain_calc ? gain_calc->parameterPort("gains_out") : static_cast<ParameterPortBase &>(*objects_gains_in);
 
-  // connect gain_calc to {direct,diffuse}_gains_out, possibly via gain_norm
-  if (panner->has_gain_compensation()) {
+  // connect objects_gains to {direct,diffuse}_gains_out, possibly via
+  // gain_norm and object_clustering
+  ParameterPortBase &normed_gains = gain_norm ? gain_norm->parameterPort("gains_out") : objects_gains;
+  if (gain_norm) {
     parameterConnection(direct_delay_calc.parameterPort("direct_delays_out"),
                         gain_norm->parameterPort("direct_delays_in"));
     parameterConnection(select_brir.parameterPort("brir_index_out"),
                         gain_norm->parameterPort("brir_index_in"));
 
-    parameterConnection(gain_calc.parameterPort("gains_out"), gain_norm->parameterPort("gains_in"));
-    parameterConnection(gain_norm->parameterPort("gains_out"),
+    parameterConnection(objects_gains, gain_norm->parameterPort("gains_in"));
+  }
+
+  parameterConnection(objects_gains, direct_delay_calc.parameterPort("gains_in"));
+
+  if (object_clustering) {
+    parameterConnection(normed_gains, object_clustering->parameterPort("gains_in"));
+    parameterConnection(direct_delay_calc.parameterPort("direct_delays_out"),
+                        object_clustering->parameterPort("direct_delays_in"));
+
+    parameterConnection(object_clustering->parameterPort("gains_out"),
                         direct_diffuse_split.parameterPort("gains_in"));
-  } else
-    parameterConnection(gain_calc.parameterPort("gains_out"), direct_diffuse_split.parameterPort("gains_in"));
+    parameterConnection(object_clustering->parameterPort("direct_delays_out"), direct_delays_out);
+    parameterConnection(object_clustering->parameterPort("cluster_gains_out"), *cluster_gains_out);
+  } else {
+    parameterConnection(normed_gains, direct_diffuse_split.parameterPort("gains_in"));
+    parameterConnection(direct_delay_calc.parameterPort("direct_delays_out"), direct_delays_out);
+  }
   parameterConnection(direct_diffuse_split.parameterPort("direct_gains_out"), direct_gains_out);
   parameterConnection(direct_diffuse_split.parameterPort("diffuse_gains_out"), diffuse_gains_out);
 
-  parameterConnection(gain_calc.parameterPort("gains_out"), direct_delay_calc.parameterPort("gains_in"));
-  parameterConnection(direct_delay_calc.parameterPort("direct_delays_out"), direct_delays_out);
-
   // shared
   parameterConnection(static_delay_calc.parameterPort("static_delays_out"), static_delays_out);
 
   // direct speakers
   parameterConnection(direct_speakers_metadata_in, direct_speakers_gain_calc.parameterPort("metadata_in"));
-  if (panner->has_gain_compensation()) {
+  if (direct_speakers_gain_norm) {
     parameterConnection(select_brir.parameterPort("brir_index_out"),
                         direct_speakers_gain_norm->parameterPort("brir_index_in"));
 
@@ -95,10 +145,16 @@ Control::Control(const SignalFlowContext &ctx,
   parameterConnection(gain_calc_hoa.parameterPort("gains_out"), hoa_gains_out);
 
   // listener stuff
-  parameterConnection(listener_in, select_brir.parameterPort("listener_in"));
-  parameterConnection(listener_in, gain_calc_hoa.parameterPort("listener_in"));
+  parameterConnection(listener_in, listener_smoother.parameterPort("listener_in"));
+  parameterConnection(listener_smoother.parameterPort("listener_out"),
+                      select_brir.parameterPort("listener_in"));
+  parameterConnection(listener_smoother.parameterPort("listener_out"),
+                      gain_calc_hoa.parameterPort("listener_in"));
 
-  parameterConnection(select_brir.parameterPort("listener_out"), gain_calc.parameterPort("listener_in"));
+  if (gain_calc)
+    parameterConnection(select_brir.parameterPort("listener_out"), gain_calc->parameterPort("listener_in"));
+  else
+    parameterConnection(select_brir.parameterPort("listener_out"), *listener_out);
   parameterConnection(select_brir.parameterPort("listener_out"),
                       direct_speakers_gain_calc.parameterPort("listener_in"));
 
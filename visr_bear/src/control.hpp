@@ -15,6 +15,8 @@
 #include "gain_calc_hoa.hpp"
 #include "gain_calc_objects.hpp"
 #include "gain_norm.hpp"
+#include "listener_smoother.hpp"
+#include "object_clustering.hpp"
 #include "panner.hpp"
 #include "select_brir.hpp"
 #include "static_delay_calc.hpp"
@@ -23,6 +25,10 @@
 namespace bear {
 using namespace visr;
 
+/// If external_objects_gains is set, there is no GainCalcObjects or
+/// metadata_in; instead, objects gains for the listener on listener_out are
+/// read from objects_gains_in. This allows one GainCalcObjects to be shared
+/// between several listeners.
 class Control : public CompositeComponent {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -30,16 +36,20 @@ class Control : public CompositeComponent {
                    const char *name,
                    CompositeComponent *parent,
                    const ConfigImpl &config,
-                   std::shared_ptr<Panner> panner);
+                   std::shared_ptr<Panner> panner,
+                   bool external_objects_gains = false);
 
  private:
   std::shared_ptr<Panner> panner;
-  GainCalcObjects gain_calc;
+  ListenerSmoother listener_smoother;
+  /// only if !external_objects_gains
+  std::unique_ptr<GainCalcObjects> gain_calc;
   DirectDiffuseSplit direct_diffuse_split;
   DirectDelayCalc direct_delay_calc;
   StaticDelayCalc static_delay_calc;
   SelectBRIR select_brir;
   std::unique_ptr<GainNorm> gain_norm;
+  std::unique_ptr<ObjectClustering> object_clustering;
 
   DirectSpeakersGainCalc direct_speakers_gain_calc;
   DirectSpeakersDelayCalc direct_speakers_delay_calc;
@@ -47,12 +57,22 @@ class Control : public CompositeComponent {
 
   GainCalcHOA gain_calc_hoa;
 
-  ParameterInput<pml::MessageQueueProtocol, ADMParameter<ObjectsInput>> metadata_in;
+  using ObjectsMetadataInput = ParameterInput<pml::MessageQueueProtocol, ADMParameter<ObjectsInput>>;
+  using ObjectsGainsInput = ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<SampleType>>;
+  using ListenerOutput = ParameterOutput<pml::DoubleBufferingProtocol, ListenerParameter>;
+
+  /// only if !external_objects_gains
+  std::unique_ptr<ObjectsMetadataInput> metadata_in;
+  /// only if external_objects_gains
+  std::unique_ptr<ObjectsGainsInput> objects_gains_in;
+  std::unique_ptr<ListenerOutput> listener_out;
   ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<float>> direct_gains_out;
   ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<float>> diffuse_gains_out;
   ParameterOutput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> direct_delays_out;
   ParameterOutput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> static_delays_out;
   ParameterOutput<pml::DoubleBufferingProtocol, pml::ScalarParameter<unsigned int>> brir_index_out;
+  /// only if use_object_clustering
+  std::unique_ptr<ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<float>>> cluster_gains_out;
 
   ParameterInput<pml::MessageQueueProtocol, ADMParameter<DirectSpeakersInput>> direct_speakers_metadata_in;
   ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<float>> direct_speakers_gains_out;
@@ -5,8 +5,8 @@
 namespace bear {
 int get_data_file_version(tensorfile::TensorFile &tf)
 {
-  auto it = tf.metadata.FindMember("bear_data_version");
-  if (it == tf.metadata.MemberEnd()) return 0;
+  auto it = tf.metadata().FindMember("bear_data_version");
+  if (it == tf.metadata().MemberEnd()) return 0;
 
   if (!it->value.IsInt()) throw std::runtime_error("version must be an integer");
 
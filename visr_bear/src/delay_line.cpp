@@ -0,0 +1,181 @@
+#include "delay_line.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bear {
+
+namespace {
+  size_t next_pow_2(size_t n)
+  {
+    size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+  }
+
+  /// 3rd order Lagrange interpolation for a total delay (including the method
+  /// delay of 1 sample) of offset + 1 + frac; the output is the sum of
+  /// coeffs[i] * x[t - offset - i] for i in 0..3
+  void lagrange_coeffs(double total_delay, size_t &offset, std::array<float, 4> &coeffs)
+  {
+    double integer_part = std::floor(total_delay);
+    double d = 1.0 + (total_delay - integer_part);
+    offset = static_cast<size_t>(integer_part) - 1;
+
+    coeffs[0] = static_cast<float>(-(d - 1.0) * (d - 2.0) * (d - 3.0) / 6.0);
+    coeffs[1] = static_cast<float>(d * (d - 2.0) * (d - 3.0) / 2.0);
+    coeffs[2] = static_cast<float>(-d * (d - 1.0) * (d - 3.0) / 2.0);
+    coeffs[3] = static_cast<float>(d * (d - 1.0) * (d - 2.0) / 6.0);
+  }
+}  // namespace
+
+DelayLine::DelayLine(size_t max_block_size, double max_delay_, size_t ramp_length_, double initial_delay)
+    : max_delay_samples(static_cast<size_t>(std::ceil(max_delay_))),
+      ramp_length(ramp_length_),
+      max_delay(max_delay_),
+      buffer(next_pow_2(max_block_size + max_delay_samples + 4)),
+      mask(buffer.size() - 1),
+      start_delay(std::min(std::max(initial_delay, 0.0), max_delay)),
+      target_delay(start_delay),
+      ramp_pos(ramp_length),
+      ramp_offsets(max_block_size)
+{
+  for (auto &coeffs : ramp_coeffs) coeffs.resize(max_block_size);
+
+  set_delay(initial_delay);
+  ramp_pos = ramp_length;
+}
+
+void DelayLine::set_delay(double delay)
+{
+  delay = std::min(std::max(delay, 0.0), max_delay);
+
+  // start from wherever we got to in the current ramp
+  start_delay = ramp_delay(ramp_pos);
+  target_delay = delay;
+  ramp_pos = 0;
+
+  double total_delay = target_delay + 1.0;
+  fixed_integer = total_delay == std::floor(total_delay);
+  if (fixed_integer)
+    fixed_offset = static_cast<size_t>(total_delay);
+  else
+    lagrange_coeffs(total_delay, fixed_offset, fixed_coeffs);
+}
+
+double DelayLine::ramp_delay(size_t n) const
+{
+  if (n >= ramp_length) return target_delay;
+  return start_delay + (target_delay - start_delay) * static_cast<double>(n) / ramp_length;
+}
+
+void DelayLine::write(const float *in, size_t n)
+{
+  size_t start = write_pos & mask;
+  size_t first = std::min(n, buffer.size() - start);
+  std::copy(in, in + first, buffer.data() + start);
+  std::copy(in + first, in + n, buffer.data());
+}
+
+void DelayLine::process(const float *in, float *out, size_t n)
+{
+  cleared = false;
+  write(in, n);
+
+  size_t ramp_samples = std::min(n, ramp_length - ramp_pos);
+  process_ramp(out, ramp_samples);
+  write_pos += ramp_samples;
+
+  process_fixed(out + ramp_samples, n - ramp_samples);
+  write_pos += n - ramp_samples;
+}
+
+void DelayLine::write_only(const float *in, size_t n)
+{
+  cleared = false;
+  write(in, n);
+  ramp_pos = std::min(ramp_length, ramp_pos + n);
+  write_pos += n;
+}
+
+void DelayLine::add_integer_delayed(size_t delay,
+                                    float start_gain,
+                                    float end_gain,
+                                    float *out,
+                                    size_t n) const
+{
+  size_t t = write_pos - n - delay - 1;
+  if (start_gain == end_gain)
+    for (size_t i = 0; i < n; i++) out[i] += end_gain * buffer[(t + i) & mask];
+  else {
+    float step = (end_gain - start_gain) / n;
+    for (size_t i = 0; i < n; i++) out[i] += (start_gain + step * (i + 1)) * buffer[(t + i) & mask];
+  }
+}
+
+void DelayLine::process_ramp(float *out, size_t n)
+{
+  // first calculate the coefficients for each sample in structure-of-arrays
+  // form, which vectorises, then apply them
+  for (size_t i = 0; i < n; i++) {
+    double total_delay = ramp_delay(ramp_pos + i + 1) + 1.0;
+    double integer_part = std::floor(total_delay);
+    double d = 1.0 + (total_delay - integer_part);
+
+    ramp_offsets[i] = static_cast<int>(integer_part) - 1;
+    ramp_coeffs[0][i] = static_cast<float>(-(d - 1.0) * (d - 2.0) * (d - 3.0) / 6.0);
+    ramp_coeffs[1][i] = static_cast<float>(d * (d - 2.0) * (d - 3.0) / 2.0);
+    ramp_coeffs[2][i] = static_cast<float>(-d * (d - 1.0) * (d - 3.0) / 2.0);
+    ramp_coeffs[3][i] = static_cast<float>(d * (d - 1.0) * (d - 2.0) / 6.0);
+  }
+  ramp_pos += n;
+
+  for (size_t i = 0; i < n; i++) {
+    size_t t = write_pos + i - ramp_offsets[i];
+    out[i] = ramp_coeffs[0][i] * buffer[t & mask] + ramp_coeffs[1][i] * buffer[(t - 1) & mask] +
+             ramp_coeffs[2][i] * buffer[(t - 2) & mask] + ramp_coeffs[3][i] * buffer[(t - 3) & mask];
+  }
+}
+
+void DelayLine::process_fixed(float *out, size_t n)
+{
+  if (n == 0) return;
+
+  if (fixed_integer) {
+    size_t start = (write_pos - fixed_offset) & mask;
+    size_t first = std::min(n, buffer.size() - start);
+    std::copy(buffer.data() + start, buffer.data() + start + first, out);
+    std::copy(buffer.data(), buffer.data() + (n - first), out + first);
+    return;
+  }
+
+  // first sample read is 3 samples before the first tap of the first output
+  size_t start = (write_pos - fixed_offset - 3) & mask;
+  if (start + n + 3 <= buffer.size()) {
+    // contiguous, so this should vectorise
+    const float *x = buffer.data() + start + 3;
+    const float c0 = fixed_coeffs[0], c1 = fixed_coeffs[1], c2 = fixed_coeffs[2], c3 = fixed_coeffs[3];
+    for (size_t i = 0; i < n; i++) out[i] = c0 * x[i] + c1 * x[i - 1] + c2 * x[i - 2] + c3 * x[i - 3];
+  } else {
+    size_t t = write_pos - fixed_offset;
+    for (size_t i = 0; i < n; i++) {
+      float sample = 0.0f;
+      for (size_t j = 0; j < 4; j++) sample += fixed_coeffs[j] * buffer[(t + i - j) & mask];
+      out[i] = sample;
+    }
+  }
+}
+
+void DelayLine::skip(size_t n)
+{
+  // positions skipped over are not written, so the whole buffer must be zero
+  if (!cleared) {
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    cleared = true;
+  }
+
+  ramp_pos = std::min(ramp_length, ramp_pos + n);
+  write_pos += n;
+}
+
+}  // namespace bear
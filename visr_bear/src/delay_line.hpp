@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace bear {
+
+/// Single-channel fractional delay line, equivalent to rcl::DelayVector with
+/// lagrangeOrder3 interpolation and MethodDelayPolicy::Add: the output is
+/// delayed by the requested delay plus one sample.
+///
+/// When the delay changes it is ramped linearly to the new value over
+/// ramp_length samples, interpolating each sample; otherwise a fixed set of
+/// interpolation coefficients is used, or a plain copy if the delay is an
+/// integer number of samples.
+class DelayLine {
+ public:
+  /// delays are in samples, and are clamped to [0, max_delay]; at most
+  /// max_block_size samples can be processed at once
+  DelayLine(size_t max_block_size, double max_delay, size_t ramp_length, double initial_delay);
+
+  /// set the delay to ramp to, starting with the next call to process
+  void set_delay(double delay);
+
+  /// process n samples from in to out; in and out may not alias
+  void process(const float *in, float *out, size_t n);
+
+  /// write n samples from in without producing output, keeping the history
+  /// and the position in any delay ramp as if process had been called
+  void write_only(const float *in, size_t n);
+
+  /// add the last n samples written to out, delayed by delay samples (plus
+  /// the method delay) and with a gain ramping linearly from start_gain to
+  /// end_gain (reached on the last sample); this ignores the delay set by
+  /// set_delay, and delay must be at most max_delay rounded up
+  void add_integer_delayed(size_t delay, float start_gain, float end_gain, float *out, size_t n) const;
+
+  /// equivalent to processing n samples of silence, for use when the input
+  /// has been silent for at least flush_samples(), so that the output is
+  /// zero too
+  void skip(size_t n);
+
+  /// number of samples of silence after which the output is silent
+  size_t flush_samples() const { return max_delay_samples + 4; }
+
+ private:
+  void write(const float *in, size_t n);
+  void process_ramp(float *out, size_t n);
+  void process_fixed(float *out, size_t n);
+
+  /// delay to use for the nth sample from the start of the ramp
+  double ramp_delay(size_t n) const;
+
+  size_t max_delay_samples;
+  size_t ramp_length;
+  double max_delay;
+
+  std::vector<float> buffer;
+  size_t mask;
+  /// index in buffer where the next input sample is written
+  size_t write_pos = 0;
+  /// has the buffer been zeroed since the last call to process?
+  bool cleared = false;
+
+  double start_delay;
+  double target_delay;
+  /// position in the current ramp; equal to ramp_length when not ramping
+  size_t ramp_pos;
+  /// temporary offsets and interpolation coefficients for each sample in a
+  /// ramp
+  std::vector<int> ramp_offsets;
+  std::array<std::vector<float>, 4> ramp_coeffs;
+
+  /// fixed coefficients for target_delay
+  size_t fixed_offset;
+  std::array<float, 4> fixed_coeffs;
+  bool fixed_integer;
+};
+
+}  // namespace bear
@@ -0,0 +1,39 @@
+#include "delays.hpp"
+
+namespace bear {
+Delays::Delays(const SignalFlowContext &ctx,
+               const char *name,
+               CompositeComponent *parent,
+               std::size_t num_channels,
+               double max_delay,
+               double initial_delay,
+               bool control_input)
+    : AtomicComponent(ctx, name, parent),
+      in("in", *this, num_channels),
+      out("out", *this, num_channels),
+      delays_in(control_input ? std::make_unique<ParameterInput<pml::DoubleBufferingProtocol,
+                                                                 pml::VectorParameter<float>>>(
+                                    "delays_in", *this, pml::VectorParameterConfig(num_channels))
+                              : nullptr)
+{
+  delays.reserve(num_channels);
+  for (size_t i = 0; i < num_channels; i++)
+    delays.emplace_back(
+        /* max_block_size = */ period(),
+        /* max_delay = */ max_delay * samplingFrequency(),
+        /* ramp_length = */ period(),
+        /* initial_delay = */ initial_delay * samplingFrequency());
+}
+
+void Delays::process()
+{
+  if (delays_in && delays_in->changed()) {
+    for (size_t i = 0; i < delays.size(); i++)
+      delays[i].set_delay(delays_in->data()[i] * samplingFrequency());
+    delays_in->resetChanged();
+  }
+
+  for (size_t i = 0; i < delays.size(); i++) delays[i].process(in.at(i), out.at(i), period());
+}
+
+}  // namespace bear
@@ -0,0 +1,45 @@
+#pragma once
+#include <libpml/double_buffering_protocol.hpp>
+#include <libpml/vector_parameter.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/audio_input.hpp>
+#include <libvisr/audio_output.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <memory>
+#include <vector>
+
+#include "delay_line.hpp"
+
+namespace bear {
+using namespace visr;
+
+/// Multi-channel delay, a replacement for rcl::DelayVector with
+/// lagrangeOrder3 interpolation and MethodDelayPolicy::Add, using DelayLine.
+///
+/// Unlike DelayVector, the buffers are sized for max_delay (in seconds) rather
+/// than an arbitrary maximum, and interpolation is only performed per-sample
+/// while a delay is changing.
+///
+/// If control_input is true, delays (in seconds, one per channel) are read
+/// from the delays_in port, and ramped to over one period.
+class Delays : public AtomicComponent {
+ public:
+  explicit Delays(const SignalFlowContext &ctx,
+                  const char *name,
+                  CompositeComponent *parent,
+                  std::size_t num_channels,
+                  double max_delay,
+                  double initial_delay,
+                  bool control_input);
+
+  void process() override;
+
+ private:
+  AudioInput in;
+  AudioOutput out;
+  std::unique_ptr<ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>>> delays_in;
+
+  std::vector<DelayLine> delays;
+};
+
+}  // namespace bear
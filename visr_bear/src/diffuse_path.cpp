@@ -0,0 +1,137 @@
+#include "diffuse_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <libvisr/constants.hpp>
+
+#include "fft_cache.hpp"
+#include "fft_utils.hpp"
+
+namespace bear {
+
+DiffusePath::DiffusePath(const SignalFlowContext &ctx,
+                         const char *name,
+                         CompositeComponent *parent,
+                         const ConfigImpl &config,
+                         std::shared_ptr<Panner> panner_)
+    : AtomicComponent(ctx, name, parent),
+      panner(std::move(panner_)),
+      num_vs(panner->num_virtual_loudspeakers()),
+      num_partitions((panner->decorrelator_length() + period() - 1) / period()),
+      convolver_index(num_vs, 2u),
+      partition_index(num_vs, num_partitions),
+      in("in", *this, num_vs),
+      out("out", *this, 2 * num_vs),
+      delays_in("delays_in", *this, pml::VectorParameterConfig(2 * num_vs)),
+      fft(get_cached_fft(config.fft_implementation, 2 * period())),
+      filter_spectra(num_vs * num_partitions, period() + 1, cVectorAlignmentSamples),
+      input_spectra(num_vs * num_partitions, period() + 1, cVectorAlignmentSamples),
+      last_input(num_vs, period(), cVectorAlignmentSamples),
+      silent_samples(num_vs, 0),
+      time_buf(1, 2 * period(), cVectorAlignmentSamples),
+      spectrum_acc(1, period() + 1, cVectorAlignmentSamples)
+{
+  size_t B = period();
+
+  SampleType scale = overlap_save_scale(*fft, B);
+
+  // filter spectra for each partition, zero-padded to 2B
+  const size_t decorrelator_length = panner->decorrelator_length();
+  for (size_t vs = 0; vs < num_vs; vs++) {
+    const float *decorrelator = panner->get_decorrelator(vs);
+    for (size_t partition = 0; partition < num_partitions; partition++) {
+      size_t start = partition * B;
+      size_t end = std::min(start + B, decorrelator_length);
+
+      std::fill(time_buf.row(0), time_buf.row(0) + 2 * B, 0.0f);
+      for (size_t i = start; i < end; i++) time_buf(0, i - start) = decorrelator[i] * scale;
+
+      check_fft(fft->forwardTransform(time_buf.row(0), filter_spectra.row(partition_index(vs, partition))));
+    }
+  }
+
+  input_spectra.zeroFill();
+  last_input.zeroFill();
+
+  // delays
+  double max_delay = panner->max_delay() * samplingFrequency();
+  double initial_delay = panner->get_default_static_delay() * samplingFrequency();
+  delays.reserve(2 * num_vs);
+  for (size_t i = 0; i < 2 * num_vs; i++)
+    delays.emplace_back(
+        /* max_block_size = */ B,
+        /* max_delay = */ max_delay,
+        /* ramp_length = */ B,
+        /* initial_delay = */ initial_delay);
+
+  flush_samples = (num_partitions + 1) * B + delays[0].flush_samples();
+  // start silent
+  std::fill(silent_samples.begin(), silent_samples.end(), flush_samples);
+}
+
+void DiffusePath::decorrelate(size_t vs, const SampleType *in_block)
+{
+  const size_t B = period();
+
+  // overlap-save: transform the last two blocks
+  std::copy(last_input.row(vs), last_input.row(vs) + B, time_buf.row(0));
+  std::copy(in_block, in_block + B, time_buf.row(0) + B);
+  std::copy(in_block, in_block + B, last_input.row(vs));
+
+  check_fft(fft->forwardTransform(time_buf.row(0), input_spectra.row(partition_index(vs, spectrum_pos))));
+
+  // multiply-accumulate each partition with the corresponding past input
+  SampleType *acc = reinterpret_cast<SampleType *>(spectrum_acc.row(0));
+  std::fill(acc, acc + 2 * (B + 1), 0.0f);
+  for (size_t partition = 0; partition < num_partitions; partition++) {
+    size_t input_partition = (spectrum_pos + num_partitions - partition) % num_partitions;
+    complex_mac(acc,
+                reinterpret_cast<const SampleType *>(input_spectra.row(partition_index(vs, input_partition))),
+                reinterpret_cast<const SampleType *>(filter_spectra.row(partition_index(vs, partition))),
+                1.0f,
+                B + 1);
+  }
+
+  check_fft(fft->inverseTransform(spectrum_acc.row(0), time_buf.row(0)));
+  // the decorrelated block is now in the second half of time_buf
+}
+
+void DiffusePath::process()
+{
+  const size_t B = period();
+
+  if (delays_in.changed()) {
+    for (size_t i = 0; i < 2 * num_vs; i++) delays[i].set_delay(delays_in.data()[i] * samplingFrequency());
+    delays_in.resetChanged();
+  }
+
+  for (size_t vs = 0; vs < num_vs; vs++) {
+    const SampleType *in_block = in.at(vs);
+
+    bool silent = std::all_of(in_block, in_block + B, [](SampleType x) { return x == 0.0f; });
+    silent_samples[vs] = silent ? std::min(silent_samples[vs] + B, flush_samples) : 0;
+
+    if (silent_samples[vs] >= flush_samples) {
+      // the last blocks of input and the decorrelator and delay line state are
+      // all zero, so the output is too; the stored input blocks and spectra
+      // are already zero
+      for (size_t ear = 0; ear < 2; ear++) {
+        size_t channel = convolver_index(vs, ear);
+        delays[channel].skip(B);
+        std::fill(out.at(channel), out.at(channel) + B, 0.0f);
+      }
+      continue;
+    }
+
+    decorrelate(vs, in_block);
+
+    for (size_t ear = 0; ear < 2; ear++) {
+      size_t channel = convolver_index(vs, ear);
+      delays[channel].process(time_buf.row(0) + B, out.at(channel), B);
+    }
+  }
+
+  spectrum_pos = (spectrum_pos + 1) % num_partitions;
+}
+
+}  // namespace bear
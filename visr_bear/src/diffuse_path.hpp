@@ -0,0 +1,91 @@
+#pragma once
+#include <complex>
+#include <libefl/basic_matrix.hpp>
+#include <libpml/double_buffering_protocol.hpp>
+#include <libpml/vector_parameter.hpp>
+#include <librbbl/fft_wrapper_base.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/audio_input.hpp>
+#include <libvisr/audio_output.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <memory>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "delay_line.hpp"
+#include "panner.hpp"
+#include "utils.hpp"
+
+namespace bear {
+using namespace visr;
+
+/// Diffuse path between the diffuse gains and the BRIR convolver: applies
+/// the decorrelation filter for each virtual loudspeaker, then the static
+/// (per-view) delay for each virtual loudspeaker and ear.
+///
+/// This replaces a FirFilterMatrix followed by a DelayVector. The
+/// decorrelators are applied with a uniformly-partitioned convolution with
+/// the same partition size as the BRIR convolver, and the delays only
+/// interpolate each sample while they are changing after a view switch.
+///
+/// Diffuse gains are often all zero, so virtual loudspeakers whose input has
+/// been silent for long enough for the filter and delay line to be flushed are
+/// skipped entirely.
+///
+/// Input channels are virtual loudspeakers, and output channels are numbered
+/// like the BRIR convolver inputs, i.e. vs * 2 + ear. delays_in has the same
+/// layout, and is in seconds.
+class DiffusePath : public AtomicComponent {
+ public:
+  explicit DiffusePath(const SignalFlowContext &ctx,
+                       const char *name,
+                       CompositeComponent *parent,
+                       const ConfigImpl &config,
+                       std::shared_ptr<Panner> panner);
+
+  void process() override;
+
+ private:
+  /// decorrelate one block of input for virtual loudspeaker vs into
+  /// decorrelated
+  void decorrelate(size_t vs, const SampleType *in);
+
+  std::shared_ptr<Panner> panner;
+  size_t num_vs;
+  /// number of decorrelator partitions of length period()
+  size_t num_partitions;
+  /// number of silent input samples after which the output for a virtual
+  /// loudspeaker is silent
+  size_t flush_samples;
+
+  Indexer<2> convolver_index;
+  Indexer<2> partition_index;
+
+  AudioInput in;
+  AudioOutput out;
+  ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> delays_in;
+
+  /// from the FFT cache
+  std::shared_ptr<rbbl::FftWrapperBase<SampleType>> fft;
+
+  /// spectra of the decorrelator partitions, partition_index(vs, partition),
+  /// including the FFT scaling
+  efl::BasicMatrix<std::complex<SampleType>> filter_spectra;
+  /// spectra of the last num_partitions input blocks, for each virtual
+  /// loudspeaker; indexed like filter_spectra, with the partition index
+  /// offset by spectrum_pos
+  efl::BasicMatrix<std::complex<SampleType>> input_spectra;
+  size_t spectrum_pos = 0;
+  /// last input block for each virtual loudspeaker
+  efl::BasicMatrix<SampleType> last_input;
+  /// number of consecutive silent samples for each virtual loudspeaker
+  std::vector<size_t> silent_samples;
+
+  // temporaries
+  efl::BasicMatrix<SampleType> time_buf;
+  efl::BasicMatrix<std::complex<SampleType>> spectrum_acc;
+
+  std::vector<DelayLine> delays;
+};
+
+}  // namespace bear
@@ -1,5 +1,7 @@
 #include "direct_diffuse_split.hpp"
 
+#include "utils.hpp"
+
 namespace bear {
 DirectDiffuseSplit::DirectDiffuseSplit(const SignalFlowContext &ctx,
                                        const char *name,
@@ -8,16 +10,12 @@ DirectDiffuseSplit::DirectDiffuseSplit(const SignalFlowContext &ctx,
                                        std::shared_ptr<Panner> panner_)
     : AtomicComponent(ctx, name, parent),
       panner(std::move(panner_)),
-      num_objects(config.num_objects_channels),
-      gains_in("gains_in",
-               *this,
-               pml::MatrixParameterConfig(panner->num_gains() * 2, config.num_objects_channels)),
-      direct_gains_out("direct_gains_out",
-                       *this,
-                       pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels)),
-      diffuse_gains_out("diffuse_gains_out",
-                        *this,
-                        pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels))
+      num_objects(num_object_paths(config)),
+      gains_in("gains_in", *this, pml::MatrixParameterConfig(panner->num_gains() * 2, num_objects)),
+      direct_gains_out(
+          "direct_gains_out", *this, pml::MatrixParameterConfig(panner->num_gains(), num_objects)),
+      diffuse_gains_out(
+          "diffuse_gains_out", *this, pml::MatrixParameterConfig(panner->num_gains(), num_objects))
 {
 }
 
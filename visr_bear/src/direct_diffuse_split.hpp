@@ -25,6 +25,7 @@ class DirectDiffuseSplit : public AtomicComponent {
 
  private:
   std::shared_ptr<Panner> panner;
+  /// number of columns of the gains; see num_object_paths
   size_t num_objects;
 
   ParameterInput<pml::SharedDataProtocol, MatrixParameter<float>> gains_in;
@@ -0,0 +1,131 @@
+#include "direct_speakers_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bear {
+DirectSpeakersPath::DirectSpeakersPath(const SignalFlowContext &ctx,
+                                       const char *name,
+                                       CompositeComponent *parent,
+                                       std::size_t num_inputs_,
+                                       std::size_t num_outputs_,
+                                       double max_delay,
+                                       double initial_delay)
+    : AtomicComponent(ctx, name, parent),
+      num_inputs(num_inputs_),
+      num_outputs(num_outputs_),
+      in("in", *this, num_inputs_),
+      out("out", *this, 2 * num_outputs_),
+      delays_in("delays_in", *this, pml::VectorParameterConfig(2 * num_inputs_)),
+      gains_in("gains_in", *this, pml::MatrixParameterConfig(num_outputs_, num_inputs_)),
+      max_delay_samples(max_delay * samplingFrequency()),
+      last_gains(num_inputs_ * num_outputs_, 0.0f),
+      delayed(period())
+{
+  delays.reserve(2 * num_inputs);
+  for (size_t i = 0; i < 2 * num_inputs; i++)
+    delays.emplace_back(
+        /* max_block_size = */ period(),
+        /* max_delay = */ max_delay_samples,
+        /* ramp_length = */ period(),
+        /* initial_delay = */ initial_delay * samplingFrequency());
+
+  double initial_delay_samples = initial_delay * samplingFrequency();
+  initial_delay_samples = std::min(std::max(initial_delay_samples, 0.0), max_delay_samples);
+  integer_delays.assign(2 * num_inputs, static_cast<size_t>(std::lround(initial_delay_samples)));
+  last_integer_delays = integer_delays;
+}
+
+void DirectSpeakersPath::process()
+{
+  const size_t B = period();
+
+  if (delays_in.changed()) {
+    for (size_t i = 0; i < delays.size(); i++) {
+      double delay = delays_in.data()[i] * samplingFrequency();
+      delays[i].set_delay(delay);
+      // the same clamping as DelayLine; rounding may give ceil(max_delay)
+      delay = std::min(std::max(delay, 0.0), max_delay_samples);
+      integer_delays[i] = static_cast<size_t>(std::lround(delay));
+    }
+    delays_in.resetChanged();
+  }
+
+  for (size_t output = 0; output < 2 * num_outputs; output++) std::fill_n(out.at(output), B, 0.0f);
+
+  for (size_t input = 0; input < num_inputs; input++) {
+    boost::optional<size_t> routed_vs = routed_output(input);
+    if (routed_vs)
+      process_routed(input, *routed_vs);
+    else
+      process_general(input);
+
+    float *channel_last_gains = last_gains.data() + input * num_outputs;
+    for (size_t vs = 0; vs < num_outputs; vs++) channel_last_gains[vs] = gains_in.data()(vs, input);
+  }
+}
+
+boost::optional<size_t> DirectSpeakersPath::routed_output(size_t input) const
+{
+  const float *channel_last_gains = last_gains.data() + input * num_outputs;
+
+  boost::optional<size_t> routed;
+  for (size_t vs = 0; vs < num_outputs; vs++)
+    if (gains_in.data()(vs, input) != 0.0f || channel_last_gains[vs] != 0.0f) {
+      if (routed) return boost::none;
+      routed = vs;
+    }
+  return routed;
+}
+
+void DirectSpeakersPath::process_routed(size_t input, size_t vs)
+{
+  const size_t B = period();
+  float last_gain = last_gains[input * num_outputs + vs];
+  float gain = gains_in.data()(vs, input);
+
+  for (size_t ear = 0; ear < 2; ear++) {
+    size_t i = input * 2 + ear;
+    // the fractional delay line keeps the history for the general path
+    delays[i].write_only(in.at(input), B);
+
+    SampleType *out_p = out.at(vs * 2 + ear);
+    if (integer_delays[i] == last_integer_delays[i])
+      delays[i].add_integer_delayed(integer_delays[i], last_gain, gain, out_p, B);
+    else {
+      delays[i].add_integer_delayed(last_integer_delays[i], last_gain, 0.0f, out_p, B);
+      delays[i].add_integer_delayed(integer_delays[i], 0.0f, gain, out_p, B);
+    }
+    last_integer_delays[i] = integer_delays[i];
+  }
+}
+
+void DirectSpeakersPath::process_general(size_t input)
+{
+  const size_t B = period();
+  const float *channel_last_gains = last_gains.data() + input * num_outputs;
+
+  for (size_t ear = 0; ear < 2; ear++) {
+    size_t i = input * 2 + ear;
+    // the delay lines are always run so that they hold the input history
+    // if this channel is switched on
+    delays[i].process(in.at(input), delayed.data(), B);
+    last_integer_delays[i] = integer_delays[i];
+
+    for (size_t vs = 0; vs < num_outputs; vs++) {
+      float last_gain = channel_last_gains[vs];
+      float gain = gains_in.data()(vs, input);
+      if (gain == 0.0f && last_gain == 0.0f) continue;
+
+      SampleType *out_p = out.at(vs * 2 + ear);
+      if (gain == last_gain)
+        for (size_t s = 0; s < B; s++) out_p[s] += gain * delayed[s];
+      else {
+        float step = (gain - last_gain) / B;
+        for (size_t s = 0; s < B; s++) out_p[s] += (last_gain + step * (s + 1)) * delayed[s];
+      }
+    }
+  }
+}
+
+}  // namespace bear
@@ -0,0 +1,81 @@
+#pragma once
+#include <boost/optional.hpp>
+#include <libpml/double_buffering_protocol.hpp>
+#include <libpml/matrix_parameter.hpp>
+#include <libpml/shared_data_protocol.hpp>
+#include <libpml/vector_parameter.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/audio_input.hpp>
+#include <libvisr/audio_output.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <vector>
+
+#include "delay_line.hpp"
+
+namespace bear {
+using namespace visr;
+
+/// Per-ear delays and gains for DirectSpeakers channels, with the same ports
+/// and behaviour as PerEarDelay: each input is delayed separately for each
+/// ear (delays_in, in seconds, index channel * 2 + ear), then mixed into the
+/// virtual loudspeaker inputs of the BRIR convolver (out, index vs * 2 + ear)
+/// with gains from gains_in (rows are virtual loudspeakers, columns are
+/// channels).
+///
+/// DirectSpeakers channels usually land exactly on one virtual loudspeaker.
+/// A channel whose gains (this period and last) are non-zero for only one
+/// virtual loudspeaker is routed straight to it: its delays are rounded to
+/// an integer number of samples, so each ear is a plain copy from the delay
+/// line history, with no interpolation. When a rounded delay changes, the
+/// old and new delays are crossfaded over one period.
+///
+/// Other channels use the general path: fractional delays, ramped over one
+/// period when they change, and a sparse mix, in which only the virtual
+/// loudspeakers with non-zero gains (this period or last) are mixed into.
+///
+/// In both paths, gain changes are ramped linearly to the new value over one
+/// period, as in rcl::GainMatrix. Switching between the paths can move the
+/// delay by up to half a sample; this only happens when the gains change.
+class DirectSpeakersPath : public AtomicComponent {
+ public:
+  explicit DirectSpeakersPath(const SignalFlowContext &ctx,
+                              const char *name,
+                              CompositeComponent *parent,
+                              std::size_t num_inputs,
+                              std::size_t num_outputs,
+                              double max_delay,
+                              double initial_delay);
+
+  void process() override;
+
+ private:
+  /// the virtual loudspeaker to route input to, if its gains in this period
+  /// and the last are zero for all others
+  boost::optional<size_t> routed_output(size_t input) const;
+  void process_routed(size_t input, size_t vs);
+  void process_general(size_t input);
+
+  std::size_t num_inputs;
+  std::size_t num_outputs;
+
+  AudioInput in;
+  AudioOutput out;
+  ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> delays_in;
+  ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>> gains_in;
+
+  /// max_delay in samples
+  double max_delay_samples;
+
+  /// one per input and ear, index input * 2 + ear
+  std::vector<DelayLine> delays;
+  /// delays from delays_in rounded to samples, and the rounded delays used in
+  /// the last period, index input * 2 + ear
+  std::vector<size_t> integer_delays;
+  std::vector<size_t> last_integer_delays;
+  /// gains at the end of the last period, index input * num_outputs + output
+  std::vector<float> last_gains;
+  /// output of one delay line
+  std::vector<float> delayed;
+};
+
+}  // namespace bear
@@ -1,9 +1,18 @@
 #include "dsp.hpp"
 
 #include <libvisr/signal_flow_context.hpp>
+#include <vector>
+
+#include "fft_cache.hpp"
 
 namespace bear {
 
+namespace {
+  /// direct delays are weighted means of the delays, plus the decorrelation
+  /// delay
+  double max_direct_delay(const Panner &panner) { return panner.max_delay() + panner.decorrelation_delay(); }
+}  // namespace
+
 DSP::DSP(const SignalFlowContext &ctx,
          const char *name,
          CompositeComponent *parent,
@@ -11,38 +20,53 @@ DSP::DSP(const SignalFlowContext &ctx,
          std::shared_ptr<Panner> panner_)
     : CompositeComponent(ctx, name, parent),
       panner(std::move(panner_)),
+      num_hoa_render_channels(hoa_render_channels(config, panner->hoa_order())),
 
       object_ear_index(config.num_objects_channels, 2u),
       convolver_index(panner->num_virtual_loudspeakers(), 2u),
-      brir_index(panner->num_views(), panner->num_virtual_loudspeakers(), 2u),
+      brir_index(num_brir_slots(config, *panner), panner->num_virtual_loudspeakers(), 2u),
 
       objects_in("objects_in", *this, config.num_objects_channels),
       direct_speakers_in("direct_speakers_in", *this, config.num_direct_speakers_channels),
       hoa_in("hoa_in", *this, config.num_hoa_channels),
       out("out", *this, 2),
 
+      cluster_mix(use_object_clustering(config)
+                      ? std::make_unique<ClusterMix>(
+                            ctx, "cluster_mix", this, config.num_objects_channels, num_object_paths(config))
+                      : nullptr),
+      cluster_gains_in(use_object_clustering(config)
+                           ? std::make_unique<ParameterInput<pml::SharedDataProtocol,
+                                                             pml::MatrixParameter<float>>>(
+                                 "cluster_gains_in",
+                                 *this,
+                                 pml::MatrixParameterConfig(num_object_paths(config),
+                                                            config.num_objects_channels))
+                           : nullptr),
+
       objects_direct_path(ctx,
                           "objects_direct_path",
                           this,
-                          config.num_objects_channels,
+                          num_object_paths(config),
                           panner->num_virtual_loudspeakers(),
+                          max_direct_delay(*panner),
                           panner->get_default_direct_delay()),
-      direct_delays_in(
-          "direct_delays_in", *this, pml::VectorParameterConfig(2 * config.num_objects_channels)),
+      direct_delays_in("direct_delays_in", *this, pml::VectorParameterConfig(2 * num_object_paths(config))),
       direct_gains_in("direct_gains_in",
                       *this,
-                      pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels)),
+                      pml::MatrixParameterConfig(panner->num_gains(), num_object_paths(config))),
 
       diffuse_gains(ctx, "diffuse_gains", this),
       diffuse_gains_in("diffuse_gains_in",
                        *this,
-                       pml::MatrixParameterConfig(panner->num_gains(), config.num_objects_channels)),
+                       pml::MatrixParameterConfig(panner->num_gains(), num_object_paths(config))),
 
       direct_speakers_path(ctx,
                            "direct_speakers_path",
                            this,
                            config.num_direct_speakers_channels,
                            panner->num_virtual_loudspeakers(),
+                           max_direct_delay(*panner),
                            panner->get_default_direct_delay()),
       direct_speakers_delays_in("direct_speakers_delays_in",
                                 *this,
@@ -58,56 +82,45 @@ DSP::DSP(const SignalFlowContext &ctx,
                       /* width = */ 2 * panner->num_virtual_loudspeakers(),
                       /* numInputs = */ 3),
 
-      decorrelators(ctx,
-                    "decorrelators",
-                    this,
-                    /* numberOfInputs = */ panner->num_virtual_loudspeakers(),
-                    /* numberOfOutputs = */ panner->num_virtual_loudspeakers(),
-                    /* filterLength = */ panner->decorrelator_length(),
-                    /* maxFilters = */ panner->num_virtual_loudspeakers(),
-                    /* maxRoutings = */ panner->num_virtual_loudspeakers(),
-                    /* filters = */ efl::BasicMatrix<SampleType>(),
-                    /* routings = */ rbbl::FilterRoutingList(),
-                    /* controlInputs = */ rcl::FirFilterMatrix::ControlPortConfig::None,
-                    /* fftImplementation = */ config.fft_implementation.c_str()),
-      brirs(ctx,
-            "brirs",
-            this,
-            /* numberOfInputs = */ 2 * panner->num_virtual_loudspeakers(),
-            /* numberOfOutputs = */ 2,
-            /* filterLength = */ panner->brir_length(),
-            /* maxFilters = */ panner->num_views() * 2 * panner->num_virtual_loudspeakers(),
-            /* maxRoutings = */ 2 * panner->num_virtual_loudspeakers(),
-            /* numberOfInterpolants = */ 1,
-            /* transitionSamples = */ ctx.period(),
-            /* filters = */ initial_brir_filters(),
-            /* initialInterpolants = */ initial_brir_interpolants(),
-            /* routings = */ initial_brir_routings(),
-            /* controlInputs = */ rcl::InterpolatingFirFilterMatrix::ControlPortConfig::Interpolants,
-            /* fftImplementation = */ config.fft_implementation.c_str()),
-      brir_interpolation_controller(ctx, "brir_interpolation_controller", this, config, panner),
+      diffuse_path(ctx, "diffuse_path", this, config, panner),
+      brirs(make_brir_convolver(ctx, config)),
+      brir_interpolation_controller(ctx,
+                                    "brir_interpolation_controller",
+                                    this,
+                                    config,
+                                    panner,
+                                    dynamic_cast<BinauralConvolver *>(brirs.get())),
       brir_index_in("brir_index_in", *this, pml::EmptyParameterConfig()),
 
       static_delays_in(
           "static_delays_in", *this, pml::VectorParameterConfig(2 * panner->num_virtual_loudspeakers())),
-      static_delays(ctx, "static_delays", this),
       hoa_gains_in("hoa_gains_in",
                    *this,
-                   pml::MatrixParameterConfig(panner->n_hoa_channels(), config.num_hoa_channels)),
+                   pml::MatrixParameterConfig(num_hoa_render_channels, config.num_hoa_channels)),
       hoa_matrix(ctx, "hoa_matrix", this),
       hoa_irs(ctx,
               "hoa_irs",
               this,
-              /* numberOfInputs = */ panner->n_hoa_channels(),
+              /* numberOfInputs = */ num_hoa_render_channels,
               /* numberOfOutputs = */ 2,
               /* filterLength = */ panner->hoa_ir_length(),
-              /* maxFilters = */ panner->n_hoa_channels() * 2,
-              /* maxRoutings = */ panner->n_hoa_channels() * 2,
+              /* maxFilters = */ num_hoa_render_channels * (panner->hoa_decoder_symmetric() ? 1 : 2),
+              /* maxRoutings = */ num_hoa_render_channels * 2,
               /* filters = */ efl::BasicMatrix<SampleType>(),
               /* routings = */ rbbl::FilterRoutingList(),
               /* controlInputs = */ rcl::FirFilterMatrix::ControlPortConfig::None,
-              /* fftImplementation = */ config.fft_implementation.c_str()),
-      hoa_delays(ctx, "hoa_delays", this),
+              /* fftImplementation = */
+              resolve_fft_implementation(config.fft_implementation, 2 * ctx.period()).c_str()),
+      hoa_mid_side(panner->hoa_decoder_symmetric()
+                       ? std::make_unique<rcl::GainMatrix>(ctx, "hoa_mid_side", this)
+                       : std::unique_ptr<rcl::GainMatrix>()),
+      hoa_delays(ctx,
+                 "hoa_delays",
+                 this,
+                 /* num_channels = */ 2,
+                 /* max_delay = */ panner->hoa_delay(),
+                 /* initial_delay = */ panner->hoa_delay(),
+                 /* control_input = */ false),
       add_hoa(ctx,
               "add_hoa",
               this,
@@ -115,47 +128,32 @@ DSP::DSP(const SignalFlowContext &ctx,
               /* numInputs = */ 2)
 
 {
+  // objects, possibly via clusters
+
+  if (cluster_mix) {
+    audioConnection(objects_in, cluster_mix->audioPort("in"));
+    parameterConnection(*cluster_gains_in, cluster_mix->parameterPort("gains_in"));
+  }
+  AudioPortBase &objects_source = cluster_mix ? cluster_mix->audioPort("out") : objects_in;
+
   // objects direct path
 
-  audioConnection(objects_in, objects_direct_path.audioPort("in"));
+  audioConnection(objects_source, objects_direct_path.audioPort("in"));
   audioConnection(objects_direct_path.audioPort("out"), add_brir_inputs.audioPort("in0"));
   parameterConnection(direct_gains_in, objects_direct_path.parameterPort("gains_in"));
   parameterConnection(direct_delays_in, objects_direct_path.parameterPort("delays_in"));
 
   // diffuse path
 
-  diffuse_gains.setup(/* numberOfInputs = */ config.num_objects_channels,
+  diffuse_gains.setup(/* numberOfInputs = */ num_object_paths(config),
                       /* numberOfOutputs = */ panner->num_virtual_loudspeakers(),
                       /* interpolationSteps = */ period());
 
-  // setup decorrelators
-  for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++) {
-    decorrelators.setFilter(vs, panner->get_decorrelator(vs), panner->decorrelator_length());
-    decorrelators.addRouting(vs, vs, vs);
-  }
-
-  static_delays.setup(
-      /* numberOfChannels = */ 2 * panner->num_virtual_loudspeakers(),
-      /* interpolationSteps = */ period(),
-      /* maximumDelaySeconds = */ 1.0,  // TODO: reduce this
-      /* interpolationMethod = */ "lagrangeOrder3",
-      /* methodDelayPolicy = */ rcl::DelayVector::MethodDelayPolicy::Add,
-      /* controlInputs = */ rcl::DelayVector::ControlPortConfig::Delay,
-      /* initialDelaySeconds = */ panner->get_default_static_delay());
-
-  audioConnection(objects_in, diffuse_gains.audioPort("in"));
+  audioConnection(objects_source, diffuse_gains.audioPort("in"));
   parameterConnection(diffuse_gains_in, diffuse_gains.parameterPort("gainInput"));
-  audioConnection(diffuse_gains.audioPort("out"), decorrelators.audioPort("in"));
-
-  // decorrelators -> static delays
-  for (size_t ear = 0; ear < 2; ear++)
-    for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++)
-      audioConnection(
-          decorrelators.audioPort("out"), {vs}, static_delays.audioPort("in"), {convolver_index(vs, ear)});
-
-  parameterConnection(static_delays_in, static_delays.parameterPort("delayInput"));
-
-  audioConnection(static_delays.audioPort("out"), add_brir_inputs.audioPort("in1"));
+  audioConnection(diffuse_gains.audioPort("out"), diffuse_path.audioPort("in"));
+  parameterConnection(static_delays_in, diffuse_path.parameterPort("delays_in"));
+  audioConnection(diffuse_path.audioPort("out"), add_brir_inputs.audioPort("in1"));
 
   // direct speakers
 
@@ -166,45 +164,101 @@ DSP::DSP(const SignalFlowContext &ctx,
 
   // BRIRs
 
-  audioConnection(add_brir_inputs.audioPort("out"), brirs.audioPort("in"));
-  audioConnection(brirs.audioPort("out"), add_hoa.audioPort("in0"));
+  audioConnection(add_brir_inputs.audioPort("out"), brirs->audioPort("in"));
+  audioConnection(brirs->audioPort("out"), add_hoa.audioPort("in0"));
 
   parameterConnection(brir_index_in, brir_interpolation_controller.parameterPort("brir_index_in"));
   parameterConnection(brir_interpolation_controller.parameterPort("interpolants_out"),
-                      brirs.parameterPort("interpolantInput"));
+                      brirs->parameterPort("interpolantInput"));
 
   // hoa
 
   hoa_matrix.setup(/* numberOfInputs = */ config.num_hoa_channels,
-                   /* numberOfOutputs = */ panner->n_hoa_channels(),
+                   /* numberOfOutputs = */ num_hoa_render_channels,
                    /* interpolationSteps = */ period());
   // hoa irs
-  for (size_t hoa_channel = 0; hoa_channel < panner->n_hoa_channels(); hoa_channel++) {
-    for (size_t ear = 0; ear < 2; ear++) {
-      size_t filter_idx = hoa_channel * 2 + ear;
-      hoa_irs.setFilter(filter_idx, panner->get_hoa_ir(hoa_channel, ear), panner->hoa_ir_length());
-      hoa_irs.addRouting(hoa_channel, ear, filter_idx);
+  if (panner->hoa_decoder_symmetric()) {
+    // the right ear IRs are the same as the left, except that they are
+    // negated for antisymmetric channels, so convolve each channel once with
+    // the left IR, summing symmetric channels into output 0 and antisymmetric
+    // channels into output 1; then left = sym + antisym, right = sym - antisym
+    for (size_t hoa_channel = 0; hoa_channel < num_hoa_render_channels; hoa_channel++) {
+      hoa_irs.setFilter(hoa_channel, panner->get_hoa_ir(hoa_channel, 0), panner->hoa_ir_length());
+      hoa_irs.addRouting(hoa_channel, Panner::hoa_channel_antisymmetric(hoa_channel) ? 1 : 0, hoa_channel);
     }
-  }
 
-  hoa_delays.setup(
-      /* numberOfChannels = */ 2,
-      /* interpolationSteps = */ period(),
-      /* maximumDelaySeconds = */ 1.0,  // TODO: reduce this
-      /* interpolationMethod = */ "lagrangeOrder3",
-      /* methodDelayPolicy = */ rcl::DelayVector::MethodDelayPolicy::Add,
-      /* controlInputs = */ rcl::DelayVector::ControlPortConfig::None,
-      /* initialDelaySeconds = */ panner->hoa_delay());
+    efl::BasicMatrix<SampleType> mid_side_gains(2, 2);
+    mid_side_gains(0, 0) = 1.0f;
+    mid_side_gains(0, 1) = 1.0f;
+    mid_side_gains(1, 0) = 1.0f;
+    mid_side_gains(1, 1) = -1.0f;
+    hoa_mid_side->setup(/* numberOfInputs = */ 2,
+                        /* numberOfOutputs = */ 2,
+                        /* interpolationSteps = */ period(),
+                        /* initialGains = */ mid_side_gains,
+                        /* controlInputs = */ false);
+  } else {
+    for (size_t hoa_channel = 0; hoa_channel < num_hoa_render_channels; hoa_channel++) {
+      for (size_t ear = 0; ear < 2; ear++) {
+        size_t filter_idx = hoa_channel * 2 + ear;
+        hoa_irs.setFilter(filter_idx, panner->get_hoa_ir(hoa_channel, ear), panner->hoa_ir_length());
+        hoa_irs.addRouting(hoa_channel, ear, filter_idx);
+      }
+    }
+  }
 
   parameterConnection(hoa_gains_in, hoa_matrix.parameterPort("gainInput"));
   audioConnection(hoa_in, hoa_matrix.audioPort("in"));
   audioConnection(hoa_matrix.audioPort("out"), hoa_irs.audioPort("in"));
-  audioConnection(hoa_irs.audioPort("out"), hoa_delays.audioPort("in"));
+  if (hoa_mid_side) {
+    audioConnection(hoa_irs.audioPort("out"), hoa_mid_side->audioPort("in"));
+    audioConnection(hoa_mid_side->audioPort("out"), hoa_delays.audioPort("in"));
+  } else
+    audioConnection(hoa_irs.audioPort("out"), hoa_delays.audioPort("in"));
   audioConnection(hoa_delays.audioPort("out"), add_hoa.audioPort("in1"));
 
   audioConnection(add_hoa.audioPort("out"), out);
 }
 
+std::unique_ptr<Component> DSP::make_brir_convolver(const SignalFlowContext &ctx, const ConfigImpl &config)
+{
+  size_t num_slots = num_brir_slots(config, *panner);
+  size_t max_filters = num_slots * 2 * panner->num_virtual_loudspeakers();
+  size_t filter_length = brir_render_length(config, panner->brir_length());
+
+  if (config.binaural_convolver)
+    return std::make_unique<BinauralConvolver>(ctx,
+                                               "brirs",
+                                               this,
+                                               /* num_inputs = */ 2 * panner->num_virtual_loudspeakers(),
+                                               /* filter_length = */ filter_length,
+                                               /* max_filters = */ max_filters,
+                                               /* filters = */ initial_brir_filters(config),
+                                               /* initial_interpolants = */ initial_brir_interpolants(),
+                                               /* routings = */ initial_brir_routings(),
+                                               // views are loaded by BRIRInterpolationController
+                                               /* filter_input = */ false,
+                                               /* fft_implementation = */ config.fft_implementation);
+  else
+    return std::make_unique<rcl::InterpolatingFirFilterMatrix>(
+        ctx,
+        "brirs",
+        this,
+        /* numberOfInputs = */ 2 * panner->num_virtual_loudspeakers(),
+        /* numberOfOutputs = */ 2,
+        /* filterLength = */ filter_length,
+        /* maxFilters = */ max_filters,
+        /* maxRoutings = */ 2 * panner->num_virtual_loudspeakers(),
+        /* numberOfInterpolants = */ 1,
+        /* transitionSamples = */ ctx.period(),
+        /* filters = */ initial_brir_filters(config),
+        /* initialInterpolants = */ initial_brir_interpolants(),
+        /* routings = */ initial_brir_routings(),
+        /* controlInputs = */ rcl::InterpolatingFirFilterMatrix::ControlPortConfig::Interpolants,
+        /* fftImplementation = */
+        resolve_fft_implementation(config.fft_implementation, 2 * ctx.period()).c_str());
+}
+
 rbbl::InterpolationParameterSet DSP::initial_brir_interpolants()
 {
   rbbl::InterpolationParameterSet ips;
@@ -223,14 +277,19 @@ rbbl::FilterRoutingList DSP::initial_brir_routings()
   return routings;
 }
 
-efl::BasicMatrix<float> DSP::initial_brir_filters()
+efl::BasicMatrix<float> DSP::initial_brir_filters(const ConfigImpl &config)
 {
-  efl::BasicMatrix<float> filters(panner->num_views() * 2 * panner->num_virtual_loudspeakers(),
-                                  panner->brir_length());
-  for (size_t view = 0; view < panner->num_views(); view++)
+  // when using a BRIRViewCache, slot i initially holds view i
+  size_t num_slots = brir_index.sizes[0];
+  size_t length = brir_render_length(config, panner->brir_length());
+  efl::BasicMatrix<float> filters(num_slots * 2 * panner->num_virtual_loudspeakers(), length);
+  std::vector<float> brir(length);
+  for (size_t view = 0; view < num_slots; view++)
     for (size_t vs = 0; vs < panner->num_virtual_loudspeakers(); vs++)
-      for (size_t ear = 0; ear < 2; ear++)
-        filters.setRow(brir_index(view, vs, ear), panner->get_brir(view, vs, ear));
+      for (size_t ear = 0; ear < 2; ear++) {
+        truncate_brir(panner->get_brir(view, vs, ear), panner->brir_length(), length, brir.data());
+        filters.setRow(brir_index(view, vs, ear), brir.data());
+      }
 
   return filters;
 }
@@ -1,7 +1,6 @@
 #pragma once
 #include <libpml/matrix_parameter.hpp>
 #include <librcl/add.hpp>
-#include <librcl/delay_vector.hpp>
 #include <librcl/fir_filter_matrix.hpp>
 #include <librcl/gain_matrix.hpp>
 #include <librcl/interpolating_fir_filter_matrix.hpp>
@@ -11,7 +10,12 @@
 #include <memory>
 
 #include "bear/api.hpp"
+#include "binaural_convolver.hpp"
 #include "brir_interpolation_controller.hpp"
+#include "cluster_mix.hpp"
+#include "delays.hpp"
+#include "diffuse_path.hpp"
+#include "direct_speakers_path.hpp"
 #include "panner.hpp"
 #include "per_ear_delay.hpp"
 #include "utils.hpp"
@@ -28,11 +32,14 @@ class DSP : public CompositeComponent {
                std::shared_ptr<Panner> panner);
 
  private:
+  std::unique_ptr<Component> make_brir_convolver(const SignalFlowContext &ctx, const ConfigImpl &config);
   rbbl::InterpolationParameterSet initial_brir_interpolants();
   rbbl::FilterRoutingList initial_brir_routings();
-  efl::BasicMatrix<float> initial_brir_filters();
+  efl::BasicMatrix<float> initial_brir_filters(const ConfigImpl &config);
 
   std::shared_ptr<Panner> panner;
+  /// number of HOA channels being rendered, see hoa_render_channels
+  size_t num_hoa_render_channels;
 
   Indexer<2> object_ear_index;
   Indexer<2> convolver_index;
@@ -43,6 +50,11 @@ class DSP : public CompositeComponent {
   AudioInput hoa_in;
   AudioOutput out;
 
+  /// only if use_object_clustering; mixes objects_in into clusters, which are
+  /// the inputs to objects_direct_path and diffuse_gains
+  std::unique_ptr<ClusterMix> cluster_mix;
+  std::unique_ptr<ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>>> cluster_gains_in;
+
   PerEarDelay objects_direct_path;
   ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> direct_delays_in;
   ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>> direct_gains_in;
@@ -50,24 +62,27 @@ class DSP : public CompositeComponent {
   rcl::GainMatrix diffuse_gains;
   ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>> diffuse_gains_in;
 
-  PerEarDelay direct_speakers_path;
+  DirectSpeakersPath direct_speakers_path;
   ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> direct_speakers_delays_in;
   ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<float>> direct_speakers_gains_in;
 
   rcl::Add add_brir_inputs;
 
-  rcl::FirFilterMatrix decorrelators;
-  rcl::InterpolatingFirFilterMatrix brirs;
+  DiffusePath diffuse_path;
+  /// either a BinauralConvolver or an rcl::InterpolatingFirFilterMatrix
+  std::unique_ptr<Component> brirs;
   BRIRInterpolationController brir_interpolation_controller;
   ParameterInput<DoubleBufferingProtocol, ScalarParameter<unsigned int>> brir_index_in;
 
   ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> static_delays_in;
-  rcl::DelayVector static_delays;
 
   ParameterInput<pml::SharedDataProtocol, pml::MatrixParameter<SampleType>> hoa_gains_in;
   rcl::GainMatrix hoa_matrix;
   rcl::FirFilterMatrix hoa_irs;
-  rcl::DelayVector hoa_delays;
+  /// for symmetric decoders, converts the sum of the symmetric and
+  /// antisymmetric channels to left/right
+  std::unique_ptr<rcl::GainMatrix> hoa_mid_side;
+  Delays hoa_delays;
   rcl::Add add_hoa;
 };
 }  // namespace bear
@@ -1,6 +1,10 @@
 #include "dynamic_renderer.hpp"
 
+#include <algorithm>
+#include <array>
 #include <boost/container/small_vector.hpp>
+#include <boost/container/static_vector.hpp>
+#include <chrono>
 #include <libefl/basic_vector.hpp>
 #include <libefl/initialise_library.hpp>
 #include <libefl/vector_functions.hpp>
@@ -9,6 +13,7 @@
 #include "bear/api.hpp"
 #include "config_impl.hpp"
 #include "constructor_thread.hpp"
+#include "load_governor.hpp"
 #include "utils.hpp"
 
 namespace bear {
@@ -31,33 +36,38 @@ class MetadataBuffer {
 };
 
 /// controller for DynamicRendererImpl, implementing fade up, fade down, waiting and preroll logic
+///
+/// When crossfading, the old renderer keeps running while the new one is
+/// waited for (OVERLAP_WAIT) and prerolled (OVERLAP_PREROLL), then the output
+/// crossfades between them (CROSSFADE).
 class StateMachine {
  public:
-  StateMachine(size_t period_size)
-      : num_preroll_frames(static_cast<int>(std::ceil((double)num_preroll_samples / period_size)))
-  {
-  }
-
   // state transitions
 
-  // call when reconfiguration is started
-  void start_config()
+  // call when reconfiguration is started; crossfade is only possible if the
+  // old renderer is running
+  void start_config(bool crossfade)
   {
-    if (state == State::RUNNING || state == State::FADE_DOWN)
+    if (crossfade && (state == State::RUNNING || is_overlapping()))
+      set_state(State::OVERLAP_WAIT);
+    else if (state == State::RUNNING || state == State::FADE_DOWN || is_overlapping())
       set_state(State::FADE_DOWN);
     else
       set_state(State::WAIT);
   }
 
   // call when reconfiguration is finished (after start_config) and we have a
-  // renderer again
-  void config_finished()
+  // renderer again, which needs num_preroll_frames of preroll
+  void config_finished(int num_preroll_frames)
   {
     bear_assert(state != State::START, "unexpected state");
     bear_assert(state != State::RUNNING, "unexpected state");
 
     if (state == State::WAIT) {
-      set_state(State::PREROLL);
+      set_state(num_preroll_frames > 0 ? State::PREROLL : State::FADE_UP);
+      preroll_frames_left = num_preroll_frames;
+    } else if (state == State::OVERLAP_WAIT) {
+      set_state(num_preroll_frames > 0 ? State::OVERLAP_PREROLL : State::CROSSFADE);
       preroll_frames_left = num_preroll_frames;
     }
   }
@@ -72,7 +82,10 @@ class StateMachine {
     else if (state == State::PREROLL) {
       preroll_frames_left--;
       if (preroll_frames_left == 0) set_state(State::FADE_UP);
-    } else if (state == State::FADE_UP)
+    } else if (state == State::OVERLAP_PREROLL) {
+      preroll_frames_left--;
+      if (preroll_frames_left == 0) set_state(State::CROSSFADE);
+    } else if (state == State::FADE_UP || state == State::CROSSFADE)
       set_state(State::RUNNING);
   }
 
@@ -95,17 +108,42 @@ class StateMachine {
   bool should_render()
   {
     return state == State::RUNNING || state == State::FADE_DOWN || state == State::PREROLL ||
-           state == State::FADE_UP;
+           state == State::FADE_UP || is_overlapping();
   }
 
   // should the renderer be swapped with the configuration result?
   bool should_swap() { return state == State::START || state == State::WAIT; }
 
+  // should the next renderer be set to the configuration result?
+  bool should_swap_next() { return state == State::OVERLAP_WAIT; }
+
+  // should the next renderer process function be called?
+  bool should_render_next() { return state == State::OVERLAP_PREROLL || state == State::CROSSFADE; }
+
+  // should the output crossfade from the renderer to the next renderer, which
+  // then replaces it?
+  bool should_crossfade() { return state == State::CROSSFADE; }
+
   bool is_running() { return state == State::RUNNING; }
 
+  bool is_overlapping()
+  {
+    return state == State::OVERLAP_WAIT || state == State::OVERLAP_PREROLL || state == State::CROSSFADE;
+  }
+
  private:
   // generally, refers to what should be done in the next frame
-  enum class State { START, FADE_DOWN, WAIT, PREROLL, FADE_UP, RUNNING };
+  enum class State {
+    START,
+    FADE_DOWN,
+    WAIT,
+    PREROLL,
+    FADE_UP,
+    RUNNING,
+    OVERLAP_WAIT,
+    OVERLAP_PREROLL,
+    CROSSFADE,
+  };
 
   State state = State::START;
   int preroll_frames_left = 0;
@@ -113,15 +151,10 @@ class StateMachine {
   void set_state(State s)
   {
     state = s;
-    // const char *names[] = {"START", "FADE_DOWN", "WAIT", "PREROLL", "FADE_UP", "RUNNING"};
+    // const char *names[] = {"START", "FADE_DOWN", "WAIT", "PREROLL", "FADE_UP", "RUNNING",
+    //                        "OVERLAP_WAIT", "OVERLAP_PREROLL", "CROSSFADE"};
     // std::cout << "state: " << names[(int)state] << "\n";
   }
-
-  static constexpr int num_preroll_samples = 2976   // brir length
-                                             + 128  // decorrelation filters
-                                             + 38   // max delays
-                                             + 3;   // delay implementation
-  const int num_preroll_frames;
 };
 
 class TypeAdapter {};
@@ -179,47 +212,104 @@ class DynamicRendererImpl {
         objects_buffer(max_size),
         direct_speakers_buffer(max_size),
         hoa_buffer(max_size),
-        state(block_size),
         ramp_up(block_size, 0),
         ramp_down(block_size, 0),
-        zeros(block_size, 0)
+        zeros(block_size, 0),
+        next_output(2 * block_size, 0)
   {
     visr::efl::vectorRamp<Sample>(ramp_up.data(), block_size, 0.0, 1.0, true, false);
     visr::efl::vectorRamp<Sample>(ramp_down.data(), block_size, 1.0, 0.0, true, false);
     visr::efl::vectorZero(zeros.data(), block_size);
 
-    next_render_config.num_objects_channels = 0;
-    next_render_config.num_direct_speakers_channels = 0;
-    next_render_config.num_hoa_channels = 0;
+    // a default ConfigImpl has zero input channels
+    next_render_config = std::make_shared<const ConfigImpl>();
+    current_render_config = next_renderer_config = next_render_config;
   }
 
   void set_config_common(const Config &config)
   {
+    bool sample_rate_changed = config.get_sample_rate() != sample_rate;
     sample_rate = config.get_sample_rate();
     bear_assert(config.get_period_size() == block_size, "config has incorrect period size");
 
-    next_render_config = config.get_impl();
+    // the governor needs the sample rate; this resets the level if it changes
+    if (governor_options.enabled && (!governor || sample_rate_changed)) make_governor();
+
+    user_config = config.get_impl();
+    make_level_configs();
+    next_render_config = level_configs[get_quality_level()];
   }
 
   void set_config(const Config &config)
   {
     set_config_common(config);
-
-    if (!constructor_thread.start(config)) next_config = config.get_impl();
-
-    state.start_config();
+    start_config(reconfigure_mode);
   }
 
   void set_config_blocking(const Config &config)
   {
-    renderer = Renderer(config);
+    Config governed = config;
+    apply_quality_level(governed.get_impl(), governor_options, get_quality_level());
+    renderer = Renderer(governed);
+    next_renderer = boost::none;
 
     set_config_common(config);
     current_render_config = next_render_config;
-    initialise_renderer();
+    initialise_renderer(*renderer, *current_render_config);
     state.set_config_blocking();
   }
 
+  void set_governor(const GovernorOptions &options, std::function<void(int)> level_callback)
+  {
+    check_governor_options(options);
+    int old_level = get_quality_level();
+
+    governor_options = options;
+    governor_callback = std::move(level_callback);
+    make_governor();
+    make_level_configs();
+
+    if (get_quality_level() != old_level) change_quality_level(old_level);
+  }
+
+  int get_quality_level() const { return governor ? governor->level() : 0; }
+  size_t get_num_quality_changes() const { return num_quality_changes; }
+
+  void set_background_preroll(bool enabled) { background_preroll = enabled; }
+  bool get_background_preroll() const { return background_preroll; }
+
+  void set_reconfigure_mode(ReconfigureMode mode) { reconfigure_mode = mode; }
+  ReconfigureMode get_reconfigure_mode() const { return reconfigure_mode; }
+  CrossfadeStats get_crossfade_stats() const { return crossfade_stats; }
+
+  MemoryReport get_memory_report() const
+  {
+    MemoryReport report;
+    auto add_report = [&](const Renderer &r) {
+      MemoryReport r_report = r.get_memory_report();
+      for (auto &component : r_report.components) {
+        auto it = std::find_if(report.components.begin(),
+                               report.components.end(),
+                               [&](const ComponentMemory &c) { return c.name == component.name; });
+        if (it == report.components.end())
+          report.components.push_back(component);
+        else {
+          it->allocated_bytes += component.allocated_bytes;
+          it->mapped_bytes += component.mapped_bytes;
+          it->resident_bytes += component.resident_bytes;
+        }
+      }
+      report.allocated_bytes += r_report.allocated_bytes;
+      report.mapped_bytes += r_report.mapped_bytes;
+      report.resident_bytes += r_report.resident_bytes;
+    };
+
+    if (renderer) add_report(*renderer);
+    if (next_renderer) add_report(*next_renderer);
+    for (auto &r : retired_renderers) add_report(r);
+    return report;
+  }
+
   std::exception_ptr get_error() { return constructor_thread.get_construction_error(); }
   bool is_running() { return state.is_running(); }
 
@@ -248,24 +338,53 @@ class DynamicRendererImpl {
   {
     if (next_config) {
       constructor_thread.get_result();
-      if (constructor_thread.start(*next_config)) next_config = boost::none;
+      if (constructor_thread.start(next_config, background_preroll)) next_config = nullptr;
     }
 
     maybe_swap();
+    maybe_swap_next();
+    destroy_retired();
 
+    double process_time = 0.0;
     if (state.should_render()) {
       bear_assert(renderer.has_value(), "expected renderer to be set");
 
-      fill_temp_pointers(
-          current_render_config.num_objects_channels, temp_objects, num_objects_channels, objects_input);
-      fill_temp_pointers(current_render_config.num_direct_speakers_channels,
-                         temp_direct_speakers,
-                         num_direct_speakers_channels,
-                         direct_speakers_input);
-      fill_temp_pointers(current_render_config.num_hoa_channels, temp_hoa, num_hoa_channels, hoa_input);
-      renderer->process(temp_objects.data(), temp_direct_speakers.data(), temp_hoa.data(), output);
+      process_time = render(*renderer,
+                            *current_render_config,
+                            num_objects_channels,
+                            objects_input,
+                            num_direct_speakers_channels,
+                            direct_speakers_input,
+                            num_hoa_channels,
+                            hoa_input,
+                            output);
+
+      update_governor(process_time);
+    } else if (governor)
+      governor->reset();
+
+    if (state.should_render_next()) {
+      bear_assert(next_renderer.has_value(), "expected next renderer to be set");
+
+      Sample *next_output_ptrs[2] = {next_output.data(), next_output.data() + block_size};
+      double next_process_time = render(*next_renderer,
+                                        *next_renderer_config,
+                                        num_objects_channels,
+                                        objects_input,
+                                        num_direct_speakers_channels,
+                                        direct_speakers_input,
+                                        num_hoa_channels,
+                                        hoa_input,
+                                        next_output_ptrs);
+
+      crossfade_stats.num_overlap_periods++;
+      crossfade_stats.overlap_time += next_process_time;
+      double load = (process_time + next_process_time) * sample_rate / block_size;
+      crossfade_stats.max_overlap_load = std::max(crossfade_stats.max_overlap_load, load);
     }
 
+    if (state.should_crossfade()) crossfade(output);
+
     if (state.should_fade_down())
       for (size_t i = 0; i < 2; i++)
         visr::efl::vectorMultiplyInplace(ramp_down.data(), output[i], block_size);
@@ -289,16 +408,16 @@ class DynamicRendererImpl {
   void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time)
   {
     if (renderer) renderer->set_listener(l, interpolation_time);
+    if (next_renderer) next_renderer->set_listener(l, interpolation_time);
 
     last_listener = l;
-    last_listener_interpolation_time = interpolation_time;
   }
 
  private:
   template <typename Adapter, typename Buffer>
   bool add_block(Buffer &buffer, size_t channel, typename Adapter::InputType metadata)
   {
-    if (!Adapter::input_fits(next_render_config, channel, metadata))
+    if (!Adapter::input_fits(*next_render_config, channel, metadata))
       throw std::invalid_argument("not enough channels configured to add block");
 
     if (metadata.rtime) *metadata.rtime += time_offset;
@@ -310,48 +429,212 @@ class DynamicRendererImpl {
       // only push metadata to the renderer when we will actually be calling
       // the process function, otherwise our notion of time and the renderer's
       // may get out of sync (plus it's wasted effort)
-      if (state.should_render() && Adapter::input_fits(current_render_config, channel, metadata)) {
+      if (state.should_render() && Adapter::input_fits(*current_render_config, channel, metadata)) {
         bear_assert(renderer.has_value(), "expected renderer to be set");
         bear_assert(Adapter::add_block(*renderer, channel, metadata), "could not push");
       }
+      // the same for the next renderer while it is being prerolled
+      if (state.should_render_next() && Adapter::input_fits(*next_renderer_config, channel, metadata)) {
+        bear_assert(next_renderer.has_value(), "expected next renderer to be set");
+        bear_assert(Adapter::add_block(*next_renderer, channel, metadata), "could not push");
+      }
       return true;
     } else
       return false;
   }
 
+  /// start reconfiguring to next_render_config, switching to the new
+  /// renderer according to mode
+  void start_config(ReconfigureMode mode)
+  {
+    if (!constructor_thread.start(next_render_config, background_preroll)) next_config = next_render_config;
+
+    // a renderer being prerolled for a crossfade has an old configuration;
+    // there is always space to retire it, because there was space for the
+    // renderer when the crossfade started
+    if (next_renderer) retire(next_renderer);
+
+    // the end of a crossfade retires the old renderer, so fade instead if
+    // there is no space for it
+    bool crossfade = mode == ReconfigureMode::CROSSFADE && retired_renderers.size() < max_retired_renderers;
+    state.start_config(crossfade);
+  }
+
+  /// make the governor if it is enabled and the sample rate is known,
+  /// starting at level 0
+  void make_governor()
+  {
+    if (governor_options.enabled && sample_rate != 0)
+      governor = LoadGovernor(governor_options, (double)block_size / sample_rate);
+    else
+      governor = boost::none;
+  }
+
+  /// make the user configuration modified for each quality level, so that
+  /// changing level in process does not copy or allocate
+  void make_level_configs()
+  {
+    for (int level = 0; level <= GovernorOptions::max_level; level++) {
+      auto config = std::make_shared<ConfigImpl>(user_config);
+      apply_quality_level(*config, governor_options, level);
+      level_configs[level] = std::move(config);
+    }
+  }
+
+  void update_governor(double process_time)
+  {
+    if (!governor) return;
+
+    // only measure while running normally, as fading and reconfiguring
+    // affect the timing
+    if (!state.is_running()) {
+      governor->reset();
+      return;
+    }
+
+    int old_level = governor->level();
+    if (governor->update(process_time)) change_quality_level(old_level);
+  }
+
+  /// reconfigure for a new quality level. Increases happen under overload,
+  /// so they fade rather than adding the cost of processing two renderers;
+  /// decreases crossfade, so that the change is not heard as a gap in the
+  /// output.
+  void change_quality_level(int old_level)
+  {
+    num_quality_changes++;
+    if (governor_callback) governor_callback(get_quality_level());
+
+    // nothing to reconfigure if set_config has not been called yet
+    if (sample_rate == 0) return;
+
+    next_render_config = level_configs[get_quality_level()];
+    start_config(get_quality_level() > old_level ? ReconfigureMode::FADE : ReconfigureMode::CROSSFADE);
+  }
+
   void maybe_swap()
   {
     if (state.should_swap()) {
-      if (constructor_thread.try_swap_result(renderer)) {
+      bool prerolled;
+      if (constructor_thread.try_swap_result(renderer, &prerolled)) {
         current_render_config = next_render_config;
 
-        initialise_renderer();
+        initialise_renderer(*renderer, *current_render_config);
 
-        state.config_finished();
+        state.config_finished(get_preroll_frames(*renderer, prerolled));
       }
     }
   }
 
-  /// initialise the newly-created renderer: set up time, listener, and push
-  /// metadata from queues
-  void initialise_renderer()
+  /// like maybe_swap, but for the renderer to crossfade to
+  void maybe_swap_next()
+  {
+    if (state.should_swap_next()) {
+      bool prerolled;
+      if (constructor_thread.try_swap_result(next_renderer, &prerolled)) {
+        next_renderer_config = next_render_config;
+
+        initialise_renderer(*next_renderer, *next_renderer_config);
+
+        state.config_finished(get_preroll_frames(*next_renderer, prerolled));
+      }
+    }
+  }
+
+  /// number of periods for which r should be processed before it is faded
+  /// or crossfaded to, so that its internal state matches a renderer which
+  /// has been running continuously
+  int get_preroll_frames(const Renderer &r, bool prerolled) const
+  {
+    // already prerolled with silence on the constructor thread; the recent
+    // input is missing, but the output is usable straight away
+    if (prerolled) return 0;
+
+    return static_cast<int>((r.get_preroll_samples() + block_size - 1) / block_size);
+  }
+
+  /// crossfade from the output of renderer to next_output, then replace
+  /// renderer with next_renderer
+  void crossfade(Sample *const *output)
+  {
+    for (size_t i = 0; i < 2; i++) {
+      visr::efl::vectorMultiplyInplace(ramp_down.data(), output[i], block_size);
+      visr::efl::vectorMultiplyAddInplace(
+          ramp_up.data(), next_output.data() + i * block_size, output[i], block_size);
+    }
+
+    retire(renderer);
+    renderer = std::move(next_renderer);
+    next_renderer = boost::none;
+    current_render_config = next_renderer_config;
+
+    crossfade_stats.num_crossfades++;
+  }
+
+  /// remove a renderer, which will be destructed on the constructor thread
+  void retire(boost::optional<Renderer> &old_renderer)
   {
-    renderer->set_block_start_time({block_size * num_blocks_processed, sample_rate});
-    renderer->set_listener(last_listener, last_listener_interpolation_time);
+    bear_assert(retired_renderers.size() < max_retired_renderers, "too many retired renderers");
+    retired_renderers.push_back(std::move(*old_renderer));
+    old_renderer = boost::none;
+  }
+
+  /// pass retired renderers to the constructor thread, as far as possible
+  void destroy_retired()
+  {
+    while (!retired_renderers.empty() && constructor_thread.try_destroy(retired_renderers.back()))
+      retired_renderers.pop_back();
+  }
+
+  /// process one block with r, which has configuration config, returning the
+  /// time taken in seconds
+  double render(Renderer &r,
+                const ConfigImpl &config,
+                size_t num_objects_channels,
+                const Sample *const *objects_input,
+                size_t num_direct_speakers_channels,
+                const Sample *const *direct_speakers_input,
+                size_t num_hoa_channels,
+                const Sample *const *hoa_input,
+                Sample *const *output)
+  {
+    fill_temp_pointers(config.num_objects_channels, temp_objects, num_objects_channels, objects_input);
+    fill_temp_pointers(config.num_direct_speakers_channels,
+                       temp_direct_speakers,
+                       num_direct_speakers_channels,
+                       direct_speakers_input);
+    fill_temp_pointers(config.num_hoa_channels, temp_hoa, num_hoa_channels, hoa_input);
+
+    auto start = std::chrono::steady_clock::now();
+    r.process(temp_objects.data(), temp_direct_speakers.data(), temp_hoa.data(), output);
+    std::chrono::duration<double> process_time = std::chrono::steady_clock::now() - start;
+
+    return process_time.count();
+  }
 
-    push_data_from_buffer<ObjectsTypeAdapter>(objects_buffer);
-    push_data_from_buffer<DirectSpeakersTypeAdapter>(direct_speakers_buffer);
-    push_data_from_buffer<HOATypeAdapter>(hoa_buffer);
+  /// initialise a newly-created renderer r with configuration config: set up
+  /// time, listener, and push metadata from queues
+  void initialise_renderer(Renderer &r, const ConfigImpl &config)
+  {
+    r.set_block_start_time({block_size * num_blocks_processed, sample_rate});
+    // the new renderer starts fading in from silence (or is prerolled before
+    // crossfading), so there's no point in interpolating from its initial
+    // listener
+    r.set_listener(last_listener);
+
+    push_data_from_buffer<ObjectsTypeAdapter>(r, config, objects_buffer);
+    push_data_from_buffer<DirectSpeakersTypeAdapter>(r, config, direct_speakers_buffer);
+    push_data_from_buffer<HOATypeAdapter>(r, config, hoa_buffer);
   }
 
   template <typename Adapter, typename Buffer>
-  void push_data_from_buffer(const Buffer &buffer)
+  void push_data_from_buffer(Renderer &r, const ConfigImpl &config, const Buffer &buffer)
   {
     for (size_t i = 0; i < buffer.data.size(); i++)
       for (size_t j = 0; j < buffer.data[i].size(); j++) {
         const auto &metadata = buffer.data[i][j];
-        if (Adapter::input_fits(current_render_config, i, metadata))
-          bear_assert(Adapter::add_block(*renderer, i, metadata), "could not push");
+        if (Adapter::input_fits(config, i, metadata))
+          bear_assert(Adapter::add_block(r, i, metadata), "could not push");
       }
   }
 
@@ -384,16 +667,43 @@ class DynamicRendererImpl {
   MetadataBuffer<HOAInput, 1> hoa_buffer;
 
   boost::optional<Renderer> renderer;
+  /// renderer being prerolled to crossfade to, set while crossfading
+  boost::optional<Renderer> next_renderer;
+  /// old renderers to be destructed on the constructor thread once it is
+  /// free; this has a fixed capacity so that retiring does not allocate on
+  /// the audio thread
+  static constexpr size_t max_retired_renderers = 2;
+  boost::container::static_vector<Renderer, max_retired_renderers> retired_renderers;
+
+  // configurations are held by shared_ptr so that they can be passed around
+  // in process without copying
 
   /// the next configuration to pass to the constructor thread, set if the
   /// thread is busy when set_config is called
-  boost::optional<ConfigImpl> next_config;
+  std::shared_ptr<const ConfigImpl> next_config;
 
   /// the configuration of renderer, if it exists
-  ConfigImpl current_render_config;
+  std::shared_ptr<const ConfigImpl> current_render_config;
   /// the externally-visible configuration, set by set_config, and starting
   /// with zero input channels
-  ConfigImpl next_render_config;
+  std::shared_ptr<const ConfigImpl> next_render_config;
+  /// the configuration of next_renderer, if it exists
+  std::shared_ptr<const ConfigImpl> next_renderer_config;
+
+  /// the configuration passed to set_config
+  ConfigImpl user_config;
+  /// user_config modified for each quality level; next_render_config is
+  /// the one for the current level
+  std::array<std::shared_ptr<const ConfigImpl>, GovernorOptions::max_level + 1> level_configs;
+
+  GovernorOptions governor_options;
+  boost::optional<LoadGovernor> governor;
+  std::function<void(int)> governor_callback;
+  size_t num_quality_changes = 0;
+
+  bool background_preroll = false;
+  ReconfigureMode reconfigure_mode = ReconfigureMode::FADE;
+  CrossfadeStats crossfade_stats;
 
   ConstructorThread constructor_thread;
 
@@ -402,6 +712,8 @@ class DynamicRendererImpl {
   visr::efl::BasicVector<Sample> ramp_up;
   visr::efl::BasicVector<Sample> ramp_down;
   visr::efl::BasicVector<Sample> zeros;
+  /// output of next_renderer, left then right
+  visr::efl::BasicVector<Sample> next_output;
 
   std::vector<const Sample *> temp_objects;
   std::vector<const Sample *> temp_direct_speakers;
@@ -412,7 +724,6 @@ class DynamicRendererImpl {
   // non-optional is fine, as the renderer start condition is the same as the
   // default-constructed listener
   Listener last_listener;
-  boost::optional<Time> last_listener_interpolation_time;
 };
 
 DynamicRenderer::DynamicRenderer() {}
@@ -476,6 +787,27 @@ void DynamicRenderer::set_listener(const Listener &l, const boost::optional<Time
   impl->set_listener(l, interpolation_time);
 }
 
+void DynamicRenderer::set_governor(const GovernorOptions &options, std::function<void(int)> level_callback)
+{
+  impl->set_governor(options, std::move(level_callback));
+}
+
+int DynamicRenderer::get_quality_level() const { return impl->get_quality_level(); }
+
+size_t DynamicRenderer::get_num_quality_changes() const { return impl->get_num_quality_changes(); }
+
+void DynamicRenderer::set_background_preroll(bool enabled) { impl->set_background_preroll(enabled); }
+
+bool DynamicRenderer::get_background_preroll() const { return impl->get_background_preroll(); }
+
+void DynamicRenderer::set_reconfigure_mode(ReconfigureMode mode) { impl->set_reconfigure_mode(mode); }
+
+ReconfigureMode DynamicRenderer::get_reconfigure_mode() const { return impl->get_reconfigure_mode(); }
+
+CrossfadeStats DynamicRenderer::get_crossfade_stats() const { return impl->get_crossfade_stats(); }
+
+MemoryReport DynamicRenderer::get_memory_report() const { return impl->get_memory_report(); }
+
 DynamicRenderer::~DynamicRenderer() = default;
 
 }  // namespace bear
@@ -1,10 +1,65 @@
 #pragma once
+#include <functional>
+
 #include "bear/api.hpp"
 
 namespace bear {
 
 class DynamicRendererImpl;
 
+/// options for the load governor, see DynamicRenderer::set_governor
+struct GovernorOptions {
+  /// highest quality level; see DynamicRenderer::set_governor for the
+  /// meaning of each level
+  static constexpr int max_level = 5;
+
+  bool enabled = false;
+
+  /// time constant in seconds for smoothing the load, which is the time taken
+  /// by process divided by the period length
+  double time_constant = 0.5;
+  /// increase the level (reducing quality) when the smoothed load has been
+  /// above high_load for overload_time seconds
+  double high_load = 0.8;
+  double overload_time = 1.0;
+  /// decrease the level when the smoothed load has been below low_load for
+  /// recovery_time seconds
+  double low_load = 0.4;
+  double recovery_time = 10.0;
+
+  /// max_brir_length used at level 1 and above
+  size_t truncated_brir_length = 1024;
+  /// max_hoa_order used at level 3 and above
+  int reduced_hoa_order = 1;
+  /// listener_update_rate used at level 4 and above
+  double reduced_listener_update_rate = 10.0;
+};
+
+/// how DynamicRenderer switches to a new renderer when the configuration
+/// changes, see DynamicRenderer::set_reconfigure_mode
+enum class ReconfigureMode {
+  /// fade the output down, construct and preroll the new renderer, then fade
+  /// up; this leaves a gap in the output
+  FADE,
+  /// keep rendering with the old renderer while the new one is constructed
+  /// and prerolled, then crossfade between them over one period
+  CROSSFADE,
+};
+
+/// statistics about crossfading reconfigurations, see
+/// DynamicRenderer::get_crossfade_stats
+struct CrossfadeStats {
+  /// number of completed crossfades
+  size_t num_crossfades = 0;
+  /// number of periods in which both the old and new renderers were processed
+  size_t num_overlap_periods = 0;
+  /// total time in seconds spent processing the new renderer in those periods
+  double overlap_time = 0.0;
+  /// highest time taken to process both renderers in one period, divided by
+  /// the period length
+  double max_overlap_load = 0.0;
+};
+
 /// renderer which supports dynamic configuration changes
 ///
 /// After construction, all methods can be used, but process will output
@@ -35,6 +90,9 @@ class DynamicRenderer {
   ///
   /// After calling this, either is_running() will become true after some time
   /// (with process calls), or get_error will return non-null once.
+  ///
+  /// See set_reconfigure_mode for how the output changes to the new
+  /// configuration.
   void set_config(const Config &config);
 
   /// Set the configuration; this blocks, and throws exceptions if something
@@ -74,6 +132,87 @@ class DynamicRenderer {
   Time get_delay() const;
   void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time = {});
 
+  /// Set up the load governor, which measures the time taken by process
+  /// against the period length, and reconfigures the renderer to use cheaper
+  /// settings under sustained overload. Each quality level adds to the
+  /// changes made by the previous level:
+  ///
+  /// 0. the configuration passed to set_config
+  /// 1. BRIRs are truncated to truncated_brir_length
+  /// 2. gain normalisation is disabled
+  /// 3. the HOA order is reduced to reduced_hoa_order
+  /// 4. listener updates are limited to reduced_listener_update_rate
+  /// 5. extent rendering is disabled
+  ///
+  /// Level changes are made like set_config, regardless of the reconfigure
+  /// mode: increases fade, as they happen under overload and crossfading
+  /// would add the cost of processing two renderers, while decreases
+  /// crossfade between the old and new levels (see set_reconfigure_mode for
+  /// when this is possible). The configuration for each level is made by
+  /// set_config and set_governor, so level changes in process do not
+  /// allocate. BRIRs truncated at level 1 and above are faded out over their
+  /// last few samples.
+  ///
+  /// level_callback is called with the new level whenever it changes. Changes
+  /// made by the governor are reported from process, on the audio thread, so
+  /// the callback must not block or allocate; changes made by set_governor
+  /// are reported from set_governor.
+  ///
+  /// Disabling the governor returns to level 0.
+  void set_governor(const GovernorOptions &options, std::function<void(int)> level_callback = {});
+
+  /// current quality level of the governor (0 if it is disabled)
+  int get_quality_level() const;
+  /// number of times the governor has changed the quality level
+  size_t get_num_quality_changes() const;
+
+  /// Set how reconfigurations from set_config and the governor switch to the
+  /// new renderer; the default is ReconfigureMode::FADE.
+  ///
+  /// With CROSSFADE there is no gap in the output, but after the new renderer
+  /// has been constructed, both renderers are processed for the preroll
+  /// length (see Renderer::get_preroll_samples) plus one period, roughly
+  /// doubling the time taken by process. At most one new renderer is processed alongside the
+  /// old one; reconfiguring again during a crossfade discards it and starts
+  /// again. The overlap is reported by get_crossfade_stats.
+  ///
+  /// Crossfading is only possible when the renderer is running and fewer
+  /// than two old renderers are waiting to be destructed on the background
+  /// thread, otherwise FADE is used. is_running returns false until the
+  /// crossfade has finished.
+  void set_reconfigure_mode(ReconfigureMode mode);
+  ReconfigureMode get_reconfigure_mode() const;
+
+  /// statistics about crossfading reconfigurations since construction
+  CrossfadeStats get_crossfade_stats() const;
+
+  /// Enable or disable prerolling new renderers on the background thread;
+  /// this is disabled by default.
+  ///
+  /// Normally, after a new renderer has been constructed, it is processed
+  /// with the real input for its preroll length (see
+  /// Renderer::get_preroll_samples) before being faded or crossfaded to, so
+  /// that its output matches a renderer which had been running
+  /// continuously.
+  ///
+  /// When enabled, new renderers are instead processed with silent input and
+  /// no metadata on the background thread after construction, and are used
+  /// as soon as they are ready, so that the time taken to reconfigure is
+  /// bounded by the construction time. The limitation is that the new
+  /// renderer has not seen the real input: reverberation from input before
+  /// the switch is missing, and builds up over the preroll length after it,
+  /// and the warm-up only touches the memory used to render silence.
+  void set_background_preroll(bool enabled);
+  bool get_background_preroll() const;
+
+  /// get the memory used by the renderers which currently exist (see
+  /// Renderer::get_memory_report); while reconfiguring, this includes both
+  /// the old and new renderers, with their components added together, so
+  /// the data_file.* components are counted once per renderer (see
+  /// MemoryReport). A renderer which is still being constructed is not
+  /// included.
+  MemoryReport get_memory_report() const;
+
  private:
   std::unique_ptr<DynamicRendererImpl> impl;
 };
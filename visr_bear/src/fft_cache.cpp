@@ -0,0 +1,215 @@
+#include "fft_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <fstream>
+#include <libefl/basic_matrix.hpp>
+#include <librbbl/fft_wrapper_factory.hpp>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bear/api.hpp"
+#include "fft_utils.hpp"
+
+#ifdef BEAR_FFTW_WISDOM
+#include <fftw3.h>
+#endif
+
+namespace bear {
+using namespace visr;
+
+namespace {
+  using Fft = rbbl::FftWrapperBase<SampleType>;
+
+  /// implementations tried for "auto", in order of preference if the timings
+  /// are equal; ones which are not available are skipped
+  const char *auto_candidates[] = {"default", "kissfft", "ffts", "fftw"};
+
+  /// time taken for a forward and inverse transform with fft
+  double time_fft(Fft &fft, std::size_t fft_size)
+  {
+    efl::BasicMatrix<SampleType> time_buf(1, fft_size, cVectorAlignmentSamples);
+    efl::BasicMatrix<std::complex<SampleType>> spectrum(1, fft_size / 2 + 1, cVectorAlignmentSamples);
+    time_buf.zeroFill();
+
+    const int num_transforms = 100;
+    double best = 0.0;
+    // the first run warms up the caches; take the best of the rest
+    for (int run = 0; run < 4; run++) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_transforms; i++) {
+        check_fft(fft.forwardTransform(time_buf.row(0), spectrum.row(0)));
+        check_fft(fft.inverseTransform(spectrum.row(0), time_buf.row(0)));
+      }
+      std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+      if (run == 1)
+        best = duration.count();
+      else if (run > 1)
+        best = std::min(best, duration.count());
+    }
+
+    return best / num_transforms;
+  }
+
+  class Cache : public std::enable_shared_from_this<Cache> {
+   public:
+    std::shared_ptr<Fft> get(const std::string &implementation, std::size_t fft_size)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      Key key{resolve(implementation, fft_size), fft_size};
+
+      std::unique_ptr<Fft> fft;
+      std::vector<std::unique_ptr<Fft>> &entries = idle[key];
+      if (entries.size()) {
+        fft = std::move(entries.back());
+        entries.pop_back();
+      } else
+        fft = create(key);
+
+      std::shared_ptr<Cache> self = shared_from_this();
+      std::shared_ptr<Fft> result(fft.get(), [self, key](Fft *p) { self->put(key, p); });
+      fft.release();
+      return result;
+    }
+
+    std::string resolve_implementation(const std::string &implementation, std::size_t fft_size)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return resolve(implementation, fft_size);
+    }
+
+    void set_fftw_wisdom_file(const std::string &path)
+    {
+#ifdef BEAR_FFTW_WISDOM
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // a file which does not exist yet will be created when wisdom is saved
+      if (std::ifstream(path).good() && !fftwf_import_wisdom_from_filename(path.c_str()))
+        throw std::runtime_error("could not read FFTW wisdom from " + path);
+
+      wisdom_file = path;
+#else
+      (void)path;
+      throw std::runtime_error("BEAR was built without FFTW wisdom support (BEAR_FFTW_WISDOM)");
+#endif
+    }
+
+    size_t num_idle()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t n = 0;
+      for (auto &entry : idle) n += entry.second.size();
+      return n;
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      idle.clear();
+    }
+
+   private:
+    using Key = std::pair<std::string, std::size_t>;
+
+    void put(const Key &key, Fft *fft)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      idle[key].emplace_back(fft);
+    }
+
+    /// make a new FFT wrapper; FFTW planning is not thread-safe, so this is
+    /// only called with mutex held
+    std::unique_ptr<Fft> create(const Key &key)
+    {
+      std::unique_ptr<Fft> fft =
+          rbbl::FftWrapperFactory<SampleType>::create(key.first, key.second, cVectorAlignmentSamples);
+      if (key.first == "fftw") save_fftw_wisdom();
+      return fft;
+    }
+
+    std::string resolve(const std::string &implementation, std::size_t fft_size)
+    {
+      if (implementation != "auto") return implementation;
+
+      auto it = auto_implementations.find(fft_size);
+      if (it != auto_implementations.end()) return it->second;
+
+      std::string best_name;
+      std::unique_ptr<Fft> best_fft;
+      double best_time = 0.0;
+      for (const char *name : auto_candidates) {
+        std::unique_ptr<Fft> fft;
+        try {
+          fft = create({name, fft_size});
+        } catch (std::exception &) {
+          continue;
+        }
+
+        double time = time_fft(*fft, fft_size);
+        if (!best_fft || time < best_time) {
+          best_name = name;
+          best_fft = std::move(fft);
+          best_time = time;
+        }
+      }
+
+      if (!best_fft) throw std::runtime_error("no FFT implementations are available");
+
+      // keep it for the renderer which asked for it
+      idle[{best_name, fft_size}].push_back(std::move(best_fft));
+      auto_implementations[fft_size] = best_name;
+      return best_name;
+    }
+
+    void save_fftw_wisdom()
+    {
+#ifdef BEAR_FFTW_WISDOM
+      // failing to save only makes planning slower next time, so is not
+      // worth failing renderer construction for
+      if (wisdom_file.size()) fftwf_export_wisdom_to_filename(wisdom_file.c_str());
+#endif
+    }
+
+    std::mutex mutex;
+    std::map<Key, std::vector<std::unique_ptr<Fft>>> idle;
+    std::map<std::size_t, std::string> auto_implementations;
+    std::string wisdom_file;
+  };
+
+  /// the process-wide cache; FFT wrappers in use hold a reference to it, so it
+  /// outlives them
+  std::shared_ptr<Cache> get_cache()
+  {
+    static std::shared_ptr<Cache> cache = std::make_shared<Cache>();
+    return cache;
+  }
+}  // namespace
+
+std::shared_ptr<Fft> get_cached_fft(const std::string &implementation, std::size_t fft_size)
+{
+  return get_cache()->get(implementation, fft_size);
+}
+
+std::string resolve_fft_implementation(const std::string &implementation, std::size_t fft_size)
+{
+  return get_cache()->resolve_implementation(implementation, fft_size);
+}
+
+void FFTCache::set_fftw_wisdom_file(const std::string &path) { get_cache()->set_fftw_wisdom_file(path); }
+
+std::string FFTCache::get_auto_implementation(size_t period_size)
+{
+  return resolve_fft_implementation("auto", 2 * period_size);
+}
+
+size_t FFTCache::get_num_idle() { return get_cache()->num_idle(); }
+
+void FFTCache::clear() { get_cache()->clear(); }
+
+}  // namespace bear
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <librbbl/fft_wrapper_base.hpp>
+#include <libvisr/constants.hpp>
+#include <memory>
+#include <string>
+
+namespace bear {
+
+/// Get an FFT wrapper for exclusive use from the process-wide cache (see
+/// FFTCache in api.hpp), creating one with rbbl::FftWrapperFactory if there
+/// are none of this implementation and size which are not in use. It is
+/// returned to the cache when the last copy of the pointer is destroyed.
+///
+/// "auto" is resolved with resolve_fft_implementation.
+std::shared_ptr<visr::rbbl::FftWrapperBase<visr::SampleType>> get_cached_fft(
+    const std::string &implementation, std::size_t fft_size);
+
+/// resolve "auto" to the implementation selected for fft_size, timing the
+/// available implementations the first time this is called for each size;
+/// other names are returned unchanged
+std::string resolve_fft_implementation(const std::string &implementation, std::size_t fft_size);
+
+}  // namespace bear
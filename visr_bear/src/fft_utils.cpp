@@ -0,0 +1,60 @@
+#include "fft_utils.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <libefl/basic_matrix.hpp>
+#include <stdexcept>
+
+namespace bear {
+using namespace visr;
+
+void check_fft(efl::ErrorCode res)
+{
+  if (res != efl::noError) throw std::runtime_error("FFT failed");
+}
+
+SampleType overlap_save_scale(rbbl::FftWrapperBase<SampleType> &fft, std::size_t block_size)
+{
+  // FFT implementations may need aligned buffers
+  efl::BasicMatrix<SampleType> time_buf(1, 2 * block_size, cVectorAlignmentSamples);
+  efl::BasicMatrix<std::complex<SampleType>> spectra(2, block_size + 1, cVectorAlignmentSamples);
+  SampleType *time = time_buf.row(0);
+  std::complex<SampleType> *input_spectrum = spectra.row(0);
+  std::complex<SampleType> *filter_spectrum = spectra.row(1);
+
+  // impulse at the start of the current input block
+  std::fill(time, time + 2 * block_size, 0.0f);
+  time[block_size] = 1.0f;
+  check_fft(fft.forwardTransform(time, input_spectrum));
+
+  // unit impulse filter
+  std::fill(time, time + 2 * block_size, 0.0f);
+  time[0] = 1.0f;
+  check_fft(fft.forwardTransform(time, filter_spectrum));
+
+  for (std::size_t i = 0; i < block_size + 1; i++) filter_spectrum[i] *= input_spectrum[i];
+  check_fft(fft.inverseTransform(filter_spectrum, time));
+
+  // the output block is the second half
+  return 1.0f / time[block_size];
+}
+
+void transform_filter_partition(rbbl::FftWrapperBase<SampleType> &fft,
+                                const SampleType *filter,
+                                std::size_t length,
+                                std::size_t block_size,
+                                std::size_t partition,
+                                SampleType scale,
+                                SampleType *time_buf,
+                                std::complex<SampleType> *spectrum)
+{
+  std::size_t start = std::min(partition * block_size, length);
+  std::size_t end = std::min(start + block_size, length);
+
+  std::fill(time_buf, time_buf + 2 * block_size, 0.0f);
+  for (std::size_t i = start; i < end; i++) time_buf[i - start] = filter[i] * scale;
+
+  check_fft(fft.forwardTransform(time_buf, spectrum));
+}
+
+}  // namespace bear
@@ -0,0 +1,49 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <libefl/error_codes.hpp>
+#include <librbbl/fft_wrapper_base.hpp>
+#include <libvisr/constants.hpp>
+
+namespace bear {
+
+// helpers for uniformly-partitioned overlap-save convolution, with
+// partitions of block_size samples and an FFT size of 2 * block_size
+
+/// throw if an FFT operation failed
+void check_fft(visr::efl::ErrorCode res);
+
+/// the scaling of the FFT depends on the implementation; this measures the
+/// gain of the overlap-save process (forward transform of input and filter,
+/// multiply, inverse transform) for unit impulses, returning the scale which
+/// should be applied to the filters to give unity gain
+visr::SampleType overlap_save_scale(visr::rbbl::FftWrapperBase<visr::SampleType> &fft,
+                                    std::size_t block_size);
+
+/// forward transform one partition of a filter of length samples into
+/// spectrum (block_size + 1 bins), scaled by scale; time_buf must hold
+/// 2 * block_size samples
+void transform_filter_partition(visr::rbbl::FftWrapperBase<visr::SampleType> &fft,
+                                const visr::SampleType *filter,
+                                std::size_t length,
+                                std::size_t block_size,
+                                std::size_t partition,
+                                visr::SampleType scale,
+                                visr::SampleType *time_buf,
+                                std::complex<visr::SampleType> *spectrum);
+
+/// acc += weight * x * h, for n complex values stored as interleaved real and
+/// imaginary parts; written on real values so that it vectorises
+inline void complex_mac(visr::SampleType *acc,
+                        const visr::SampleType *x,
+                        const visr::SampleType *h,
+                        visr::SampleType weight,
+                        std::size_t n)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    acc[2 * i] += weight * (x[2 * i] * h[2 * i] - x[2 * i + 1] * h[2 * i + 1]);
+    acc[2 * i + 1] += weight * (x[2 * i] * h[2 * i + 1] + x[2 * i + 1] * h[2 * i]);
+  }
+}
+
+}  // namespace bear
@@ -24,14 +24,15 @@ GainCalcHOA::GainCalcHOA(const SignalFlowContext &ctx,
     : AtomicComponent(ctx, name, parent),
       panner(std::move(panner_)),
       sample_rate(config.sample_rate),
+      order(hoa_render_order(config, panner->hoa_order())),
+      num_hoa_channels(hoa_render_channels(config, panner->hoa_order())),
       metadata_in("metadata_in", *this, pml::EmptyParameterConfig()),
-      gains_out(
-          "gains_out", *this, pml::MatrixParameterConfig(panner->n_hoa_channels(), config.num_hoa_channels)),
+      gains_out("gains_out", *this, pml::MatrixParameterConfig(num_hoa_channels, config.num_hoa_channels)),
       listener_in("listener_in", *this, pml::EmptyParameterConfig()),
-      per_channel_data(config.num_hoa_channels, {panner->n_hoa_channels()}),
-      sh_rotation_matrix(Eigen::MatrixXd::Identity(panner->n_hoa_channels(), panner->n_hoa_channels())),
-      num_hoa_channels(panner->n_hoa_channels()),
-      order(panner->hoa_order())
+      per_channel_data(config.num_hoa_channels, {num_hoa_channels}),
+      yaw_rotation(order),
+      sh_rotation_matrix(Eigen::MatrixXd::Identity(num_hoa_channels, num_hoa_channels)),
+      rotated(num_hoa_channels)
 {
 }
 
@@ -89,7 +90,14 @@ void GainCalcHOA::process()
 
   if (listener_in.changed()) {
     listener_changed = true;
-    quaternion_to_sh_rotation_matrix(listener_in.data().orientation, order, sh_rotation_matrix);
+
+    boost::optional<double> yaw = quaternion_to_yaw(listener_in.data().orientation);
+    // order 0 is not affected by rotation
+    rotation_is_yaw = yaw || order == 0;
+    if (rotation_is_yaw)
+      yaw_rotation.set_yaw(yaw ? *yaw : 0.0);
+    else
+      quaternion_to_sh_rotation_matrix(listener_in.data().orientation, order, sh_rotation_matrix);
 
     listener_in.resetChanged();
   }
@@ -114,8 +122,13 @@ void GainCalcHOA::process()
         using StrideT = Eigen::InnerStride<Eigen::Dynamic>;
         using MapT = Eigen::Map<Eigen::VectorXf, 0, StrideT>;
 
+        if (rotation_is_yaw)
+          yaw_rotation.apply(channel.to_hoa, rotated);
+        else
+          apply_sh_rotation_blocks(sh_rotation_matrix, order, channel.to_hoa, rotated);
+
         MapT col(&(gains_out.data()(0, i)), num_hoa_channels, StrideT(gains_out.data().stride()));
-        col = (sh_rotation_matrix * channel.to_hoa).cast<float>();
+        col = rotated.cast<float>();
       }
     }
 
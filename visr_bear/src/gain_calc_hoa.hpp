@@ -10,6 +10,7 @@
 #include "dsp.hpp"
 #include "panner.hpp"
 #include "parameters.hpp"
+#include "sh_rotation.hpp"
 #include "utils.hpp"
 
 namespace bear {
@@ -28,6 +29,10 @@ class GainCalcHOA : public AtomicComponent {
  private:
   std::shared_ptr<Panner> panner;
   size_t sample_rate;
+  /// order and number of channels being rendered, which may be less than the
+  /// order of the decoder
+  size_t order;
+  size_t num_hoa_channels;
 
   ParameterInput<pml::MessageQueueProtocol, ADMParameter<HOAInput>> metadata_in;
   ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<SampleType>> gains_out;
@@ -47,9 +52,13 @@ class GainCalcHOA : public AtomicComponent {
   };
 
   std::vector<PerChannel> per_channel_data;
+
+  // the listener rotation is applied using yaw_rotation if it is only around
+  // the z axis, otherwise the per-order blocks of sh_rotation_matrix are used
+  bool rotation_is_yaw = true;
+  SHYawRotation yaw_rotation;
   Eigen::MatrixXd sh_rotation_matrix;
-  size_t num_hoa_channels;
-  size_t order;
+  Eigen::VectorXd rotated;
 };
 
 }  // namespace bear
@@ -1,33 +1,51 @@
 #include "gain_calc_objects.hpp"
 
+#include <algorithm>
 #include <libvisr/time.hpp>
+#include <string>
 
 #include "listener_adaptation.hpp"
 
 namespace bear {
 
+namespace {
+  /// ports for listener i are suffixed with _i if there are several listeners
+  std::string listener_port_name(const std::string &name, size_t listener, size_t num_listeners)
+  {
+    if (num_listeners == 1) return name;
+    return name + "_" + std::to_string(listener);
+  }
+}  // namespace
+
 GainCalcObjects::GainCalcObjects(const SignalFlowContext &ctx,
                                  const char *name,
                                  CompositeComponent *parent,
                                  const ConfigImpl &config,
-                                 std::shared_ptr<Panner> panner_)
+                                 std::shared_ptr<Panner> panner_,
+                                 size_t num_listeners_)
     : AtomicComponent(ctx, name, parent),
       panner(std::move(panner_)),
       sample_rate(config.sample_rate),
       num_objects(config.num_objects_channels),
+      num_listeners(num_listeners_),
+      enable_extent(config.enable_extent),
       metadata_in("metadata_in", *this, pml::EmptyParameterConfig()),
-      gains_out("gains_out",
-                *this,
-                pml::MatrixParameterConfig(2 * panner->num_gains(), config.num_objects_channels)),
-      listener_in("listener_in", *this, pml::EmptyParameterConfig()),
       temp_direct(panner->num_gains()),
       temp_diffuse(panner->num_gains()),
       temp_direct_a(panner->num_gains()),
       temp_diffuse_a(panner->num_gains()),
       temp_direct_b(panner->num_gains()),
       temp_diffuse_b(panner->num_gains()),
-      per_object_data(config.num_objects_channels, panner->num_gains())
+      per_object_data(config.num_objects_channels, PerObject(panner->num_gains(), num_listeners_))
 {
+  for (size_t i = 0; i < num_listeners; i++) {
+    gains_out.push_back(std::make_unique<GainsOutput>(
+        listener_port_name("gains_out", i, num_listeners).c_str(),
+        *this,
+        pml::MatrixParameterConfig(2 * panner->num_gains(), config.num_objects_channels)));
+    listener_in.push_back(std::make_unique<ListenerInput>(
+        listener_port_name("listener_in", i, num_listeners).c_str(), *this, pml::EmptyParameterConfig()));
+  }
 }
 
 size_t GainCalcObjects::to_sample(const Time &t)
@@ -35,34 +53,60 @@ size_t GainCalcObjects::to_sample(const Time &t)
   return boost::rational_cast<size_t>(t * (int64_t)sample_rate);
 }
 
-GainCalcObjects::Point::Point(size_t n_gains) : direct_cache(n_gains), diffuse_cache(n_gains) {}
+GainCalcObjects::Point::Point(size_t n_gains, size_t n_listeners)
+    : listeners(n_listeners, PerListener(n_gains))
+{
+}
 
-void GainCalcObjects::Point::calc_gains(GainCalcObjects &parent, DirectDiffuse<Ref<VectorXd>> gains)
+void GainCalcObjects::Point::calc_gains(GainCalcObjects &parent,
+                                        size_t listener,
+                                        DirectDiffuse<Ref<VectorXd>> gains)
 {
-  if (!cache_valid) {
-    adapt_otm(otm, adapted_otm, listener);
-    parent.panner->calc_objects_gains(adapted_otm.type_metadata, {direct_cache, diffuse_cache});
-    cache_valid = true;
+  PerListener &l = listeners[listener];
+  if (!l.cache_valid) {
+    // listeners are calculated in order, so reuse the gains of an earlier
+    // listener in the same place
+    auto same = std::find_if(listeners.begin(), listeners.begin() + listener, [&](const PerListener &other) {
+      return other.cache_valid && listeners_approx_equal(other.listener, l.listener);
+    });
+
+    if (same != listeners.begin() + listener) {
+      l.direct_cache = same->direct_cache;
+      l.diffuse_cache = same->diffuse_cache;
+    } else {
+      adapt_otm(otm, adapted_otm, l.listener);
+      if (!parent.enable_extent) {
+        adapted_otm.type_metadata.width = 0.0;
+        adapted_otm.type_metadata.height = 0.0;
+        adapted_otm.type_metadata.depth = 0.0;
+      }
+      parent.panner->calc_objects_gains(adapted_otm.type_metadata, {l.direct_cache, l.diffuse_cache});
+    }
+    l.cache_valid = true;
   }
-  gains.direct = direct_cache;
-  gains.diffuse = diffuse_cache;
+  gains.direct = l.direct_cache;
+  gains.diffuse = l.diffuse_cache;
 }
 
 void GainCalcObjects::Point::set_otm(const ObjectsInput &new_otm)
 {
   otm = new_otm;
-  cache_valid = false;
+  for (PerListener &l : listeners) l.cache_valid = false;
 }
 
-void GainCalcObjects::Point::set_listener(const ListenerImpl &new_listener)
+void GainCalcObjects::Point::set_listener(size_t listener, const ListenerImpl &new_listener)
 {
-  if (!listeners_approx_equal(listener, new_listener)) {
-    listener = new_listener;
-    cache_valid = false;
+  PerListener &l = listeners[listener];
+  if (!listeners_approx_equal(l.listener, new_listener)) {
+    l.listener = new_listener;
+    l.cache_valid = false;
   }
 }
 
-GainCalcObjects::PerObject::PerObject(size_t n_gains) : a(n_gains), b(n_gains) {}
+GainCalcObjects::PerObject::PerObject(size_t n_gains, size_t n_listeners)
+    : a(n_gains, n_listeners), b(n_gains, n_listeners)
+{
+}
 
 void GainCalcObjects::PerObject::update(const ObjectsInput &block)
 {
@@ -89,26 +133,27 @@ void GainCalcObjects::PerObject::update(const ObjectsInput &block)
   }
 }
 
-void GainCalcObjects::PerObject::set_listener(const ListenerImpl &listener)
+void GainCalcObjects::PerObject::set_listener(size_t listener, const ListenerImpl &listener_data)
 {
-  a.set_listener(listener);
-  b.set_listener(listener);
+  a.set_listener(listener, listener_data);
+  b.set_listener(listener, listener_data);
 }
 
 void GainCalcObjects::PerObject::calc_gains(GainCalcObjects &parent,
+                                            size_t listener,
                                             Time t,
                                             DirectDiffuse<Ref<VectorXd>> gains)
 {
   if (infinite_block) {
-    b.calc_gains(parent, gains);
+    b.calc_gains(parent, listener, gains);
   } else if (t > last_block_end) {
     gains.direct.setZero();
     gains.diffuse.setZero();
   } else if (t >= b.time) {
-    b.calc_gains(parent, gains);
+    b.calc_gains(parent, listener, gains);
   } else if (t >= a.time) {
-    a.calc_gains(parent, {parent.temp_direct_a, parent.temp_diffuse_a});
-    b.calc_gains(parent, {parent.temp_direct_b, parent.temp_diffuse_b});
+    a.calc_gains(parent, listener, {parent.temp_direct_a, parent.temp_diffuse_a});
+    b.calc_gains(parent, listener, {parent.temp_direct_b, parent.temp_diffuse_b});
 
     // t_b - t_a == 0 is handled by previous case
     double p = boost::rational_cast<double>((t - a.time) / (b.time - a.time));
@@ -121,9 +166,12 @@ void GainCalcObjects::PerObject::calc_gains(GainCalcObjects &parent,
 
 void GainCalcObjects::process()
 {
-  if (listener_in.changed()) {
-    for (size_t i = 0; i < num_objects; i++) per_object_data.at(i).set_listener(listener_in.data());
-    listener_in.resetChanged();
+  for (size_t listener = 0; listener < num_listeners; listener++) {
+    ListenerInput &in = *listener_in[listener];
+    if (in.changed()) {
+      for (size_t i = 0; i < num_objects; i++) per_object_data.at(i).set_listener(listener, in.data());
+      in.resetChanged();
+    }
   }
 
   while (!metadata_in.empty()) {
@@ -135,13 +183,15 @@ void GainCalcObjects::process()
 
   Time block_end{time().sampleCount() + period(), sample_rate};
 
-  for (size_t i = 0; i < num_objects; i++) {
-    per_object_data.at(i).calc_gains(*this, block_end, {temp_direct, temp_diffuse});
-    for (size_t j = 0; j < panner->num_gains(); j++) {
-      gains_out.data()(j, i) = temp_direct(j);
-      gains_out.data()(panner->num_gains() + j, i) = temp_diffuse(j);
+  for (size_t i = 0; i < num_objects; i++)
+    for (size_t listener = 0; listener < num_listeners; listener++) {
+      per_object_data.at(i).calc_gains(*this, listener, block_end, {temp_direct, temp_diffuse});
+      auto &gains = gains_out[listener]->data();
+      for (size_t j = 0; j < panner->num_gains(); j++) {
+        gains(j, i) = temp_direct(j);
+        gains(panner->num_gains() + j, i) = temp_diffuse(j);
+      }
     }
-  }
 }
 
 }  // namespace bear
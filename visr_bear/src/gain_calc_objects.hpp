@@ -5,6 +5,7 @@
 #include <libvisr/parameter_input.hpp>
 #include <libvisr/parameter_output.hpp>
 #include <memory>
+#include <vector>
 
 #include "bear/api.hpp"
 #include "dsp.hpp"
@@ -15,6 +16,12 @@
 namespace bear {
 using namespace visr;
 
+/// calculate gains for Objects channels for one or more listeners
+///
+/// With one listener the ports are metadata_in, listener_in and gains_out.
+/// With num_listeners > 1, metadata is parsed once, and each listener i has
+/// its own listener_in_i and gains_out_i; gains are only calculated once for
+/// listeners with the same position and orientation.
 class GainCalcObjects : public AtomicComponent {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -22,7 +29,8 @@ class GainCalcObjects : public AtomicComponent {
                            const char *name,
                            CompositeComponent *parent,
                            const ConfigImpl &config,
-                           std::shared_ptr<Panner> panner);
+                           std::shared_ptr<Panner> panner,
+                           size_t num_listeners = 1);
 
   void process() override;
 
@@ -30,10 +38,15 @@ class GainCalcObjects : public AtomicComponent {
   std::shared_ptr<Panner> panner;
   size_t sample_rate;
   size_t num_objects;
+  size_t num_listeners;
+  bool enable_extent;
+
+  using ListenerInput = ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter>;
+  using GainsOutput = ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<SampleType>>;
 
   ParameterInput<pml::MessageQueueProtocol, ADMParameter<ObjectsInput>> metadata_in;
-  ParameterOutput<pml::SharedDataProtocol, pml::MatrixParameter<SampleType>> gains_out;
-  ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter> listener_in;
+  std::vector<std::unique_ptr<GainsOutput>> gains_out;
+  std::vector<std::unique_ptr<ListenerInput>> listener_in;
 
   size_t to_sample(const Time &t);
 
@@ -45,28 +58,34 @@ class GainCalcObjects : public AtomicComponent {
   Eigen::VectorXd temp_diffuse_b;
 
   /// Point in time with associated type metadata and listener data; this
-  /// caches gains, which are invalidated when the listener or type-metadata
-  /// are changed. If the listener is not updated, this means that during long
-  /// blocks the gains are not re-calculated.
+  /// caches gains for each listener, which are invalidated when the listener
+  /// or type-metadata are changed. If the listener is not updated, this means
+  /// that during long blocks the gains are not re-calculated.
   class Point {
    public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-    Point(size_t n_gains);
+    Point(size_t n_gains, size_t n_listeners);
 
-    void calc_gains(GainCalcObjects &parent, DirectDiffuse<Ref<VectorXd>> gains);
+    void calc_gains(GainCalcObjects &parent, size_t listener, DirectDiffuse<Ref<VectorXd>> gains);
     void set_otm(const ObjectsInput &otm);
-    void set_listener(const ListenerImpl &listener);
+    void set_listener(size_t listener, const ListenerImpl &listener_data);
 
     Time time;
 
    private:
     ObjectsInput otm;
     ObjectsInput adapted_otm;
-    ListenerImpl listener;
 
-    Eigen::VectorXd direct_cache;
-    Eigen::VectorXd diffuse_cache;
-    bool cache_valid = false;
+    struct PerListener {
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+      PerListener(size_t n_gains) : direct_cache(n_gains), diffuse_cache(n_gains) {}
+
+      ListenerImpl listener;
+      Eigen::VectorXd direct_cache;
+      Eigen::VectorXd diffuse_cache;
+      bool cache_valid = false;
+    };
+    std::vector<PerListener, Eigen::aligned_allocator<PerListener>> listeners;
   };
 
   /// per-object data; new metadata is pushed in through update, and gains can
@@ -74,10 +93,10 @@ class GainCalcObjects : public AtomicComponent {
   class PerObject {
    public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-    PerObject(size_t n_gains);
+    PerObject(size_t n_gains, size_t n_listeners);
     void update(const ObjectsInput &block);
-    void set_listener(const ListenerImpl &listener);
-    void calc_gains(GainCalcObjects &parent, Time t, DirectDiffuse<Ref<VectorXd>> gains);
+    void set_listener(size_t listener, const ListenerImpl &listener_data);
+    void calc_gains(GainCalcObjects &parent, size_t listener, Time t, DirectDiffuse<Ref<VectorXd>> gains);
 
    private:
     // current metadata: interpolation from a to b (both containing a time and
@@ -0,0 +1,67 @@
+#include "listener_smoother.hpp"
+
+#include <cmath>
+
+#include "config_impl.hpp"
+
+namespace bear {
+ListenerSmoother::ListenerSmoother(const SignalFlowContext &ctx,
+                                   const char *name,
+                                   CompositeComponent *parent,
+                                   const ConfigImpl &config)
+    : AtomicComponent(ctx, name, parent),
+      orientation_hysteresis(config.listener_orientation_hysteresis),
+      position_hysteresis(config.listener_position_hysteresis),
+      update_interval(config.listener_update_rate > 0.0
+                          ? static_cast<size_t>(std::round(config.sample_rate / config.listener_update_rate))
+                          : 0),
+      listener_in("listener_in", *this, pml::EmptyParameterConfig()),
+      listener_out("listener_out", *this, pml::EmptyParameterConfig())
+{
+}
+
+bool ListenerSmoother::moved_from_output() const
+{
+  double position_change = (current.position - last_output.position).norm();
+  double orientation_change = current.orientation.angularDistance(last_output.orientation);
+
+  return position_change > position_hysteresis || orientation_change > orientation_hysteresis;
+}
+
+void ListenerSmoother::process()
+{
+  if (listener_in.changed()) {
+    start = current;
+    end.position = listener_in.data().position;
+    end.orientation = listener_in.data().orientation;
+    ramp_samples =
+        static_cast<size_t>(std::round(listener_in.data().interpolation_time * samplingFrequency()));
+    ramp_pos = 0;
+    ramping = true;
+
+    listener_in.resetChanged();
+  }
+
+  if (ramping) {
+    ramp_pos += period();
+    if (ramp_pos >= ramp_samples) {
+      current = end;
+      ramping = false;
+    } else {
+      double t = static_cast<double>(ramp_pos) / ramp_samples;
+      current.position = start.position + t * (end.position - start.position);
+      current.orientation = start.orientation.slerp(t, end.orientation);
+    }
+  }
+
+  samples_since_output += period();
+  if (samples_since_output >= update_interval && moved_from_output()) {
+    last_output = current;
+    listener_out.data().position = current.position;
+    listener_out.data().orientation = current.orientation;
+    listener_out.swapBuffers();
+
+    samples_since_output = 0;
+  }
+}
+}  // namespace bear
@@ -0,0 +1,58 @@
+#pragma once
+#include <libpml/double_buffering_protocol.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <libvisr/parameter_output.hpp>
+
+#include "bear/api.hpp"
+#include "parameters.hpp"
+
+namespace bear {
+using namespace visr;
+
+/// Interpolates listener changes over the interpolation_time given to
+/// Renderer::set_listener, and limits the rate at which the listener seen by
+/// the rest of the control path changes.
+///
+/// The output is only updated once every 1/listener_update_rate seconds (or
+/// every period if this is 0), and only if the listener has moved further
+/// than the configured orientation or position hysteresis since the last
+/// update. This avoids recalculating the gains and delays for every object in
+/// response to small head tracker movements.
+class ListenerSmoother : public AtomicComponent {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  explicit ListenerSmoother(const SignalFlowContext &ctx,
+                            const char *name,
+                            CompositeComponent *parent,
+                            const ConfigImpl &config);
+
+  void process() override;
+
+ private:
+  /// has the listener moved far enough from the last output to be updated?
+  bool moved_from_output() const;
+
+  double orientation_hysteresis;
+  double position_hysteresis;
+  size_t update_interval;
+
+  ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter> listener_in;
+  ParameterOutput<pml::DoubleBufferingProtocol, ListenerParameter> listener_out;
+
+  // interpolating from start to end over ramp_samples; ramp_pos samples have
+  // elapsed
+  ListenerImpl start;
+  ListenerImpl end;
+  size_t ramp_samples = 0;
+  size_t ramp_pos = 0;
+  bool ramping = false;
+
+  /// listener at the end of the current period
+  ListenerImpl current;
+  /// the last listener sent to listener_out
+  ListenerImpl last_output;
+  size_t samples_since_output = 0;
+};
+
+}  // namespace bear
@@ -0,0 +1,79 @@
+#include "load_governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace bear {
+
+LoadGovernor::LoadGovernor(const GovernorOptions &options_, double period_)
+    : options(options_), period(period_), alpha(1.0 - std::exp(-period_ / options_.time_constant))
+{
+  check_governor_options(options);
+}
+
+bool LoadGovernor::update(double process_time)
+{
+  load += alpha * (process_time / period - load);
+
+  if (load > options.high_load) {
+    time_high += period;
+    time_low = 0.0;
+  } else if (load < options.low_load) {
+    time_low += period;
+    time_high = 0.0;
+  } else {
+    time_high = 0.0;
+    time_low = 0.0;
+  }
+
+  if (time_high >= options.overload_time && level_ < GovernorOptions::max_level) {
+    level_++;
+    reset();
+    return true;
+  }
+  if (time_low >= options.recovery_time && level_ > 0) {
+    level_--;
+    reset();
+    return true;
+  }
+  return false;
+}
+
+void LoadGovernor::reset()
+{
+  load = 0.0;
+  time_high = 0.0;
+  time_low = 0.0;
+}
+
+void check_governor_options(const GovernorOptions &options)
+{
+  if (!(options.time_constant > 0.0)) throw std::invalid_argument("governor time constant must be positive");
+  if (!(options.low_load < options.high_load))
+    throw std::invalid_argument("governor low_load must be less than high_load");
+  if (options.overload_time < 0.0 || options.recovery_time < 0.0)
+    throw std::invalid_argument("governor times must not be negative");
+  if (options.reduced_hoa_order < 0) throw std::invalid_argument("governor HOA order must not be negative");
+}
+
+void apply_quality_level(ConfigImpl &config, const GovernorOptions &options, int level)
+{
+  if (level >= 1) {
+    if (config.max_brir_length == 0 || config.max_brir_length > options.truncated_brir_length)
+      config.max_brir_length = options.truncated_brir_length;
+  }
+  if (level >= 2) config.enable_gain_norm = false;
+  if (level >= 3) {
+    if (config.max_hoa_order < 0 || config.max_hoa_order > options.reduced_hoa_order)
+      config.max_hoa_order = options.reduced_hoa_order;
+  }
+  if (level >= 4) {
+    double rate = options.reduced_listener_update_rate;
+    if (config.listener_update_rate == 0.0 || config.listener_update_rate > rate)
+      config.listener_update_rate = rate;
+  }
+  if (level >= 5) config.enable_extent = false;
+}
+
+}  // namespace bear
@@ -0,0 +1,46 @@
+#pragma once
+#include "config_impl.hpp"
+#include "dynamic_renderer.hpp"
+
+namespace bear {
+
+/// Decides the quality level of a DynamicRenderer from the time taken to
+/// process each period. The load (process time divided by the period length)
+/// is smoothed with a one-pole filter; the level is increased when the
+/// smoothed load has been above high_load for overload_time, and decreased
+/// when it has been below low_load for recovery_time.
+class LoadGovernor {
+ public:
+  /// period: length of one period in seconds
+  LoadGovernor(const GovernorOptions &options, double period);
+
+  /// update with the time in seconds taken to process one period; returns
+  /// true if the level changed
+  bool update(double process_time);
+
+  /// restart the measurement without changing the level; this should be
+  /// called whenever the renderer is not running normally, for example
+  /// while it is being reconfigured
+  void reset();
+
+  int level() const { return level_; }
+
+ private:
+  GovernorOptions options;
+  double period;
+  /// coefficient of the one-pole smoothing filter
+  double alpha;
+
+  double load = 0.0;
+  double time_high = 0.0;
+  double time_low = 0.0;
+  int level_ = 0;
+};
+
+/// throw std::invalid_argument if options are not valid
+void check_governor_options(const GovernorOptions &options);
+
+/// modify config to render at a given quality level
+void apply_quality_level(ConfigImpl &config, const GovernorOptions &options, int level);
+
+}  // namespace bear
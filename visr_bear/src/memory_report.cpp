@@ -0,0 +1,239 @@
+#include "memory_report.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "brir_view_cache.hpp"
+#include "utils.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace bear {
+
+namespace {
+  const size_t sample_bytes = sizeof(float);
+  const size_t bin_bytes = sizeof(std::complex<float>);
+
+  size_t num_partitions(size_t filter_length, size_t period) { return (filter_length + period - 1) / period; }
+
+  /// DelayLine with a maximum delay in samples
+  size_t delay_line_bytes(size_t period, double max_delay)
+  {
+    size_t buffer_size = 1;
+    while (buffer_size < period + static_cast<size_t>(std::ceil(max_delay)) + 4) buffer_size *= 2;
+    // the buffer, plus ramp offsets and 4 sets of ramp coefficients
+    return buffer_size * sample_bytes + period * (sizeof(int) + 4 * sample_bytes);
+  }
+
+  /// rcl::GainMatrix, which holds the previous, current and target gains
+  size_t gain_matrix_bytes(size_t num_inputs, size_t num_outputs)
+  {
+    return 3 * num_inputs * num_outputs * sample_bytes;
+  }
+
+  /// uniformly-partitioned convolution with a partition size of one period,
+  /// as in BinauralConvolver, DiffusePath and the VISR FIR filter matrices:
+  /// the spectra of each partition of each filter and of the last
+  /// num_partitions blocks of each input, plus the last block of each input
+  /// and an FFT buffer
+  size_t convolver_bytes(size_t num_inputs, size_t num_filters, size_t filter_length, size_t period)
+  {
+    size_t partitions = num_partitions(filter_length, period);
+    return (num_filters + num_inputs) * partitions * (period + 1) * bin_bytes +
+           num_inputs * period * sample_bytes + 2 * period * sample_bytes;
+  }
+
+  /// PerEarDelay, with one delay line per input and ear, and a gain matrix
+  /// per ear
+  size_t per_ear_delay_bytes(size_t num_inputs, size_t num_outputs, size_t period, double max_delay)
+  {
+    return 2 * num_inputs * delay_line_bytes(period, max_delay) +
+           2 * gain_matrix_bytes(num_inputs, num_outputs);
+  }
+
+  /// allocations made by one set of DSP and Control components; see
+  /// dsp.cpp and control.cpp for the structure
+  std::vector<ComponentMemory> calc_allocations(const ConfigImpl &config, const Panner &panner)
+  {
+    const size_t period = config.period_size;
+    const double fs = static_cast<double>(config.sample_rate);
+    const size_t num_objects = config.num_objects_channels;
+    const size_t num_paths = num_object_paths(config);
+    const size_t num_direct_speakers = config.num_direct_speakers_channels;
+    const size_t num_hoa = config.num_hoa_channels;
+    const size_t num_vs = panner.num_virtual_loudspeakers();
+    const size_t num_gains = panner.num_gains();
+    const size_t num_hoa_render = hoa_render_channels(config, panner.hoa_order());
+    const double max_direct_delay = (panner.max_delay() + panner.decorrelation_delay()) * fs;
+
+    std::vector<ComponentMemory> components;
+    auto add = [&](const char *name, size_t bytes) {
+      ComponentMemory component;
+      component.name = name;
+      component.allocated_bytes = bytes;
+      components.push_back(std::move(component));
+    };
+
+    // ObjectClustering features and centroids, and the ClusterMix gains and
+    // their parameter
+    if (use_object_clustering(config))
+      add("object_clustering",
+          (2 * num_gains + 2) * (num_objects + num_paths) * sizeof(double) +
+              2 * num_paths * num_objects * sample_bytes);
+
+    add("objects_direct_path", per_ear_delay_bytes(num_paths, num_vs, period, max_direct_delay));
+    add("diffuse_gains", gain_matrix_bytes(num_paths, num_vs));
+    // DirectSpeakersPath has the same delay lines as PerEarDelay, but one set
+    // of previous gains and a single temporary buffer
+    add("direct_speakers_path",
+        2 * num_direct_speakers * delay_line_bytes(period, max_direct_delay) +
+            num_direct_speakers * num_vs * sample_bytes + period * sample_bytes);
+
+    // decorrelators, plus the static delays
+    add("diffuse_path",
+        convolver_bytes(num_vs, num_vs, panner.decorrelator_length(), period) + period * sample_bytes +
+            2 * num_vs * delay_line_bytes(period, panner.max_delay() * fs));
+
+    // one filter per view held, virtual loudspeaker and ear; the binaural
+    // convolver also has four accumulators and the previous output
+    size_t num_brir_filters = num_brir_slots(config, panner) * 2 * num_vs;
+    size_t brir_length = brir_render_length(config, panner.brir_length());
+    add("brir_convolver",
+        convolver_bytes(2 * num_vs, num_brir_filters, brir_length, period) +
+            (config.binaural_convolver ? 4 * (period + 1) * bin_bytes + period * sample_bytes : 0));
+
+    size_t num_hoa_filters = num_hoa_render * (panner.hoa_decoder_symmetric() ? 1 : 2);
+    add("hoa",
+        gain_matrix_bytes(num_hoa, num_hoa_render) +
+            convolver_bytes(num_hoa_render, num_hoa_filters, panner.hoa_ir_length(), period) +
+            2 * delay_line_bytes(period, panner.hoa_delay() * fs));
+
+    // one buffer per output channel of each component, plus the inputs
+    size_t num_audio_channels = (num_objects + num_direct_speakers + num_hoa)        // inputs
+                                + (use_object_clustering(config) ? num_paths : 0)  // cluster_mix
+                                + (2 * num_paths + 2 * num_vs)                     // objects_direct_path
+                                + num_vs                                           // diffuse_gains
+                                + 2 * num_vs                                       // direct_speakers_path
+                                + 2 * num_vs                                       // diffuse_path
+                                + 2 * num_vs                                       // add_brir_inputs
+                                + 2                                                // brirs
+                                + num_hoa_render + 4 * 2                           // HOA path
+                                + 2;                                               // add_hoa
+    add("audio_buffers", num_audio_channels * period * sample_bytes);
+
+    // per-object and per-channel gain caches (double) and the gain matrix
+    // and delay parameters sent to the DSP (float, double-buffered for
+    // delays)
+    add("control",
+        num_objects * (2 * num_gains * sizeof(double) + 2 * num_gains * sample_bytes + 4 * sample_bytes) +
+            num_direct_speakers * (num_gains * sizeof(double) + num_gains * sample_bytes + 4 * sample_bytes) +
+            num_hoa * num_hoa_render * sample_bytes + 4 * num_vs * sample_bytes);
+
+    return components;
+  }
+
+  /// number of bytes of [data, data + size) which are resident
+  size_t resident_bytes(const void *data, size_t size)
+  {
+#ifndef _WIN32
+    if (size == 0) return 0;
+    const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(data) / page_size * page_size;
+    uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+#ifdef __APPLE__
+    std::vector<char> pages((end - start + page_size - 1) / page_size);
+#else
+    std::vector<unsigned char> pages((end - start + page_size - 1) / page_size);
+#endif
+    if (mincore(reinterpret_cast<void *>(start), end - start, pages.data()) != 0) return 0;
+
+    size_t num_resident = std::count_if(pages.begin(), pages.end(), [](unsigned char p) { return p & 1; });
+    // the first and last pages may only partly belong to this array
+    return std::min(num_resident * static_cast<size_t>(page_size), size);
+#else
+    (void)data;
+    (void)size;
+    return 0;
+#endif
+  }
+
+  /// the arrays of the data file; arrays which were converted on load are
+  /// allocated rather than mapped
+  std::vector<ComponentMemory> data_file_usage(const Panner &panner, bool measure_resident)
+  {
+    std::vector<ComponentMemory> components;
+    for (auto &array : panner.get_arrays()) {
+      ComponentMemory component;
+      component.name = "data_file." + array.first;
+      size_t num_bytes = array.second->num_bytes();
+      if (array.second->mapped()) {
+        component.mapped_bytes = num_bytes;
+        if (measure_resident) component.resident_bytes = resident_bytes(array.second->data(), num_bytes);
+      } else
+        component.allocated_bytes = num_bytes;
+      components.push_back(std::move(component));
+    }
+    return components;
+  }
+
+  /// bytes counted against the memory budget
+  size_t budgeted_bytes(const ConfigImpl &config, const Panner &panner, size_t num_listeners)
+  {
+    size_t total = 0;
+    for (auto &component : calc_allocations(config, panner))
+      total += num_listeners * component.allocated_bytes;
+    for (auto &component : data_file_usage(panner, false))
+      total += component.allocated_bytes + (config.data_file_lock ? component.mapped_bytes : 0);
+    return total;
+  }
+}  // namespace
+
+MemoryReport get_memory_report(const ConfigImpl &config, const Panner &panner, size_t num_listeners)
+{
+  MemoryReport report;
+  for (auto &component : calc_allocations(config, panner)) {
+    component.allocated_bytes *= num_listeners;
+    report.components.push_back(std::move(component));
+  }
+  for (auto &component : data_file_usage(panner, true)) report.components.push_back(std::move(component));
+
+  for (auto &component : report.components) {
+    report.allocated_bytes += component.allocated_bytes;
+    report.mapped_bytes += component.mapped_bytes;
+    report.resident_bytes += component.resident_bytes;
+  }
+  return report;
+}
+
+ConfigImpl fit_memory_budget(const ConfigImpl &config, const Panner &panner, size_t num_listeners)
+{
+  if (config.memory_budget == 0) return config;
+
+  ConfigImpl fitted = config;
+  size_t required = budgeted_bytes(fitted, panner, num_listeners);
+
+  // the BRIR filter spectra are usually the largest allocation, and shrinking
+  // the view cache does not change the rendering once views are loaded
+  if (config.adapt_to_memory_budget && config.binaural_convolver)
+    for (size_t slots = num_brir_slots(fitted, panner); required > config.memory_budget && slots > 2;) {
+      fitted.brir_view_cache_size = --slots;
+      required = budgeted_bytes(fitted, panner, num_listeners);
+    }
+
+  if (required > config.memory_budget)
+    throw std::runtime_error("renderer needs " + std::to_string(required) +
+                             " bytes, which exceeds the memory budget of " +
+                             std::to_string(config.memory_budget) + " bytes");
+
+  return fitted;
+}
+
+}  // namespace bear
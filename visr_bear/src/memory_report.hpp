@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+#include "bear/api.hpp"
+#include "config_impl.hpp"
+#include "panner.hpp"
+
+namespace bear {
+
+/// get the memory used by num_listeners sets of DSP and control components
+/// (as in Top or MultiListenerTop) which share panner. Allocations are
+/// calculated from the configuration and the dimensions of the data file
+/// (see MemoryReport), so this can be called before they are made; the
+/// arrays in the data file are measured.
+MemoryReport get_memory_report(const ConfigImpl &config, const Panner &panner, size_t num_listeners = 1);
+
+/// check config against config.memory_budget, returning the configuration to
+/// use, which has a smaller brir_view_cache_size if adapt_to_memory_budget
+/// is enabled and this is needed to fit; throws std::runtime_error if it does
+/// not fit
+ConfigImpl fit_memory_budget(const ConfigImpl &config, const Panner &panner, size_t num_listeners = 1);
+
+}  // namespace bear
@@ -0,0 +1,278 @@
+#include "metadata_file.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace bear {
+
+namespace {
+  using rapidjson::Value;
+
+  void check(bool x, const std::string &message)
+  {
+    if (!x) throw std::runtime_error("metadata file error: " + message);
+  }
+
+  const Value &get_member(const Value &v, const char *name)
+  {
+    check(v.IsObject(), std::string("expected an object containing ") + name);
+    auto it = v.FindMember(name);
+    check(it != v.MemberEnd(), std::string("missing ") + name);
+    return it->value;
+  }
+
+  template <typename T>
+  std::shared_ptr<tensorfile::NDArrayT<T>> get_array(const tensorfile::TensorFile &tf,
+                                                     const Value &v,
+                                                     const char *name,
+                                                     size_t ndim)
+  {
+    auto array = tf.unpack<T>(get_member(v, name));
+    check(array != nullptr, std::string(name) + " has the wrong type");
+    check(array->ndim() == ndim, std::string(name) + " has the wrong number of dimensions");
+    return array;
+  }
+
+  /// check that offsets has num + 1 increasing entries starting at 0 and
+  /// ending at end
+  void check_offsets(const tensorfile::NDArrayT<int64_t> &offsets, size_t num, size_t end, const char *name)
+  {
+    check(offsets.shape(0) == num + 1, std::string(name) + " has the wrong size");
+    check(offsets(0) == 0, std::string(name) + " must start at 0");
+    for (size_t i = 0; i < num; i++)
+      check(offsets(i + 1) >= offsets(i), std::string(name) + " must be sorted");
+    check(static_cast<size_t>(offsets(num)) == end, std::string(name) + " has the wrong end");
+  }
+
+  void check_index(size_t index, size_t size, const char *what)
+  {
+    if (index >= size) throw std::out_of_range(std::string(what) + " index out of range");
+  }
+
+  boost::optional<size_t> get_track(int64_t track)
+  {
+    if (track < 0) return boost::none;
+    return static_cast<size_t>(track);
+  }
+
+  boost::optional<Time> get_time(const tensorfile::NDArrayT<int64_t> &times, size_t block, size_t i)
+  {
+    int64_t denominator = times(block, 2 * i + 1);
+    if (denominator == 0) return boost::none;
+    return Time{times(block, 2 * i), denominator};
+  }
+
+  boost::optional<double> get_optional(double value)
+  {
+    if (std::isnan(value)) return boost::none;
+    return value;
+  }
+
+  std::vector<std::string> get_strings(const Value &v, const char *what)
+  {
+    check(v.IsArray(), std::string(what) + " must be an array");
+    std::vector<std::string> strings;
+    for (const Value &s : v.GetArray()) {
+      check(s.IsString(), std::string(what) + " must contain strings");
+      strings.push_back(s.GetString());
+    }
+    return strings;
+  }
+
+  /// number of time and value columns for each channel type
+  constexpr size_t objects_times = 3, objects_values = 9;
+  constexpr size_t direct_speakers_times = 2, direct_speakers_values = 4;
+  constexpr size_t hoa_times = 2, hoa_values = 1;
+}  // namespace
+
+size_t MetadataFile::Section::num_blocks(size_t i) const
+{
+  check_index(i, block_offsets->shape(0) - 1, "channel");
+  return static_cast<size_t>((*block_offsets)(i + 1) - (*block_offsets)(i));
+}
+
+size_t MetadataFile::Section::block_index(size_t i, size_t block) const
+{
+  if (block >= num_blocks(i)) throw std::out_of_range("block index out of range");
+  return static_cast<size_t>((*block_offsets)(i)) + block;
+}
+
+MetadataFile::MetadataFile(const std::string &path)
+{
+  tensorfile::ReadOptions options;
+  options.sequential = true;
+  tensorfile::TensorFile tf = tensorfile::read(path, options);
+  const Value &root = tf.metadata();
+
+  const Value &format_j = get_member(root, "format");
+  check(format_j.IsString() && std::string(format_j.GetString()) == "bear_metadata", "not a metadata file");
+  const Value &version_j = get_member(root, "version");
+  check(version_j.IsInt() && version_j.GetInt() == 0, "unsupported version");
+
+  auto load_section = [&](Section &section, const char *name, size_t num_times, size_t num_values)
+      -> const Value & {
+    const Value &section_j = get_member(root, name);
+    section.tracks = get_array<int64_t>(tf, section_j, "tracks", 1);
+    section.block_offsets = get_array<int64_t>(tf, section_j, "block_offsets", 1);
+    section.times = get_array<int64_t>(tf, section_j, "times", 2);
+    section.values = get_array<double>(tf, section_j, "values", 2);
+
+    size_t num_blocks = section.times->shape(0);
+    check(section.times->shape(1) == 2 * num_times, std::string(name) + " times has the wrong shape");
+    check(section.values->shape(0) == num_blocks && section.values->shape(1) == num_values,
+          std::string(name) + " values has the wrong shape");
+    return section_j;
+  };
+
+  load_section(objects, "objects", objects_times, objects_values);
+  check_offsets(*objects.block_offsets, objects.tracks->shape(0), objects.times->shape(0), "block_offsets");
+
+  const Value &direct_speakers_j =
+      load_section(direct_speakers, "direct_speakers", direct_speakers_times, direct_speakers_values);
+  check_offsets(*direct_speakers.block_offsets,
+                direct_speakers.tracks->shape(0),
+                direct_speakers.times->shape(0),
+                "block_offsets");
+
+  const Value &labels_j = get_member(direct_speakers_j, "speaker_labels");
+  const Value &ids_j = get_member(direct_speakers_j, "audio_pack_format_ids");
+  check(labels_j.IsArray() && labels_j.Size() == direct_speakers.times->shape(0),
+        "speaker_labels must have one entry per block");
+  check(ids_j.IsArray() && ids_j.Size() == direct_speakers.times->shape(0),
+        "audio_pack_format_ids must have one entry per block");
+  for (const Value &block_labels_j : labels_j.GetArray())
+    speaker_labels.push_back(get_strings(block_labels_j, "speaker_labels"));
+  for (const Value &id_j : ids_j.GetArray()) {
+    if (id_j.IsNull())
+      audio_pack_format_ids.push_back(boost::none);
+    else {
+      check(id_j.IsString(), "audio_pack_format_ids must contain strings or null");
+      audio_pack_format_ids.push_back(std::string(id_j.GetString()));
+    }
+  }
+
+  const Value &hoa_j = load_section(hoa, "hoa", hoa_times, hoa_values);
+  hoa_track_offsets = get_array<int64_t>(tf, hoa_j, "track_offsets", 1);
+  check(hoa_track_offsets->shape(0) >= 1, "track_offsets must not be empty");
+  size_t num_streams = hoa_track_offsets->shape(0) - 1;
+  check_offsets(*hoa_track_offsets, num_streams, hoa.tracks->shape(0), "track_offsets");
+  check_offsets(*hoa.block_offsets, num_streams, hoa.times->shape(0), "block_offsets");
+
+  hoa_orders = get_array<int32_t>(tf, hoa_j, "orders", 1);
+  hoa_degrees = get_array<int32_t>(tf, hoa_j, "degrees", 1);
+  hoa_normalizations = get_strings(get_member(hoa_j, "normalizations"), "normalizations");
+  check(hoa_normalizations.size() == hoa.times->shape(0), "normalizations must have one entry per block");
+
+  // each block has one order and degree per channel in its stream
+  size_t coefficient = 0;
+  for (size_t stream = 0; stream < num_streams; stream++) {
+    size_t num_channels =
+        static_cast<size_t>((*hoa_track_offsets)(stream + 1) - (*hoa_track_offsets)(stream));
+    for (size_t block = 0; block < hoa.num_blocks(stream); block++) {
+      hoa_block_starts.push_back(coefficient);
+      coefficient += num_channels;
+    }
+  }
+  check(hoa_orders->shape(0) == coefficient && hoa_degrees->shape(0) == coefficient,
+        "orders and degrees have the wrong size");
+}
+
+size_t MetadataFile::num_objects_channels() const { return objects.tracks->shape(0); }
+
+boost::optional<size_t> MetadataFile::objects_track(size_t channel) const
+{
+  check_index(channel, objects.tracks->shape(0), "channel");
+  return get_track((*objects.tracks)(channel));
+}
+
+size_t MetadataFile::num_objects_blocks(size_t channel) const { return objects.num_blocks(channel); }
+
+ObjectsInput MetadataFile::objects_block(size_t channel, size_t block) const
+{
+  size_t i = objects.block_index(channel, block);
+  const auto &values = *objects.values;
+
+  ObjectsInput oi;
+  oi.rtime = get_time(*objects.times, i, 0);
+  oi.duration = get_time(*objects.times, i, 1);
+  oi.interpolationLength = get_time(*objects.times, i, 2);
+  oi.type_metadata.position = ear::PolarPosition{values(i, 0), values(i, 1), values(i, 2)};
+  oi.type_metadata.gain = values(i, 3);
+  oi.type_metadata.width = values(i, 4);
+  oi.type_metadata.height = values(i, 5);
+  oi.type_metadata.depth = values(i, 6);
+  oi.type_metadata.diffuse = values(i, 7);
+  oi.audioPackFormat_data.absoluteDistance = get_optional(values(i, 8));
+  return oi;
+}
+
+size_t MetadataFile::num_direct_speakers_channels() const { return direct_speakers.tracks->shape(0); }
+
+boost::optional<size_t> MetadataFile::direct_speakers_track(size_t channel) const
+{
+  check_index(channel, direct_speakers.tracks->shape(0), "channel");
+  return get_track((*direct_speakers.tracks)(channel));
+}
+
+size_t MetadataFile::num_direct_speakers_blocks(size_t channel) const
+{
+  return direct_speakers.num_blocks(channel);
+}
+
+DirectSpeakersInput MetadataFile::direct_speakers_block(size_t channel, size_t block) const
+{
+  size_t i = direct_speakers.block_index(channel, block);
+  const auto &values = *direct_speakers.values;
+
+  DirectSpeakersInput dsi;
+  dsi.rtime = get_time(*direct_speakers.times, i, 0);
+  dsi.duration = get_time(*direct_speakers.times, i, 1);
+  dsi.type_metadata.position = ear::PolarSpeakerPosition{values(i, 0), values(i, 1), values(i, 2)};
+  dsi.type_metadata.speakerLabels = speaker_labels[i];
+  dsi.type_metadata.audioPackFormatID = audio_pack_format_ids[i];
+  dsi.audioPackFormat_data.absoluteDistance = get_optional(values(i, 3));
+  return dsi;
+}
+
+size_t MetadataFile::num_hoa_streams() const { return hoa_track_offsets->shape(0) - 1; }
+
+size_t MetadataFile::num_hoa_channels() const { return hoa.tracks->shape(0); }
+
+std::vector<boost::optional<size_t>> MetadataFile::hoa_tracks(size_t stream) const
+{
+  check_index(stream, num_hoa_streams(), "stream");
+  std::vector<boost::optional<size_t>> tracks;
+  for (int64_t i = (*hoa_track_offsets)(stream); i < (*hoa_track_offsets)(stream + 1); i++)
+    tracks.push_back(get_track((*hoa.tracks)(i)));
+  return tracks;
+}
+
+size_t MetadataFile::num_hoa_blocks(size_t stream) const
+{
+  check_index(stream, num_hoa_streams(), "stream");
+  return hoa.num_blocks(stream);
+}
+
+HOAInput MetadataFile::hoa_block(size_t stream, size_t block) const
+{
+  check_index(stream, num_hoa_streams(), "stream");
+  size_t i = hoa.block_index(stream, block);
+
+  HOAInput hi;
+  hi.rtime = get_time(*hoa.times, i, 0);
+  hi.duration = get_time(*hoa.times, i, 1);
+  hi.audioPackFormat_data.absoluteDistance = get_optional((*hoa.values)(i, 0));
+
+  size_t first_channel = static_cast<size_t>((*hoa_track_offsets)(stream));
+  size_t num_channels = static_cast<size_t>((*hoa_track_offsets)(stream + 1)) - first_channel;
+  for (size_t channel = 0; channel < num_channels; channel++) {
+    hi.type_metadata.orders.push_back((*hoa_orders)(hoa_block_starts[i] + channel));
+    hi.type_metadata.degrees.push_back((*hoa_degrees)(hoa_block_starts[i] + channel));
+    hi.channels.push_back(first_channel + channel);
+  }
+  hi.type_metadata.normalization = hoa_normalizations[i];
+
+  return hi;
+}
+
+}  // namespace bear
@@ -0,0 +1,176 @@
+#pragma once
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bear/api.hpp"
+#include "tensorfile.hpp"
+
+namespace bear {
+
+/// Reader for binary metadata files, written by bear.metadata_file or
+/// bear-extract-metadata --format binary.
+///
+/// These are tensorfiles storing the block timeline of each renderer channel
+/// (or HOA stream) in flat arrays. The arrays are memory-mapped rather than
+/// copied, and blocks are converted to ObjectsInput etc. when they are
+/// requested, so opening a file is cheap however long the programme is.
+///
+/// Channels of each type are numbered as in the renderer, and HOA channels
+/// are numbered in order over all streams. Methods taking a channel, stream
+/// or block index throw std::out_of_range if it is too large.
+class MetadataFile {
+ public:
+  /// open a file; throws std::runtime_error if it is not a valid metadata
+  /// file
+  explicit MetadataFile(const std::string &path);
+
+  size_t num_objects_channels() const;
+  /// input file track for a channel, or none if it is silent
+  boost::optional<size_t> objects_track(size_t channel) const;
+  size_t num_objects_blocks(size_t channel) const;
+  ObjectsInput objects_block(size_t channel, size_t block) const;
+
+  size_t num_direct_speakers_channels() const;
+  boost::optional<size_t> direct_speakers_track(size_t channel) const;
+  size_t num_direct_speakers_blocks(size_t channel) const;
+  DirectSpeakersInput direct_speakers_block(size_t channel, size_t block) const;
+
+  size_t num_hoa_streams() const;
+  size_t num_hoa_channels() const;
+  /// input file track for each channel in a HOA stream
+  std::vector<boost::optional<size_t>> hoa_tracks(size_t stream) const;
+  size_t num_hoa_blocks(size_t stream) const;
+  HOAInput hoa_block(size_t stream, size_t block) const;
+
+ private:
+  template <typename T>
+  using Array = std::shared_ptr<tensorfile::NDArrayT<T>>;
+
+  /// arrays common to all channel types
+  struct Section {
+    /// input track per channel, -1 if silent
+    Array<int64_t> tracks;
+    /// blocks of channel (or stream) i are block_offsets[i] to
+    /// block_offsets[i + 1]
+    Array<int64_t> block_offsets;
+    /// numerator and denominator of each time per block; 0 denominator if
+    /// not set
+    Array<int64_t> times;
+    /// type-specific values per block
+    Array<double> values;
+
+    size_t num_blocks(size_t i) const;
+    size_t block_index(size_t i, size_t block) const;
+  };
+
+  Section objects;
+  Section direct_speakers;
+  Section hoa;
+
+  std::vector<std::vector<std::string>> speaker_labels;
+  std::vector<boost::optional<std::string>> audio_pack_format_ids;
+
+  /// tracks of HOA stream i are hoa_track_offsets[i] to
+  /// hoa_track_offsets[i + 1]
+  Array<int64_t> hoa_track_offsets;
+  Array<int32_t> hoa_orders;
+  Array<int32_t> hoa_degrees;
+  std::vector<std::string> hoa_normalizations;
+  /// start of each HOA block in hoa_orders and hoa_degrees
+  std::vector<size_t> hoa_block_starts;
+};
+
+namespace detail {
+  inline boost::optional<Time> block_end(const MetadataInput &block)
+  {
+    if (block.rtime && block.duration) return *block.rtime + *block.duration;
+    return boost::none;
+  }
+
+  /// index of the first block needed to render from start: blocks before the
+  /// last one which ended before start have no effect, as the last one is
+  /// the starting point for interpolation
+  template <typename GetBlock>
+  size_t first_block(size_t num_blocks, GetBlock get_block, const Time &start)
+  {
+    size_t i = 0;
+    while (i + 1 < num_blocks) {
+      boost::optional<Time> end = block_end(get_block(i + 1));
+      if (!end || *end > start) break;
+      i++;
+    }
+    return i;
+  }
+}  // namespace detail
+
+/// Pushes the blocks from a metadata source into a renderer as its queues
+/// have space.
+///
+/// Source is normally MetadataFile, but may be anything with the same
+/// num_*, *_block and num_*_blocks methods; blocks are requested from the
+/// source only when they are pushed. The source must outlive the player.
+template <typename Source>
+class MetadataPlayer {
+ public:
+  /// start with the blocks needed to render from start, which should match
+  /// the block start time of the renderer
+  explicit MetadataPlayer(const Source &source, const Time &start = Time{0}) : source(source)
+  {
+    for (size_t i = 0; i < source.num_objects_channels(); i++)
+      objects_pos.push_back(detail::first_block(
+          source.num_objects_blocks(i), [&](size_t b) { return source.objects_block(i, b); }, start));
+
+    for (size_t i = 0; i < source.num_direct_speakers_channels(); i++)
+      direct_speakers_pos.push_back(detail::first_block(
+          source.num_direct_speakers_blocks(i),
+          [&](size_t b) { return source.direct_speakers_block(i, b); },
+          start));
+
+    for (size_t i = 0; i < source.num_hoa_streams(); i++)
+      hoa_pos.push_back(detail::first_block(
+          source.num_hoa_blocks(i), [&](size_t b) { return source.hoa_block(i, b); }, start));
+  }
+
+  /// push as many blocks as the renderer will accept; R can be Renderer or
+  /// DynamicRenderer
+  template <typename R>
+  void push(R &renderer)
+  {
+    for (size_t i = 0; i < objects_pos.size(); i++)
+      while (objects_pos[i] < source.num_objects_blocks(i) &&
+             renderer.add_objects_block(i, source.objects_block(i, objects_pos[i])))
+        objects_pos[i]++;
+
+    for (size_t i = 0; i < direct_speakers_pos.size(); i++)
+      while (direct_speakers_pos[i] < source.num_direct_speakers_blocks(i) &&
+             renderer.add_direct_speakers_block(i, source.direct_speakers_block(i, direct_speakers_pos[i])))
+        direct_speakers_pos[i]++;
+
+    for (size_t i = 0; i < hoa_pos.size(); i++)
+      while (hoa_pos[i] < source.num_hoa_blocks(i) &&
+             renderer.add_hoa_block(i, source.hoa_block(i, hoa_pos[i])))
+        hoa_pos[i]++;
+  }
+
+  /// have all blocks been pushed?
+  bool done() const
+  {
+    for (size_t i = 0; i < objects_pos.size(); i++)
+      if (objects_pos[i] < source.num_objects_blocks(i)) return false;
+    for (size_t i = 0; i < direct_speakers_pos.size(); i++)
+      if (direct_speakers_pos[i] < source.num_direct_speakers_blocks(i)) return false;
+    for (size_t i = 0; i < hoa_pos.size(); i++)
+      if (hoa_pos[i] < source.num_hoa_blocks(i)) return false;
+    return true;
+  }
+
+ private:
+  const Source &source;
+  std::vector<size_t> objects_pos;
+  std::vector<size_t> direct_speakers_pos;
+  std::vector<size_t> hoa_pos;
+};
+
+}  // namespace bear
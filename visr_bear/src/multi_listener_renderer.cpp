@@ -0,0 +1,201 @@
+#include "bear/multi_listener_renderer.hpp"
+
+#include <libefl/denormalised_number_handling.hpp>
+#include <libefl/initialise_library.hpp>
+#include <libpml/initialise_parameter_library.hpp>
+#include <librrl/audio_signal_flow.hpp>
+#include <libvisr/signal_flow_context.hpp>
+#include <libvisr/time.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "listener_impl.hpp"
+#include "parameters.hpp"
+#include "top.hpp"
+#include "utils.hpp"
+
+using namespace visr;
+
+namespace bear {
+
+class MultiListenerRendererImpl {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  MultiListenerRendererImpl(ConfigImpl config, size_t num_listeners)
+      : config(config),
+        num_listeners(num_listeners),
+        ctx(config.period_size, config.sample_rate),
+        top(ctx, "top", nullptr, config, num_listeners),
+        flow(top),
+        temp_input_channels(num_input_channels(config))
+  {
+    objects_metadata_in.push_back(&dynamic_cast<pml::MessageQueueProtocol::OutputBase &>(
+        flow.externalParameterReceivePort("objects_metadata_in")));
+
+    for (size_t i = 0; i < num_listeners; i++) {
+      std::string suffix = "_" + std::to_string(i);
+      direct_speakers_metadata_in.push_back(&dynamic_cast<pml::MessageQueueProtocol::OutputBase &>(
+          flow.externalParameterReceivePort(("direct_speakers_metadata_in" + suffix).c_str())));
+      hoa_metadata_in.push_back(&dynamic_cast<pml::MessageQueueProtocol::OutputBase &>(
+          flow.externalParameterReceivePort(("hoa_metadata_in" + suffix).c_str())));
+      listener_in.push_back(&dynamic_cast<pml::DoubleBufferingProtocol::OutputBase &>(
+          flow.externalParameterReceivePort(("listener_in" + suffix).c_str())));
+
+      // default-initialised listeners in listener_in contain default values
+      listener_in.back()->swapBuffers();
+    }
+  }
+
+  void process(const Sample *const *objects_input,
+               const Sample *const *direct_speakers_input,
+               const Sample *const *hoa_input,
+               Sample *const *output)
+  {
+    {
+      size_t i = 0;
+      for (size_t j = 0; j < config.num_objects_channels; j++, i++) temp_input_channels[i] = objects_input[j];
+      for (size_t j = 0; j < config.num_direct_speakers_channels; j++, i++)
+        temp_input_channels[i] = direct_speakers_input[j];
+      for (size_t j = 0; j < config.num_hoa_channels; j++, i++) temp_input_channels[i] = hoa_input[j];
+    }
+
+    auto denorm_state = efl::DenormalisedNumbers::setDenormHandling();
+    flow.process(temp_input_channels.data(), output);
+    efl::DenormalisedNumbers::resetDenormHandling(denorm_state);
+  }
+
+  bool add_objects_block(size_t channel, ObjectsInput metadata)
+  {
+    if (channel >= config.num_objects_channels)
+      throw std::invalid_argument("channel number out of range in add_objects_block");
+    return add_block(objects_metadata_in, channel, std::move(metadata));
+  }
+
+  bool add_direct_speakers_block(size_t channel, DirectSpeakersInput metadata)
+  {
+    if (channel >= config.num_direct_speakers_channels)
+      throw std::invalid_argument("channel number out of range in add_direct_speakers_block");
+    return add_block(direct_speakers_metadata_in, channel, std::move(metadata));
+  }
+
+  bool add_hoa_block(size_t stream, HOAInput metadata)
+  {
+    for (size_t channel : metadata.channels)
+      if (channel >= config.num_hoa_channels)
+        throw std::invalid_argument("channel number out of range in add_hoa_block");
+    return add_block(hoa_metadata_in, stream, std::move(metadata));
+  }
+
+  Time get_raw_block_start_time() const { return {top.time().sampleCount(), config.sample_rate}; }
+  Time get_raw_next_block_start_time() const
+  {
+    return {top.time().sampleCount() + config.period_size, config.sample_rate};
+  }
+
+  Time get_block_start_time() const { return get_raw_block_start_time() - time_offset; }
+  void set_block_start_time(const Time &time) { time_offset = get_raw_block_start_time() - time; }
+
+  void set_listener(size_t listener, const Listener &l, const boost::optional<Time> &interpolation_time)
+  {
+    if (listener >= num_listeners)
+      throw std::invalid_argument("listener number out of range in set_listener");
+
+    auto &data = dynamic_cast<ListenerParameter &>(listener_in[listener]->data());
+    data = l.get_impl();
+    data.interpolation_time = interpolation_time ? boost::rational_cast<double>(*interpolation_time) : 0.0;
+    listener_in[listener]->swapBuffers();
+  }
+
+  size_t get_num_listeners() const { return num_listeners; }
+  size_t get_preroll_samples() const { return top.preroll_samples(); }
+
+ private:
+  /// the timing checks are the same as RendererImpl; accepted blocks are
+  /// sent to every port in ports
+  template <typename T>
+  bool add_block(std::vector<pml::MessageQueueProtocol::OutputBase *> &ports, size_t index, T metadata)
+  {
+    if (metadata.rtime) *metadata.rtime += time_offset;
+
+    if (!metadata.rtime || metadata.rtime < get_raw_next_block_start_time()) {
+      for (auto port : ports) port->enqueue(std::make_unique<ADMParameter<T>>(index, metadata));
+      return true;
+    } else
+      return false;
+  }
+
+  ConfigImpl config;
+  size_t num_listeners;
+  const SignalFlowContext ctx;
+  MultiListenerTop top;
+  rrl::AudioSignalFlow flow;
+  /// objects metadata is shared between listeners, so this has one port
+  std::vector<pml::MessageQueueProtocol::OutputBase *> objects_metadata_in;
+  std::vector<pml::MessageQueueProtocol::OutputBase *> direct_speakers_metadata_in;
+  std::vector<pml::MessageQueueProtocol::OutputBase *> hoa_metadata_in;
+  std::vector<pml::DoubleBufferingProtocol::OutputBase *> listener_in;
+  std::vector<const Sample *> temp_input_channels;
+  Time time_offset;
+};
+
+MultiListenerRenderer::MultiListenerRenderer() {}
+
+MultiListenerRenderer::MultiListenerRenderer(const Config &config, size_t num_listeners)
+{
+  efl::initialiseLibrary();
+  pml::initialiseParameterLibrary();
+  init_parameters();
+
+  config.validate();
+  if (num_listeners == 0) throw std::invalid_argument("MultiListenerRenderer: need at least one listener");
+
+  impl = std::make_unique<MultiListenerRendererImpl>(config.get_impl(), num_listeners);
+}
+
+MultiListenerRenderer::MultiListenerRenderer(MultiListenerRenderer &&r) = default;
+
+MultiListenerRenderer &MultiListenerRenderer::operator=(MultiListenerRenderer &&r) = default;
+
+MultiListenerRenderer::~MultiListenerRenderer() = default;
+
+size_t MultiListenerRenderer::get_num_listeners() const { return impl->get_num_listeners(); }
+
+void MultiListenerRenderer::process(const Sample *const *objects_input,
+                                    const Sample *const *direct_speakers_input,
+                                    const Sample *const *hoa_input,
+                                    Sample *const *output)
+{
+  impl->process(objects_input, direct_speakers_input, hoa_input, output);
+}
+
+bool MultiListenerRenderer::add_objects_block(size_t channel, ObjectsInput metadata)
+{
+  return impl->add_objects_block(channel, std::move(metadata));
+}
+
+bool MultiListenerRenderer::add_direct_speakers_block(size_t channel, DirectSpeakersInput metadata)
+{
+  return impl->add_direct_speakers_block(channel, std::move(metadata));
+}
+
+bool MultiListenerRenderer::add_hoa_block(size_t stream, HOAInput metadata)
+{
+  return impl->add_hoa_block(stream, std::move(metadata));
+}
+
+Time MultiListenerRenderer::get_block_start_time() const { return impl->get_block_start_time(); }
+
+void MultiListenerRenderer::set_block_start_time(const Time &time) { impl->set_block_start_time(time); }
+
+size_t MultiListenerRenderer::get_preroll_samples() const { return impl->get_preroll_samples(); }
+
+void MultiListenerRenderer::set_listener(size_t listener,
+                                         const Listener &l,
+                                         const boost::optional<Time> &interpolation_time)
+{
+  impl->set_listener(listener, l, interpolation_time);
+}
+
+}  // namespace bear
@@ -0,0 +1,175 @@
+#include "object_clustering.hpp"
+
+#include <algorithm>
+
+#include "utils.hpp"
+
+namespace bear {
+
+namespace {
+  const int unassigned = -1;
+
+  /// delays are in seconds, so scale them so that a difference of 1ms counts
+  /// as much as a difference of 1 in one gain
+  const double delay_scale = 1000.0;
+
+  /// squared distance by which a channel must be closer to another cluster
+  /// to move to it
+  const double switch_threshold = 0.01;
+}  // namespace
+
+ObjectClustering::ObjectClustering(const SignalFlowContext &ctx,
+                                   const char *name,
+                                   CompositeComponent *parent,
+                                   const ConfigImpl &config,
+                                   std::shared_ptr<Panner> panner_)
+    : AtomicComponent(ctx, name, parent),
+      panner(std::move(panner_)),
+      num_objects(config.num_objects_channels),
+      num_clusters(num_object_paths(config)),
+      gains_in("gains_in",
+               *this,
+               pml::MatrixParameterConfig(panner->num_gains() * 2, config.num_objects_channels)),
+      direct_delays_in(
+          "direct_delays_in", *this, pml::VectorParameterConfig(2 * config.num_objects_channels)),
+      gains_out("gains_out", *this, pml::MatrixParameterConfig(panner->num_gains() * 2, num_clusters)),
+      direct_delays_out("direct_delays_out", *this, pml::VectorParameterConfig(2 * num_clusters)),
+      cluster_gains_out(
+          "cluster_gains_out", *this, pml::MatrixParameterConfig(num_clusters, config.num_objects_channels)),
+      features(panner->num_gains() * 2 + 2, config.num_objects_channels),
+      centroids(panner->num_gains() * 2 + 2, num_clusters),
+      cluster_size(num_clusters, 0),
+      assignment(config.num_objects_channels, unassigned),
+      last_features(features.rows(), features.cols()),
+      last_assignment(config.num_objects_channels, unassigned)
+{
+}
+
+void ObjectClustering::process()
+{
+  const size_t num_gains = panner->num_gains() * 2;
+
+  for (size_t object_i = 0; object_i < num_objects; object_i++) {
+    for (size_t gain_i = 0; gain_i < num_gains; gain_i++)
+      features(gain_i, object_i) = gains_in.data()(gain_i, object_i);
+    for (size_t ear = 0; ear < 2; ear++)
+      features(num_gains + ear, object_i) = delay_scale * direct_delays_in.data().at(object_i * 2 + ear);
+  }
+
+  // the update is deterministic, so if the features are the same as last
+  // time and it did not change the assignment then, it would not now; the
+  // outputs are left as they are
+  if (settled && features == last_features) return;
+  last_features = features;
+  std::copy(assignment.begin(), assignment.end(), last_assignment.begin());
+
+  for (size_t object_i = 0; object_i < num_objects; object_i++)
+    if (features.col(object_i).head(num_gains).isZero(0.0)) assignment[object_i] = unassigned;
+
+  update_centroids();
+
+  // move active channels to the closest non-empty cluster, or to cluster 0
+  // if there are none; this uses the centroids from before any moves
+  for (size_t object_i = 0; object_i < num_objects; object_i++) {
+    if (features.col(object_i).head(num_gains).isZero(0.0)) continue;
+
+    int best = unassigned;
+    double best_distance = 0.0;
+    for (size_t cluster = 0; cluster < num_clusters; cluster++) {
+      if (cluster_size[cluster] == 0) continue;
+      double d = distance(object_i, cluster);
+      if (best == unassigned || d < best_distance) {
+        best = static_cast<int>(cluster);
+        best_distance = d;
+      }
+    }
+
+    int current = assignment[object_i];
+    if (current == unassigned)
+      assignment[object_i] = best == unassigned ? 0 : best;
+    else if (best != current && best_distance + switch_threshold < distance(object_i, current))
+      assignment[object_i] = best;
+  }
+
+  update_centroids();
+
+  // fill empty clusters with the channels furthest from their centroids, in
+  // clusters which have more than one member
+  for (size_t cluster = 0; cluster < num_clusters; cluster++) {
+    if (cluster_size[cluster] != 0) continue;
+
+    int furthest = unassigned;
+    double furthest_distance = 0.0;
+    for (size_t object_i = 0; object_i < num_objects; object_i++) {
+      int current = assignment[object_i];
+      if (current == unassigned || cluster_size[current] < 2) continue;
+      double d = distance(object_i, current);
+      if (furthest == unassigned || d > furthest_distance) {
+        furthest = static_cast<int>(object_i);
+        furthest_distance = d;
+      }
+    }
+
+    if (furthest == unassigned) break;
+    move(furthest, cluster);
+  }
+
+  // outputs; delays of empty clusters are left alone, so that they do not
+  // ramp when the cluster is next used
+  for (size_t cluster = 0; cluster < num_clusters; cluster++) {
+    for (size_t object_i = 0; object_i < num_objects; object_i++)
+      cluster_gains_out.data()(cluster, object_i) = assignment[object_i] == static_cast<int>(cluster);
+
+    for (size_t gain_i = 0; gain_i < num_gains; gain_i++)
+      gains_out.data()(gain_i, cluster) = static_cast<float>(centroids(gain_i, cluster));
+
+    if (cluster_size[cluster] != 0)
+      for (size_t ear = 0; ear < 2; ear++)
+        direct_delays_out.data().at(cluster * 2 + ear) =
+            static_cast<float>(centroids(num_gains + ear, cluster) / delay_scale);
+  }
+
+  direct_delays_out.swapBuffers(/* copyValue = */ true);
+
+  settled = assignment == last_assignment;
+}
+
+void ObjectClustering::update_centroids()
+{
+  centroids.setZero();
+  std::fill(cluster_size.begin(), cluster_size.end(), 0);
+
+  for (size_t object_i = 0; object_i < num_objects; object_i++) {
+    int cluster = assignment[object_i];
+    if (cluster == unassigned) continue;
+    centroids.col(cluster) += features.col(object_i);
+    cluster_size[cluster]++;
+  }
+
+  for (size_t cluster = 0; cluster < num_clusters; cluster++)
+    if (cluster_size[cluster] != 0) centroids.col(cluster) /= static_cast<double>(cluster_size[cluster]);
+}
+
+void ObjectClustering::move(size_t object_i, size_t cluster)
+{
+  size_t old_cluster = static_cast<size_t>(assignment[object_i]);
+
+  // remove the channel from the old mean, and add it to the new one
+  double old_size = static_cast<double>(cluster_size[old_cluster]);
+  centroids.col(old_cluster) =
+      (centroids.col(old_cluster) * old_size - features.col(object_i)) / (old_size - 1.0);
+  cluster_size[old_cluster]--;
+
+  double new_size = static_cast<double>(cluster_size[cluster]);
+  centroids.col(cluster) = (centroids.col(cluster) * new_size + features.col(object_i)) / (new_size + 1.0);
+  cluster_size[cluster]++;
+
+  assignment[object_i] = static_cast<int>(cluster);
+}
+
+double ObjectClustering::distance(size_t object_i, size_t cluster) const
+{
+  return (features.col(object_i) - centroids.col(cluster)).squaredNorm();
+}
+
+}  // namespace bear
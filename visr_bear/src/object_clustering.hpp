@@ -0,0 +1,91 @@
+#pragma once
+#include <Eigen/Core>
+#include <libpml/double_buffering_protocol.hpp>
+#include <libpml/matrix_parameter.hpp>
+#include <libpml/shared_data_protocol.hpp>
+#include <libpml/vector_parameter.hpp>
+#include <libvisr/atomic_component.hpp>
+#include <libvisr/parameter_input.hpp>
+#include <libvisr/parameter_output.hpp>
+#include <memory>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "panner.hpp"
+
+namespace bear {
+using namespace visr;
+using namespace visr::pml;
+
+/// Groups Objects channels with similar gains and direct delays into at most
+/// max_object_clusters clusters, so that the DSP applies delays and gains
+/// per cluster rather than per channel; see ClusterMix.
+///
+/// Each period, each channel is moved to the cluster whose centroid (the
+/// mean gains and delays of its members) is closest, starting from the
+/// previous assignment; a channel only moves if this reduces the distance by
+/// more than a threshold, so that channels do not flip between clusters.
+/// Empty clusters are then filled by splitting off the channels furthest
+/// from their centroids, so that when there are no more active channels than
+/// clusters, each has its own cluster and the rendering is exact. Channels
+/// with zero gains are not assigned to a cluster. Once the assignment has
+/// settled, this is skipped until the gains or delays change.
+///
+/// When a channel moves, ClusterMix crossfades it between clusters before
+/// the delay lines, whereas the changes in cluster gains and delays are
+/// ramped after them. While the delays of the two clusters differ, the
+/// channel is therefore briefly rendered with a mix of the old and new
+/// delays and gains, misaligned by up to the delay difference (at most
+/// Panner::max_delay); the error lasts about one period plus that delay.
+///
+/// gains_in and direct_delays_in are per channel (as from GainCalcObjects
+/// and DirectDelayCalc), and gains_out and direct_delays_out are the same
+/// per cluster, taken from the centroids. cluster_gains_out is the mix matrix
+/// for ClusterMix: 1 for the cluster which each channel is in, otherwise 0.
+class ObjectClustering : public AtomicComponent {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  explicit ObjectClustering(const SignalFlowContext &ctx,
+                            const char *name,
+                            CompositeComponent *parent,
+                            const ConfigImpl &config,
+                            std::shared_ptr<Panner> panner);
+
+  void process() override;
+
+ private:
+  /// update centroids and cluster_size from assignment
+  void update_centroids();
+  /// move an active channel from its cluster to another
+  void move(size_t object_i, size_t cluster);
+  double distance(size_t object_i, size_t cluster) const;
+
+  std::shared_ptr<Panner> panner;
+  size_t num_objects;
+  size_t num_clusters;
+
+  ParameterInput<pml::SharedDataProtocol, MatrixParameter<float>> gains_in;
+  ParameterInput<pml::DoubleBufferingProtocol, VectorParameter<float>> direct_delays_in;
+  ParameterOutput<pml::SharedDataProtocol, MatrixParameter<float>> gains_out;
+  ParameterOutput<pml::DoubleBufferingProtocol, VectorParameter<float>> direct_delays_out;
+  ParameterOutput<pml::SharedDataProtocol, MatrixParameter<float>> cluster_gains_out;
+
+  /// for each channel, the gains followed by the scaled delays; see
+  /// delay_scale in the implementation
+  Eigen::MatrixXd features;
+  /// mean features of the members of each cluster
+  Eigen::MatrixXd centroids;
+  std::vector<size_t> cluster_size;
+
+  /// cluster index for each channel, or -1 if it is not assigned to one
+  std::vector<int> assignment;
+
+  /// features and assignment at the start of the last update, to detect
+  /// when it can be skipped
+  Eigen::MatrixXd last_features;
+  std::vector<int> last_assignment;
+  /// did the last update leave the assignment unchanged?
+  bool settled = false;
+};
+
+}  // namespace bear
@@ -0,0 +1,27 @@
+#include "page_faults.hpp"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace bear {
+
+PageFaults get_page_faults()
+{
+  PageFaults faults;
+#ifndef _WIN32
+  struct rusage usage;
+#ifdef RUSAGE_THREAD
+  int who = RUSAGE_THREAD;
+#else
+  int who = RUSAGE_SELF;
+#endif
+  if (getrusage(who, &usage) == 0) {
+    faults.minor = usage.ru_minflt;
+    faults.major = usage.ru_majflt;
+  }
+#endif
+  return faults;
+}
+
+}  // namespace bear
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace bear {
+
+/// numbers of page faults which did not (minor) and did (major) require I/O
+struct PageFaults {
+  long minor = 0;
+  long major = 0;
+};
+
+/// get the number of page faults so far on the calling thread, or in the
+/// whole process where per-thread counts are not available; always zero on
+/// platforms without getrusage
+PageFaults get_page_faults();
+
+}  // namespace bear
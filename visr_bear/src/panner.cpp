@@ -1,6 +1,9 @@
 #include "panner.hpp"
 
+#include <algorithm>
+
 #include "data_file.hpp"
+#include "ear_bits/hoa.hpp"
 #include "utils.hpp"
 
 namespace {
@@ -49,19 +52,19 @@ void check(bool x, const std::string &message)
 namespace bear {
 using namespace Eigen;
 
-Panner::Panner(const std::string &brir_file_name)
+Panner::Panner(const std::string &brir_file_name, const tensorfile::ReadOptions &read_options, bool prefault)
 {
-  auto tf = tensorfile::read(brir_file_name);
+  auto tf = tensorfile::read(brir_file_name, read_options);
 
   check_data_file_version(tf);
 
-  views = tf.unpack<float>(tf.metadata["views"]);
-  brirs = tf.unpack<float>(tf.metadata["brirs"]);
-  delays = tf.unpack<float>(tf.metadata["delays"]);
-  decorrelation_filters = tf.unpack<float>(tf.metadata["decorrelation_filters"]);
-  fs = tf.metadata["fs"].GetDouble();
-  decorrelation_delay_ = tf.metadata["decorrelation_delay"].GetDouble();
-  front_loudspeaker_ = tf.metadata["front_loudspeaker"].GetUint();
+  views = tf.unpack<float>(tf.metadata()["views"]);
+  brirs = tf.unpack<float>(tf.metadata()["brirs"]);
+  delays = tf.unpack<float>(tf.metadata()["delays"]);
+  decorrelation_filters = tf.unpack<float>(tf.metadata()["decorrelation_filters"]);
+  fs = tf.metadata()["fs"].GetDouble();
+  decorrelation_delay_ = tf.metadata()["decorrelation_delay"].GetDouble();
+  front_loudspeaker_ = tf.metadata()["front_loudspeaker"].GetUint();
 
   // check and unpack dimensions
   check(views->ndim() == 2, "views must have 2 dimensions");
@@ -86,6 +89,14 @@ Panner::Panner(const std::string &brir_file_name)
   check(delays->shape(1) == n_virtual_loudspeakers_, "delays axis 1 is wrong size");
   check(delays->shape(2) == 2, "delays axis 2 is wrong size");
 
+  for (size_t view = 0; view < n_views_; view++)
+    for (size_t vs = 0; vs < n_virtual_loudspeakers_; vs++)
+      for (size_t ear = 0; ear < 2; ear++) {
+        double delay = (*delays)(view, vs, ear);
+        check(delay >= 0.0, "delays must not be negative");
+        max_delay_ = std::max(max_delay_, delay);
+      }
+
   check(decorrelation_filters->shape(0) == n_virtual_loudspeakers_,
         "decorrelation filters axis 0 is wrong size");
   check(decorrelation_filters->shape(1) == decorrelator_length_,
@@ -93,11 +104,11 @@ Panner::Panner(const std::string &brir_file_name)
 
   // load layout
   ear::Layout layout;
-  if (tf.metadata["layout"].IsString()) {
-    std::string layout_name = tf.metadata["layout"].GetString();
+  if (tf.metadata()["layout"].IsString()) {
+    std::string layout_name = tf.metadata()["layout"].GetString();
     layout = ear::getLayout(layout_name).withoutLfe();
   } else {
-    layout = load_layout(tf.metadata["layout"]);
+    layout = load_layout(tf.metadata()["layout"]);
   }
 
   // make gain calculators
@@ -110,9 +121,9 @@ Panner::Panner(const std::string &brir_file_name)
   temp_direct_diffuse.resize(num_gains() * 2);
   temp_direct_speakers.resize(num_gains());
 
-  if (tf.metadata.HasMember("gain_norm_quick")) {
+  if (tf.metadata().HasMember("gain_norm_quick")) {
     gain_comp_type = GainCompType::QUICK;
-    gain_comp_factors = tf.unpack<float>(tf.metadata["gain_norm_quick"]["factors"]);
+    gain_comp_factors = tf.unpack<float>(tf.metadata()["gain_norm_quick"]["factors"]);
     check(gain_comp_factors->ndim() == 5, "gain comp factors must have 5 dimensions");
     // TODO: check max delays?
     check(gain_comp_factors->shape(1) == n_views_, "gain comp factors axis 1 is wrong size");
@@ -123,17 +134,71 @@ Panner::Panner(const std::string &brir_file_name)
     check(gain_comp_factors->shape(4) == 2, "gain comp factors axis 4 is wrong size");
   }
 
-  check(tf.metadata.HasMember("hoa"), "HOA decoder not present");
-  hoa_irs = tf.unpack<float>(tf.metadata["hoa"]["irs"]);
+  check(tf.metadata().HasMember("hoa"), "HOA decoder not present");
+  hoa_irs = tf.unpack<float>(tf.metadata()["hoa"]["irs"]);
   check(hoa_irs->ndim() == 3, "HOA decoder must have 3 dimensions");
   n_hoa_channels_ = hoa_irs->shape(0);
   check(hoa_irs->shape(1) == 2, "HOA decoder axis 1 is wrong size");
 
-  if (tf.metadata["hoa"].HasMember("delay")) hoa_delay_ = tf.metadata["hoa"]["delay"].GetDouble();
+  if (tf.metadata()["hoa"].HasMember("delay")) hoa_delay_ = tf.metadata()["hoa"]["delay"].GetDouble();
 
   hoa_order_ = ((size_t)std::round(std::sqrt(n_hoa_channels_))) - 1;
   size_t nch_for_order = (hoa_order_ + 1) * (hoa_order_ + 1);
   if (nch_for_order != n_hoa_channels_) throw std::logic_error("bad number of hoa channels");
+
+  if (tf.metadata()["hoa"].HasMember("symmetric"))
+    hoa_symmetric_ = tf.metadata()["hoa"]["symmetric"].GetBool();
+  else
+    hoa_symmetric_ = detect_hoa_symmetric();
+
+  if (prefault) {
+    // roughly in order of first use; the arrays are held until the thread
+    // finishes
+    std::vector<std::shared_ptr<tensorfile::NDArrayT<float>>> arrays = {
+        brirs, decorrelation_filters, hoa_irs, views, delays};
+    if (gain_comp_factors) arrays.push_back(gain_comp_factors);
+
+    prefault_thread = std::thread([this, arrays]() {
+      for (auto &array : arrays) {
+        if (stop_prefault) return;
+        tensorfile::prefault(*array);
+      }
+    });
+  }
+}
+
+Panner::~Panner()
+{
+  stop_prefault = true;
+  if (prefault_thread.joinable()) prefault_thread.join();
+}
+
+bool Panner::detect_hoa_symmetric() const
+{
+  for (size_t channel = 0; channel < n_hoa_channels_; channel++) {
+    float sign = hoa_channel_antisymmetric(channel) ? -1.0f : 1.0f;
+    for (size_t i = 0; i < hoa_ir_length(); i++)
+      if ((*hoa_irs)(channel, 1u, i) != sign * (*hoa_irs)(channel, 0u, i)) return false;
+  }
+  return true;
+}
+
+bool Panner::hoa_channel_antisymmetric(size_t channel)
+{
+  return ear_bits::hoa::from_acn(static_cast<int>(channel)).second < 0;
+}
+
+std::vector<Panner::NamedArray> Panner::get_arrays() const
+{
+  std::vector<NamedArray> arrays = {
+      {"views", views},
+      {"brirs", brirs},
+      {"delays", delays},
+      {"decorrelation_filters", decorrelation_filters},
+      {"hoa_irs", hoa_irs},
+  };
+  if (gain_comp_factors) arrays.emplace_back("gain_comp_factors", gain_comp_factors);
+  return arrays;
 }
 
 void Panner::calc_objects_gains(const ear::ObjectsTypeMetadata &type_metadata,
@@ -1,5 +1,11 @@
 #pragma once
 #include <Eigen/Core>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "ear/ear.hpp"
 #include "tensorfile.hpp"
@@ -49,7 +55,13 @@ using namespace Eigen;
 /// inserted without affecting the delay calculation.
 class Panner {
  public:
-  Panner(const std::string &brir_file_name);
+  /// load a data file; if prefault is true, the arrays which are needed for
+  /// rendering are read on a background thread, so that they are resident
+  /// before they are first used
+  Panner(const std::string &brir_file_name,
+         const tensorfile::ReadOptions &read_options = {},
+         bool prefault = false);
+  ~Panner();
 
   size_t num_gains() const { return n_gains_; }
   size_t num_virtual_loudspeakers() const { return n_virtual_loudspeakers_; }
@@ -98,6 +110,10 @@ class Panner {
   double compensation_gain_direct(const Ref<const VectorXd> &gains, SelectedBRIR selected_brir) const;
 
   double decorrelation_delay() const;
+  /// largest value in the delays tensor, in seconds; this is the longest
+  /// diffuse delay, and the longest direct delay excluding the decorrelation
+  /// delay
+  double max_delay() const { return max_delay_ / fs; }
 
   size_t n_hoa_channels() const { return n_hoa_channels_; }
   size_t hoa_order() const { return hoa_order_; }
@@ -105,6 +121,18 @@ class Panner {
   const float *get_hoa_ir(size_t channel, size_t ear) const;
   double hoa_delay() const { return hoa_delay_ / fs; }
 
+  /// is the HOA decoder left/right symmetric? if so, the right ear IR for each
+  /// channel is the left ear IR, negated if hoa_channel_antisymmetric(channel)
+  bool hoa_decoder_symmetric() const { return hoa_symmetric_; }
+  /// is the spherical harmonic for an ACN channel number antisymmetric under
+  /// y -> -y (i.e. left/right reflection)?
+  static bool hoa_channel_antisymmetric(size_t channel);
+
+  using NamedArray = std::pair<std::string, std::shared_ptr<const tensorfile::NDArrayT<float>>>;
+  /// the arrays from the data file which are used for rendering, with their
+  /// names, for memory accounting
+  std::vector<NamedArray> get_arrays() const;
+
  private:
   double get_real_gain_quick(double *gains,
                              LeftRight<double> direct_delays,
@@ -116,6 +144,8 @@ class Panner {
   double get_real_gain_quick_direct(const Ref<const VectorXd> &gains, SelectedBRIR selected_brir) const;
   double get_expected_gain_quick_direct(const Ref<const VectorXd> &gains, SelectedBRIR selected_brir) const;
 
+  bool detect_hoa_symmetric() const;
+
   template <typename Derived>
   LeftRight<double> get_delays(const Eigen::DenseBase<Derived> &gains, SelectedBRIR selected_brir = {}) const;
 
@@ -125,10 +155,12 @@ class Panner {
   size_t brir_length_;
   size_t decorrelator_length_;
   size_t decorrelation_delay_;
+  double max_delay_ = 0.0;
   size_t front_loudspeaker_;
   size_t n_hoa_channels_;
   size_t hoa_order_;
   double hoa_delay_ = 0.0;
+  bool hoa_symmetric_ = false;
   enum class GainCompType { NONE, QUICK } gain_comp_type = GainCompType::NONE;
 
   std::shared_ptr<tensorfile::NDArrayT<float>> views;
@@ -147,6 +179,9 @@ class Panner {
   mutable std::vector<double> temp_direct_diffuse;
 
   mutable std::vector<double> temp_direct_speakers;
+
+  std::atomic<bool> stop_prefault{false};
+  std::thread prefault_thread;
 };
 
 }  // namespace bear
@@ -0,0 +1,55 @@
+#include "panner_cache.hpp"
+
+namespace bear {
+
+namespace {
+  /// key identifying a Panner loaded with the options in config
+  std::string panner_key(const ConfigImpl &config)
+  {
+    return config.data_path + '\0' + config.data_file_advice + '\0' +
+           (config.data_file_huge_pages ? "h" : "-") + (config.data_file_lock ? "l" : "-") +
+           (config.data_file_prefault ? "p" : "-");
+  }
+}  // namespace
+
+tensorfile::ReadOptions data_file_read_options(const ConfigImpl &config)
+{
+  tensorfile::ReadOptions options;
+  options.sequential = config.data_file_advice == "sequential";
+  options.will_need = config.data_file_advice == "willneed";
+  options.huge_pages = config.data_file_huge_pages;
+  options.lock = config.data_file_lock;
+  return options;
+}
+
+std::shared_ptr<Panner> PannerCache::get(const ConfigImpl &config)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // drop panners which are no longer used
+  for (auto it = panners.begin(); it != panners.end();)
+    if (it->second.expired())
+      it = panners.erase(it);
+    else
+      ++it;
+
+  std::weak_ptr<Panner> &entry = panners[panner_key(config)];
+  std::shared_ptr<Panner> panner = entry.lock();
+  if (!panner) {
+    panner = std::make_shared<Panner>(
+        config.data_path, data_file_read_options(config), config.data_file_prefault);
+    entry = panner;
+  }
+  return panner;
+}
+
+size_t PannerCache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t n = 0;
+  for (auto &entry : panners)
+    if (!entry.second.expired()) n++;
+  return n;
+}
+
+}  // namespace bear
@@ -0,0 +1,36 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "config_impl.hpp"
+#include "panner.hpp"
+
+namespace bear {
+
+/// Shares Panner instances between renderers which use the same data file
+/// with the same read options.
+///
+/// Panners are held weakly, so one is freed once the last renderer using it
+/// has been destroyed. get may be called from any thread, but Panner is not
+/// thread-safe while rendering (gain calculation uses temporary buffers in
+/// the Panner), so renderers which share a cache must be processed from one
+/// thread at a time.
+class PannerCache {
+ public:
+  /// get the Panner for config, loading it if it is not already loaded
+  std::shared_ptr<Panner> get(const ConfigImpl &config);
+
+  /// number of Panners currently loaded
+  size_t size();
+
+ private:
+  std::mutex mutex;
+  std::map<std::string, std::weak_ptr<Panner>> panners;
+};
+
+/// read options for loading the data file specified in config
+tensorfile::ReadOptions data_file_read_options(const ConfigImpl &config);
+
+}  // namespace bear
@@ -54,6 +54,10 @@ struct ListenerParameter
   ListenerParameter(const visr::ParameterConfigBase &) {}
   ListenerParameter(const ListenerImpl &listener) : ListenerImpl(listener) {}
   ListenerParameter() {}
+
+  /// time in seconds over which to interpolate from the previous listener to
+  /// this one
+  double interpolation_time = 0.0;
 };
 
 void init_parameters();
@@ -6,6 +6,7 @@ PerEarDelay::PerEarDelay(const SignalFlowContext &ctx,
                          CompositeComponent *parent,
                          size_t num_inputs,
                          size_t num_outputs,
+                         double max_delay,
                          double initial_delay)
     : CompositeComponent(ctx, name, parent),
       object_ear_index(num_inputs, 2u),
@@ -13,21 +14,18 @@ PerEarDelay::PerEarDelay(const SignalFlowContext &ctx,
       in("in", *this, num_inputs),
       out("out", *this, 2 * num_outputs),
 
-      delays(ctx, "delays", this),
+      delays(ctx,
+             "delays",
+             this,
+             /* num_channels = */ 2 * num_inputs,
+             /* max_delay = */ max_delay,
+             /* initial_delay = */ initial_delay,
+             /* control_input = */ true),
       delays_in("delays_in", *this, pml::VectorParameterConfig(2 * num_inputs)),
       gains_l(ctx, "gains_l", this),
       gains_r(ctx, "gains_r", this),
       gains_in("gains_in", *this, pml::MatrixParameterConfig(num_outputs, num_inputs))
 {
-  delays.setup(
-      /* numberOfChannels = */ 2 * num_inputs,
-      /* interpolationSteps = */ period(),
-      /* maximumDelaySeconds = */ 1.0,  // TODO: reduce this to match maximum required delay
-      /* interpolationMethod = */ "lagrangeOrder3",
-      /* methodDelayPolicy = */ rcl::DelayVector::MethodDelayPolicy::Add,
-      /* controlInputs = */ rcl::DelayVector::ControlPortConfig::Delay,
-      /* initialDelaySeconds = */ initial_delay);
-
   std::array<rcl::GainMatrix *, 2> gains{&gains_l, &gains_r};
   for (auto gains_i : gains)
     gains_i->setup(
@@ -53,6 +51,6 @@ PerEarDelay::PerEarDelay(const SignalFlowContext &ctx,
 
   parameterConnection(gains_in, gains_l.parameterPort("gainInput"));
   parameterConnection(gains_in, gains_r.parameterPort("gainInput"));
-  parameterConnection(delays_in, delays.parameterPort("delayInput"));
+  parameterConnection(delays_in, delays.parameterPort("delays_in"));
 }
 }  // namespace bear
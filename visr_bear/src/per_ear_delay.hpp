@@ -1,7 +1,6 @@
 #pragma once
 #include <libpml/matrix_parameter.hpp>
 #include <librcl/add.hpp>
-#include <librcl/delay_vector.hpp>
 #include <librcl/gain_matrix.hpp>
 #include <libvisr/audio_input.hpp>
 #include <libvisr/audio_output.hpp>
@@ -9,6 +8,7 @@
 #include <memory>
 
 #include "bear/api.hpp"
+#include "delays.hpp"
 #include "utils.hpp"
 
 namespace bear {
@@ -21,6 +21,7 @@ class PerEarDelay : public CompositeComponent {
                        CompositeComponent *parent,
                        std::size_t num_inputs,
                        std::size_t num_outputs,
+                       double max_delay,
                        double initial_delay);
 
  private:
@@ -30,7 +31,7 @@ class PerEarDelay : public CompositeComponent {
   AudioInput in;
   AudioOutput out;
 
-  rcl::DelayVector delays;
+  Delays delays;
   ParameterInput<pml::DoubleBufferingProtocol, pml::VectorParameter<float>> delays_in;
   rcl::GainMatrix gains_l;
   rcl::GainMatrix gains_r;
@@ -156,4 +156,53 @@ void quaternion_to_sh_rotation_matrix(const Eigen::Quaterniond &q,
   CalculateTransform(rotation_matrix, order, sh_transform);
 }
 
+void apply_sh_rotation_blocks(const Eigen::Ref<const Eigen::MatrixXd> &sh_mat,
+                              int order,
+                              const Eigen::Ref<const Eigen::VectorXd> &in,
+                              Eigen::Ref<Eigen::VectorXd> out)
+{
+  for (int l = 0; l <= order; l++)
+    out.segment(l * l, 2 * l + 1).noalias() =
+        sh_mat.block(l * l, l * l, 2 * l + 1, 2 * l + 1) * in.segment(l * l, 2 * l + 1);
+}
+
+boost::optional<double> quaternion_to_yaw(const Eigen::Quaterniond &q)
+{
+  Eigen::Quaterniond qn = q.normalized();
+  // components this small correspond to a tilt of a few micro-radians, which
+  // is well below the precision of the gains
+  const double tolerance = 1e-6;
+  if (std::abs(qn.x()) > tolerance || std::abs(qn.y()) > tolerance) return boost::none;
+
+  return 2.0 * std::atan2(qn.z(), qn.w());
+}
+
+SHYawRotation::SHYawRotation(int order_) : order(order_), cos_m(order + 1), sin_m(order + 1)
+{
+  set_yaw(0.0);
+}
+
+void SHYawRotation::set_yaw(double yaw)
+{
+  for (int m = 0; m <= order; m++) {
+    cos_m(m) = std::cos(m * yaw);
+    sin_m(m) = std::sin(m * yaw);
+  }
+}
+
+void SHYawRotation::apply(const Eigen::Ref<const Eigen::VectorXd> &in, Eigen::Ref<Eigen::VectorXd> out) const
+{
+  for (int l = 0; l <= order; l++) {
+    // ACN = l * l + l + m
+    int centre = l * l + l;
+    out(centre) = in(centre);
+    for (int m = 1; m <= l; m++) {
+      double cos_part = in(centre + m);
+      double sin_part = in(centre - m);
+      out(centre + m) = cos_m(m) * cos_part - sin_m(m) * sin_part;
+      out(centre - m) = cos_m(m) * sin_part + sin_m(m) * cos_part;
+    }
+  }
+}
+
 }  // namespace bear
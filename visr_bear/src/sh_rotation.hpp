@@ -1,10 +1,44 @@
 #pragma once
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <boost/optional.hpp>
 #include <vector>
 
 namespace bear {
 void quaternion_to_sh_rotation_matrix(const Eigen::Quaterniond &q,
                                       int order,
                                       Eigen::Ref<Eigen::MatrixXd> sh_mat);
+
+/// multiply in by the block-diagonal matrix sh_mat from
+/// quaternion_to_sh_rotation_matrix, only using the blocks for each order
+void apply_sh_rotation_blocks(const Eigen::Ref<const Eigen::MatrixXd> &sh_mat,
+                              int order,
+                              const Eigen::Ref<const Eigen::VectorXd> &in,
+                              Eigen::Ref<Eigen::VectorXd> out);
+
+/// if q is a rotation around the z axis only (within a small tolerance),
+/// get the angle of rotation in radians, for use with SHYawRotation
+boost::optional<double> quaternion_to_yaw(const Eigen::Quaterniond &q);
+
+/// Rotation of ACN-ordered real spherical harmonics around the z axis.
+///
+/// This is equivalent to the matrix from quaternion_to_sh_rotation_matrix
+/// for a rotation around z, but each pair of degrees +m and -m are rotated by
+/// a 2x2 block, so applying it is O(n) in the number of channels, rather than
+/// O(n^2).
+class SHYawRotation {
+ public:
+  explicit SHYawRotation(int order);
+
+  /// set the angle to rotate by, from quaternion_to_yaw
+  void set_yaw(double yaw);
+
+  void apply(const Eigen::Ref<const Eigen::VectorXd> &in, Eigen::Ref<Eigen::VectorXd> out) const;
+
+ private:
+  int order;
+  // cos(m * yaw) and sin(m * yaw), indexed by m
+  Eigen::VectorXd cos_m;
+  Eigen::VectorXd sin_m;
+};
 }  // namespace bear
@@ -1,6 +1,12 @@
 #include "tensorfile.hpp"
 
+#include <algorithm>
+#include <boost/crc.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
 #include <sstream>
+#include <type_traits>
 
 // Prevent mio's window.h include assigning problematic macros
 #define WIN32_LEAN_AND_MEAN
@@ -8,6 +14,10 @@
 #include "mio.hpp"
 #include "rapidjson/error/en.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 namespace tensorfile {
 
 class MMap : public mio::ummap_source {
@@ -26,6 +36,8 @@ namespace detail {
     {
     }
 
+    bool mapped() const override { return std::is_same<PtrT, std::shared_ptr<MMap>>::value; }
+
    private:
     PtrT ptr;
   };
@@ -62,6 +74,15 @@ namespace detail {
 
   std::string parse_type(const std::string &type) { return type.substr(1, std::string::npos); }
 
+  /// number of bytes in one element of a dtype like "<f4"
+  size_t item_size(const std::string &dtype)
+  {
+    std::string type = parse_type(dtype);
+    if (type.size() < 2 || type.find_first_not_of("0123456789", 1) != std::string::npos)
+      throw format_error("unknown dtype " + dtype);
+    return std::stoul(type.substr(1));
+  }
+
   /// get the current system byte order
   ByteOrder get_byte_order()
   {
@@ -146,6 +167,126 @@ namespace detail {
     }
   };
 
+  /// convert an IEEE 754 half precision number to float
+  float half_to_float(uint16_t h)
+  {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1fu;
+    uint32_t mantissa = h & 0x3ffu;
+
+    if (exponent == 0) {
+      // zero or subnormal
+      float value = std::ldexp((float)mantissa, -24);
+      return sign ? -value : value;
+    }
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+      // inf or nan
+      bits = sign | 0x7f800000u | (mantissa << 13);
+    else
+      bits = sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  /// native-order float32 dtype string
+  std::string native_float_dtype() { return get_byte_order() == ByteOrder::BIG ? ">f4" : "<f4"; }
+
+  /// make a dense C-order float copy of an array, converting each element
+  /// with f
+  template <typename T, typename F>
+  std::shared_ptr<NDArray> convert_to_float(const NDArrayT<T> &src, F f)
+  {
+    size_t ndim = src.ndim();
+    std::vector<size_t> strides(ndim);
+    size_t num_elements = 1;
+    for (size_t i = ndim; i-- > 0;) {
+      strides[i] = num_elements;
+      num_elements *= src.shape(i);
+    }
+
+    std::vector<float> storage(num_elements);
+    std::vector<size_t> index(ndim, 0);
+    for (size_t out_idx = 0; out_idx < num_elements; out_idx++) {
+      size_t src_idx = 0;
+      for (size_t i = 0; i < ndim; i++) src_idx += index[i] * src.stride(i);
+      storage[out_idx] = f(src.data()[src_idx]);
+
+      for (size_t i = ndim; i-- > 0;) {
+        if (++index[i] < src.shape(i)) break;
+        index[i] = 0;
+      }
+    }
+
+    using ArrayT = NDArrayTHold<float, std::vector<float>>;
+    return std::make_shared<ArrayT>(
+        native_float_dtype(), src.shape(), std::move(strides), storage.data(), std::move(storage));
+  }
+
+  /// half precision arrays are loaded as uint16_t (dealing with byte order
+  /// and alignment) then converted to float
+  struct HalfTypeHandler : public TypeHandler {
+   public:
+    std::shared_ptr<NDArray> operator()(std::string dtype,
+                                        std::vector<size_t> shape,
+                                        std::vector<size_t> strides,
+                                        std::shared_ptr<MMap> mmap,
+                                        size_t offset) override
+    {
+      auto raw = std::dynamic_pointer_cast<NDArrayT<uint16_t>>(TypeHandlerT<uint16_t>()(
+          std::move(dtype), std::move(shape), std::move(strides), std::move(mmap), offset));
+      return convert_to_float(*raw, half_to_float);
+    }
+  };
+
+  /// apply the scale of a scaled array, returning a float array
+  template <typename T>
+  std::shared_ptr<NDArray> try_scale(const std::shared_ptr<NDArray> &array, float scale)
+  {
+    auto array_t = std::dynamic_pointer_cast<NDArrayT<T>>(array);
+    if (!array_t) return {};
+    return convert_to_float(*array_t, [scale](T x) { return static_cast<float>(x) * scale; });
+  }
+
+  std::shared_ptr<NDArray> apply_scale(const std::shared_ptr<NDArray> &array, float scale)
+  {
+    std::shared_ptr<NDArray> result;
+    if (!result) result = try_scale<int8_t>(array, scale);
+    if (!result) result = try_scale<int16_t>(array, scale);
+    if (!result) result = try_scale<int32_t>(array, scale);
+    if (!result) result = try_scale<uint8_t>(array, scale);
+    if (!result) result = try_scale<uint16_t>(array, scale);
+    if (!result) result = try_scale<uint32_t>(array, scale);
+    if (!result) throw format_error("scaled arrays must have an integer type of at most 4 bytes");
+    return result;
+  }
+
+  /// apply ReadOptions to a mapping; the advice is only a hint, so failures
+  /// are ignored
+  void apply_read_options(MMap &mmap, const ReadOptions &options)
+  {
+    if (mmap.mapped_length() == 0) return;
+    // the whole file is mapped, so this is page-aligned
+    void *addr = (void *)mmap.data();
+    size_t length = mmap.mapped_length();
+
+#ifndef _WIN32
+    if (options.sequential) madvise(addr, length, MADV_SEQUENTIAL);
+    if (options.will_need) madvise(addr, length, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages) madvise(addr, length, MADV_HUGEPAGE);
+#endif
+    if (options.lock && mlock(addr, length) != 0)
+      throw std::runtime_error(std::string("could not lock tensorfile in memory: ") + std::strerror(errno));
+#else
+    if (options.lock && !VirtualLock(addr, length))
+      throw std::runtime_error("could not lock tensorfile in memory");
+#endif
+  }
+
   // get the handler for a particular type
   std::unique_ptr<TypeHandler> get_type_handler(const std::string &dtype)
   {
@@ -154,6 +295,8 @@ namespace detail {
       return std::unique_ptr<TypeHandler>(new TypeHandlerT<double>());
     else if (type == "f4")
       return std::unique_ptr<TypeHandler>(new TypeHandlerT<float>());
+    else if (type == "f2")
+      return std::unique_ptr<TypeHandler>(new HalfTypeHandler());
     else if (type == "u8")
       return std::unique_ptr<TypeHandler>(new TypeHandlerT<uint64_t>());
     else if (type == "u4")
@@ -176,6 +319,96 @@ namespace detail {
 
 }  // namespace detail
 
+rapidjson::Document &TensorFile::metadata()
+{
+  return const_cast<rapidjson::Document &>(static_cast<const TensorFile &>(*this).metadata());
+}
+
+const rapidjson::Document &TensorFile::metadata() const
+{
+  if (!metadata_) {
+    auto metadata = std::make_unique<rapidjson::Document>();
+    metadata->Parse((const char *)mmap->data() + metadata_offset, metadata_len);
+    if (metadata->HasParseError()) {
+      std::stringstream err;
+      err << "could not parse JSON metadata at " << metadata->GetErrorOffset() << ": "
+          << GetParseError_En(metadata->GetParseError());
+      throw format_error(err.str());
+    }
+    metadata_ = std::move(metadata);
+  }
+  return *metadata_;
+}
+
+std::pair<const char *, size_t> TensorFile::entry_name(const unsigned char *entry) const
+{
+  auto name_offset = detail::read_unsigned<uint32_t>(entry + 20);
+  if (name_offset >= names_len) throw format_error("array name is outside the name table");
+
+  const char *name = (const char *)mmap->data() + names_offset + name_offset;
+  const char *names_end = (const char *)mmap->data() + names_offset + names_len;
+  const char *name_end = std::find(name, names_end, '\0');
+  if (name_end == names_end) throw format_error("array name is not terminated");
+
+  return {name, static_cast<size_t>(name_end - name)};
+}
+
+IndexEntry TensorFile::index_entry(size_t index) const
+{
+  if (index >= num_arrays()) throw format_error("array index out of range");
+  const unsigned char *entry = mmap->data() + entries_offset + index * index_entry_size;
+
+  IndexEntry result;
+  result.base = detail::read_unsigned<uint64_t>(entry);
+  result.length = detail::read_unsigned<uint64_t>(entry + 8);
+  result.crc32 = detail::read_unsigned<uint32_t>(entry + 16);
+
+  // dtype is padded with zeros
+  const char *dtype = (const char *)entry + 24;
+  result.dtype = std::string(dtype, std::find(dtype, dtype + 8, '\0'));
+
+  auto name = entry_name(entry);
+  result.name = std::string(name.first, name.second);
+
+  if (result.base > mmap->length() || result.length > mmap->length() - result.base)
+    throw format_error("array extends past the end of the file");
+
+  return result;
+}
+
+boost::optional<size_t> TensorFile::find(const std::string &name) const
+{
+  for (size_t i = 0; i < num_arrays(); i++) {
+    auto entry_name_i = entry_name(mmap->data() + entries_offset + i * index_entry_size);
+    if (entry_name_i.second == name.size() && std::equal(name.begin(), name.end(), entry_name_i.first))
+      return i;
+  }
+  return boost::none;
+}
+
+bool TensorFile::verify(size_t index) const
+{
+  IndexEntry entry = index_entry(index);
+
+  boost::crc_32_type crc;
+  crc.process_bytes(mmap->data() + entry.base, entry.length);
+  return crc.checksum() == entry.crc32;
+}
+
+bool TensorFile::verify(const rapidjson::Value &v) const
+{
+  auto it = v.FindMember("index");
+  if (it == v.MemberEnd()) return true;
+  return verify(it->value.GetUint64());
+}
+
+bool TensorFile::verify_all() const
+{
+  for (size_t i = 0; i < num_arrays(); i++)
+    if (!verify(i)) return false;
+  return true;
+}
+
 std::shared_ptr<NDArray> TensorFile::unpack(const rapidjson::Value &v) const
 {
   if (std::string(v["_tenf_type"].GetString()) == "array") {
@@ -187,44 +420,95 @@ std::shared_ptr<NDArray> TensorFile::unpack(const rapidjson::Value &v) const
 
     if (strides.size() != shape.size()) throw format_error("mismatched strides and shape");
 
-    std::string dtype(v["dtype"].GetString());
-    size_t offset = v["base"].GetInt64();
+    std::string dtype;
+    size_t offset;
+
+    auto index_it = v.FindMember("index");
+    if (index_it != v.MemberEnd()) {
+      // version 1: the index is authoritative, and gives the length so that
+      // the array can be bounds-checked
+      IndexEntry entry = index_entry(index_it->value.GetUint64());
+      dtype = entry.dtype;
+      offset = entry.base;
+
+      // bytes from the base to the end of the last element, or 0 if the array
+      // has no elements
+      size_t end_byte = detail::item_size(dtype);
+      for (size_t i = 0; i < shape.size(); i++) {
+        if (shape[i] == 0) {
+          end_byte = 0;
+          break;
+        }
+        end_byte += strides[i] * (shape[i] - 1);
+      }
+      if (end_byte > entry.length) throw format_error("array shape exceeds its length");
+    } else {
+      dtype = v["dtype"].GetString();
+      offset = v["base"].GetInt64();
+    }
 
     auto type_handler = detail::get_type_handler(dtype);
-    return (*type_handler)(std::move(dtype), std::move(shape), std::move(strides), mmap, offset);
+    if (!type_handler) throw format_error("unknown dtype " + dtype);
+    auto array = (*type_handler)(std::move(dtype), std::move(shape), std::move(strides), mmap, offset);
+
+    if (v.HasMember("scale")) return detail::apply_scale(array, static_cast<float>(v["scale"].GetDouble()));
+
+    return array;
 
   } else {
     throw format_error("unknown type");
   }
 }
 
-TensorFile read(const std::string &path)
+TensorFile read(const std::string &path, const ReadOptions &options)
 {
   auto mmap = std::make_shared<MMap>(path);
+  detail::apply_read_options(*mmap, options);
   const unsigned char *data = mmap->data();
-  size_t header_len = 4 + 4 + 8 + 8;
-  if (mmap->length() < header_len) throw format_error("file not long enough");
+  if (mmap->length() < 8) throw format_error("file not long enough");
 
   if (std::string((const char *)data, 4) != "TENF") throw format_error("magic number not found");
 
   auto version = detail::read_unsigned<uint32_t>(data + 4);
-  if (version != 0) throw format_error("unknown version number");
+  size_t header_len;
+  if (version == 0)
+    header_len = 4 + 4 + 8 + 8;
+  else if (version == 1)
+    header_len = 4 + 4 + 8 + 8 + 8;
+  else
+    throw format_error("unknown version number");
+
+  if (mmap->length() < header_len) throw format_error("file not long enough");
+
   auto data_len = detail::read_unsigned<uint64_t>(data + 8);
   auto metadata_len = detail::read_unsigned<uint64_t>(data + 16);
+  uint64_t index_len = version == 1 ? detail::read_unsigned<uint64_t>(data + 24) : 0;
 
-  if (mmap->length() < header_len + data_len + metadata_len) throw format_error("file not long enough");
+  if (mmap->length() < header_len + data_len + metadata_len + index_len)
+    throw format_error("file not long enough");
   if (metadata_len == 0) throw format_error("no JSON metadata found");
 
-  rapidjson::Document metadata;
-  metadata.Parse((char *)data + header_len + data_len, metadata_len);
-  if (metadata.HasParseError()) {
-    std::stringstream err;
-    err << "could not parse JSON metadata at " << metadata.GetErrorOffset() << ": "
-        << GetParseError_En(metadata.GetParseError());
-    throw format_error(err.str());
+  // the index is the number of arrays, one entry per array, then the name
+  // table
+  size_t index_offset = header_len + data_len + metadata_len;
+  uint64_t num_arrays = 0;
+  size_t names_offset = index_offset;
+  if (version == 1) {
+    if (index_len < 8) throw format_error("index too short");
+    num_arrays = detail::read_unsigned<uint64_t>(data + index_offset);
+    if (num_arrays > (index_len - 8) / TensorFile::index_entry_size)
+      throw format_error("index too short for the number of arrays");
+    names_offset = index_offset + 8 + num_arrays * TensorFile::index_entry_size;
   }
 
-  return TensorFile(std::move(mmap), std::move(metadata));
+  return TensorFile(std::move(mmap),
+                    version,
+                    /* metadata_offset = */ header_len + data_len,
+                    metadata_len,
+                    /* entries_offset = */ index_offset + 8,
+                    num_arrays,
+                    names_offset,
+                    /* names_len = */ index_offset + index_len - names_offset);
 }
 
 }  // namespace tensorfile
@@ -1,8 +1,11 @@
 #pragma once
+#include <boost/optional.hpp>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rapidjson/document.h"
@@ -46,6 +49,10 @@ class NDArray {
     return detail::calc_index(strides_.data(), indices...);
   }
 
+  /// true if the data points into the mapped file, or false if it is held
+  /// by the array (because it was converted or realigned on load)
+  virtual bool mapped() const = 0;
+
   virtual ~NDArray() {}
 
  protected:
@@ -71,6 +78,19 @@ struct NDArrayT : public NDArray {
     return base_ptr[idx(indices...)];
   }
 
+  /// number of bytes from the start of the data to the end of the last
+  /// element
+  size_t num_bytes() const
+  {
+    // index of the last element + 1
+    size_t num_elements = 1;
+    for (size_t i = 0; i < ndim(); i++) {
+      if (shape(i) == 0) return 0;
+      num_elements += stride(i) * (shape(i) - 1);
+    }
+    return num_elements * sizeof(T);
+  }
+
   T *base_ptr;
 
  protected:
@@ -80,14 +100,94 @@ struct NDArrayT : public NDArray {
   }
 };
 
+/// touch each page of an array so that it is resident before it is used
+template <typename T>
+void prefault(const NDArrayT<T> &array)
+{
+  size_t num_bytes = array.num_bytes();
+  if (num_bytes == 0) return;
+
+  // the smallest page size on supported platforms
+  const size_t page_size = 4096;
+  const volatile unsigned char *bytes = reinterpret_cast<const volatile unsigned char *>(array.data());
+  for (size_t i = 0; i < num_bytes; i += page_size) (void)bytes[i];
+  (void)bytes[num_bytes - 1];
+}
+
+/// hints about how a file will be used, to control how it is paged in
+struct ReadOptions {
+  /// the file will be read sequentially, so read ahead aggressively
+  bool sequential = false;
+  /// the whole file will be needed soon, so start reading it immediately
+  bool will_need = false;
+  /// back the mapping with transparent huge pages, if the kernel supports
+  /// this for files; arrays in files written with a large alignment (see
+  /// tensorfile.py) then do not share huge pages
+  bool huge_pages = false;
+  /// lock the mapping in memory, so that pages are never evicted after they
+  /// have been read; this throws std::runtime_error if it fails, for example
+  /// because RLIMIT_MEMLOCK is too low
+  bool lock = false;
+};
+
+/// entry in the binary index of a version 1 file
+struct IndexEntry {
+  size_t base;
+  size_t length;
+  uint32_t crc32;
+  std::string dtype;
+  /// JSON pointer to the array in the metadata, e.g. "/views/0/brirs"
+  std::string name;
+};
+
 class TensorFile {
  public:
-  TensorFile(std::shared_ptr<MMap> mmap, rapidjson::Document metadata)
-      : metadata(std::move(metadata)), mmap(std::move(mmap))
+  TensorFile(std::shared_ptr<MMap> mmap,
+             uint32_t version,
+             size_t metadata_offset,
+             size_t metadata_len,
+             size_t entries_offset,
+             size_t num_arrays,
+             size_t names_offset,
+             size_t names_len)
+      : mmap(std::move(mmap)),
+        version_(version),
+        metadata_offset(metadata_offset),
+        metadata_len(metadata_len),
+        entries_offset(entries_offset),
+        num_arrays_(num_arrays),
+        names_offset(names_offset),
+        names_len(names_len)
   {
   }
-  rapidjson::Document metadata;
 
+  /// the JSON metadata, which is parsed on first use; not thread-safe
+  rapidjson::Document &metadata();
+  const rapidjson::Document &metadata() const;
+
+  uint32_t version() const { return version_; }
+
+  /// number of entries in the binary index; 0 for version 0 files
+  size_t num_arrays() const { return num_arrays_; }
+
+  /// get an entry in the binary index without parsing the JSON
+  IndexEntry index_entry(size_t index) const;
+
+  /// find the index of an array by its name (see IndexEntry::name) without
+  /// parsing the JSON; none if it is not found, or for version 0 files
+  boost::optional<size_t> find(const std::string &name) const;
+
+  /// check the checksum of one array in the index, either by index or from
+  /// its JSON metadata; always true for version 0 files, which have no
+  /// checksums
+  bool verify(size_t index) const;
+  bool verify(const rapidjson::Value &v) const;
+
+  /// check the checksums of all arrays in the index
+  bool verify_all() const;
+
+  /// unpack an array; half precision ("f2") arrays and scaled integer arrays
+  /// (with a "scale" key) are converted to float on load
   std::shared_ptr<NDArray> unpack(const rapidjson::Value &v) const;
 
   template <typename T>
@@ -96,10 +196,26 @@ class TensorFile {
     return std::dynamic_pointer_cast<NDArrayT<T>>(unpack(v));
   }
 
+  static constexpr size_t index_entry_size = 32;
+
  private:
   std::shared_ptr<MMap> mmap;
+  uint32_t version_;
+  size_t metadata_offset;
+  size_t metadata_len;
+  size_t entries_offset;
+  size_t num_arrays_;
+  size_t names_offset;
+  size_t names_len;
+
+  /// get the name of an index entry, pointing into the name table
+  std::pair<const char *, size_t> entry_name(const unsigned char *entry) const;
+
+  mutable std::unique_ptr<rapidjson::Document> metadata_;
 };
 
-TensorFile read(const std::string &path);
+/// open a tensorfile; this checks the header and maps the file, but the JSON
+/// metadata is not parsed and checksums are not checked until they are needed
+TensorFile read(const std::string &path, const ReadOptions &options = {});
 
 }  // namespace tensorfile
@@ -1,54 +1,160 @@
 #include "top.hpp"
 
+#include <cmath>
 #include <iostream>
 #include <libvisr/signal_flow_context.hpp>
+#include <string>
+#include <utility>
+
+#include "brir_view_cache.hpp"
+#include "memory_report.hpp"
+#include "panner_cache.hpp"
 
 namespace bear {
 
-Top::Top(const SignalFlowContext &ctx, const char *name, CompositeComponent *parent, const ConfigImpl &config)
+namespace {
+  std::shared_ptr<Panner> make_panner(const ConfigImpl &config)
+  {
+    if (config.panner_cache) return config.panner_cache->get(config);
+    return std::make_shared<Panner>(
+        config.data_path, data_file_read_options(config), config.data_file_prefault);
+  }
+
+  /// connect the inputs of parent to the audio inputs of dsp
+  void connect_inputs(CompositeComponent &parent, AudioInput &in, DSP &dsp, const ConfigImpl &config)
+  {
+    ChannelRange objects_range(0, config.num_objects_channels);
+    parent.audioConnection(in, objects_range, dsp.audioPort("objects_in"), objects_range);
+
+    ChannelRange direct_speakers_range(objects_range.end(),
+                                       objects_range.end() + config.num_direct_speakers_channels);
+    ChannelRange just_direct_speakers_range(0, config.num_direct_speakers_channels);
+    parent.audioConnection(
+        in, direct_speakers_range, dsp.audioPort("direct_speakers_in"), just_direct_speakers_range);
+
+    ChannelRange hoa_range(direct_speakers_range.end(),
+                           direct_speakers_range.end() + config.num_hoa_channels);
+    ChannelRange just_hoa_range(0, config.num_hoa_channels);
+    parent.audioConnection(in, hoa_range, dsp.audioPort("hoa_in"), just_hoa_range);
+  }
+
+  /// connect the parameter outputs of control to the inputs of dsp
+  void connect_control(CompositeComponent &parent, Control &control, DSP &dsp, const ConfigImpl &config)
+  {
+    const std::pair<const char *, const char *> connections[] = {
+        {"direct_gains_out", "direct_gains_in"},
+        {"diffuse_gains_out", "diffuse_gains_in"},
+        {"direct_delays_out", "direct_delays_in"},
+        {"static_delays_out", "static_delays_in"},
+        {"brir_index_out", "brir_index_in"},
+        {"hoa_gains_out", "hoa_gains_in"},
+        {"direct_speakers_gains_out", "direct_speakers_gains_in"},
+        {"direct_speakers_delays_out", "direct_speakers_delays_in"},
+    };
+    for (auto &connection : connections)
+      parent.parameterConnection(control.parameterPort(connection.first),
+                                 dsp.parameterPort(connection.second));
+
+    if (use_object_clustering(config))
+      parent.parameterConnection(control.parameterPort("cluster_gains_out"),
+                                 dsp.parameterPort("cluster_gains_in"));
+  }
+
+  /// the longest path through the renderer is a decorrelator, a delay (plus
+  /// the interpolation filter) and a BRIR
+  size_t get_preroll_samples(const SignalFlowContext &ctx, const ConfigImpl &config, const Panner &panner)
+  {
+    double max_delay = panner.max_delay() + panner.decorrelation_delay();
+    return brir_render_length(config, panner.brir_length()) + panner.decorrelator_length() +
+           static_cast<size_t>(std::ceil(max_delay * ctx.samplingFrequency())) + 3;
+  }
+}  // namespace
+
+Top::Top(const SignalFlowContext &ctx,
+         const char *name,
+         CompositeComponent *parent,
+         const ConfigImpl &config)
     : CompositeComponent(ctx, name, parent),
-      panner(std::make_shared<Panner>(config.data_path)),
-      dsp(ctx, "dsp", this, config, panner),
-      control(ctx, "control", this, config, panner),
-      in("in", *this, num_input_channels(config)),
+      panner(make_panner(config)),
+      config_(fit_memory_budget(config, *panner)),
+      dsp(ctx, "dsp", this, config_, panner),
+      control(ctx, "control", this, config_, panner),
+      in("in", *this, num_input_channels(config_)),
       out("out", *this, 2),
       objects_metadata_in("objects_metadata_in", *this, pml::EmptyParameterConfig()),
       direct_speakers_metadata_in("direct_speakers_metadata_in", *this, pml::EmptyParameterConfig()),
       hoa_metadata_in("hoa_metadata_in", *this, pml::EmptyParameterConfig()),
       listener_in("listener_in", *this, pml::EmptyParameterConfig())
 {
-  ChannelRange objects_range(0, config.num_objects_channels);
-  audioConnection(in, objects_range, dsp.audioPort("objects_in"), objects_range);
+  connect_inputs(*this, in, dsp, config_);
+  audioConnection(dsp.audioPort("out"), out);
 
-  ChannelRange direct_speakers_range(objects_range.end(),
-                                     objects_range.end() + config.num_direct_speakers_channels);
-  ChannelRange just_direct_speakers_range(0, config.num_direct_speakers_channels);
-  audioConnection(in, direct_speakers_range, dsp.audioPort("direct_speakers_in"), just_direct_speakers_range);
+  connect_control(*this, control, dsp, config_);
 
-  ChannelRange hoa_range(direct_speakers_range.end(), direct_speakers_range.end() + config.num_hoa_channels);
-  ChannelRange just_hoa_range(0, config.num_hoa_channels);
-  audioConnection(in, hoa_range, dsp.audioPort("hoa_in"), just_hoa_range);
+  parameterConnection(objects_metadata_in, control.parameterPort("metadata_in"));
+  parameterConnection(direct_speakers_metadata_in, control.parameterPort("direct_speakers_metadata_in"));
+  parameterConnection(hoa_metadata_in, control.parameterPort("hoa_metadata_in"));
+  parameterConnection(listener_in, control.parameterPort("listener_in"));
 
-  audioConnection(dsp.audioPort("out"), out);
+  preroll_samples_ = get_preroll_samples(ctx, config_, *panner);
+}
 
-  parameterConnection(control.parameterPort("direct_gains_out"), dsp.parameterPort("direct_gains_in"));
-  parameterConnection(control.parameterPort("diffuse_gains_out"), dsp.parameterPort("diffuse_gains_in"));
-  parameterConnection(control.parameterPort("direct_delays_out"), dsp.parameterPort("direct_delays_in"));
-  parameterConnection(control.parameterPort("static_delays_out"), dsp.parameterPort("static_delays_in"));
-  parameterConnection(control.parameterPort("brir_index_out"), dsp.parameterPort("brir_index_in"));
-  parameterConnection(control.parameterPort("hoa_gains_out"), dsp.parameterPort("hoa_gains_in"));
+MemoryReport Top::memory_report() const { return get_memory_report(config_, *panner); }
 
-  parameterConnection(objects_metadata_in, control.parameterPort("metadata_in"));
+MultiListenerTop::MultiListenerTop(const SignalFlowContext &ctx,
+                                   const char *name,
+                                   CompositeComponent *parent,
+                                   const ConfigImpl &config,
+                                   size_t num_listeners)
+    : CompositeComponent(ctx, name, parent),
+      panner(make_panner(config)),
+      config_(fit_memory_budget(config, *panner, num_listeners)),
+      gain_calc(ctx, "gain_calc", this, config_, panner, num_listeners),
+      in("in", *this, num_input_channels(config_)),
+      out("out", *this, 2 * num_listeners),
+      objects_metadata_in("objects_metadata_in", *this, pml::EmptyParameterConfig())
+{
+  parameterConnection(objects_metadata_in, gain_calc.parameterPort("metadata_in"));
 
-  parameterConnection(direct_speakers_metadata_in, control.parameterPort("direct_speakers_metadata_in"));
-  parameterConnection(control.parameterPort("direct_speakers_gains_out"),
-                      dsp.parameterPort("direct_speakers_gains_in"));
-  parameterConnection(control.parameterPort("direct_speakers_delays_out"),
-                      dsp.parameterPort("direct_speakers_delays_in"));
+  for (size_t i = 0; i < num_listeners; i++) {
+    std::string suffix = "_" + std::to_string(i);
 
-  parameterConnection(hoa_metadata_in, control.parameterPort("hoa_metadata_in"));
+    dsps.push_back(std::make_unique<DSP>(ctx, ("dsp" + suffix).c_str(), this, config_, panner));
+    controls.push_back(
+        std::make_unique<Control>(ctx, ("control" + suffix).c_str(), this, config_, panner, true));
+    DSP &dsp = *dsps.back();
+    Control &control = *controls.back();
 
-  parameterConnection(listener_in, control.parameterPort("listener_in"));
+    connect_inputs(*this, in, dsp, config_);
+    audioConnection(dsp.audioPort("out"), ChannelRange(0, 2), out, ChannelRange(2 * i, 2 * i + 2));
+
+    connect_control(*this, control, dsp, config_);
+
+    parameterConnection(gain_calc.parameterPort(("gains_out" + suffix).c_str()),
+                        control.parameterPort("objects_gains_in"));
+    parameterConnection(control.parameterPort("listener_out"),
+                        gain_calc.parameterPort(("listener_in" + suffix).c_str()));
+
+    direct_speakers_metadata_in.push_back(std::make_unique<MetadataInput<DirectSpeakersInput>>(
+        ("direct_speakers_metadata_in" + suffix).c_str(), *this, pml::EmptyParameterConfig()));
+    parameterConnection(*direct_speakers_metadata_in.back(),
+                        control.parameterPort("direct_speakers_metadata_in"));
+
+    hoa_metadata_in.push_back(std::make_unique<MetadataInput<HOAInput>>(
+        ("hoa_metadata_in" + suffix).c_str(), *this, pml::EmptyParameterConfig()));
+    parameterConnection(*hoa_metadata_in.back(), control.parameterPort("hoa_metadata_in"));
+
+    listener_in.push_back(std::make_unique<ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter>>(
+        ("listener_in" + suffix).c_str(), *this, pml::EmptyParameterConfig()));
+    parameterConnection(*listener_in.back(), control.parameterPort("listener_in"));
+  }
+
+  preroll_samples_ = get_preroll_samples(ctx, config_, *panner);
+}
+
+MemoryReport MultiListenerTop::memory_report() const
+{
+  return get_memory_report(config_, *panner, dsps.size());
 }
 
 }  // namespace bear
@@ -3,10 +3,13 @@
 #include <libvisr/audio_output.hpp>
 #include <libvisr/composite_component.hpp>
 #include <memory>
+#include <vector>
 
 #include "bear/api.hpp"
+#include "config_impl.hpp"
 #include "control.hpp"
 #include "dsp.hpp"
+#include "gain_calc_objects.hpp"
 #include "panner.hpp"
 #include "utils.hpp"
 
@@ -21,8 +24,15 @@ class Top : public CompositeComponent {
                CompositeComponent *parent,
                const ConfigImpl &config);
 
+  /// number of samples of input which can affect each output sample
+  size_t preroll_samples() const { return preroll_samples_; }
+
+  MemoryReport memory_report() const;
+
  private:
   std::shared_ptr<Panner> panner;
+  /// the configuration after fit_memory_budget
+  ConfigImpl config_;
   DSP dsp;
   Control control;
 
@@ -32,5 +42,52 @@ class Top : public CompositeComponent {
   ParameterInput<pml::MessageQueueProtocol, ADMParameter<DirectSpeakersInput>> direct_speakers_metadata_in;
   ParameterInput<pml::MessageQueueProtocol, ADMParameter<HOAInput>> hoa_metadata_in;
   ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter> listener_in;
+
+  size_t preroll_samples_;
+};
+
+/// Like Top, but rendering the same inputs for num_listeners listeners.
+///
+/// There is one Control and DSP per listener, sharing a single Panner.
+/// Objects metadata is parsed once on objects_metadata_in, and a single
+/// GainCalcObjects calculates the objects gains for all listeners, so
+/// listeners in the same position share this work. The rest of Control
+/// depends on the BRIR selected for each listener, so is per-listener. Each
+/// listener has its own direct speakers, HOA and listener inputs
+/// (direct_speakers_metadata_in_0 etc.), and its output is channels
+/// 2 * listener and 2 * listener + 1 of out.
+class MultiListenerTop : public CompositeComponent {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  explicit MultiListenerTop(const SignalFlowContext &ctx,
+                            const char *name,
+                            CompositeComponent *parent,
+                            const ConfigImpl &config,
+                            size_t num_listeners);
+
+  /// number of samples of input which can affect each output sample
+  size_t preroll_samples() const { return preroll_samples_; }
+
+  MemoryReport memory_report() const;
+
+ private:
+  template <typename T>
+  using MetadataInput = ParameterInput<pml::MessageQueueProtocol, ADMParameter<T>>;
+
+  std::shared_ptr<Panner> panner;
+  /// the configuration after fit_memory_budget
+  ConfigImpl config_;
+  GainCalcObjects gain_calc;
+  std::vector<std::unique_ptr<DSP>> dsps;
+  std::vector<std::unique_ptr<Control>> controls;
+
+  AudioInput in;
+  AudioOutput out;
+  MetadataInput<ObjectsInput> objects_metadata_in;
+  std::vector<std::unique_ptr<MetadataInput<DirectSpeakersInput>>> direct_speakers_metadata_in;
+  std::vector<std::unique_ptr<MetadataInput<HOAInput>>> hoa_metadata_in;
+  std::vector<std::unique_ptr<ParameterInput<pml::DoubleBufferingProtocol, ListenerParameter>>> listener_in;
+
+  size_t preroll_samples_;
 };
 }  // namespace bear
@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
 #include <cstddef>
 #include <stdexcept>
 
@@ -11,6 +14,60 @@ inline size_t num_input_channels(const ConfigImpl &config)
   return config.num_objects_channels + config.num_direct_speakers_channels + config.num_hoa_channels;
 }
 
+/// are Objects channels grouped into clusters, see ObjectClustering
+inline bool use_object_clustering(const ConfigImpl &config)
+{
+  return config.max_object_clusters > 0 && config.max_object_clusters < config.num_objects_channels;
+}
+
+/// number of Objects signals with their own delays and gains in the DSP:
+/// the number of clusters if clustering is used, otherwise the number of
+/// channels
+inline size_t num_object_paths(const ConfigImpl &config)
+{
+  return use_object_clustering(config) ? config.max_object_clusters : config.num_objects_channels;
+}
+
+/// HOA order to render, given the order of the decoder in the data file
+inline size_t hoa_render_order(const ConfigImpl &config, size_t decoder_order)
+{
+  if (config.max_hoa_order >= 0 && static_cast<size_t>(config.max_hoa_order) < decoder_order)
+    return config.max_hoa_order;
+  else
+    return decoder_order;
+}
+
+/// number of HOA channels to render, given the order of the decoder in the
+/// data file
+inline size_t hoa_render_channels(const ConfigImpl &config, size_t decoder_order)
+{
+  size_t order = hoa_render_order(config, decoder_order);
+  return (order + 1) * (order + 1);
+}
+
+/// length of the BRIRs in the convolver, given their length in the data
+/// file; they may be truncated by max_brir_length
+inline size_t brir_render_length(const ConfigImpl &config, size_t brir_length)
+{
+  if (config.max_brir_length == 0) return brir_length;
+  return std::min(config.max_brir_length, brir_length);
+}
+
+/// copy the first length samples of a BRIR which has full_length samples to
+/// out; if this truncates it, the end is faded out with half of a Hann window
+/// so that the response does not stop abruptly
+inline void truncate_brir(const float *brir, size_t full_length, size_t length, float *out)
+{
+  std::copy(brir, brir + length, out);
+  if (length >= full_length) return;
+
+  size_t fade_length = std::min(length / 4, size_t{256});
+  for (size_t i = 0; i < fade_length; i++) {
+    double phase = boost::math::constants::pi<double>() * (i + 1) / fade_length;
+    out[length - fade_length + i] *= static_cast<float>(0.5 * (1.0 + std::cos(phase)));
+  }
+}
+
 /// helper to convert between N-dimensional indices and a 1-dimensional
 /// flattened representation
 template <int N>
@@ -94,9 +94,10 @@ struct BenchmarkConfig {
   size_t hoa_channels_per_block;
 };
 
-std::vector<double> run_benchmark(const BenchmarkConfig &c)
+std::vector<double> run_benchmark(const BenchmarkConfig &c, ConstructionStats &construction_stats)
 {
   Renderer renderer(c.config);
+  construction_stats = renderer.get_construction_stats();
 
   // make I/O buffers
 
@@ -202,7 +203,8 @@ std::vector<double> run_benchmark(const BenchmarkConfig &c)
 
 void run_benchmark_print(const BenchmarkConfig &c, size_t run)
 {
-  std::vector<double> times = run_benchmark(c);
+  ConstructionStats construction_stats;
+  std::vector<double> times = run_benchmark(c, construction_stats);
 
   rapidjson::Document d(rapidjson::kObjectType);
 
@@ -223,6 +225,7 @@ void run_benchmark_print(const BenchmarkConfig &c, size_t run)
   config_json.AddMember(
       "num_direct_speakers_channels", c.config.get_num_direct_speakers_channels(), d.GetAllocator());
   config_json.AddMember("num_hoa_channels", c.config.get_num_hoa_channels(), d.GetAllocator());
+  config_json.AddMember("binaural_convolver", c.config.get_binaural_convolver(), d.GetAllocator());
 
   d.AddMember("config", std::move(config_json), d.GetAllocator());
 
@@ -233,6 +236,11 @@ void run_benchmark_print(const BenchmarkConfig &c, size_t run)
 
   d.AddMember("times", std::move(times_json), d.GetAllocator());
 
+  d.AddMember(
+      "minor_page_faults", static_cast<int64_t>(construction_stats.minor_page_faults), d.GetAllocator());
+  d.AddMember(
+      "major_page_faults", static_cast<int64_t>(construction_stats.major_page_faults), d.GetAllocator());
+
   rapidjson::OStreamWrapper osw(std::cout);
   rapidjson::Writer<rapidjson::OStreamWrapper> writer(osw);
   d.Accept(writer);
@@ -248,7 +256,8 @@ int main(int, char **)
                            size_t num_hoa_channels,
                            bool update_every_time = false,
                            bool extent = false,
-                           const std::string &fft_implementation = "ffts") {
+                           const std::string &fft_implementation = "ffts",
+                           bool binaural_convolver = false) {
         BenchmarkConfig c;
         c.config.set_num_objects_channels(num_objects_channels);
         c.config.set_num_direct_speakers_channels(num_direct_speakers_channels);
@@ -256,6 +265,7 @@ int main(int, char **)
         c.config.set_period_size(period);
         c.config.set_data_path(DEFAULT_TENSORFILE_NAME);
         c.config.set_fft_implementation(fft_implementation);
+        c.config.set_binaural_convolver(binaural_convolver);
 
         c.n_blocks = 15;
         c.update_every_time = update_every_time;
@@ -271,6 +281,10 @@ int main(int, char **)
         for (int num_objects_p = -1; num_objects_p <= 6; num_objects_p++)
           run_bench(num_objects_p >= 0 ? 1 << num_objects_p : 0, 0, 0, false, false, fft_implementation);
 
+      // dedicated BRIR convolver
+      for (int num_objects_p = -1; num_objects_p <= 6; num_objects_p++)
+        run_bench(num_objects_p >= 0 ? 1 << num_objects_p : 0, 0, 0, false, false, "ffts", true);
+
       for (bool update_every_time : {false, true})
         for (bool extent : {false, true})
           for (int num_objects_p = -1; num_objects_p <= 6; num_objects_p++)
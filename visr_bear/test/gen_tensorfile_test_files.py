@@ -1,3 +1,4 @@
+import bear.metadata_file
 import bear.tensorfile
 import numpy as np
 
@@ -32,3 +33,80 @@ if __name__ == "__main__":
                     byte_order=dict(le="<", be=">")[byte_order],
                     alignment=alignment,
                 )
+
+    # version 1, with aligned arrays and a binary index
+    for byte_order in "le", "be":
+        fname = f"test/files/tensorfile_v1_{byte_order}.tenf"
+        with open(fname, "wb") as f:
+            bear.tensorfile.write(
+                f,
+                data,
+                byte_order=dict(le="<", be=">")[byte_order],
+                version=1,
+            )
+
+    # reduced precision types, which the C++ reader converts to float
+    reduced_data = dict(
+        multi_dim=dict(
+            float16=multi_dim.astype(np.float16),
+            scaled_int16=bear.tensorfile.ScaledArray(multi_dim.astype(np.int16), 0.5),
+        ),
+    )
+
+    for byte_order in "le", "be":
+        fname = f"test/files/tensorfile_reduced_{byte_order}.tenf"
+        with open(fname, "wb") as f:
+            bear.tensorfile.write(
+                f,
+                reduced_data,
+                byte_order=dict(le="<", be=">")[byte_order],
+            )
+
+    # binary metadata file; this must match test_stream_json in
+    # test_offline_render.cpp
+    metadata_stream = dict(
+        version=0,
+        objects=[
+            dict(
+                track=1,
+                blocks=[
+                    dict(
+                        rtime=[0, 1],
+                        duration=[1, 2],
+                        position=dict(azimuth=30.0, elevation=10.0, distance=1.0),
+                        width=20.0,
+                        interpolationLength=[0, 1],
+                        absoluteDistance=2.0,
+                    ),
+                    dict(
+                        rtime=[1, 2],
+                        duration=[1, 2],
+                        position=dict(azimuth=-30.0, elevation=0.0),
+                    ),
+                ],
+            ),
+            dict(track=None, blocks=[]),
+        ],
+        direct_speakers=[
+            dict(
+                track=0,
+                blocks=[
+                    dict(
+                        position=dict(azimuth=110.0, elevation=0.0, distance=1.0),
+                        speakerLabels=["M+110"],
+                        audioPackFormatID="AP_00010003",
+                    )
+                ],
+            )
+        ],
+        hoa=[
+            dict(
+                tracks=[2, 3],
+                blocks=[dict(orders=[0, 1], degrees=[0, -1], normalization="SN3D")],
+            ),
+            dict(tracks=[4], blocks=[dict(orders=[0], degrees=[0])]),
+        ],
+    )
+
+    with open("test/files/metadata_file.tenf", "wb") as f:
+        bear.metadata_file.write(f, metadata_stream)
@@ -0,0 +1,85 @@
+#include <cmath>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "delay_line.hpp"
+
+using namespace bear;
+
+namespace {
+double signal(double t) { return std::sin(0.05 * t) + 0.3 * std::cos(0.31 * t); }
+
+std::vector<float> make_signal(size_t n)
+{
+  std::vector<float> x(n);
+  for (size_t i = 0; i < n; i++) x[i] = static_cast<float>(signal(i));
+  return x;
+}
+}  // namespace
+
+TEST_CASE("integer delay")
+{
+  size_t block_size = 64;
+  std::vector<float> x = make_signal(block_size * 20), y(x.size());
+
+  DelayLine delay(block_size, 100.0, block_size, 5.0);
+  for (size_t b = 0; b < 20; b++) delay.process(&x[b * block_size], &y[b * block_size], block_size);
+
+  // includes the method delay of 1 sample
+  for (size_t i = 6; i < x.size(); i++) REQUIRE(y[i] == x[i - 6]);
+}
+
+TEST_CASE("fractional delay")
+{
+  size_t block_size = 64;
+  std::vector<float> x = make_signal(block_size * 20), y(x.size());
+
+  DelayLine delay(block_size, 100.0, block_size, 0.0);
+  for (size_t b = 0; b < 20; b++) {
+    // ramps in block 3, then fixed
+    if (b == 3) delay.set_delay(37.5);
+    delay.process(&x[b * block_size], &y[b * block_size], block_size);
+  }
+
+  for (size_t i = 4 * block_size; i < x.size(); i++) REQUIRE(y[i] == Approx(signal(i - 38.5)).margin(1e-4));
+}
+
+TEST_CASE("skip")
+{
+  size_t block_size = 64;
+  std::vector<float> x = make_signal(block_size), zeros(block_size, 0.0f), y(block_size);
+
+  DelayLine delay(block_size, 100.0, block_size, 10.0);
+  delay.process(x.data(), y.data(), block_size);
+  for (size_t i = 0; i < delay.flush_samples(); i += block_size)
+    delay.process(zeros.data(), y.data(), block_size);
+
+  for (size_t b = 0; b < 10; b++) delay.skip(block_size);
+
+  delay.process(x.data(), y.data(), block_size);
+  for (size_t i = 11; i < block_size; i++) REQUIRE(y[i] == x[i - 11]);
+  for (size_t i = 0; i < 11; i++) REQUIRE(y[i] == 0.0f);
+}
+
+TEST_CASE("add_integer_delayed")
+{
+  size_t block_size = 64;
+  std::vector<float> x = make_signal(block_size * 4), y(x.size(), 0.0f);
+
+  // the set delay is ignored, and the method delay is included
+  DelayLine delay(block_size, 100.0, block_size, 37.5);
+  for (size_t b = 0; b < 4; b++) {
+    delay.write_only(&x[b * block_size], block_size);
+    if (b < 3)
+      delay.add_integer_delayed(5, 0.5f, 0.5f, &y[b * block_size], block_size);
+    else
+      delay.add_integer_delayed(5, 0.5f, 1.0f, &y[b * block_size], block_size);
+  }
+
+  for (size_t i = 6; i < 3 * block_size; i++) REQUIRE(y[i] == 0.5f * x[i - 6]);
+  for (size_t i = 0; i < block_size; i++) {
+    float gain = 0.5f + 0.5f * (i + 1) / block_size;
+    size_t t = 3 * block_size + i;
+    REQUIRE(y[t] == Approx(gain * x[t - 6]));
+  }
+}
@@ -0,0 +1,107 @@
+import visr_bear
+import numpy as np
+import numpy.testing as npt
+import visr
+import rrl
+
+period = 512
+sample_rate = 48000
+num_inputs = 2
+num_outputs = 3
+
+
+def make_flow(Component):
+    ctxt = visr.SignalFlowContext(period=period, samplingFrequency=sample_rate)
+    component = Component(
+        ctxt, Component.__name__, None, num_inputs, num_outputs, 0.01, 0.0
+    )
+    return rrl.AudioSignalFlow(component)
+
+
+def set_parameters(flow, gains, delays):
+    gains_in = flow.parameterReceivePort("gains_in")
+    np.array(gains_in.data(), copy=False)[:] = gains
+
+    delays_in = flow.parameterReceivePort("delays_in")
+    np.array(delays_in.data(), copy=False)[:] = delays
+    delays_in.swapBuffers()
+
+
+def seconds(delays):
+    return np.array(delays) / sample_rate
+
+
+def run(changes, num_blocks):
+    """Process random input through DirectSpeakersPath and PerEarDelay.
+
+    changes maps block numbers to gains (rows are virtual loudspeakers,
+    columns are channels) and delays (index channel * 2 + ear, in seconds) for
+    each component, which are applied before that block. Yields the output of
+    both components for each block.
+    """
+    flows = [make_flow(visr_bear.DirectSpeakersPath), make_flow(visr_bear.PerEarDelay)]
+
+    rng = np.random.default_rng(0)
+    for block in range(num_blocks):
+        if block in changes:
+            for flow, (gains, delays) in zip(flows, changes[block]):
+                set_parameters(flow, gains, delays)
+
+        samples = rng.normal(size=(num_inputs, period)).astype(np.float32)
+        yield block, [flow.process(samples) for flow in flows]
+
+
+def test_matches_per_ear_delay():
+    """DirectSpeakersPath should give the same output as PerEarDelay (a delay
+    per channel and ear followed by a dense gain matrix per ear) for the same
+    gains and delays, including while they change, as long as the delays of
+    channels routed to one virtual loudspeaker are integers"""
+    # channel 0 is one-hot, then mixed into two virtual loudspeakers, with a
+    # fractional delay change; channel 1 is one-hot with a gain change, then
+    # turned off
+    silent = np.zeros((num_outputs, num_inputs))
+    one_hot = np.array([[1.0, 0.0], [0.0, 0.0], [0.0, 1.0]])
+    sparse = np.array([[0.5, 0.0], [0.7, 0.0], [0.0, 1.0]])
+    quieter = np.array([[0.5, 0.0], [0.7, 0.0], [0.0, 0.5]])
+    one_off = np.array([[0.5, 0.0], [0.7, 0.0], [0.0, 0.0]])
+    delays = seconds([48, 96, 0, 24])
+    changed_delays = seconds([72, 48.5, 0, 24])
+    changes = {
+        # the delays settle while the gains are zero
+        0: (silent, delays),
+        1: (one_hot, delays),
+        4: (sparse, delays),
+        8: (quieter, changed_delays),
+        12: (one_off, changed_delays),
+    }
+    changes = {block: [change, change] for block, change in changes.items()}
+
+    max_output = 0.0
+    for block, (path_out, per_ear_out) in run(changes, 16):
+        # delays are not exactly integers once converted to seconds and back
+        npt.assert_allclose(path_out, per_ear_out, atol=1e-4)
+        max_output = max(max_output, np.max(np.abs(path_out)))
+
+    assert max_output > 0.1
+
+
+def test_routed_delays_rounded():
+    """channels routed to one virtual loudspeaker should use their delays
+    rounded to an integer number of samples, and a change in delay should take
+    one period, as in PerEarDelay"""
+    gains = np.array([[1.0, 0.0], [0.0, 0.0], [0.0, 0.7]])
+    delays = [10.4, 20.6, 0.2, 30.3]
+    changed_delays = [40.3, 15.7, 5.6, 30.3]
+    changes = {
+        0: [(gains, seconds(delays)), (gains, seconds(np.round(delays)))],
+        4: [
+            (gains, seconds(changed_delays)),
+            (gains, seconds(np.round(changed_delays))),
+        ],
+    }
+
+    for block, (path_out, per_ear_out) in run(changes, 8):
+        # block 0 ramps from the initial delay, and block 4 crossfades between
+        # delays rather than ramping
+        if block not in (0, 4):
+            npt.assert_allclose(path_out, per_ear_out, atol=1e-4)
@@ -1,9 +1,12 @@
 #include <chrono>
+#include <vector>
 
 #include "catch2/catch.hpp"
 #include "constructor_thread.hpp"
 #include "dynamic_renderer.hpp"
+#include "load_governor.hpp"
 #include "test_config.h"
+#include "utils.hpp"
 
 using namespace bear;
 using namespace std::chrono_literals;
@@ -54,6 +57,30 @@ TEST_CASE("test_ConstructorThread_swap")
   }
 }
 
+TEST_CASE("test_ConstructorThread_preroll")
+{
+  ConstructorThread t;
+
+  Config config;
+  config.set_num_direct_speakers_channels(1);
+  config.set_period_size(512);
+  config.set_data_path(DEFAULT_TENSORFILE_NAME);
+
+  boost::optional<Renderer> renderer;
+
+  for (bool preroll : {true, false}) {
+    while (!t.start(config, preroll)) std::this_thread::sleep_for(10ms);
+
+    bool prerolled = !preroll;
+    while (!t.try_swap_result(renderer, &prerolled)) std::this_thread::sleep_for(10ms);
+    REQUIRE(prerolled == preroll);
+
+    // prerolling advances the renderer time by whole periods
+    size_t preroll_samples = preroll ? (renderer->get_preroll_samples() + 511) / 512 * 512 : 0;
+    REQUIRE(renderer->get_block_start_time() == Time{preroll_samples, 48000});
+  }
+}
+
 TEST_CASE("test_DynamicRenderer_basic")
 {
   // the real tests for this are in test_dynamic_renderer.py; this is just here
@@ -116,3 +143,125 @@ TEST_CASE("test_DynamicRenderer_error")
   }
   REQUIRE(found_error);
 }
+
+TEST_CASE("test_LoadGovernor")
+{
+  GovernorOptions options;
+  options.enabled = true;
+  options.time_constant = 0.1;
+  options.overload_time = 1.0;
+  options.recovery_time = 2.0;
+
+  const double period = 0.01;
+  LoadGovernor governor(options, period);
+  REQUIRE(governor.level() == 0);
+
+  SECTION("overload")
+  {
+    // the level goes up after the smoothed load has been high for
+    // overload_time, then again after another overload_time
+    size_t first_change = 0;
+    for (size_t i = 1; i <= 300 && governor.level() < 2; i++)
+      if (governor.update(0.9 * period) && governor.level() == 1) first_change = i;
+
+    REQUIRE(governor.level() == 2);
+    REQUIRE(first_change > 100);
+    REQUIRE(first_change < 130);
+  }
+
+  SECTION("limited")
+  {
+    for (size_t i = 0; i < 1000; i++) governor.update(2.0 * period);
+    REQUIRE(governor.level() == GovernorOptions::max_level);
+  }
+
+  SECTION("recovery")
+  {
+    while (governor.level() < 2) governor.update(0.9 * period);
+
+    // load between the thresholds does not change the level
+    for (size_t i = 0; i < 1000; i++) REQUIRE(!governor.update(0.6 * period));
+
+    size_t updates = 0;
+    while (governor.level() > 1) {
+      governor.update(0.1 * period);
+      updates++;
+    }
+    // the smoothed load takes a few periods to drop below low_load
+    REQUIRE(updates >= 200);
+    REQUIRE(updates < 230);
+  }
+
+  SECTION("reset")
+  {
+    for (size_t i = 0; i < 10; i++) {
+      for (size_t j = 0; j < 50; j++) governor.update(0.9 * period);
+      governor.reset();
+    }
+    REQUIRE(governor.level() == 0);
+  }
+}
+
+TEST_CASE("test_LoadGovernor_options")
+{
+  GovernorOptions options;
+  options.low_load = 0.9;
+  REQUIRE_THROWS_AS(LoadGovernor(options, 0.01), std::invalid_argument);
+}
+
+TEST_CASE("test_apply_quality_level")
+{
+  GovernorOptions options;
+  ConfigImpl base;
+  base.max_brir_length = 512;
+
+  ConfigImpl config = base;
+  apply_quality_level(config, options, 0);
+  REQUIRE(config.max_brir_length == 512);
+  REQUIRE(config.enable_gain_norm);
+
+  // a shorter user length is kept
+  apply_quality_level(config, options, 1);
+  REQUIRE(config.max_brir_length == 512);
+  REQUIRE(config.enable_gain_norm);
+
+  config = base;
+  config.max_brir_length = 0;
+  apply_quality_level(config, options, 3);
+  REQUIRE(config.max_brir_length == options.truncated_brir_length);
+  REQUIRE(!config.enable_gain_norm);
+  REQUIRE(config.max_hoa_order == options.reduced_hoa_order);
+  REQUIRE(config.listener_update_rate == 0.0);
+  REQUIRE(config.enable_extent);
+
+  config = base;
+  apply_quality_level(config, options, GovernorOptions::max_level);
+  REQUIRE(config.listener_update_rate == options.reduced_listener_update_rate);
+  REQUIRE(!config.enable_extent);
+}
+
+TEST_CASE("test_truncate_brir")
+{
+  std::vector<float> brir(2048, 1.0f);
+
+  ConfigImpl config;
+  REQUIRE(brir_render_length(config, brir.size()) == 2048);
+  config.max_brir_length = 1024;
+  REQUIRE(brir_render_length(config, brir.size()) == 1024);
+
+  // not truncated: copied unchanged
+  std::vector<float> out(2048);
+  truncate_brir(brir.data(), brir.size(), out.size(), out.data());
+  REQUIRE(out == brir);
+
+  // truncated: the start is unchanged, and the end fades smoothly to zero
+  out.resize(1024);
+  truncate_brir(brir.data(), brir.size(), out.size(), out.data());
+  REQUIRE(out[0] == 1.0f);
+  REQUIRE(out[1024 - 257] == 1.0f);
+  REQUIRE(out[1023] == Approx(0.0f).margin(1e-6));
+  for (size_t i = 1; i < out.size(); i++) {
+    REQUIRE(out[i] <= out[i - 1]);
+    REQUIRE(out[i - 1] - out[i] < 0.01f);
+  }
+}
@@ -1,4 +1,4 @@
-from visr_bear import DynamicRenderer
+from visr_bear import DynamicRenderer, ReconfigureMode
 import visr_bear.api
 from visr_bear.api import Config, Renderer, Listener
 from test_changes import do_render, RendererInput
@@ -131,11 +131,12 @@ def expand_hoa_config(config: Config):
 
 
 @pytest.mark.parametrize(
-    "period,set_config_blocking,renderer_input,setup_config_base,expand_config",
+    "period,set_config_blocking,crossfade,renderer_input,setup_config_base,expand_config",
     [
         (
             512,
             False,
+            False,
             get_objects_input_dynamic(),
             setup_objects_config,
             expand_objects_config,
@@ -143,6 +144,7 @@ def expand_hoa_config(config: Config):
         (
             512,
             False,
+            False,
             get_objects_input_static(),
             setup_objects_config,
             expand_objects_config,
@@ -150,6 +152,7 @@ def expand_hoa_config(config: Config):
         (
             512,
             False,
+            False,
             get_direct_speakers_input_dynamic(),
             setup_direct_speakers_config,
             expand_direct_speakers_config,
@@ -157,20 +160,31 @@ def expand_hoa_config(config: Config):
         (
             512,
             False,
+            False,
             get_direct_speakers_input_static(),
             setup_direct_speakers_config,
             expand_direct_speakers_config,
         ),
-        (512, False, get_hoa_input(), setup_hoa_config, expand_hoa_config),
+        (512, False, False, get_hoa_input(), setup_hoa_config, expand_hoa_config),
         (
             64,
             False,
+            False,
+            get_objects_input_dynamic(),
+            setup_objects_config,
+            expand_objects_config,
+        ),
+        (
+            512,
+            True,
+            False,
             get_objects_input_dynamic(),
             setup_objects_config,
             expand_objects_config,
         ),
         (
             512,
+            False,
             True,
             get_objects_input_dynamic(),
             setup_objects_config,
@@ -185,14 +199,22 @@ def expand_hoa_config(config: Config):
         "hoa",
         "objects_dynamic_64",
         "objects_dynamic_blocking",
+        "objects_dynamic_crossfade",
     ],
 )
 def test_dynamic_renderer(
-    period, set_config_blocking, renderer_input, setup_config_base, expand_config
+    period,
+    set_config_blocking,
+    crossfade,
+    renderer_input,
+    setup_config_base,
+    expand_config,
 ):
     """test that the dynamic renderer matches the static renderer, except for
     some fading up/down when it's configuring"""
     r = DynamicRenderer(period, 100)
+    if crossfade:
+        r.set_reconfigure_mode(ReconfigureMode.CROSSFADE)
 
     def base_config():
         c = Config()
@@ -239,6 +261,7 @@ def test_dynamic_renderer(
     )
 
     assert r.is_running()
+    crossfade_stats = r.get_crossfade_stats()
 
     c = base_config()
     r = Renderer(c)
@@ -285,6 +308,10 @@ def test_dynamic_renderer(
             assert block_is_fade_up or block_is_silence
             if block_is_fade_up:
                 faded_down = False
+        elif crossfade:
+            # the expanded config renders the same, so crossfading to it
+            # should not be visible
+            assert block_is_passthrough
         else:
             assert block_is_fade_down or block_is_passthrough
             if block_is_fade_down:
@@ -305,6 +332,17 @@ def test_dynamic_renderer(
             "switching, or renderer construction being too slow"
         )
 
+    if crossfade:
+        if crossfade_stats.num_crossfades == 1:
+            # preroll plus one period for the crossfade
+            assert crossfade_stats.num_overlap_periods > 1
+            assert crossfade_stats.overlap_time > 0.0
+        else:
+            warnings.warn(
+                "no crossfade; this is caused by a logic error, or renderer "
+                "construction being too slow"
+            )
+
 
 def test_dynamic_renderer_construct():
     r = DynamicRenderer(512, 100)
@@ -179,3 +179,46 @@ def test_timing(flow):
     flow.process()
     gains = np.array(gains_out.data())
     npt.assert_allclose(gains[:4, 1:], np.zeros((4, 4)))
+
+
+@pytest.mark.parametrize("max_order", [0, 1, 2])
+def test_max_order(basic_config, max_order):
+    """check that orders above max_hoa_order are discarded"""
+    acn = np.arange(16)
+    orders, degrees = hoa.from_acn(acn)
+
+    config = visr_bear.api.Config(basic_config)
+    config.num_hoa_channels = len(acn)
+    config.max_hoa_order = max_order
+    flow = make_flow(config, visr_bear.GainCalcHOA)
+
+    metadata_in = flow.parameterReceivePort("metadata_in")
+    listener_in = flow.parameterReceivePort("listener_in")
+    gains_out = flow.parameterSendPort("gains_out")
+
+    metadata = visr_bear.api.HOAInput()
+    metadata.channels = acn
+    metadata.type_metadata.orders = orders
+    metadata.type_metadata.degrees = degrees
+    metadata.type_metadata.normalization = "SN3D"
+    metadata_in.enqueue(visr_bear.ADMParameterHOA(0, metadata))
+
+    n_render = (max_order + 1) ** 2
+    flow.process()
+    gains = np.array(gains_out.data())
+    npt.assert_allclose(gains, np.eye(n_render, len(acn)))
+
+    # rotation only mixes channels within each order, so should still work
+    q = quaternion.from_rotation_vector(np.array([0.3, 0.2, 1.0]))
+    listener_in.data().orientation = q.components
+    listener_in.swapBuffers()
+
+    flow.process()
+    gains = np.array(gains_out.data())
+    assert gains.shape == (n_render, len(acn))
+    npt.assert_allclose(gains[:, n_render:], 0)
+    if max_order > 0:
+        encoded, encoded_rot = get_encoded_rot(order=max_order, q=q)
+        npt.assert_allclose(
+            np.dot(gains[:, :n_render], encoded), encoded_rot, atol=1e-4
+        )
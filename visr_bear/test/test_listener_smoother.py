@@ -0,0 +1,120 @@
+import visr_bear
+import pytest
+import numpy as np
+import numpy.testing as npt
+import visr
+import rrl
+import warnings
+
+with warnings.catch_warnings():
+    warnings.simplefilter("ignore")
+    import quaternion
+
+
+def make_config(**kwargs):
+    config = visr_bear.api.Config()
+    config.num_objects_channels = 1
+    config.period_size = 512
+    for name, value in kwargs.items():
+        setattr(config, name, value)
+    return config
+
+
+class Smoother:
+    def __init__(self, config):
+        ctxt = visr.SignalFlowContext(
+            period=config.period_size, samplingFrequency=config.sample_rate
+        )
+        component = visr_bear.ListenerSmoother(ctxt, "ListenerSmoother", None, config)
+        self.flow = rrl.AudioSignalFlow(component)
+        self.listener_in = self.flow.parameterReceivePort("listener_in")
+        self.listener_out = self.flow.parameterSendPort("listener_out")
+
+    def set(self, q, position=(0.0, 0.0, 0.0), interpolation_time=0.0):
+        self.listener_in.data().orientation = q.components
+        self.listener_in.data().position = np.array(position)
+        self.listener_in.data().interpolation_time = interpolation_time
+        self.listener_in.swapBuffers()
+
+    def process(self):
+        """process one period, returning the output orientation if it changed"""
+        self.flow.process()
+        if self.listener_out.changed():
+            self.listener_out.resetChanged()
+            return quaternion.quaternion(*self.listener_out.data().orientation)
+
+
+def yaw(degrees):
+    return quaternion.from_rotation_vector(np.array([0, 0, 1]) * np.radians(degrees))
+
+
+def test_immediate():
+    smoother = Smoother(make_config())
+
+    # no change is passed on until the listener moves
+    assert smoother.process() is None
+
+    smoother.set(yaw(10))
+    npt.assert_allclose(smoother.process(), yaw(10), atol=1e-9)
+    assert smoother.process() is None
+
+    # setting the same listener again is not a change
+    smoother.set(yaw(10))
+    assert smoother.process() is None
+
+
+def test_interpolation():
+    config = make_config()
+    smoother = Smoother(config)
+
+    # interpolate over 4 periods
+    interpolation_time = 4 * config.period_size / config.sample_rate
+    smoother.set(yaw(40), interpolation_time=interpolation_time)
+
+    for i in range(1, 5):
+        npt.assert_allclose(smoother.process(), yaw(10 * i), atol=1e-9)
+    assert smoother.process() is None
+
+
+def test_update_rate():
+    config = make_config()
+    # update every 4 periods
+    config.listener_update_rate = config.sample_rate / (4 * config.period_size)
+    smoother = Smoother(config)
+
+    outputs = []
+    for i in range(16):
+        smoother.set(yaw(i))
+        outputs.append(smoother.process())
+
+    changed = [i for i, output in enumerate(outputs) if output is not None]
+    assert changed == [3, 7, 11, 15]
+    for i in changed:
+        npt.assert_allclose(outputs[i], yaw(i), atol=1e-9)
+
+
+@pytest.mark.parametrize("hysteresis_deg", [1.0, 5.0])
+def test_orientation_hysteresis(hysteresis_deg):
+    smoother = Smoother(
+        make_config(listener_orientation_hysteresis=np.radians(hysteresis_deg))
+    )
+
+    # jitter within the hysteresis does not cause updates
+    for angle in [0.5, -0.5, 0.9, -0.9] * 3:
+        smoother.set(yaw(angle * hysteresis_deg))
+        assert smoother.process() is None
+
+    smoother.set(yaw(2 * hysteresis_deg))
+    npt.assert_allclose(smoother.process(), yaw(2 * hysteresis_deg), atol=1e-9)
+
+
+def test_position_hysteresis():
+    smoother = Smoother(make_config(listener_position_hysteresis=0.01))
+    q = yaw(0)
+
+    smoother.set(q, position=(0.005, 0.0, 0.0))
+    assert smoother.process() is None
+
+    smoother.set(q, position=(0.02, 0.0, 0.0))
+    smoother.process()
+    assert smoother.listener_out.data().position[0] == pytest.approx(0.02)
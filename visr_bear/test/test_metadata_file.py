@@ -0,0 +1,234 @@
+import bear.metadata_file
+import numpy as np
+import visr_bear
+from bear.extract_metadata import rendering_items_to_stream
+from bear.render_cli import convert_direct_speakers, convert_hoa, convert_objects
+from ear.core.geom import PolarPosition
+from ear.core.metadata_input import (
+    DirectSpeakersRenderingItem,
+    DirectSpeakersTypeMetadata,
+    DirectTrackSpec,
+    HOARenderingItem,
+    HOATypeMetadata,
+    MetadataSourceIter,
+    ObjectRenderingItem,
+    ObjectTypeMetadata,
+)
+from ear.fileio.adm.elements import (
+    AudioBlockFormatDirectSpeakers,
+    AudioBlockFormatObjects,
+    BoundCoordinate,
+    DirectSpeakerPolarPosition,
+    JumpPosition,
+)
+from fractions import Fraction
+from utils import data_path
+
+
+def test_metadata_file(tmp_path):
+    stream = dict(
+        version=0,
+        objects=[
+            dict(
+                track=0,
+                blocks=[
+                    dict(
+                        rtime=[0, 1],
+                        duration=[1, 2],
+                        position=dict(azimuth=30.0, elevation=0.0),
+                        gain=0.5,
+                    ),
+                    dict(
+                        rtime=[1, 2],
+                        duration=[1, 2],
+                        position=dict(azimuth=-30.0, elevation=10.0, distance=0.5),
+                        absoluteDistance=2.0,
+                    ),
+                ],
+            )
+        ],
+        hoa=[
+            dict(
+                tracks=[1, None],
+                blocks=[dict(orders=[0, 1], degrees=[0, 0], normalization="N3D")],
+            )
+        ],
+    )
+
+    path = tmp_path / "metadata.tenf"
+    with open(path, "wb") as f:
+        bear.metadata_file.write(f, stream)
+
+    mf = visr_bear.MetadataFile(str(path))
+    assert mf.num_objects_channels == 1
+    assert mf.num_direct_speakers_channels == 0
+    assert mf.num_hoa_streams == 1
+    assert mf.num_hoa_channels == 2
+
+    assert mf.objects_track(0) == 0
+    assert mf.num_objects_blocks(0) == 2
+
+    block = mf.objects_block(0, 0)
+    assert block.rtime.numerator == 0
+    assert block.duration.denominator == 2
+    assert block.interpolationLength is None
+    assert block.type_metadata.gain == 0.5
+    assert block.type_metadata.position.distance == 1.0
+    assert block.audioPackFormat_data.absoluteDistance is None
+
+    block = mf.objects_block(0, 1)
+    assert block.type_metadata.position.azimuth == -30.0
+    assert block.type_metadata.position.distance == 0.5
+    assert block.audioPackFormat_data.absoluteDistance == 2.0
+
+    assert mf.hoa_tracks(0) == [1, None]
+    block = mf.hoa_block(0, 0)
+    assert block.type_metadata.orders == [0, 1]
+    assert block.type_metadata.normalization == "N3D"
+    assert block.channels == [0, 1]
+
+    # play the blocks into a renderer
+    config = visr_bear.api.Config()
+    config.num_objects_channels = 1
+    config.num_hoa_channels = 2
+    config.period_size = 512
+    config.data_path = data_path
+    renderer = visr_bear.api.Renderer(config)
+
+    def make_buffer(nch):
+        return np.zeros((nch, config.period_size), dtype=np.float32)
+
+    # blocks are only accepted shortly before they start, so this has to
+    # process past the start of the last block
+    player = visr_bear.MetadataFilePlayer(mf)
+    assert not player.done()
+    for _ in range(60):
+        player.push(renderer)
+        renderer.process(make_buffer(1), make_buffer(0), make_buffer(2), make_buffer(2))
+    assert player.done()
+
+
+def make_rendering_items():
+    objects_blocks = [
+        ObjectTypeMetadata(
+            block_format=AudioBlockFormatObjects(
+                rtime=Fraction(0),
+                duration=Fraction(1, 2),
+                position=PolarPosition(30.0, 0.0, 1.0),
+                gain=0.5,
+                width=10.0,
+                diffuse=0.25,
+            )
+        ),
+        ObjectTypeMetadata(
+            block_format=AudioBlockFormatObjects(
+                rtime=Fraction(1, 2),
+                duration=Fraction(1, 3),
+                position=PolarPosition(-30.0, 10.0, 0.5),
+                jumpPosition=JumpPosition(
+                    flag=True, interpolationLength=Fraction(1, 10)
+                ),
+            )
+        ),
+    ]
+    direct_speakers_blocks = [
+        DirectSpeakersTypeMetadata(
+            block_format=AudioBlockFormatDirectSpeakers(
+                position=DirectSpeakerPolarPosition(
+                    bounded_azimuth=BoundCoordinate(110.0),
+                    bounded_elevation=BoundCoordinate(0.0),
+                ),
+                speakerLabel=["M+110"],
+            )
+        )
+    ]
+    hoa_blocks = [
+        HOATypeMetadata(orders=[0, 1, 1, 1], degrees=[0, -1, 0, 1], normalization="N3D")
+    ]
+
+    return [
+        ObjectRenderingItem(
+            track_spec=DirectTrackSpec(2),
+            metadata_source=MetadataSourceIter(objects_blocks),
+        ),
+        DirectSpeakersRenderingItem(
+            track_spec=DirectTrackSpec(0),
+            metadata_source=MetadataSourceIter(direct_speakers_blocks),
+        ),
+        HOARenderingItem(
+            track_specs=[DirectTrackSpec(i) for i in range(3, 7)],
+            metadata_source=MetadataSourceIter(hoa_blocks),
+        ),
+    ]
+
+
+def blocks_of(item):
+    return list(iter(item.metadata_source.get_next_block, None))
+
+
+def assert_time_equal(a, b):
+    if b is None:
+        assert a is None
+    else:
+        assert Fraction(a.numerator, a.denominator) == Fraction(
+            b.numerator, b.denominator
+        )
+
+
+def test_extract_metadata_round_trip(tmp_path):
+    """metadata extracted by bear-extract-metadata and read by MetadataFile
+    should match the metadata which bear-render would pass to the renderer"""
+    path = tmp_path / "metadata.tenf"
+    with open(path, "wb") as f:
+        bear.metadata_file.write(f, rendering_items_to_stream(make_rendering_items()))
+    mf = visr_bear.MetadataFile(str(path))
+
+    objects_item, direct_speakers_item, hoa_item = make_rendering_items()
+
+    assert mf.num_objects_channels == 1
+    assert mf.objects_track(0) == 2
+    expected_blocks = [convert_objects(b, 0) for b in blocks_of(objects_item)]
+    assert mf.num_objects_blocks(0) == len(expected_blocks)
+    for i, expected in enumerate(expected_blocks):
+        block = mf.objects_block(0, i)
+        assert_time_equal(block.rtime, expected.rtime)
+        assert_time_equal(block.duration, expected.duration)
+        assert_time_equal(block.interpolationLength, expected.interpolationLength)
+        tm, expected_tm = block.type_metadata, expected.type_metadata
+        assert tm.position.azimuth == expected_tm.position.azimuth
+        assert tm.position.elevation == expected_tm.position.elevation
+        assert tm.position.distance == expected_tm.position.distance
+        assert tm.gain == expected_tm.gain
+        assert tm.width == expected_tm.width
+        assert tm.height == expected_tm.height
+        assert tm.depth == expected_tm.depth
+        assert tm.diffuse == expected_tm.diffuse
+
+    assert mf.num_direct_speakers_channels == 1
+    assert mf.direct_speakers_track(0) == 0
+    expected_blocks = [
+        convert_direct_speakers(b, 0) for b in blocks_of(direct_speakers_item)
+    ]
+    assert mf.num_direct_speakers_blocks(0) == len(expected_blocks)
+    for i, expected in enumerate(expected_blocks):
+        block = mf.direct_speakers_block(0, i)
+        assert_time_equal(block.rtime, expected.rtime)
+        assert_time_equal(block.duration, expected.duration)
+        tm, expected_tm = block.type_metadata, expected.type_metadata
+        assert tm.position.azimuth == expected_tm.position.azimuth
+        assert tm.position.elevation == expected_tm.position.elevation
+        assert tm.position.distance == expected_tm.position.distance
+        assert tm.speakerLabels == expected_tm.speakerLabels
+
+    assert mf.num_hoa_streams == 1
+    assert mf.num_hoa_channels == 4
+    assert mf.hoa_tracks(0) == [3, 4, 5, 6]
+    expected_blocks = [convert_hoa(b, 0) for b in blocks_of(hoa_item)]
+    assert mf.num_hoa_blocks(0) == len(expected_blocks)
+    for i, expected in enumerate(expected_blocks):
+        block = mf.hoa_block(0, i)
+        assert block.channels == expected.channels
+        tm, expected_tm = block.type_metadata, expected.type_metadata
+        assert tm.orders == expected_tm.orders
+        assert tm.degrees == expected_tm.degrees
+        assert tm.normalization == expected_tm.normalization
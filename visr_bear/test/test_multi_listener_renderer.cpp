@@ -0,0 +1,86 @@
+#include <cmath>
+#include <vector>
+
+#include "bear/api.hpp"
+#include "bear/multi_listener_renderer.hpp"
+#include "catch2/catch.hpp"
+#include "test_config.h"
+
+using namespace bear;
+
+TEST_CASE("matches_renderers")
+{
+  // a MultiListenerRenderer should give the same output as one Renderer per
+  // listener; listeners 0 and 2 are the same, so share their objects gains
+  const size_t period = 512;
+  const std::vector<double> yaws = {0.0, 0.7, 0.0, 2.0};
+
+  Config config;
+  config.set_num_objects_channels(1);
+  config.set_num_hoa_channels(1);
+  config.set_period_size(period);
+  config.set_data_path(DEFAULT_TENSORFILE_NAME);
+
+  bear::ObjectsInput oi;
+  oi.type_metadata.position = ear::PolarPosition{30.0, 0.0, 1.0};
+  oi.type_metadata.diffuse = 0.5;
+
+  bear::HOAInput hi;
+  hi.type_metadata.orders = {0};
+  hi.type_metadata.degrees = {0};
+  hi.type_metadata.normalization = "SN3D";
+  hi.channels = {0};
+
+  MultiListenerRenderer multi(config, yaws.size());
+  REQUIRE(multi.get_num_listeners() == yaws.size());
+  REQUIRE(multi.add_objects_block(0, oi));
+  REQUIRE(multi.add_hoa_block(0, hi));
+
+  std::vector<Renderer> renderers;
+  for (size_t i = 0; i < yaws.size(); i++) {
+    renderers.emplace_back(config);
+    renderers.back().add_objects_block(0, oi);
+    renderers.back().add_hoa_block(0, hi);
+  }
+
+  REQUIRE(multi.get_preroll_samples() == renderers[0].get_preroll_samples());
+
+  for (size_t i = 0; i < yaws.size(); i++) {
+    Listener listener;
+    listener.set_orientation_quaternion({std::cos(yaws[i] / 2), 0.0, 0.0, std::sin(yaws[i] / 2)});
+    multi.set_listener(i, listener);
+    renderers[i].set_listener(listener);
+  }
+
+  std::vector<float> objects_input(period), hoa_input(period);
+  const float *objects_input_p[1] = {objects_input.data()};
+  const float *hoa_input_p[1] = {hoa_input.data()};
+
+  std::vector<float> multi_out(2 * yaws.size() * period), single_out(2 * period);
+  std::vector<float *> multi_out_p;
+  for (size_t ch = 0; ch < 2 * yaws.size(); ch++) multi_out_p.push_back(multi_out.data() + ch * period);
+  float *single_out_p[2] = {single_out.data(), single_out.data() + period};
+
+  for (size_t block = 0; block < 20; block++) {
+    for (size_t s = 0; s < period; s++) {
+      objects_input[s] = std::sin(0.01 * (block * period + s));
+      hoa_input[s] = std::cos(0.02 * (block * period + s));
+    }
+
+    multi.process(objects_input_p, nullptr, hoa_input_p, multi_out_p.data());
+
+    for (size_t i = 0; i < yaws.size(); i++) {
+      renderers[i].process(objects_input_p, nullptr, hoa_input_p, single_out_p);
+      for (size_t s = 0; s < 2 * period; s++)
+        REQUIRE(multi_out[2 * i * period + s] == Approx(single_out[s]).margin(1e-6));
+    }
+  }
+
+  REQUIRE(multi.get_block_start_time() == renderers[0].get_block_start_time());
+  REQUIRE_THROWS_AS(multi.set_listener(yaws.size(), Listener()), std::invalid_argument);
+  REQUIRE_THROWS_AS(multi.add_objects_block(1, oi), std::invalid_argument);
+
+  bear::HOAInput bad_hi = hi;
+  bad_hi.channels = {1};
+  REQUIRE_THROWS_AS(multi.add_hoa_block(0, bad_hi), std::invalid_argument);
+}
@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <boost/optional/optional_io.hpp>
+#include <cmath>
+#include <random>
+
+#include "bw64.hpp"
+#include "catch2/catch.hpp"
+#include "metadata_file.hpp"
+#include "metadata_stream.hpp"
+#include "offline_render.hpp"
+#include "test_config.h"
+
+using namespace bear;
+
+namespace {
+  std::vector<std::vector<float>> make_noise(size_t num_channels, size_t num_frames)
+  {
+    std::mt19937 gen{};
+    std::uniform_real_distribution<float> d{-0.5f, 0.5f};
+
+    std::vector<std::vector<float>> samples(num_channels, std::vector<float>(num_frames));
+    for (auto &channel : samples)
+      for (float &sample : channel) sample = d(gen);
+    return samples;
+  }
+
+  std::vector<float *> make_ptrs(std::vector<std::vector<float>> &buffers)
+  {
+    std::vector<float *> ptrs;
+    for (auto &buffer : buffers) ptrs.push_back(buffer.data());
+    return ptrs;
+  }
+
+  void write_file(const std::string &path,
+                  SampleFormat sample_format,
+                  std::vector<std::vector<float>> &samples)
+  {
+    Bw64Format format;
+    format.num_channels = samples.size();
+    format.sample_rate = 48000;
+    format.sample_format = sample_format;
+
+    Bw64Writer writer(path, format);
+    auto ptrs = make_ptrs(samples);
+    writer.write(ptrs.data(), samples[0].size());
+    writer.close();
+  }
+
+  // files/metadata_file.tenf contains the same metadata; see
+  // gen_tensorfile_test_files.py
+  const char *test_stream_json = R"({
+    "version": 0,
+    "objects": [
+      {"track": 1, "blocks": [
+        {"rtime": [0, 1], "duration": [1, 2],
+         "position": {"azimuth": 30.0, "elevation": 10.0, "distance": 1.0},
+         "width": 20.0, "interpolationLength": [0, 1], "absoluteDistance": 2.0},
+        {"rtime": [1, 2], "duration": [1, 2],
+         "position": {"azimuth": -30.0, "elevation": 0.0}}
+      ]},
+      {"track": null, "blocks": []}
+    ],
+    "direct_speakers": [
+      {"track": 0, "blocks": [
+        {"position": {"azimuth": 110.0, "elevation": 0.0, "distance": 1.0},
+         "speakerLabels": ["M+110"], "audioPackFormatID": "AP_00010003"}
+      ]}
+    ],
+    "hoa": [
+      {"tracks": [2, 3], "blocks": [{"orders": [0, 1], "degrees": [0, -1], "normalization": "SN3D"}]},
+      {"tracks": [4], "blocks": [{"orders": [0], "degrees": [0]}]}
+    ]
+  })";
+
+  void check_common(const MetadataInput &a, const MetadataInput &b)
+  {
+    REQUIRE(a.rtime == b.rtime);
+    REQUIRE(a.duration == b.duration);
+    REQUIRE(a.audioPackFormat_data.absoluteDistance == b.audioPackFormat_data.absoluteDistance);
+  }
+}  // namespace
+
+TEST_CASE("bw64_round_trip")
+{
+  const size_t num_frames = 1001;
+  auto samples = make_noise(3, num_frames);
+  // out of range samples are clipped in integer formats
+  samples[0][10] = 2.0f;
+
+  for (auto sample_format :
+       {SampleFormat::PCM16, SampleFormat::PCM24, SampleFormat::PCM32, SampleFormat::FLOAT32}) {
+    write_file("test_bw64_round_trip.wav", sample_format, samples);
+
+    Bw64Reader reader("test_bw64_round_trip.wav");
+    REQUIRE(reader.format().num_channels == 3);
+    REQUIRE(reader.format().sample_rate == 48000);
+    REQUIRE(reader.format().sample_format == sample_format);
+    REQUIRE(reader.num_frames() == num_frames);
+
+    // read a subset of channels in a different order, past the end
+    std::vector<std::vector<float>> read_samples(2, std::vector<float>(num_frames + 10, 1.0f));
+    auto read_ptrs = make_ptrs(read_samples);
+    reader.read(0, num_frames + 10, {2, 0}, read_ptrs.data());
+
+    float tol = sample_format == SampleFormat::PCM16 ? 1e-4f : 1e-6f;
+    for (size_t i = 0; i < num_frames; i++) {
+      REQUIRE(read_samples[0][i] == Approx(samples[2][i]).margin(tol));
+      if (i != 10) REQUIRE(read_samples[1][i] == Approx(samples[0][i]).margin(tol));
+    }
+    REQUIRE(read_samples[1][10] == Approx(sample_format == SampleFormat::FLOAT32 ? 2.0f : 1.0f).margin(tol));
+
+    for (size_t i = num_frames; i < num_frames + 10; i++) {
+      REQUIRE(read_samples[0][i] == 0.0f);
+      REQUIRE(read_samples[1][i] == 0.0f);
+    }
+
+    // reading entirely past the end gives silence
+    for (size_t start : {num_frames, num_frames + 100}) {
+      for (auto &channel : read_samples) std::fill(channel.begin(), channel.end(), 1.0f);
+      reader.read(start, 10, {2, 0}, read_ptrs.data());
+      for (size_t i = 0; i < 10; i++) {
+        REQUIRE(read_samples[0][i] == 0.0f);
+        REQUIRE(read_samples[1][i] == 0.0f);
+      }
+    }
+  }
+}
+
+TEST_CASE("metadata_stream_json")
+{
+  MetadataStream stream = parse_metadata_stream_json(test_stream_json);
+
+  REQUIRE(stream.objects.size() == 2);
+  REQUIRE(stream.objects[0].track == size_t{1});
+  REQUIRE(stream.objects[1].track == boost::none);
+  REQUIRE(stream.objects[0].blocks.size() == 2);
+
+  const ObjectsInput &oi = stream.objects[0].blocks[0];
+  REQUIRE(oi.rtime == Time{0});
+  REQUIRE(oi.duration == Time{1, 2});
+  REQUIRE(oi.interpolationLength == Time{0});
+  REQUIRE(oi.audioPackFormat_data.absoluteDistance == 2.0);
+  REQUIRE(boost::get<ear::PolarPosition>(oi.type_metadata.position).azimuth == 30.0);
+  REQUIRE(oi.type_metadata.width == 20.0);
+  REQUIRE(oi.type_metadata.gain == 1.0);
+  REQUIRE(stream.objects[0].blocks[1].interpolationLength == boost::none);
+
+  REQUIRE(stream.direct_speakers.size() == 1);
+  const DirectSpeakersInput &dsi = stream.direct_speakers[0].blocks[0];
+  REQUIRE(dsi.rtime == boost::none);
+  REQUIRE(dsi.type_metadata.speakerLabels == std::vector<std::string>{"M+110"});
+  REQUIRE(dsi.type_metadata.audioPackFormatID == std::string("AP_00010003"));
+
+  REQUIRE(stream.num_hoa_channels() == 3);
+  REQUIRE(stream.hoa[0].blocks[0].channels == std::vector<size_t>{0, 1});
+  REQUIRE(stream.hoa[1].blocks[0].channels == std::vector<size_t>{2});
+  REQUIRE(stream.hoa[1].blocks[0].type_metadata.normalization == "SN3D");
+
+  REQUIRE_THROWS_AS(parse_metadata_stream_json(R"({"version": 1})"), std::runtime_error);
+  REQUIRE_THROWS_AS(parse_metadata_stream_json(R"({"version": 0, "objects": [{"blocks": []}]})"),
+                    std::runtime_error);
+}
+
+TEST_CASE("metadata_file")
+{
+  MetadataStream stream = parse_metadata_stream_json(test_stream_json);
+  MetadataFile file(std::string(BUNDLED_TEST_FILES) + "metadata_file.tenf");
+
+  REQUIRE(file.num_objects_channels() == 2);
+  for (size_t i = 0; i < 2; i++) {
+    REQUIRE(file.objects_track(i) == stream.objects_track(i));
+    REQUIRE(file.num_objects_blocks(i) == stream.num_objects_blocks(i));
+    for (size_t j = 0; j < file.num_objects_blocks(i); j++) {
+      ObjectsInput a = file.objects_block(i, j);
+      const ObjectsInput &b = stream.objects_block(i, j);
+      check_common(a, b);
+      REQUIRE(a.interpolationLength == b.interpolationLength);
+
+      auto &pos_a = boost::get<ear::PolarPosition>(a.type_metadata.position);
+      auto &pos_b = boost::get<ear::PolarPosition>(b.type_metadata.position);
+      REQUIRE(pos_a.azimuth == pos_b.azimuth);
+      REQUIRE(pos_a.elevation == pos_b.elevation);
+      REQUIRE(pos_a.distance == pos_b.distance);
+      REQUIRE(a.type_metadata.gain == b.type_metadata.gain);
+      REQUIRE(a.type_metadata.width == b.type_metadata.width);
+      REQUIRE(a.type_metadata.height == b.type_metadata.height);
+      REQUIRE(a.type_metadata.depth == b.type_metadata.depth);
+      REQUIRE(a.type_metadata.diffuse == b.type_metadata.diffuse);
+    }
+  }
+  REQUIRE_THROWS_AS(file.objects_block(1, 0), std::out_of_range);
+  REQUIRE_THROWS_AS(file.objects_track(2), std::out_of_range);
+  REQUIRE_THROWS_AS(file.num_objects_blocks(2), std::out_of_range);
+  REQUIRE_THROWS_AS(file.objects_block(2, 0), std::out_of_range);
+
+  REQUIRE(file.num_direct_speakers_channels() == 1);
+  REQUIRE(file.direct_speakers_track(0) == size_t{0});
+  REQUIRE(file.num_direct_speakers_blocks(0) == 1);
+  DirectSpeakersInput dsi = file.direct_speakers_block(0, 0);
+  check_common(dsi, stream.direct_speakers_block(0, 0));
+  REQUIRE(boost::get<ear::PolarSpeakerPosition>(dsi.type_metadata.position).azimuth == 110.0);
+  REQUIRE(dsi.type_metadata.speakerLabels == std::vector<std::string>{"M+110"});
+  REQUIRE(dsi.type_metadata.audioPackFormatID == std::string("AP_00010003"));
+  REQUIRE_THROWS_AS(file.direct_speakers_track(1), std::out_of_range);
+  REQUIRE_THROWS_AS(file.num_direct_speakers_blocks(1), std::out_of_range);
+  REQUIRE_THROWS_AS(file.direct_speakers_block(1, 0), std::out_of_range);
+  REQUIRE_THROWS_AS(file.direct_speakers_block(0, 1), std::out_of_range);
+
+  REQUIRE(file.num_hoa_streams() == 2);
+  REQUIRE(file.num_hoa_channels() == 3);
+  for (size_t i = 0; i < 2; i++) {
+    REQUIRE(file.hoa_tracks(i) == stream.hoa_tracks(i));
+    REQUIRE(file.num_hoa_blocks(i) == 1);
+    HOAInput a = file.hoa_block(i, 0);
+    const HOAInput &b = stream.hoa_block(i, 0);
+    check_common(a, b);
+    REQUIRE(a.type_metadata.orders == b.type_metadata.orders);
+    REQUIRE(a.type_metadata.degrees == b.type_metadata.degrees);
+    REQUIRE(a.type_metadata.normalization == b.type_metadata.normalization);
+    REQUIRE(a.channels == b.channels);
+  }
+  REQUIRE_THROWS_AS(file.hoa_tracks(2), std::out_of_range);
+  REQUIRE_THROWS_AS(file.num_hoa_blocks(2), std::out_of_range);
+  REQUIRE_THROWS_AS(file.hoa_block(2, 0), std::out_of_range);
+  REQUIRE_THROWS_AS(file.hoa_block(0, 1), std::out_of_range);
+
+  // rendering with the file and the stream gives the same result
+  const size_t num_frames = 3000;
+  auto samples = make_noise(5, num_frames);
+  write_file("test_metadata_file_in.wav", SampleFormat::FLOAT32, samples);
+  Bw64Reader in("test_metadata_file_in.wav");
+  Bw64Format out_format = in.format();
+  out_format.num_channels = 2;
+
+  OfflineRenderOptions options;
+  options.data_path = DEFAULT_TENSORFILE_NAME;
+  options.block_size = 1024;
+
+  {
+    Bw64Writer out("test_metadata_file_stream.wav", out_format);
+    render_offline(in, stream, out, options);
+    out.close();
+  }
+  {
+    Bw64Writer out("test_metadata_file_file.wav", out_format);
+    render_offline(in, file, out, options);
+    out.close();
+  }
+
+  std::vector<std::vector<float>> expected(2, std::vector<float>(num_frames));
+  std::vector<std::vector<float>> output(2, std::vector<float>(num_frames));
+  auto expected_ptrs = make_ptrs(expected);
+  auto output_ptrs = make_ptrs(output);
+  Bw64Reader("test_metadata_file_stream.wav").read(0, num_frames, {0, 1}, expected_ptrs.data());
+  Bw64Reader("test_metadata_file_file.wav").read(0, num_frames, {0, 1}, output_ptrs.data());
+  REQUIRE(output == expected);
+}
+
+TEST_CASE("render_offline")
+{
+  // a little over two blocks
+  const size_t num_frames = 2 * 4096 + 100;
+  auto samples = make_noise(2, num_frames);
+  write_file("test_render_offline_in.wav", SampleFormat::FLOAT32, samples);
+
+  // one object on the left on track 1, and one silent object
+  MetadataStream metadata = parse_metadata_stream_json(R"({
+    "version": 0,
+    "objects": [
+      {"track": 1, "blocks": [{"position": {"azimuth": 90.0, "elevation": 0.0}}]},
+      {"track": null, "blocks": [{"position": {"azimuth": -90.0, "elevation": 0.0}}]}
+    ]
+  })");
+
+  OfflineRenderOptions options;
+  options.data_path = DEFAULT_TENSORFILE_NAME;
+
+  Bw64Reader in("test_render_offline_in.wav");
+  Bw64Format out_format = in.format();
+  out_format.num_channels = 2;
+  {
+    Bw64Writer out("test_render_offline_out.wav", out_format);
+    OfflineRenderStats stats = render_offline(in, metadata, out, options);
+    out.close();
+    REQUIRE(stats.num_frames == num_frames);
+    REQUIRE(stats.peak > 0.0f);
+  }
+
+  Bw64Reader result("test_render_offline_out.wav");
+  REQUIRE(result.num_frames() == num_frames);
+
+  std::vector<std::vector<float>> output(2, std::vector<float>(num_frames));
+  auto output_ptrs = make_ptrs(output);
+  result.read(0, num_frames, {0, 1}, output_ptrs.data());
+
+  double energy[2] = {0.0, 0.0};
+  for (size_t ear = 0; ear < 2; ear++)
+    for (float sample : output[ear]) energy[ear] += sample * sample;
+  REQUIRE(energy[0] > 2.0 * energy[1]);
+}
+
+TEST_CASE("render_offline_parallel")
+{
+  const size_t num_frames = 48000 * 3 + 123;
+  auto samples = make_noise(2, num_frames);
+  write_file("test_render_offline_parallel_in.wav", SampleFormat::FLOAT32, samples);
+
+  // moving objects, with blocks which end within each chunk and its preroll
+  MetadataStream metadata = parse_metadata_stream_json(R"({
+    "version": 0,
+    "objects": [
+      {"track": 0, "blocks": [
+        {"rtime": [0, 1], "duration": [1, 4], "position": {"azimuth": 0.0, "elevation": 0.0}},
+        {"rtime": [1, 4], "duration": [1, 1], "position": {"azimuth": 90.0, "elevation": 0.0}},
+        {"rtime": [5, 4], "duration": [1, 100], "position": {"azimuth": -90.0, "elevation": 30.0}},
+        {"rtime": [126, 100], "duration": [2, 1], "position": {"azimuth": 180.0, "elevation": 0.0},
+         "diffuse": 0.5}
+      ]},
+      {"track": 1, "blocks": [{"position": {"azimuth": 30.0, "elevation": 0.0}}]}
+    ]
+  })");
+
+  Bw64Reader in("test_render_offline_parallel_in.wav");
+  Bw64Format out_format = in.format();
+  out_format.num_channels = 2;
+
+  auto render = [&](const std::string &path, size_t num_threads, size_t chunk_frames) {
+    OfflineRenderOptions options;
+    options.data_path = DEFAULT_TENSORFILE_NAME;
+    options.block_size = 1024;
+    options.num_threads = num_threads;
+    options.chunk_frames = chunk_frames;
+
+    Bw64Writer out(path, out_format);
+    OfflineRenderStats stats = render_offline(in, metadata, out, options);
+    out.close();
+    REQUIRE(stats.num_frames == num_frames);
+
+    Bw64Reader result(path);
+    REQUIRE(result.num_frames() == num_frames);
+    std::vector<std::vector<float>> output(2, std::vector<float>(num_frames));
+    auto output_ptrs = make_ptrs(output);
+    result.read(0, num_frames, {0, 1}, output_ptrs.data());
+    return output;
+  };
+
+  auto expected = render("test_render_offline_parallel_1.wav", 1, 0);
+
+  for (size_t num_threads : {2, 3}) {
+    // chunk boundaries are not aligned with the metadata blocks, and there
+    // are more chunks than threads
+    auto output = render("test_render_offline_parallel_n.wav", num_threads, 20000);
+
+    float max_error = 0.0f;
+    for (size_t ear = 0; ear < 2; ear++)
+      for (size_t i = 0; i < num_frames; i++)
+        max_error = std::max(max_error, std::abs(output[ear][i] - expected[ear][i]));
+    REQUIRE(max_error < 1e-6f);
+  }
+}
@@ -55,3 +55,22 @@ TEST_CASE("gain_norm")
     }
   }
 }
+
+TEST_CASE("hoa_symmetric")
+{
+  bear::Panner panner(DEFAULT_TENSORFILE_NAME);
+
+  REQUIRE(!bear::Panner::hoa_channel_antisymmetric(0));
+  REQUIRE(bear::Panner::hoa_channel_antisymmetric(1));   // n=1, m=-1 (y)
+  REQUIRE(!bear::Panner::hoa_channel_antisymmetric(2));  // n=1, m=0 (z)
+  REQUIRE(!bear::Panner::hoa_channel_antisymmetric(3));  // n=1, m=1 (x)
+
+  if (panner.hoa_decoder_symmetric()) {
+    for (size_t channel = 0; channel < panner.n_hoa_channels(); channel++) {
+      float sign = bear::Panner::hoa_channel_antisymmetric(channel) ? -1.0f : 1.0f;
+      const float *left = panner.get_hoa_ir(channel, 0);
+      const float *right = panner.get_hoa_ir(channel, 1);
+      for (size_t i = 0; i < panner.hoa_ir_length(); i++) REQUIRE(right[i] == sign * left[i]);
+    }
+  }
+}
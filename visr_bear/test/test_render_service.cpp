@@ -0,0 +1,217 @@
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "dynamic_renderer.hpp"
+#include "render_client.hpp"
+#include "render_service.hpp"
+#include "test_config.h"
+
+using namespace bear;
+using namespace std::chrono_literals;
+
+namespace {
+  struct UnityDistanceBehaviour : public DistanceBehaviour {
+    double get_gain(double, boost::optional<double>) override { return 1.0; }
+  };
+
+  std::string socket_path(const std::string &name)
+  {
+    return "/tmp/bear-test-" + name + "-" + std::to_string(getpid()) + ".sock";
+  }
+
+  Config make_config(size_t period)
+  {
+    Config config;
+    config.set_num_objects_channels(1);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    return config;
+  }
+
+  /// make the same calls on a RenderClient and a DynamicRenderer, and check
+  /// that the client output matches, delayed by latency periods
+  void check_matches_dynamic_renderer(RenderClient &client, size_t period, size_t latency)
+  {
+    Config config = make_config(period);
+    client.set_config_blocking(config);
+    REQUIRE(client.is_running());
+    DynamicRenderer renderer(period, 1);
+    renderer.set_config_blocking(config);
+
+    Listener listener;
+    listener.set_orientation_quaternion({std::cos(0.35), 0.0, 0.0, std::sin(0.35)});
+    client.set_listener(listener);
+    renderer.set_listener(listener);
+
+    // one block at the start, and one which is not accepted until later
+    ObjectsInput first;
+    first.rtime = Time{0};
+    first.duration = Time{1, 10};
+    first.type_metadata.position = ear::PolarPosition{30.0, 0.0, 1.0};
+
+    ObjectsInput second = first;
+    second.rtime = Time{1, 10};
+    second.type_metadata.position = ear::PolarPosition{-60.0, 10.0, 1.0};
+    second.type_metadata.width = 20.0;
+
+    REQUIRE(client.add_objects_block(0, first));
+    REQUIRE(renderer.add_objects_block(0, first));
+
+    std::vector<float> input(period);
+    const float *input_p[1] = {input.data()};
+
+    std::vector<float> client_out(2 * period), renderer_out(2 * period);
+    float *client_out_p[2] = {client_out.data(), client_out.data() + period};
+    float *renderer_out_p[2] = {renderer_out.data(), renderer_out.data() + period};
+
+    // renderer output for each period, to compare with the delayed client
+    // output
+    std::vector<std::vector<float>> expected;
+
+    bool second_added = false;
+    for (size_t block = 0; block < 20 + latency; block++) {
+      if (!second_added) {
+        bool client_added = client.add_objects_block(0, second);
+        REQUIRE(renderer.add_objects_block(0, second) == client_added);
+        second_added = client_added;
+      }
+
+      for (size_t s = 0; s < period; s++) input[s] = std::sin(0.01 * (block * period + s));
+
+      client.process(1, input_p, 0, nullptr, 0, nullptr, client_out_p);
+      renderer.process(1, input_p, 0, nullptr, 0, nullptr, renderer_out_p);
+      expected.push_back(renderer_out);
+
+      for (size_t s = 0; s < 2 * period; s++) {
+        float expected_sample = block >= latency ? expected[block - latency][s] : 0.0f;
+        REQUIRE(client_out[s] == Approx(expected_sample).margin(1e-6));
+      }
+    }
+
+    REQUIRE(second_added);
+    REQUIRE(client.is_running());
+    REQUIRE(client.get_block_start_time() == renderer.get_block_start_time());
+  }
+}  // namespace
+
+TEST_CASE("matches_dynamic_renderer")
+{
+  const size_t period = 512;
+  RenderServiceOptions options;
+  options.socket_path = socket_path("matches");
+  RenderService service(options);
+
+  SECTION("synchronous")
+  {
+    RenderClient client(options.socket_path, period);
+    check_matches_dynamic_renderer(client, period, 0);
+  }
+
+  SECTION("latency")
+  {
+    RenderClientOptions client_options;
+    client_options.latency_periods = 2;
+    RenderClient client(options.socket_path, period, client_options);
+    check_matches_dynamic_renderer(client, period, 2);
+  }
+}
+
+TEST_CASE("zero_copy")
+{
+  const size_t period = 512;
+  RenderServiceOptions options;
+  options.socket_path = socket_path("zero-copy");
+  RenderService service(options);
+
+  RenderClient a(options.socket_path, period), b(options.socket_path, period);
+  a.set_config_blocking(make_config(period));
+  b.set_config_blocking(make_config(period));
+
+  ObjectsInput block;
+  block.type_metadata.position = ear::PolarPosition{30.0, 0.0, 1.0};
+  REQUIRE(a.add_objects_block(0, block));
+  REQUIRE(b.add_objects_block(0, block));
+
+  std::vector<float> input(period), out(2 * period);
+  const float *input_p[1] = {input.data()};
+  float *out_p[2] = {out.data(), out.data() + period};
+
+  for (size_t i = 0; i < 10; i++) {
+    for (size_t s = 0; s < period; s++) input[s] = std::sin(0.01 * (i * period + s));
+
+    std::copy(input.begin(), input.end(), b.objects_input_buffer(0));
+    b.process_buffers(1, 0, 0);
+    a.process(1, input_p, 0, nullptr, 0, nullptr, out_p);
+
+    for (size_t ear = 0; ear < 2; ear++)
+      for (size_t s = 0; s < period; s++)
+        REQUIRE(b.output_buffer(ear)[s] == Approx(out[ear * period + s]).margin(1e-6));
+  }
+}
+
+TEST_CASE("sessions_share_panner")
+{
+  const size_t period = 512;
+  RenderServiceOptions options;
+  options.socket_path = socket_path("share");
+  RenderService service(options);
+
+  {
+    RenderClient a(options.socket_path, period), b(options.socket_path, period);
+    a.set_config_blocking(make_config(period));
+    b.set_config_blocking(make_config(period));
+
+    REQUIRE(service.get_num_sessions() == 2);
+    REQUIRE(service.get_num_panners() == 1);
+  }
+
+  // sessions are ended asynchronously when the clients disconnect
+  for (size_t i = 0; i < 100 && service.get_num_sessions() != 0; i++) std::this_thread::sleep_for(10ms);
+  REQUIRE(service.get_num_sessions() == 0);
+  REQUIRE(service.get_num_panners() == 0);
+}
+
+TEST_CASE("errors")
+{
+  const size_t period = 512;
+  RenderServiceOptions options;
+  options.socket_path = socket_path("errors");
+
+  // no service
+  REQUIRE_THROWS_AS(RenderClient(options.socket_path, period), std::runtime_error);
+
+  auto service = std::make_unique<RenderService>(options);
+  RenderClient client(options.socket_path, period);
+
+  Config bad_config = make_config(period);
+  bad_config.set_data_path("/does/not/exist.tf");
+  REQUIRE_THROWS_AS(client.set_config_blocking(bad_config), std::runtime_error);
+
+  // errors from set_config are reported through get_error, as with
+  // DynamicRenderer
+  client.set_config(bad_config);
+  std::vector<float> out(2 * period);
+  float *out_p[2] = {out.data(), out.data() + period};
+  std::exception_ptr error;
+  for (size_t i = 0; i < 1000 && !error; i++) {
+    client.process(0, nullptr, 0, nullptr, 0, nullptr, out_p);
+    error = client.get_error();
+    if (!error) std::this_thread::sleep_for(1ms);
+  }
+  REQUIRE(error);
+
+  client.set_config_blocking(make_config(period));
+  ObjectsInput block;
+  REQUIRE_THROWS_AS(client.add_objects_block(1, block), std::invalid_argument);
+  block.distance_behaviour = std::make_shared<UnityDistanceBehaviour>();
+  REQUIRE_THROWS_AS(client.add_objects_block(0, block), std::invalid_argument);
+
+  // the service going away
+  service.reset();
+  REQUIRE_THROWS_AS(client.process(0, nullptr, 0, nullptr, 0, nullptr, out_p), std::runtime_error);
+}
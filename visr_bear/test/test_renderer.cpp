@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
 #include "bear/api.hpp"
 #include "catch2/catch.hpp"
 #include "test_config.h"
@@ -92,3 +98,388 @@ TEST_CASE("fft_error")
   config.set_fft_implementation("unavailable_fft");
   REQUIRE_THROWS_WITH(Renderer(config), Contains("The specified FFT wrapper does not exist"));
 }
+
+TEST_CASE("fft_cache")
+{
+  Config config;
+  config.set_num_objects_channels(1);
+  config.set_period_size(512);
+  config.set_data_path(DEFAULT_TENSORFILE_NAME);
+  config.set_binaural_convolver(true);
+
+  FFTCache::clear();
+  { Renderer renderer(config); }
+  size_t num_idle = FFTCache::get_num_idle();
+  REQUIRE(num_idle > 0);
+
+  // a second renderer reuses all of the FFTs from the first
+  {
+    Renderer renderer(config);
+    REQUIRE(FFTCache::get_num_idle() == 0);
+  }
+  REQUIRE(FFTCache::get_num_idle() == num_idle);
+
+  FFTCache::clear();
+  REQUIRE(FFTCache::get_num_idle() == 0);
+}
+
+TEST_CASE("fft_auto")
+{
+  Config config;
+  config.set_num_objects_channels(1);
+  config.set_period_size(512);
+  config.set_data_path(DEFAULT_TENSORFILE_NAME);
+  config.set_fft_implementation("auto");
+  Renderer renderer(config);
+
+  std::string implementation = FFTCache::get_auto_implementation(512);
+  REQUIRE(implementation != "auto");
+  // selected once per process
+  REQUIRE(FFTCache::get_auto_implementation(512) == implementation);
+}
+
+TEST_CASE("brir_view_cache")
+{
+  // render an object while the listener turns, with and without the view
+  // cache; once the cache has caught up, the outputs should match
+  const size_t period = 512;
+  auto make_renderer = [&](size_t cache_size) {
+    Config config;
+    config.set_num_objects_channels(1);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    config.set_brir_view_cache_size(cache_size);
+    config.set_binaural_convolver(true);
+    Renderer renderer(config);
+
+    bear::ObjectsInput oi;
+    oi.type_metadata.position = ear::PolarPosition{30.0, 0.0, 1.0};
+    renderer.add_objects_block(0, oi);
+    return renderer;
+  };
+
+  Renderer reference = make_renderer(0);
+  Renderer cached = make_renderer(2);
+
+  std::vector<float> input(period, 1.0);
+  const float *input_p[1] = {input.data()};
+  std::vector<float> reference_out(2 * period), cached_out(2 * period);
+  float *reference_out_p[2] = {reference_out.data(), reference_out.data() + period};
+  float *cached_out_p[2] = {cached_out.data(), cached_out.data() + period};
+
+  // yaw angles in radians
+  for (double yaw : {0.0, 0.7, 1.6, 3.1}) {
+    Listener listener;
+    listener.set_orientation_quaternion({std::cos(yaw / 2), 0.0, 0.0, std::sin(yaw / 2)});
+    reference.set_listener(listener);
+    cached.set_listener(listener);
+
+    bool matched = false;
+    for (size_t i = 0; i < 1000 && !matched; i++) {
+      reference.process(input_p, nullptr, nullptr, reference_out_p);
+      cached.process(input_p, nullptr, nullptr, cached_out_p);
+
+      matched = true;
+      for (size_t s = 0; s < 2 * period; s++)
+        if (std::abs(reference_out[s] - cached_out[s]) > 1e-5) matched = false;
+
+      // give the loader thread a chance to run
+      if (!matched) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(matched);
+  }
+
+  SECTION("requires binaural convolver")
+  {
+    Config config;
+    config.set_num_objects_channels(1);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    config.set_brir_view_cache_size(2);
+    REQUIRE_THROWS_AS(Renderer(config), std::invalid_argument);
+  }
+}
+
+TEST_CASE("binaural_convolver")
+{
+  // the dedicated BRIR convolver should give the same output as the generic
+  // one, including for diffuse objects and after view switches; the
+  // crossfades may not be identical, so only compare once they are done
+  const size_t period = 512;
+  auto make_renderer = [&](bool binaural_convolver) {
+    Config config;
+    config.set_num_objects_channels(1);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    config.set_binaural_convolver(binaural_convolver);
+    Renderer renderer(config);
+
+    bear::ObjectsInput oi;
+    oi.type_metadata.position = ear::PolarPosition{30.0, 0.0, 1.0};
+    oi.type_metadata.diffuse = 0.5;
+    renderer.add_objects_block(0, oi);
+    return renderer;
+  };
+
+  Renderer generic = make_renderer(false);
+  Renderer binaural = make_renderer(true);
+
+  std::vector<float> input(period);
+  const float *input_p[1] = {input.data()};
+  std::vector<float> generic_out(2 * period), binaural_out(2 * period);
+  float *generic_out_p[2] = {generic_out.data(), generic_out.data() + period};
+  float *binaural_out_p[2] = {binaural_out.data(), binaural_out.data() + period};
+
+  for (double yaw : {0.0, 0.7, 1.6}) {
+    Listener listener;
+    listener.set_orientation_quaternion({std::cos(yaw / 2), 0.0, 0.0, std::sin(yaw / 2)});
+    generic.set_listener(listener);
+    binaural.set_listener(listener);
+
+    for (size_t block = 0; block < 20; block++) {
+      for (size_t s = 0; s < period; s++) input[s] = std::sin(0.01 * (block * period + s));
+
+      generic.process(input_p, nullptr, nullptr, generic_out_p);
+      binaural.process(input_p, nullptr, nullptr, binaural_out_p);
+
+      if (block >= 10)
+        for (size_t s = 0; s < 2 * period; s++)
+          REQUIRE(binaural_out[s] == Approx(generic_out[s]).margin(1e-4));
+    }
+  }
+}
+
+TEST_CASE("memory_report")
+{
+  Config config;
+  config.set_num_objects_channels(2);
+  config.set_num_direct_speakers_channels(1);
+  config.set_period_size(512);
+  config.set_data_path(DEFAULT_TENSORFILE_NAME);
+  MemoryReport report = Renderer(config).get_memory_report();
+
+  size_t allocated = 0, mapped = 0, resident = 0;
+  for (auto &component : report.components) {
+    allocated += component.allocated_bytes;
+    mapped += component.mapped_bytes;
+    resident += component.resident_bytes;
+    REQUIRE(component.resident_bytes <= component.mapped_bytes);
+  }
+  REQUIRE(report.allocated_bytes == allocated);
+  REQUIRE(report.mapped_bytes == mapped);
+  REQUIRE(report.resident_bytes == resident);
+
+  auto find = [&](const MemoryReport &r, const std::string &name) {
+    auto it = std::find_if(r.components.begin(), r.components.end(), [&](const ComponentMemory &c) {
+      return c.name == name;
+    });
+    REQUIRE(it != r.components.end());
+    return *it;
+  };
+  REQUIRE(find(report, "brir_convolver").allocated_bytes > 0);
+  ComponentMemory brirs = find(report, "data_file.brirs");
+  REQUIRE(brirs.allocated_bytes + brirs.mapped_bytes > 0);
+
+  SECTION("budget exceeded")
+  {
+    config.set_memory_budget(report.allocated_bytes / 2);
+    REQUIRE_THROWS_AS(Renderer(config), std::runtime_error);
+  }
+
+  SECTION("adapt to budget")
+  {
+    // the view cache needs the binaural convolver
+    config.set_binaural_convolver(true);
+    MemoryReport full = Renderer(config).get_memory_report();
+
+    // just too small for all views, so the view cache has to be used
+    config.set_memory_budget(full.allocated_bytes - 1);
+    config.set_adapt_to_memory_budget(true);
+    MemoryReport adapted = Renderer(config).get_memory_report();
+
+    REQUIRE(adapted.allocated_bytes <= config.get_memory_budget());
+    REQUIRE(find(adapted, "brir_convolver").allocated_bytes < find(full, "brir_convolver").allocated_bytes);
+  }
+
+  SECTION("no adaptation without binaural convolver")
+  {
+    config.set_memory_budget(report.allocated_bytes - 1);
+    config.set_adapt_to_memory_budget(true);
+    REQUIRE_THROWS_AS(Renderer(config), std::runtime_error);
+  }
+}
+
+TEST_CASE("object_clustering")
+{
+  // two pairs of objects at the same positions should be rendered exactly
+  // with two clusters; the input is silent while the clusters settle, so
+  // that the output matches from the start
+  const size_t period = 512;
+  auto make_renderer = [&](size_t max_clusters) {
+    Config config;
+    config.set_num_objects_channels(4);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    config.set_max_object_clusters(max_clusters);
+    Renderer renderer(config);
+
+    for (size_t channel = 0; channel < 4; channel++) {
+      bear::ObjectsInput oi;
+      oi.type_metadata.position = ear::PolarPosition{channel < 2 ? 30.0 : -110.0, 0.0, 1.0};
+      renderer.add_objects_block(channel, oi);
+    }
+    return renderer;
+  };
+
+  Renderer reference = make_renderer(0);
+  Renderer clustered = make_renderer(2);
+
+  std::vector<std::vector<float>> input(4, std::vector<float>(period));
+  const float *input_p[4] = {input[0].data(), input[1].data(), input[2].data(), input[3].data()};
+  std::vector<float> reference_out(2 * period), clustered_out(2 * period);
+  float *reference_out_p[2] = {reference_out.data(), reference_out.data() + period};
+  float *clustered_out_p[2] = {clustered_out.data(), clustered_out.data() + period};
+
+  for (size_t block = 0; block < 20; block++) {
+    for (size_t channel = 0; channel < 4; channel++)
+      for (size_t s = 0; s < period; s++)
+        input[channel][s] = block < 5 ? 0.0f : std::sin(0.01 * (channel + 1) * (block * period + s));
+
+    reference.process(input_p, nullptr, nullptr, reference_out_p);
+    clustered.process(input_p, nullptr, nullptr, clustered_out_p);
+
+    for (size_t s = 0; s < 2 * period; s++)
+      REQUIRE(clustered_out[s] == Approx(reference_out[s]).margin(1e-4));
+  }
+}
+
+TEST_CASE("object_clustering_move")
+{
+  // three objects in two clusters, one of which moves from one fixed object
+  // to the other while there is input, so it changes cluster during the
+  // audio; the clustered output is approximate, but should be no less
+  // smooth than the reference
+  const size_t period = 512;
+  const size_t num_blocks = 32;
+  auto make_renderer = [&](size_t max_clusters) {
+    Config config;
+    config.set_num_objects_channels(3);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    config.set_max_object_clusters(max_clusters);
+    return Renderer(config);
+  };
+  auto block_at = [](double azimuth) {
+    bear::ObjectsInput oi;
+    oi.type_metadata.position = ear::PolarPosition{azimuth, 0.0, 1.0};
+    return oi;
+  };
+
+  Renderer reference = make_renderer(0);
+  Renderer clustered = make_renderer(2);
+  for (Renderer *renderer : {&reference, &clustered}) {
+    renderer->add_objects_block(0, block_at(30.0));
+    renderer->add_objects_block(1, block_at(-110.0));
+  }
+
+  std::vector<std::vector<float>> input(3, std::vector<float>(period));
+  const float *input_p[3] = {input[0].data(), input[1].data(), input[2].data()};
+  std::vector<float> reference_out(2 * period), clustered_out(2 * period);
+  float *reference_out_p[2] = {reference_out.data(), reference_out.data() + period};
+  float *clustered_out_p[2] = {clustered_out.data(), clustered_out.data() + period};
+
+  // largest difference between consecutive samples in each ear, and the
+  // largest output, over the whole output
+  float reference_last[2] = {0.0f, 0.0f}, clustered_last[2] = {0.0f, 0.0f};
+  float reference_max_step = 0.0f, clustered_max_step = 0.0f;
+  float reference_max = 0.0f, clustered_max = 0.0f;
+
+  for (size_t block = 0; block < num_blocks; block++) {
+    // from 25 degrees (with object 0) to -105 degrees (with object 1) over
+    // blocks 8 to 24
+    double t = std::min(std::max((static_cast<double>(block) - 8.0) / 16.0, 0.0), 1.0);
+    for (Renderer *renderer : {&reference, &clustered})
+      renderer->add_objects_block(2, block_at(25.0 - 130.0 * t));
+
+    for (size_t channel = 0; channel < 3; channel++)
+      for (size_t s = 0; s < period; s++)
+        input[channel][s] = block < 5 ? 0.0f : std::sin(0.01 * (channel + 1) * (block * period + s));
+
+    reference.process(input_p, nullptr, nullptr, reference_out_p);
+    clustered.process(input_p, nullptr, nullptr, clustered_out_p);
+
+    for (size_t ear = 0; ear < 2; ear++)
+      for (size_t s = 0; s < period; s++) {
+        float r = reference_out[ear * period + s], c = clustered_out[ear * period + s];
+        reference_max_step = std::max(reference_max_step, std::abs(r - reference_last[ear]));
+        clustered_max_step = std::max(clustered_max_step, std::abs(c - clustered_last[ear]));
+        reference_max = std::max(reference_max, std::abs(r));
+        clustered_max = std::max(clustered_max, std::abs(c));
+        reference_last[ear] = r;
+        clustered_last[ear] = c;
+      }
+  }
+
+  REQUIRE(reference_max > 0.01f);
+  REQUIRE(clustered_max > 0.5f * reference_max);
+  REQUIRE(clustered_max_step <= 2.0f * reference_max_step);
+}
+
+TEST_CASE("direct_speakers_routing")
+{
+  // one channel on a loudspeaker, which is routed directly, and one between
+  // loudspeakers, which is panned; the first moves between loudspeakers half
+  // way through. Rendering both together should be the same as rendering
+  // each separately.
+  const size_t period = 512;
+  auto make_renderer = [&](size_t num_channels) {
+    Config config;
+    config.set_num_direct_speakers_channels(num_channels);
+    config.set_period_size(period);
+    config.set_data_path(DEFAULT_TENSORFILE_NAME);
+    return Renderer(config);
+  };
+  auto block_at = [](double azimuth) {
+    bear::DirectSpeakersInput block;
+    block.type_metadata.position = ear::PolarSpeakerPosition{azimuth, 0.0, 1.0};
+    return block;
+  };
+
+  Renderer both = make_renderer(2);
+  Renderer first = make_renderer(1);
+  Renderer second = make_renderer(1);
+
+  both.add_direct_speakers_block(0, block_at(30.0));
+  first.add_direct_speakers_block(0, block_at(30.0));
+  both.add_direct_speakers_block(1, block_at(10.0));
+  second.add_direct_speakers_block(0, block_at(10.0));
+
+  std::vector<std::vector<float>> input(2, std::vector<float>(period));
+  const float *input_p[2] = {input[0].data(), input[1].data()};
+  std::vector<float> both_out(2 * period), first_out(2 * period), second_out(2 * period);
+  float *both_out_p[2] = {both_out.data(), both_out.data() + period};
+  float *first_out_p[2] = {first_out.data(), first_out.data() + period};
+  float *second_out_p[2] = {second_out.data(), second_out.data() + period};
+
+  float max_output = 0.0f;
+  for (size_t block = 0; block < 20; block++) {
+    if (block == 10) {
+      both.add_direct_speakers_block(0, block_at(10.0));
+      first.add_direct_speakers_block(0, block_at(10.0));
+    }
+
+    for (size_t channel = 0; channel < 2; channel++)
+      for (size_t s = 0; s < period; s++)
+        input[channel][s] = std::sin(0.01 * (channel + 1) * (block * period + s));
+
+    both.process(nullptr, input_p, nullptr, both_out_p);
+    first.process(nullptr, &input_p[0], nullptr, first_out_p);
+    second.process(nullptr, &input_p[1], nullptr, second_out_p);
+
+    for (size_t s = 0; s < 2 * period; s++) {
+      REQUIRE(both_out[s] == Approx(first_out[s] + second_out[s]).margin(1e-5));
+      max_output = std::max(max_output, std::abs(both_out[s]));
+    }
+  }
+  REQUIRE(max_output > 0.01f);
+}
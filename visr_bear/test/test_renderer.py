@@ -95,3 +95,74 @@ def test_add_error(basic_config):
     with pytest.raises(ValueError):
         renderer.add_direct_speakers_block(1, dsi)
     dummy_process_call(renderer, basic_config)
+
+
+def test_process_blocks(basic_config):
+    period_size = basic_config.period_size
+    num_periods = 4
+    num_samples = num_periods * period_size
+
+    rng = np.random.default_rng(0)
+    objects_input = rng.normal(size=(1, num_samples)).astype(np.float32)
+    empty_input = np.zeros((0, num_samples), dtype=np.float32)
+
+    def make_block(i, azimuth):
+        block = visr_bear.api.ObjectsInput()
+        block.rtime = Time(i * period_size, 48000)
+        block.duration = Time(period_size, 48000)
+        block.type_metadata.position = visr_bear.api.PolarPosition(azimuth, 0.0, 1.0)
+        return block
+
+    # one block per period, and one which starts after the end
+    blocks = [make_block(i, 30.0 * i) for i in range(num_periods + 1)]
+
+    # reference: render one period at a time
+    renderer = visr_bear.api.Renderer(basic_config)
+    expected = np.zeros((2, num_samples), dtype=np.float32)
+    to_add = list(blocks)
+    for i in range(num_periods):
+        while to_add and renderer.add_objects_block(0, to_add[0]):
+            to_add.pop(0)
+
+        period = slice(i * period_size, (i + 1) * period_size)
+        output = np.zeros((2, period_size), dtype=np.float32)
+        renderer.process(
+            np.ascontiguousarray(objects_input[:, period]),
+            np.zeros((0, period_size), dtype=np.float32),
+            np.zeros((0, period_size), dtype=np.float32),
+            output,
+        )
+        expected[:, period] = output
+
+    renderer = visr_bear.api.Renderer(basic_config)
+    output = np.zeros((2, num_samples), dtype=np.float32)
+    (
+        objects_remaining,
+        direct_speakers_remaining,
+        hoa_remaining,
+    ) = renderer.process_blocks(
+        objects_input,
+        empty_input,
+        empty_input,
+        output,
+        objects_blocks=[(0, block) for block in blocks],
+    )
+
+    np.testing.assert_allclose(output, expected, atol=1e-6)
+    assert to_frac(renderer.get_block_start_time()) == Fraction(num_samples, 48000)
+
+    assert len(objects_remaining) == 1
+    channel, block = objects_remaining[0]
+    assert channel == 0
+    assert to_frac(block.rtime) == Fraction(num_periods * period_size, 48000)
+    assert direct_speakers_remaining == []
+    assert hoa_remaining == []
+
+    # the output length must be a whole number of periods
+    with pytest.raises(ValueError):
+        renderer.process_blocks(
+            objects_input[:, :-1].copy(),
+            empty_input[:, :-1].copy(),
+            empty_input[:, :-1].copy(),
+            output[:, :-1].copy(),
+        )
@@ -49,6 +49,58 @@ TEST_CASE("rotation")
   }
 }
 
+TEST_CASE("yaw_rotation")
+{
+  for (int order = 1; order < 5; order++) {
+    size_t n_channels = (order + 1) * (order + 1);
+    SHYawRotation yaw_rotation(order);
+
+    for (double angle : {0.0, 0.1, -0.7, 2.5, -3.1}) {
+      Eigen::Quaterniond q(Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()));
+
+      boost::optional<double> yaw = quaternion_to_yaw(q);
+      REQUIRE(static_cast<bool>(yaw));
+      yaw_rotation.set_yaw(*yaw);
+
+      Eigen::MatrixXd M(n_channels, n_channels);
+      quaternion_to_sh_rotation_matrix(q, order, M);
+
+      for (size_t sample = 0; sample < 10; sample++) {
+        Eigen::VectorXd sh = Eigen::VectorXd::Random(n_channels);
+        Eigen::VectorXd sh_rot(n_channels);
+        yaw_rotation.apply(sh, sh_rot);
+
+        REQUIRE_THAT(sh_rot, IsApprox(Eigen::VectorXd(M * sh)));
+      }
+    }
+  }
+
+  // not a pure yaw
+  Eigen::Quaterniond q(Eigen::AngleAxisd(0.1, Eigen::Vector3d(0.0, 0.1, 1.0).normalized()));
+  REQUIRE_FALSE(static_cast<bool>(quaternion_to_yaw(q)));
+}
+
+TEST_CASE("block_rotation")
+{
+  for (int order = 1; order < 5; order++) {
+    size_t n_channels = (order + 1) * (order + 1);
+    Eigen::Vector4d qp = Eigen::Vector4d::Random();
+    qp.normalize();
+    Eigen::Quaterniond q(qp);
+
+    Eigen::MatrixXd M(n_channels, n_channels);
+    quaternion_to_sh_rotation_matrix(q, order, M);
+
+    for (size_t sample = 0; sample < 10; sample++) {
+      Eigen::VectorXd sh = Eigen::VectorXd::Random(n_channels);
+      Eigen::VectorXd sh_rot(n_channels);
+      apply_sh_rotation_blocks(M, order, sh, sh_rot);
+
+      REQUIRE_THAT(sh_rot, IsApprox(Eigen::VectorXd(M * sh)));
+    }
+  }
+}
+
 #ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
 TEST_CASE("bench", "[benchmark]")
 {
@@ -95,5 +147,31 @@ TEST_CASE("bench", "[benchmark]")
       return result.sum();
     };
   }
+
+  {
+    size_t n_channels = 5 * 5;
+    Eigen::MatrixXd M(n_channels, n_channels);
+    quaternion_to_sh_rotation_matrix(q, 4, M);
+    Eigen::VectorXd sh = Eigen::VectorXd::Random(n_channels);
+    Eigen::VectorXd result(n_channels);
+    SHYawRotation yaw_rotation(4);
+
+    BENCHMARK("apply dense 4")
+    {
+      result = M * sh;
+      return result.sum();
+    };
+    BENCHMARK("apply blocks 4")
+    {
+      apply_sh_rotation_blocks(M, 4, sh, result);
+      return result.sum();
+    };
+    BENCHMARK("apply yaw 4")
+    {
+      yaw_rotation.set_yaw(0.1);
+      yaw_rotation.apply(sh, result);
+      return result.sum();
+    };
+  }
 }
 #endif
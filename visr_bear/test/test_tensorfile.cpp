@@ -1,3 +1,9 @@
+#include <boost/optional/optional_io.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
 #include "catch2/catch.hpp"
 #include "tensorfile.hpp"
 #include "test_config.h"
@@ -24,16 +30,16 @@ void check_one_multi_dim(const TensorFile &tenf, const rapidjson::Value &v)
 
 void check_multi_dim(const TensorFile &tenf)
 {
-  check_one_multi_dim<float>(tenf, tenf.metadata["multi_dim"]["float32"]);
-  check_one_multi_dim<double>(tenf, tenf.metadata["multi_dim"]["float64"]);
-  check_one_multi_dim<uint64_t>(tenf, tenf.metadata["multi_dim"]["uint64"]);
-  check_one_multi_dim<uint32_t>(tenf, tenf.metadata["multi_dim"]["uint32"]);
-  check_one_multi_dim<uint16_t>(tenf, tenf.metadata["multi_dim"]["uint16"]);
-  check_one_multi_dim<uint8_t>(tenf, tenf.metadata["multi_dim"]["uint8"]);
-  check_one_multi_dim<int64_t>(tenf, tenf.metadata["multi_dim"]["int64"]);
-  check_one_multi_dim<int32_t>(tenf, tenf.metadata["multi_dim"]["int32"]);
-  check_one_multi_dim<int16_t>(tenf, tenf.metadata["multi_dim"]["int16"]);
-  check_one_multi_dim<int8_t>(tenf, tenf.metadata["multi_dim"]["int8"]);
+  check_one_multi_dim<float>(tenf, tenf.metadata()["multi_dim"]["float32"]);
+  check_one_multi_dim<double>(tenf, tenf.metadata()["multi_dim"]["float64"]);
+  check_one_multi_dim<uint64_t>(tenf, tenf.metadata()["multi_dim"]["uint64"]);
+  check_one_multi_dim<uint32_t>(tenf, tenf.metadata()["multi_dim"]["uint32"]);
+  check_one_multi_dim<uint16_t>(tenf, tenf.metadata()["multi_dim"]["uint16"]);
+  check_one_multi_dim<uint8_t>(tenf, tenf.metadata()["multi_dim"]["uint8"]);
+  check_one_multi_dim<int64_t>(tenf, tenf.metadata()["multi_dim"]["int64"]);
+  check_one_multi_dim<int32_t>(tenf, tenf.metadata()["multi_dim"]["int32"]);
+  check_one_multi_dim<int16_t>(tenf, tenf.metadata()["multi_dim"]["int16"]);
+  check_one_multi_dim<int8_t>(tenf, tenf.metadata()["multi_dim"]["int8"]);
 }
 
 TEST_CASE("read_le_32")
@@ -59,3 +65,182 @@ TEST_CASE("read_be_1")
   auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_be_1.tenf");
   check_multi_dim(tenf);
 }
+
+void check_reduced(const TensorFile &tenf)
+{
+  // converted to float on load
+  auto float16 = tenf.unpack<float>(tenf.metadata()["multi_dim"]["float16"]);
+  auto scaled_int16 = tenf.unpack<float>(tenf.metadata()["multi_dim"]["scaled_int16"]);
+  REQUIRE(float16);
+  REQUIRE(scaled_int16);
+
+  for (auto &array : {float16, scaled_int16}) {
+    REQUIRE(array->ndim() == 3);
+    REQUIRE(array->shape(0) == 2);
+    REQUIRE(array->shape(1) == 4);
+    REQUIRE(array->shape(2) == 8);
+  }
+
+  for (size_t i = 0; i < 2; i++)
+    for (size_t j = 0; j < 4; j++)
+      for (size_t k = 0; k < 8; k++) {
+        float value = (float)((i << 5) + (j << 3) + k);
+        REQUIRE((*float16)(i, j, k) == value);
+        REQUIRE((*scaled_int16)(i, j, k) == value * 0.5f);
+      }
+}
+
+TEST_CASE("read_reduced_le")
+{
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_reduced_le.tenf");
+  check_reduced(tenf);
+}
+
+TEST_CASE("read_reduced_be")
+{
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_reduced_be.tenf");
+  check_reduced(tenf);
+}
+
+void check_v1(const TensorFile &tenf)
+{
+  REQUIRE(tenf.version() == 1);
+  REQUIRE(tenf.num_arrays() == 10);
+  REQUIRE(tenf.verify_all());
+
+  // index entries match the JSON, and arrays are aligned
+  const rapidjson::Value &float32 = tenf.metadata()["multi_dim"]["float32"];
+  IndexEntry entry = tenf.index_entry(float32["index"].GetUint64());
+  REQUIRE(entry.base == float32["base"].GetUint64());
+  REQUIRE(entry.dtype == float32["dtype"].GetString());
+  REQUIRE(entry.length == 2 * 4 * 8 * sizeof(float));
+  REQUIRE(entry.name == "/multi_dim/float32");
+  for (size_t i = 0; i < tenf.num_arrays(); i++) REQUIRE(tenf.index_entry(i).base % 64 == 0);
+
+  REQUIRE_THROWS_AS(tenf.index_entry(10), format_error);
+
+  // arrays can be found by name using only the index
+  for (size_t i = 0; i < tenf.num_arrays(); i++) REQUIRE(tenf.find(tenf.index_entry(i).name) == i);
+  REQUIRE(tenf.find("/multi_dim/float32") == float32["index"].GetUint64());
+  REQUIRE(!tenf.find("/multi_dim"));
+  REQUIRE(!tenf.find("/multi_dim/float"));
+  REQUIRE(!tenf.find(""));
+
+  check_multi_dim(tenf);
+}
+
+TEST_CASE("read_v1_le")
+{
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_v1_le.tenf");
+  check_v1(tenf);
+}
+
+TEST_CASE("read_v1_be")
+{
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_v1_be.tenf");
+  check_v1(tenf);
+}
+
+namespace {
+  void put_unsigned(std::string &out, uint64_t x, size_t size)
+  {
+    for (size_t i = 0; i < size; i++) out.push_back(static_cast<char>((x >> (i * 8)) & 0xff));
+  }
+
+  /// write a version 1 file containing one "<f4" array of 4 elements, with
+  /// the given shape and index entry length, and the given name table
+  std::string write_v1_file(const std::string &shape,
+                            size_t length,
+                            const std::string &names = std::string("/a\0", 3))
+  {
+    std::string data(16, '\0');
+    std::string metadata = "{\"a\": {\"_tenf_type\": \"array\", \"index\": 0, \"shape\": [" + shape +
+                           "], \"strides\": [4]}}";
+
+    std::string index;
+    put_unsigned(index, 1, 8);
+    put_unsigned(index, 32, 8);
+    put_unsigned(index, length, 8);
+    put_unsigned(index, 0, 8);
+    index += std::string("<f4\0\0\0\0\0", 8);
+    index += names;
+
+    std::string file = "TENF";
+    put_unsigned(file, 1, 4);
+    put_unsigned(file, data.size(), 8);
+    put_unsigned(file, metadata.size(), 8);
+    put_unsigned(file, index.size(), 8);
+    file += data + metadata + index;
+
+    std::string path = "/tmp/bear-test-tensorfile-" + std::to_string(getpid()) + ".tenf";
+    std::ofstream(path, std::ios::binary) << file;
+    return path;
+  }
+
+  void check_v1_bounds(const std::string &shape, size_t length, bool valid)
+  {
+    std::string path = write_v1_file(shape, length);
+    {
+      auto tenf = read(path);
+      if (valid)
+        REQUIRE(tenf.unpack<float>(tenf.metadata()["a"]));
+      else
+        REQUIRE_THROWS_AS(tenf.unpack(tenf.metadata()["a"]), format_error);
+    }
+    std::remove(path.c_str());
+  }
+}  // namespace
+
+TEST_CASE("read_v1_bounds")
+{
+  check_v1_bounds("4", 16, true);
+  // the last element overlaps the end of the entry
+  check_v1_bounds("4", 15, false);
+  check_v1_bounds("4", 13, false);
+  check_v1_bounds("5", 16, false);
+  // zero-length entries can only hold empty arrays
+  check_v1_bounds("4", 0, false);
+  check_v1_bounds("0", 0, true);
+}
+
+TEST_CASE("read_v1_names")
+{
+  std::string path = write_v1_file("4", 16);
+  {
+    auto tenf = read(path);
+    REQUIRE(tenf.index_entry(0).name == "/a");
+    REQUIRE(tenf.find("/a") == size_t(0));
+    REQUIRE(!tenf.find("/b"));
+  }
+
+  // names must be terminated within the name table
+  path = write_v1_file("4", 16, "/a");
+  {
+    auto tenf = read(path);
+    REQUIRE_THROWS_AS(tenf.index_entry(0), format_error);
+    REQUIRE_THROWS_AS(tenf.find("/a"), format_error);
+  }
+  std::remove(path.c_str());
+}
+
+TEST_CASE("read_v0_no_index")
+{
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_le_32.tenf");
+  REQUIRE(tenf.version() == 0);
+  REQUIRE(tenf.num_arrays() == 0);
+  REQUIRE(!tenf.find("/multi_dim/float32"));
+  REQUIRE(tenf.verify_all());
+  REQUIRE(tenf.verify(tenf.metadata()["multi_dim"]["float32"]));
+}
+
+TEST_CASE("read_options")
+{
+  ReadOptions options;
+  options.sequential = true;
+  options.will_need = true;
+  options.huge_pages = true;
+
+  auto tenf = read(BUNDLED_TEST_FILES "/tensorfile_v1_le.tenf", options);
+  prefault(*tenf.unpack<float>(tenf.metadata()["multi_dim"]["float32"]));
+  check_multi_dim(tenf);
+}
@@ -0,0 +1,175 @@
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bw64.hpp"
+#include "metadata_file.hpp"
+#include "metadata_stream.hpp"
+#include "offline_render.hpp"
+
+using namespace bear;
+
+namespace {
+  const char *usage =
+      "usage: bear-offline-render [options] input_file metadata_file output_file\n"
+      "\n"
+      "Render a BW64 file to binaural, using metadata extracted from its ADM with\n"
+      "bear-extract-metadata, in either JSON or binary format.\n"
+      "\n"
+      "options:\n"
+      "  --data-path path       path to the BEAR data file (required)\n"
+      "  --block-size n         samples per block (default: 4096)\n"
+      "  --output-gain-db gain  output gain in dB (default: 0)\n"
+      "  --output-format fmt    pcm16, pcm24, pcm32 or float32 (default: same as input)\n"
+      "  --fft-impl name        FFT implementation, or auto (default: default)\n"
+      "  --threads n            number of threads, or 0 for one per core (default: 1)\n"
+      "  --chunk-seconds t      length of chunks rendered in parallel (default: split\n"
+      "                         evenly between threads)\n"
+      "  --fail-on-overload     fail if the output overloads\n"
+      "  --verbose              print rendering speed\n";
+
+  struct Args {
+    std::string input_file;
+    std::string metadata_file;
+    std::string output_file;
+    OfflineRenderOptions options;
+    boost::optional<SampleFormat> output_format;
+    boost::optional<double> chunk_seconds;
+    bool fail_on_overload = false;
+    bool verbose = false;
+  };
+
+  SampleFormat parse_sample_format(const std::string &name)
+  {
+    if (name == "pcm16") return SampleFormat::PCM16;
+    if (name == "pcm24") return SampleFormat::PCM24;
+    if (name == "pcm32") return SampleFormat::PCM32;
+    if (name == "float32") return SampleFormat::FLOAT32;
+    throw std::invalid_argument("unknown output format: " + name);
+  }
+
+  /// is path a binary metadata file (which is a tensorfile) rather than JSON?
+  bool is_binary_metadata(const std::string &path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    char tag[4] = {};
+    file.read(tag, sizeof(tag));
+    return file && std::string(tag, sizeof(tag)) == "TENF";
+  }
+
+  Args parse_args(int argc, char **argv)
+  {
+    Args args;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      auto value = [&]() -> std::string {
+        if (i + 1 >= argc) throw std::invalid_argument(arg + " requires a value");
+        return argv[++i];
+      };
+
+      if (arg == "--data-path")
+        args.options.data_path = value();
+      else if (arg == "--block-size")
+        args.options.block_size = std::stoul(value());
+      else if (arg == "--output-gain-db")
+        args.options.output_gain = static_cast<float>(std::pow(10.0, std::stod(value()) / 20.0));
+      else if (arg == "--output-format")
+        args.output_format = parse_sample_format(value());
+      else if (arg == "--fft-impl")
+        args.options.fft_implementation = value();
+      else if (arg == "--threads")
+        args.options.num_threads = std::stoul(value());
+      else if (arg == "--chunk-seconds")
+        args.chunk_seconds = std::stod(value());
+      else if (arg == "--fail-on-overload")
+        args.fail_on_overload = true;
+      else if (arg == "--verbose")
+        args.verbose = true;
+      else if (arg == "--help" || arg == "-h") {
+        std::cout << usage;
+        std::exit(0);
+      } else if (arg.size() > 1 && arg[0] == '-')
+        throw std::invalid_argument("unknown option: " + arg);
+      else
+        positional.push_back(arg);
+    }
+
+    if (positional.size() != 3) throw std::invalid_argument("expected 3 positional arguments");
+    if (args.options.data_path.empty()) throw std::invalid_argument("--data-path is required");
+    if (args.options.block_size == 0) throw std::invalid_argument("--block-size must be positive");
+    if (args.chunk_seconds && !(*args.chunk_seconds > 0.0))
+      throw std::invalid_argument("--chunk-seconds must be positive");
+
+    args.input_file = positional[0];
+    args.metadata_file = positional[1];
+    args.output_file = positional[2];
+
+    return args;
+  }
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  Args args;
+  try {
+    args = parse_args(argc, argv);
+  } catch (std::exception &e) {
+    std::cerr << "error: " << e.what() << "\n\n" << usage;
+    return 2;
+  }
+
+  try {
+    Bw64Reader input(args.input_file);
+    std::unique_ptr<MetadataFile> metadata_file;
+    MetadataStream metadata_stream;
+    if (is_binary_metadata(args.metadata_file))
+      metadata_file.reset(new MetadataFile(args.metadata_file));
+    else
+      metadata_stream = read_metadata_stream_json(args.metadata_file);
+
+    if (args.chunk_seconds)
+      args.options.chunk_frames =
+          static_cast<size_t>(std::ceil(*args.chunk_seconds * input.format().sample_rate));
+
+    Bw64Format output_format;
+    output_format.num_channels = 2;
+    output_format.sample_rate = input.format().sample_rate;
+    output_format.sample_format = args.output_format ? *args.output_format : input.format().sample_format;
+    Bw64Writer output(args.output_file, output_format);
+
+    auto start = std::chrono::steady_clock::now();
+    OfflineRenderStats stats = metadata_file ? render_offline(input, *metadata_file, output, args.options)
+                                             : render_offline(input, metadata_stream, output, args.options);
+    output.close();
+    std::chrono::duration<double> render_time = std::chrono::steady_clock::now() - start;
+
+    if (args.verbose) {
+      double duration = static_cast<double>(stats.num_frames) / input.format().sample_rate;
+      std::cerr << "rendered " << duration << " s in " << render_time.count() << " s ("
+                << duration / render_time.count() << "x real time)\n";
+    }
+
+    // the same threshold as ear.core.monitor.PeakMonitor
+    if (stats.peak > 1.0f) {
+      std::cerr << "warning: output overloaded (peak " << 20.0 * std::log10(stats.peak) << " dBFS)\n";
+      if (args.fail_on_overload) {
+        std::cerr << "error: output overloaded\n";
+        return 1;
+      }
+    }
+  } catch (std::exception &e) {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
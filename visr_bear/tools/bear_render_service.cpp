@@ -0,0 +1,81 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+
+#include "render_service.hpp"
+
+using namespace bear;
+
+namespace {
+  const char *usage =
+      "usage: bear-render-service [options]\n"
+      "\n"
+      "Run a service which renders for RenderClient sessions in other processes,\n"
+      "sharing the data file between sessions. Runs until interrupted.\n"
+      "\n"
+      "options:\n"
+      "  --socket path   path of the Unix domain socket to listen on (required)\n"
+      "  --workers n     number of rendering threads (default: 1)\n";
+
+  RenderServiceOptions parse_args(int argc, char **argv)
+  {
+    RenderServiceOptions options;
+
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      auto value = [&]() -> std::string {
+        if (i + 1 >= argc) throw std::invalid_argument(arg + " requires a value");
+        return argv[++i];
+      };
+
+      if (arg == "--socket")
+        options.socket_path = value();
+      else if (arg == "--workers")
+        options.num_workers = std::stoul(value());
+      else if (arg == "--help" || arg == "-h") {
+        std::cout << usage;
+        std::exit(0);
+      } else
+        throw std::invalid_argument("unknown argument: " + arg);
+    }
+
+    if (options.socket_path.empty()) throw std::invalid_argument("--socket is required");
+    if (options.num_workers == 0) throw std::invalid_argument("--workers must be positive");
+
+    return options;
+  }
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  RenderServiceOptions options;
+  try {
+    options = parse_args(argc, argv);
+  } catch (std::exception &e) {
+    std::cerr << "error: " << e.what() << "\n\n" << usage;
+    return 2;
+  }
+
+  // block the signals before starting the service threads, so that they are
+  // only received by sigwait below
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try {
+    RenderService service(options);
+
+    int signal;
+    sigwait(&signals, &signal);
+  } catch (std::exception &e) {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,346 @@
+#include "bw64.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace bear {
+
+namespace {
+  constexpr uint16_t format_tag_pcm = 1;
+  constexpr uint16_t format_tag_float = 3;
+  constexpr uint16_t format_tag_extensible = 0xfffe;
+
+  /// size of the JUNK/ds64 chunk body, without a table
+  constexpr size_t ds64_size = 28;
+  constexpr size_t header_size = 12 + (8 + ds64_size) + (8 + 16) + 8;
+
+  uint16_t read_u16(const char *p)
+  {
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint16_t>(u[0] | (u[1] << 8));
+  }
+
+  uint32_t read_u32(const char *p)
+  {
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<uint32_t>(u[0]) | (static_cast<uint32_t>(u[1]) << 8) |
+           (static_cast<uint32_t>(u[2]) << 16) | (static_cast<uint32_t>(u[3]) << 24);
+  }
+
+  uint64_t read_u64(const char *p)
+  {
+    return static_cast<uint64_t>(read_u32(p)) | (static_cast<uint64_t>(read_u32(p + 4)) << 32);
+  }
+
+  void write_u16(std::ostream &s, uint16_t x)
+  {
+    char b[2] = {static_cast<char>(x & 0xff), static_cast<char>(x >> 8)};
+    s.write(b, 2);
+  }
+
+  void write_u32(std::ostream &s, uint32_t x)
+  {
+    write_u16(s, static_cast<uint16_t>(x & 0xffff));
+    write_u16(s, static_cast<uint16_t>(x >> 16));
+  }
+
+  void write_u64(std::ostream &s, uint64_t x)
+  {
+    write_u32(s, static_cast<uint32_t>(x & 0xffffffff));
+    write_u32(s, static_cast<uint32_t>(x >> 32));
+  }
+
+  void check(bool x, const std::string &message)
+  {
+    if (!x) throw std::runtime_error("error reading BW64 file: " + message);
+  }
+
+  SampleFormat get_sample_format(uint16_t format_tag, uint16_t bits_per_sample)
+  {
+    if (format_tag == format_tag_pcm) {
+      switch (bits_per_sample) {
+        case 16: return SampleFormat::PCM16;
+        case 24: return SampleFormat::PCM24;
+        case 32: return SampleFormat::PCM32;
+      }
+    } else if (format_tag == format_tag_float && bits_per_sample == 32)
+      return SampleFormat::FLOAT32;
+
+    throw std::runtime_error("error reading BW64 file: unsupported format " + std::to_string(format_tag) +
+                             " with " + std::to_string(bits_per_sample) + " bits per sample");
+  }
+
+  /// de-interleave n frames from data, converting each sample with convert
+  template <typename Convert>
+  void deinterleave(const char *data,
+                    size_t frame_size,
+                    size_t sample_size,
+                    size_t n,
+                    const std::vector<size_t> &channels,
+                    float *const *out,
+                    Convert convert)
+  {
+    for (size_t i = 0; i < n; i++) {
+      const char *frame = data + i * frame_size;
+      for (size_t c = 0; c < channels.size(); c++) out[c][i] = convert(frame + channels[c] * sample_size);
+    }
+  }
+
+  template <typename T>
+  T quantise(float x, double scale)
+  {
+    double max = scale - 1.0;
+    double y = std::round(static_cast<double>(x) * scale);
+    return static_cast<T>(std::min(std::max(y, -scale), max));
+  }
+}  // namespace
+
+size_t bytes_per_sample(SampleFormat format)
+{
+  switch (format) {
+    case SampleFormat::PCM16: return 2;
+    case SampleFormat::PCM24: return 3;
+    case SampleFormat::PCM32: return 4;
+    case SampleFormat::FLOAT32: return 4;
+  }
+  throw std::invalid_argument("unknown sample format");
+}
+
+Bw64Reader::Bw64Reader(const std::string &path)
+{
+  std::error_code error;
+  mmap.map(path, error);
+  if (error) throw std::runtime_error("could not open " + path + ": " + error.message());
+
+  const char *base = mmap.data();
+  size_t size = mmap.size();
+
+  check(size >= 12, "file too short");
+  bool is_riff = std::memcmp(base, "RIFF", 4) == 0;
+  bool is_64 = std::memcmp(base, "RF64", 4) == 0 || std::memcmp(base, "BW64", 4) == 0;
+  check(is_riff || is_64, "not a RIFF, RF64 or BW64 file");
+  check(std::memcmp(base + 8, "WAVE", 4) == 0, "not a WAVE file");
+
+  bool have_ds64 = false;
+  uint64_t ds64_data_size = 0;
+  bool have_fmt = false;
+  bool have_data = false;
+  uint64_t data_size = 0;
+
+  size_t block_align = 0;
+
+  for (size_t offset = 12; offset + 8 <= size;) {
+    const char *id = base + offset;
+    uint64_t chunk_size = read_u32(base + offset + 4);
+    const char *body = base + offset + 8;
+    size_t body_offset = offset + 8;
+
+    if (std::memcmp(id, "ds64", 4) == 0) {
+      check(chunk_size >= ds64_size && body_offset + ds64_size <= size, "ds64 chunk too short");
+      ds64_data_size = read_u64(body + 8);
+      have_ds64 = true;
+    } else if (std::memcmp(id, "fmt ", 4) == 0) {
+      check(chunk_size >= 16 && body_offset + 16 <= size, "fmt chunk too short");
+      uint16_t format_tag = read_u16(body);
+      format_.num_channels = read_u16(body + 2);
+      format_.sample_rate = read_u32(body + 4);
+      block_align = read_u16(body + 12);
+      uint16_t bits_per_sample = read_u16(body + 14);
+
+      if (format_tag == format_tag_extensible) {
+        check(chunk_size >= 40 && body_offset + 40 <= size, "extensible fmt chunk too short");
+        // the first two bytes of the sub-format GUID are the format tag
+        format_tag = read_u16(body + 24);
+      }
+
+      format_.sample_format = get_sample_format(format_tag, bits_per_sample);
+      check(format_.num_channels > 0, "no channels");
+      check(block_align == format_.num_channels * bytes_per_sample(format_.sample_format),
+            "unexpected block alignment");
+      have_fmt = true;
+    } else if (std::memcmp(id, "data", 4) == 0) {
+      if (is_64 && chunk_size == 0xffffffff) {
+        check(have_ds64, "data chunk size requires a ds64 chunk");
+        chunk_size = ds64_data_size;
+      }
+      data_offset = body_offset;
+      // allow truncated files
+      data_size = std::min<uint64_t>(chunk_size, size - body_offset);
+      have_data = true;
+    }
+
+    if (have_fmt && have_data) break;
+
+    // chunks are padded to an even length
+    uint64_t next = body_offset + chunk_size + (chunk_size & 1);
+    if (next > size) break;
+    offset = static_cast<size_t>(next);
+  }
+
+  check(have_fmt, "no fmt chunk");
+  check(have_data, "no data chunk");
+
+  num_frames_ = static_cast<size_t>(data_size / block_align);
+}
+
+void Bw64Reader::read(size_t start,
+                      size_t num_frames,
+                      const std::vector<size_t> &channels,
+                      float *const *out) const
+{
+  for (size_t channel : channels)
+    if (channel >= format_.num_channels) throw std::invalid_argument("channel out of range");
+
+  size_t n = start < num_frames_ ? std::min(num_frames, num_frames_ - start) : 0;
+
+  size_t sample_size = bytes_per_sample(format_.sample_format);
+  size_t frame_size = sample_size * format_.num_channels;
+  // start may be past the end of the data, in which case nothing is read
+  const char *data = n > 0 ? mmap.data() + data_offset + start * frame_size : nullptr;
+
+  switch (format_.sample_format) {
+    case SampleFormat::PCM16:
+      deinterleave(data, frame_size, sample_size, n, channels, out, [](const char *p) {
+        return static_cast<int16_t>(read_u16(p)) * (1.0f / 32768.0f);
+      });
+      break;
+    case SampleFormat::PCM24:
+      deinterleave(data, frame_size, sample_size, n, channels, out, [](const char *p) {
+        // shift into the top 24 bits for sign extension
+        const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+        uint32_t x = static_cast<uint32_t>(u[0]) << 8 | static_cast<uint32_t>(u[1]) << 16 |
+                     static_cast<uint32_t>(u[2]) << 24;
+        return static_cast<int32_t>(x) * (1.0f / 2147483648.0f);
+      });
+      break;
+    case SampleFormat::PCM32:
+      deinterleave(data, frame_size, sample_size, n, channels, out, [](const char *p) {
+        return static_cast<float>(static_cast<int32_t>(read_u32(p)) * (1.0 / 2147483648.0));
+      });
+      break;
+    case SampleFormat::FLOAT32:
+      deinterleave(data, frame_size, sample_size, n, channels, out, [](const char *p) {
+        uint32_t x = read_u32(p);
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+      });
+      break;
+  }
+
+  for (size_t c = 0; c < channels.size(); c++) std::fill(out[c] + n, out[c] + num_frames, 0.0f);
+}
+
+Bw64Writer::Bw64Writer(const std::string &path, const Bw64Format &format)
+    : format_(format), file(path, std::ios::binary)
+{
+  if (!file) throw std::runtime_error("could not open " + path + " for writing");
+  if (format_.num_channels == 0 || format_.num_channels > 0xffff)
+    throw std::invalid_argument("bad number of channels");
+
+  bool is_float = format_.sample_format == SampleFormat::FLOAT32;
+  uint16_t sample_size = static_cast<uint16_t>(bytes_per_sample(format_.sample_format));
+  uint16_t block_align = static_cast<uint16_t>(sample_size * format_.num_channels);
+
+  file.write("RIFF", 4);
+  write_u32(file, 0);
+  file.write("WAVE", 4);
+
+  // placeholder for the ds64 chunk
+  file.write("JUNK", 4);
+  write_u32(file, ds64_size);
+  for (size_t i = 0; i < ds64_size; i++) file.put(0);
+
+  file.write("fmt ", 4);
+  write_u32(file, 16);
+  write_u16(file, is_float ? format_tag_float : format_tag_pcm);
+  write_u16(file, static_cast<uint16_t>(format_.num_channels));
+  write_u32(file, static_cast<uint32_t>(format_.sample_rate));
+  write_u32(file, static_cast<uint32_t>(format_.sample_rate * block_align));
+  write_u16(file, block_align);
+  write_u16(file, static_cast<uint16_t>(8 * sample_size));
+
+  file.write("data", 4);
+  write_u32(file, 0);
+
+  if (!file) throw std::runtime_error("error writing BW64 header");
+}
+
+Bw64Writer::~Bw64Writer()
+{
+  if (file.is_open()) {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+}
+
+void Bw64Writer::write(const float *const *in, size_t num_frames) { write_at(num_frames_, in, num_frames); }
+
+void Bw64Writer::write_at(size_t start, const float *const *in, size_t num_frames)
+{
+  size_t sample_size = bytes_per_sample(format_.sample_format);
+  size_t frame_size = sample_size * format_.num_channels;
+  buffer.resize(num_frames * frame_size);
+
+  for (size_t i = 0; i < num_frames; i++) {
+    unsigned char *frame = reinterpret_cast<unsigned char *>(buffer.data()) + i * frame_size;
+    for (size_t c = 0; c < format_.num_channels; c++) {
+      unsigned char *p = frame + c * sample_size;
+      float x = in[c][i];
+      uint32_t bits = 0;
+      switch (format_.sample_format) {
+        case SampleFormat::PCM16: bits = static_cast<uint16_t>(quantise<int16_t>(x, 32768.0)); break;
+        case SampleFormat::PCM24: bits = static_cast<uint32_t>(quantise<int32_t>(x, 8388608.0)); break;
+        case SampleFormat::PCM32: bits = static_cast<uint32_t>(quantise<int32_t>(x, 2147483648.0)); break;
+        case SampleFormat::FLOAT32: std::memcpy(&bits, &x, sizeof(bits)); break;
+      }
+      for (size_t b = 0; b < sample_size; b++) p[b] = static_cast<unsigned char>(bits >> (8 * b));
+    }
+  }
+
+  file.seekp(static_cast<std::streamoff>(header_size + start * frame_size));
+  file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  if (!file) throw std::runtime_error("error writing BW64 file");
+  num_frames_ = std::max(num_frames_, start + num_frames);
+}
+
+void Bw64Writer::close()
+{
+  uint64_t data_size = static_cast<uint64_t>(num_frames_) * bytes_per_sample(format_.sample_format) *
+                       format_.num_channels;
+  file.seekp(static_cast<std::streamoff>(header_size + data_size));
+  if (data_size & 1) file.put(0);
+  uint64_t riff_size = header_size - 8 + data_size + (data_size & 1);
+
+  if (riff_size > 0xffffffff) {
+    file.seekp(0);
+    file.write("BW64", 4);
+    write_u32(file, 0xffffffff);
+
+    file.seekp(12);
+    file.write("ds64", 4);
+    write_u32(file, ds64_size);
+    write_u64(file, riff_size);
+    write_u64(file, data_size);
+    write_u64(file, num_frames_);
+    write_u32(file, 0);
+
+    file.seekp(header_size - 4);
+    write_u32(file, 0xffffffff);
+  } else {
+    file.seekp(4);
+    write_u32(file, static_cast<uint32_t>(riff_size));
+    file.seekp(header_size - 4);
+    write_u32(file, static_cast<uint32_t>(data_size));
+  }
+
+  bool ok = static_cast<bool>(file);
+  file.close();
+  if (!ok || !file) throw std::runtime_error("error writing BW64 file");
+}
+
+}  // namespace bear
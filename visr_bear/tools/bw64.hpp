@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mio.hpp"
+
+namespace bear {
+
+enum class SampleFormat { PCM16, PCM24, PCM32, FLOAT32 };
+
+size_t bytes_per_sample(SampleFormat format);
+
+struct Bw64Format {
+  size_t num_channels = 0;
+  size_t sample_rate = 0;
+  SampleFormat sample_format = SampleFormat::PCM24;
+};
+
+/// Reader for WAV, RF64 and BW64 files, supporting 16/24/32 bit integer and
+/// 32 bit float samples. The file is memory-mapped, so reading is just
+/// de-interleaving and conversion to float; chunks other than fmt, ds64 and
+/// data are ignored.
+class Bw64Reader {
+ public:
+  explicit Bw64Reader(const std::string &path);
+
+  const Bw64Format &format() const { return format_; }
+  size_t num_frames() const { return num_frames_; }
+
+  /// read num_frames frames starting at start for each channel in channels
+  /// into out, which has one pointer per channel; reading past the end of
+  /// the file produces zeros
+  void read(size_t start, size_t num_frames, const std::vector<size_t> &channels, float *const *out) const;
+
+ private:
+  mio::mmap_source mmap;
+  Bw64Format format_;
+  size_t data_offset = 0;
+  size_t num_frames_ = 0;
+};
+
+/// Writer for WAV files which become BW64 (with a ds64 chunk) if they grow
+/// past 4GB. Space for the ds64 chunk is reserved by a JUNK chunk, as
+/// recommended by BS.2088.
+class Bw64Writer {
+ public:
+  Bw64Writer(const std::string &path, const Bw64Format &format);
+  ~Bw64Writer();
+
+  Bw64Writer(const Bw64Writer &) = delete;
+  Bw64Writer &operator=(const Bw64Writer &) = delete;
+
+  const Bw64Format &format() const { return format_; }
+  size_t num_frames() const { return num_frames_; }
+
+  /// write num_frames frames after the end of the file, with one pointer per
+  /// channel in in; samples outside [-1, 1) are clipped for integer formats
+  void write(const float *const *in, size_t num_frames);
+
+  /// write num_frames frames starting at frame start, like write; this may
+  /// overwrite earlier frames or leave a gap, which reads as silence
+  void write_at(size_t start, const float *const *in, size_t num_frames);
+
+  /// write the chunk sizes and close the file; this is called by the
+  /// destructor, but errors are only reported if it is called explicitly
+  void close();
+
+ private:
+  Bw64Format format_;
+  std::ofstream file;
+  size_t num_frames_ = 0;
+  std::vector<char> buffer;
+};
+
+}  // namespace bear
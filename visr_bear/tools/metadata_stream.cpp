@@ -0,0 +1,220 @@
+#include "metadata_stream.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+
+namespace bear {
+
+namespace {
+  using rapidjson::Value;
+
+  void check(bool x, const std::string &message)
+  {
+    if (!x) throw std::runtime_error("metadata stream error: " + message);
+  }
+
+  const Value &get_member(const Value &v, const char *name)
+  {
+    check(v.IsObject(), std::string("expected an object containing ") + name);
+    auto it = v.FindMember(name);
+    check(it != v.MemberEnd(), std::string("missing ") + name);
+    return it->value;
+  }
+
+  /// find an optional member; returns nullptr if missing or null
+  const Value *find_member(const Value &v, const char *name)
+  {
+    auto it = v.FindMember(name);
+    if (it == v.MemberEnd() || it->value.IsNull()) return nullptr;
+    return &it->value;
+  }
+
+  double get_double(const Value &v, const char *name)
+  {
+    const Value &m = get_member(v, name);
+    check(m.IsNumber(), std::string(name) + " must be a number");
+    return m.GetDouble();
+  }
+
+  double get_double(const Value &v, const char *name, double default_value)
+  {
+    return find_member(v, name) ? get_double(v, name) : default_value;
+  }
+
+  Value::ConstArray get_array(const Value &v, const char *name)
+  {
+    const Value &m = get_member(v, name);
+    check(m.IsArray(), std::string(name) + " must be an array");
+    return m.GetArray();
+  }
+
+  boost::optional<size_t> load_track(const Value &v)
+  {
+    if (v.IsNull()) return boost::none;
+    check(v.IsUint(), "track must be an unsigned integer or null");
+    return static_cast<size_t>(v.GetUint());
+  }
+
+  boost::optional<Time> load_time(const Value &v, const char *name)
+  {
+    const Value *m = find_member(v, name);
+    if (!m) return boost::none;
+    check(m->IsArray() && m->Size() == 2 && (*m)[0].IsInt64() && (*m)[1].IsInt64() && (*m)[1].GetInt64() > 0,
+          std::string(name) + " must be [numerator, denominator]");
+    return Time{(*m)[0].GetInt64(), (*m)[1].GetInt64()};
+  }
+
+  void load_common(const Value &block_j, MetadataInput &block)
+  {
+    block.rtime = load_time(block_j, "rtime");
+    block.duration = load_time(block_j, "duration");
+    if (find_member(block_j, "absoluteDistance"))
+      block.audioPackFormat_data.absoluteDistance = get_double(block_j, "absoluteDistance");
+  }
+
+  ObjectsInput load_objects_block(const Value &block_j)
+  {
+    ObjectsInput block;
+    load_common(block_j, block);
+    block.interpolationLength = load_time(block_j, "interpolationLength");
+
+    const Value &position_j = get_member(block_j, "position");
+    block.type_metadata.position = ear::PolarPosition{get_double(position_j, "azimuth"),
+                                                      get_double(position_j, "elevation"),
+                                                      get_double(position_j, "distance", 1.0)};
+    block.type_metadata.gain = get_double(block_j, "gain", 1.0);
+    block.type_metadata.width = get_double(block_j, "width", 0.0);
+    block.type_metadata.height = get_double(block_j, "height", 0.0);
+    block.type_metadata.depth = get_double(block_j, "depth", 0.0);
+    block.type_metadata.diffuse = get_double(block_j, "diffuse", 0.0);
+
+    return block;
+  }
+
+  DirectSpeakersInput load_direct_speakers_block(const Value &block_j)
+  {
+    DirectSpeakersInput block;
+    load_common(block_j, block);
+
+    const Value &position_j = get_member(block_j, "position");
+    block.type_metadata.position = ear::PolarSpeakerPosition{get_double(position_j, "azimuth"),
+                                                             get_double(position_j, "elevation"),
+                                                             get_double(position_j, "distance", 1.0)};
+
+    if (const Value *labels_j = find_member(block_j, "speakerLabels")) {
+      check(labels_j->IsArray(), "speakerLabels must be an array");
+      for (const Value &label_j : labels_j->GetArray()) {
+        check(label_j.IsString(), "speakerLabels must contain strings");
+        block.type_metadata.speakerLabels.push_back(label_j.GetString());
+      }
+    }
+
+    if (const Value *id_j = find_member(block_j, "audioPackFormatID")) {
+      check(id_j->IsString(), "audioPackFormatID must be a string");
+      block.type_metadata.audioPackFormatID = std::string(id_j->GetString());
+    }
+
+    return block;
+  }
+
+  HOAInput load_hoa_block(const Value &block_j, size_t start_channel, size_t num_channels)
+  {
+    HOAInput block;
+    load_common(block_j, block);
+
+    for (const Value &order_j : get_array(block_j, "orders")) {
+      check(order_j.IsInt(), "orders must contain integers");
+      block.type_metadata.orders.push_back(order_j.GetInt());
+    }
+    for (const Value &degree_j : get_array(block_j, "degrees")) {
+      check(degree_j.IsInt(), "degrees must contain integers");
+      block.type_metadata.degrees.push_back(degree_j.GetInt());
+    }
+    check(block.type_metadata.orders.size() == num_channels, "wrong number of orders");
+    check(block.type_metadata.degrees.size() == num_channels, "wrong number of degrees");
+
+    if (const Value *normalization_j = find_member(block_j, "normalization")) {
+      check(normalization_j->IsString(), "normalization must be a string");
+      block.type_metadata.normalization = normalization_j->GetString();
+    }
+
+    for (size_t i = 0; i < num_channels; i++) block.channels.push_back(start_channel + i);
+
+    return block;
+  }
+}  // namespace
+
+size_t MetadataStream::num_hoa_channels() const
+{
+  size_t n = 0;
+  for (auto &stream : hoa) n += stream.tracks.size();
+  return n;
+}
+
+MetadataStream parse_metadata_stream_json(const std::string &json)
+{
+  rapidjson::Document doc;
+  doc.Parse(json.c_str(), json.size());
+  if (doc.HasParseError())
+    throw std::runtime_error(std::string("metadata stream error: ") +
+                             rapidjson::GetParseError_En(doc.GetParseError()) + " at offset " +
+                             std::to_string(doc.GetErrorOffset()));
+
+  const Value &version_j = get_member(doc, "version");
+  check(version_j.IsInt() && version_j.GetInt() == 0, "unsupported version");
+
+  MetadataStream stream;
+
+  if (const Value *objects_j = find_member(doc, "objects")) {
+    check(objects_j->IsArray(), "objects must be an array");
+    for (const Value &item_j : objects_j->GetArray()) {
+      ObjectsStream item;
+      item.track = load_track(get_member(item_j, "track"));
+      for (const Value &block_j : get_array(item_j, "blocks"))
+        item.blocks.push_back(load_objects_block(block_j));
+      stream.objects.push_back(std::move(item));
+    }
+  }
+
+  if (const Value *direct_speakers_j = find_member(doc, "direct_speakers")) {
+    check(direct_speakers_j->IsArray(), "direct_speakers must be an array");
+    for (const Value &item_j : direct_speakers_j->GetArray()) {
+      DirectSpeakersStream item;
+      item.track = load_track(get_member(item_j, "track"));
+      for (const Value &block_j : get_array(item_j, "blocks"))
+        item.blocks.push_back(load_direct_speakers_block(block_j));
+      stream.direct_speakers.push_back(std::move(item));
+    }
+  }
+
+  if (const Value *hoa_j = find_member(doc, "hoa")) {
+    check(hoa_j->IsArray(), "hoa must be an array");
+    size_t start_channel = 0;
+    for (const Value &item_j : hoa_j->GetArray()) {
+      HOAStream item;
+      for (const Value &track_j : get_array(item_j, "tracks")) item.tracks.push_back(load_track(track_j));
+      for (const Value &block_j : get_array(item_j, "blocks"))
+        item.blocks.push_back(load_hoa_block(block_j, start_channel, item.tracks.size()));
+      start_channel += item.tracks.size();
+      stream.hoa.push_back(std::move(item));
+    }
+  }
+
+  return stream;
+}
+
+MetadataStream read_metadata_stream_json(const std::string &path)
+{
+  std::ifstream file(path);
+  if (!file) throw std::runtime_error("could not open " + path);
+
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return parse_metadata_stream_json(contents.str());
+}
+
+}  // namespace bear
@@ -0,0 +1,80 @@
+#pragma once
+#include <boost/optional.hpp>
+#include <string>
+#include <vector>
+
+#include "bear/api.hpp"
+
+namespace bear {
+
+/// metadata for one Objects channel of the renderer
+struct ObjectsStream {
+  /// input file track, or none if silent
+  boost::optional<size_t> track;
+  std::vector<ObjectsInput> blocks;
+};
+
+/// metadata for one DirectSpeakers channel of the renderer
+struct DirectSpeakersStream {
+  boost::optional<size_t> track;
+  std::vector<DirectSpeakersInput> blocks;
+};
+
+/// metadata for one HOA stream of the renderer; the channels of each block
+/// refer to renderer HOA channels, numbered in order over all streams
+struct HOAStream {
+  /// input file track for each channel, or none if silent
+  std::vector<boost::optional<size_t>> tracks;
+  std::vector<HOAInput> blocks;
+};
+
+/// metadata for all items in a programme, extracted from the ADM by
+/// bear-extract-metadata
+///
+/// The accessors are the same as MetadataFile, so either can be used with
+/// MetadataPlayer and render_offline.
+struct MetadataStream {
+  std::vector<ObjectsStream> objects;
+  std::vector<DirectSpeakersStream> direct_speakers;
+  std::vector<HOAStream> hoa;
+
+  size_t num_objects_channels() const { return objects.size(); }
+  boost::optional<size_t> objects_track(size_t channel) const { return objects.at(channel).track; }
+  size_t num_objects_blocks(size_t channel) const { return objects.at(channel).blocks.size(); }
+  const ObjectsInput &objects_block(size_t channel, size_t block) const
+  {
+    return objects.at(channel).blocks.at(block);
+  }
+
+  size_t num_direct_speakers_channels() const { return direct_speakers.size(); }
+  boost::optional<size_t> direct_speakers_track(size_t channel) const
+  {
+    return direct_speakers.at(channel).track;
+  }
+  size_t num_direct_speakers_blocks(size_t channel) const
+  {
+    return direct_speakers.at(channel).blocks.size();
+  }
+  const DirectSpeakersInput &direct_speakers_block(size_t channel, size_t block) const
+  {
+    return direct_speakers.at(channel).blocks.at(block);
+  }
+
+  size_t num_hoa_streams() const { return hoa.size(); }
+  size_t num_hoa_channels() const;
+  const std::vector<boost::optional<size_t>> &hoa_tracks(size_t stream) const
+  {
+    return hoa.at(stream).tracks;
+  }
+  size_t num_hoa_blocks(size_t stream) const { return hoa.at(stream).blocks.size(); }
+  const HOAInput &hoa_block(size_t stream, size_t block) const { return hoa.at(stream).blocks.at(block); }
+};
+
+/// parse a JSON metadata stream; throws std::runtime_error if it is not
+/// valid
+MetadataStream parse_metadata_stream_json(const std::string &json);
+
+/// read a JSON metadata stream from a file
+MetadataStream read_metadata_stream_json(const std::string &path);
+
+}  // namespace bear
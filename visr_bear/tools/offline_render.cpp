@@ -0,0 +1,228 @@
+#include "offline_render.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace bear {
+
+namespace {
+  template <typename Source>
+  Config make_config(const OfflineRenderOptions &options, const Source &metadata, size_t sample_rate)
+  {
+    Config config;
+    config.set_num_objects_channels(metadata.num_objects_channels());
+    config.set_num_direct_speakers_channels(metadata.num_direct_speakers_channels());
+    config.set_num_hoa_channels(metadata.num_hoa_channels());
+    config.set_period_size(options.block_size);
+    config.set_sample_rate(sample_rate);
+    config.set_data_path(options.data_path);
+    config.set_fft_implementation(options.fft_implementation);
+    // the whole file is read once, start to end
+    config.set_data_file_advice("sequential");
+    return config;
+  }
+
+  /// renderer input buffers for all channel types, and the mapping from
+  /// input file tracks to buffers; silent channels stay zero
+  struct InputBuffers {
+    template <typename Source>
+    InputBuffers(const Source &metadata, size_t block_size)
+        : buffers(metadata.num_objects_channels() + metadata.num_direct_speakers_channels() +
+                      metadata.num_hoa_channels(),
+                  std::vector<float>(block_size, 0.0f))
+    {
+      size_t channel = 0;
+      auto add_channel = [&](const boost::optional<size_t> &track) {
+        if (track) {
+          tracks.push_back(*track);
+          track_ptrs.push_back(buffers[channel].data());
+        }
+        ptrs.push_back(buffers[channel].data());
+        channel++;
+      };
+
+      for (size_t i = 0; i < metadata.num_objects_channels(); i++) add_channel(metadata.objects_track(i));
+      for (size_t i = 0; i < metadata.num_direct_speakers_channels(); i++)
+        add_channel(metadata.direct_speakers_track(i));
+      for (size_t i = 0; i < metadata.num_hoa_streams(); i++)
+        for (auto &track : metadata.hoa_tracks(i)) add_channel(track);
+
+      objects = ptrs.data();
+      direct_speakers = objects + metadata.num_objects_channels();
+      hoa = direct_speakers + metadata.num_direct_speakers_channels();
+    }
+
+    std::vector<std::vector<float>> buffers;
+    std::vector<float *> ptrs;
+
+    /// input file track for each non-silent channel
+    std::vector<size_t> tracks;
+    std::vector<float *> track_ptrs;
+
+    float *const *objects;
+    float *const *direct_speakers;
+    float *const *hoa;
+  };
+
+  /// render frames start to end of in into out, returning the peak output
+  /// sample value
+  template <typename Source>
+  float render_chunk(const Bw64Reader &in,
+                     const Source &metadata,
+                     Bw64Writer &out,
+                     std::mutex &out_mutex,
+                     const OfflineRenderOptions &options,
+                     size_t start,
+                     size_t end)
+  {
+    const size_t block_size = options.block_size;
+    const int64_t sample_rate = static_cast<int64_t>(in.format().sample_rate);
+
+    Renderer renderer(make_config(options, metadata, in.format().sample_rate));
+
+    // start is a whole number of blocks, so rendering from render_start keeps
+    // the blocks aligned with a render of the whole file
+    size_t preroll = (renderer.get_preroll_samples() + block_size - 1) / block_size * block_size;
+    size_t render_start = start > preroll ? start - preroll : 0;
+    Time render_start_time{static_cast<int64_t>(render_start), sample_rate};
+    renderer.set_block_start_time(render_start_time);
+
+    MetadataPlayer<Source> player(metadata, render_start_time);
+    InputBuffers input(metadata, block_size);
+
+    std::vector<std::vector<float>> output_buffers(2, std::vector<float>(block_size, 0.0f));
+    float *output[2] = {output_buffers[0].data(), output_buffers[1].data()};
+
+    float peak = 0.0f;
+    for (size_t pos = render_start; pos < end; pos += block_size) {
+      player.push(renderer);
+
+      // the last block is zero-padded by read
+      in.read(pos, block_size, input.tracks, input.track_ptrs.data());
+
+      renderer.process(input.objects, input.direct_speakers, input.hoa, output);
+
+      if (pos < start) continue;
+
+      size_t n = std::min(block_size, end - pos);
+      for (size_t ch = 0; ch < 2; ch++)
+        for (size_t i = 0; i < n; i++) {
+          output[ch][i] *= options.output_gain;
+          peak = std::max(peak, std::abs(output[ch][i]));
+        }
+
+      std::lock_guard<std::mutex> lock(out_mutex);
+      out.write_at(pos, output, n);
+    }
+
+    return peak;
+  }
+
+  template <typename Source>
+  OfflineRenderStats render(const Bw64Reader &in,
+                            const Source &metadata,
+                            Bw64Writer &out,
+                            const OfflineRenderOptions &options)
+  {
+    if (out.format().num_channels != 2) throw std::invalid_argument("output must have two channels");
+    if (out.format().sample_rate != in.format().sample_rate)
+      throw std::invalid_argument("input and output sample rates must match");
+    if (options.block_size == 0) throw std::invalid_argument("block size must be positive");
+
+    for (size_t track : InputBuffers(metadata, 0).tracks)
+      if (track >= in.format().num_channels)
+        throw std::invalid_argument("metadata refers to track " + std::to_string(track) +
+                                    " but the input has " + std::to_string(in.format().num_channels) +
+                                    " channels");
+
+    const size_t block_size = options.block_size;
+    const size_t num_frames = in.num_frames();
+
+    size_t num_threads = options.num_threads;
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    size_t chunk_frames = options.chunk_frames;
+    if (chunk_frames == 0) chunk_frames = (num_frames + num_threads - 1) / num_threads;
+    size_t chunk_blocks = std::max<size_t>((chunk_frames + block_size - 1) / block_size, 1);
+    chunk_frames = chunk_blocks * block_size;
+    size_t num_chunks = (num_frames + chunk_frames - 1) / chunk_frames;
+
+    std::vector<float> peaks(num_chunks, 0.0f);
+    std::atomic<size_t> next_chunk{0};
+    std::mutex out_mutex;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+      while (true) {
+        size_t chunk = next_chunk++;
+        if (chunk >= num_chunks) return;
+
+        size_t start = chunk * chunk_frames;
+        size_t end = std::min(start + chunk_frames, num_frames);
+        try {
+          peaks[chunk] = render_chunk(in, metadata, out, out_mutex, options, start, end);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) error = std::current_exception();
+          // stop the other threads starting new chunks
+          next_chunk = num_chunks;
+          return;
+        }
+      }
+    };
+
+    num_threads = std::min(num_threads, num_chunks);
+    if (num_threads <= 1)
+      worker();
+    else {
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < num_threads; i++) threads.emplace_back(worker);
+      for (auto &thread : threads) thread.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+
+    OfflineRenderStats stats;
+    stats.num_frames = num_frames;
+    for (float peak : peaks) stats.peak = std::max(stats.peak, peak);
+    return stats;
+  }
+}  // namespace
+
+Config make_offline_config(const OfflineRenderOptions &options,
+                           const MetadataStream &metadata,
+                           size_t sample_rate)
+{
+  return make_config(options, metadata, sample_rate);
+}
+
+Config make_offline_config(const OfflineRenderOptions &options,
+                           const MetadataFile &metadata,
+                           size_t sample_rate)
+{
+  return make_config(options, metadata, sample_rate);
+}
+
+OfflineRenderStats render_offline(const Bw64Reader &in,
+                                  const MetadataStream &metadata,
+                                  Bw64Writer &out,
+                                  const OfflineRenderOptions &options)
+{
+  return render(in, metadata, out, options);
+}
+
+OfflineRenderStats render_offline(const Bw64Reader &in,
+                                  const MetadataFile &metadata,
+                                  Bw64Writer &out,
+                                  const OfflineRenderOptions &options)
+{
+  return render(in, metadata, out, options);
+}
+
+}  // namespace bear
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+
+#include "bw64.hpp"
+#include "metadata_file.hpp"
+#include "metadata_stream.hpp"
+
+namespace bear {
+
+struct OfflineRenderOptions {
+  std::string data_path;
+  std::string fft_implementation = "default";
+  /// period size of the renderer; offline rendering is more efficient with
+  /// large blocks
+  size_t block_size = 4096;
+  /// linear gain applied to the output
+  float output_gain = 1.0f;
+
+  /// number of threads to render with, or 0 to use one per core
+  size_t num_threads = 1;
+  /// length of the chunks which are rendered independently, rounded up to a
+  /// whole number of blocks; 0 splits the input into one chunk per thread
+  size_t chunk_frames = 0;
+};
+
+struct OfflineRenderStats {
+  size_t num_frames = 0;
+  /// peak absolute output sample value, including the output gain
+  float peak = 0.0f;
+};
+
+/// make a renderer Config for rendering metadata from a file with the given
+/// sample rate
+Config make_offline_config(const OfflineRenderOptions &options,
+                           const MetadataStream &metadata,
+                           size_t sample_rate);
+Config make_offline_config(const OfflineRenderOptions &options,
+                           const MetadataFile &metadata,
+                           size_t sample_rate);
+
+/// render all of in to out, which must have two channels and the same sample
+/// rate as in, with metadata from a JSON metadata stream or binary metadata
+/// file
+///
+/// The output has the same length as the input; the renderer delay is not
+/// compensated, matching bear-render.
+///
+/// The input is split into chunks, which are rendered in parallel, each on
+/// its own Renderer. Each chunk starts early by the renderer preroll length
+/// (see Renderer::get_preroll_samples), with the block grid aligned to the
+/// start of the file, so the output is the same as if the whole file were
+/// rendered at once.
+OfflineRenderStats render_offline(const Bw64Reader &in,
+                                  const MetadataStream &metadata,
+                                  Bw64Writer &out,
+                                  const OfflineRenderOptions &options);
+OfflineRenderStats render_offline(const Bw64Reader &in,
+                                  const MetadataFile &metadata,
+                                  Bw64Writer &out,
+                                  const OfflineRenderOptions &options);
+
+}  // namespace bear
@@ -0,0 +1,417 @@
+#include "render_client.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "render_service_protocol.hpp"
+
+namespace bear {
+
+using namespace render_service;
+
+namespace {
+  /// maximum time to wait for the service before checking that it is still
+  /// connected
+  constexpr std::chrono::milliseconds check_interval{50};
+
+  uint32_t handshake_value(size_t value, const char *name)
+  {
+    if (value > UINT32_MAX) throw std::invalid_argument(std::string(name) + " out of range");
+    return static_cast<uint32_t>(value);
+  }
+
+  Handshake make_handshake(size_t period_size, const RenderClientOptions &options)
+  {
+    Handshake handshake;
+    handshake.period_size = handshake_value(period_size, "period_size");
+    handshake.max_objects_channels = handshake_value(options.max_objects_channels, "max_objects_channels");
+    handshake.max_direct_speakers_channels =
+        handshake_value(options.max_direct_speakers_channels, "max_direct_speakers_channels");
+    handshake.max_hoa_channels = handshake_value(options.max_hoa_channels, "max_hoa_channels");
+    handshake.num_slots = handshake_value(options.latency_periods + 1, "latency_periods");
+    handshake.message_ring_size = handshake_value(options.message_buffer_size, "message_buffer_size");
+    check_handshake(handshake);
+    return handshake;
+  }
+}  // namespace
+
+class RenderClientImpl {
+ public:
+  RenderClientImpl(const std::string &socket_path, size_t period_size, const RenderClientOptions &options)
+      : period_size(period_size),
+        latency_periods(options.latency_periods),
+        timeout(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options.timeout))),
+        zeros(period_size, 0.0f)
+  {
+    Handshake handshake = make_handshake(period_size, options);
+
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+      throw std::invalid_argument("invalid render service socket path: " + socket_path);
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket < 0)
+      throw std::runtime_error(std::string("render service: could not create socket: ") +
+                               std::strerror(errno));
+
+    try {
+      if (connect(socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0)
+        throw std::runtime_error("render service: could not connect to " + socket_path + ": " +
+                                 std::strerror(errno));
+
+      send_all(socket, &handshake, sizeof(handshake));
+
+      HandshakeReply reply;
+      std::vector<int> fds;
+      bool received = receive_all(socket, &reply, sizeof(reply), &fds, 2);
+      try {
+        if (!received) throw std::runtime_error("render service: connection closed during handshake");
+        if (!reply.ok)
+          throw std::runtime_error("render service: " +
+                                   std::string(reply.error, strnlen(reply.error, error_length)));
+        if (fds.size() != 2) throw std::runtime_error("render service: expected shared memory from service");
+      } catch (...) {
+        for (int fd : fds) close(fd);
+        throw;
+      }
+
+      try {
+        doorbell_mapping = SharedMapping(fds[1], sizeof(Doorbell));
+      } catch (...) {
+        close(fds[0]);
+        throw;
+      }
+      session = SessionMemory(fds[0], handshake);
+    } catch (...) {
+      close(socket);
+      throw;
+    }
+  }
+
+  ~RenderClientImpl() { close(socket); }
+
+  void set_config(const Config &config)
+  {
+    check_config(config);
+    send(MessageType::CONFIG, encode_config(config.get_impl()));
+
+    sample_rate = config.get_sample_rate();
+    next_config = config.get_impl();
+  }
+
+  void set_config_blocking(const Config &config)
+  {
+    check_config(config);
+    SessionHeader &header = session.header();
+    uint32_t errors_before = header.request_error.count.load(std::memory_order_acquire);
+
+    send(MessageType::CONFIG_BLOCKING, encode_config(config.get_impl()));
+    num_requests++;
+    ring_doorbell();
+    wait_for(header.replies.value, num_requests);
+
+    if (header.request_error.count.load(std::memory_order_acquire) != errors_before)
+      throw std::runtime_error(header.request_error.get());
+
+    sample_rate = config.get_sample_rate();
+    next_config = config.get_impl();
+  }
+
+  std::exception_ptr get_error()
+  {
+    SharedError &error = session.header().config_error;
+    uint32_t count = error.count.load(std::memory_order_acquire);
+    if (count == config_errors_seen) return nullptr;
+
+    config_errors_seen = count;
+    return std::make_exception_ptr(std::runtime_error(error.get()));
+  }
+
+  bool is_running() { return session.header().running.load(std::memory_order_relaxed) != 0; }
+
+  void process(size_t num_objects_channels,
+               const Sample *const *objects_input,
+               size_t num_direct_speakers_channels,
+               const Sample *const *direct_speakers_input,
+               size_t num_hoa_channels,
+               const Sample *const *hoa_input,
+               Sample *const *output)
+  {
+    const size_t num_channels[3] = {num_objects_channels, num_direct_speakers_channels, num_hoa_channels};
+    const Sample *const *inputs[3] = {objects_input, direct_speakers_input, hoa_input};
+
+    for (size_t type = 0; type < 3; type++)
+      for (size_t channel = 0; channel < std::min(num_channels[type], session.max_channels(type)); channel++)
+        std::copy_n(inputs[type][channel], period_size, input_buffer(type, channel));
+
+    process_buffers(num_objects_channels, num_direct_speakers_channels, num_hoa_channels);
+
+    for (size_t ear = 0; ear < 2; ear++) std::copy_n(output_buffer(ear), period_size, output[ear]);
+  }
+
+  void process_buffers(size_t num_objects_channels,
+                       size_t num_direct_speakers_channels,
+                       size_t num_hoa_channels)
+  {
+    check_failure();
+
+    // channels beyond the maximum are treated as missing; this is fine as
+    // check_config ensures that they are not used
+    uint32_t *slot_channels = session.num_channels(current_slot());
+    slot_channels[0] = static_cast<uint32_t>(std::min(num_objects_channels, session.max_channels(0)));
+    slot_channels[1] = static_cast<uint32_t>(std::min(num_direct_speakers_channels, session.max_channels(1)));
+    slot_channels[2] = static_cast<uint32_t>(std::min(num_hoa_channels, session.max_channels(2)));
+
+    SessionHeader &header = session.header();
+    num_submitted++;
+    header.submitted.value.store(static_cast<uint32_t>(num_submitted), std::memory_order_release);
+    ring_doorbell();
+
+    if (num_submitted > latency_periods)
+      wait_for(header.completed.value, static_cast<uint32_t>(num_submitted - latency_periods));
+  }
+
+  Sample *input_buffer(size_t type, size_t channel)
+  {
+    if (channel >= session.max_channels(type))
+      throw std::invalid_argument("channel number out of range in render client input buffer");
+    return session.input(current_slot(), type, channel);
+  }
+
+  const Sample *output_buffer(size_t ear) const
+  {
+    if (ear >= 2) throw std::invalid_argument("ear must be 0 or 1");
+    if (num_submitted <= latency_periods) return zeros.data();
+    return session.output((num_submitted - 1 - latency_periods) % session.num_slots(), ear);
+  }
+
+  bool add_objects_block(size_t channel, const ObjectsInput &metadata)
+  {
+    if (channel >= next_config.num_objects_channels)
+      throw std::invalid_argument("not enough channels configured to add block");
+    return add_block(MessageType::OBJECTS_BLOCK, channel, metadata);
+  }
+
+  bool add_direct_speakers_block(size_t channel, const DirectSpeakersInput &metadata)
+  {
+    if (channel >= next_config.num_direct_speakers_channels)
+      throw std::invalid_argument("not enough channels configured to add block");
+    return add_block(MessageType::DIRECT_SPEAKERS_BLOCK, channel, metadata);
+  }
+
+  bool add_hoa_block(size_t stream, const HOAInput &metadata)
+  {
+    for (size_t channel : metadata.channels)
+      if (channel >= next_config.num_hoa_channels)
+        throw std::invalid_argument("not enough channels configured to add block");
+    return add_block(MessageType::HOA_BLOCK, stream, metadata);
+  }
+
+  void set_block_start_time(const Time &time)
+  {
+    Time new_offset = get_raw_block_start_time() - time;
+    send(MessageType::BLOCK_START_TIME, encode_time(time));
+    time_offset = new_offset;
+  }
+
+  Time get_block_start_time() const { return get_raw_block_start_time() - time_offset; }
+
+  void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time)
+  {
+    send(MessageType::LISTENER, encode_listener(l, interpolation_time));
+  }
+
+ private:
+  /// the timing check is the same as DynamicRenderer; the service adds the
+  /// block before the same period, so will accept it too
+  template <typename T>
+  bool add_block(MessageType type, size_t index, const T &metadata)
+  {
+    std::vector<char> payload = encode_block(index, metadata);
+
+    if (!metadata.rtime || *metadata.rtime + time_offset < get_raw_next_block_start_time()) {
+      send(type, payload);
+      return true;
+    } else
+      return false;
+  }
+
+  void check_config(const Config &config) const
+  {
+    if (config.get_period_size() != period_size) throw std::logic_error("config has incorrect period size");
+    if (config.get_num_objects_channels() > session.max_channels(0) ||
+        config.get_num_direct_speakers_channels() > session.max_channels(1) ||
+        config.get_num_hoa_channels() > session.max_channels(2))
+      throw std::invalid_argument("config has more channels than the render client maximum");
+  }
+
+  Time get_raw_block_start_time() const
+  {
+    return {static_cast<int64_t>(num_submitted * period_size), static_cast<int64_t>(sample_rate)};
+  }
+
+  Time get_raw_next_block_start_time() const
+  {
+    return {static_cast<int64_t>((num_submitted + 1) * period_size), static_cast<int64_t>(sample_rate)};
+  }
+
+  size_t current_slot() const { return num_submitted % session.num_slots(); }
+
+  /// send a message to be applied before the next period
+  void send(MessageType type, const std::vector<char> &payload)
+  {
+    if (!session.push_message(type, static_cast<uint32_t>(num_submitted), payload))
+      throw std::runtime_error("render service: message buffer is full; increase message_buffer_size");
+  }
+
+  void ring_doorbell()
+  {
+    Doorbell &doorbell = *reinterpret_cast<Doorbell *>(doorbell_mapping.get_data());
+    doorbell.rings.value.fetch_add(1, std::memory_order_release);
+    futex_wake(doorbell.rings.value);
+  }
+
+  /// wait until counter reaches target, throwing if the session has failed,
+  /// the service has gone away, or it takes longer than the timeout
+  void wait_for(std::atomic<uint32_t> &counter, uint32_t target)
+  {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      uint32_t value = counter.load(std::memory_order_acquire);
+      if (reached(value, target)) return;
+
+      check_failure();
+      check_connected();
+      if (std::chrono::steady_clock::now() > deadline)
+        throw std::runtime_error("render service: timed out waiting for the service");
+
+      futex_wait(counter, value, check_interval);
+    }
+  }
+
+  void check_failure() const
+  {
+    SharedError &failure = session.header().failure;
+    if (failure.count.load(std::memory_order_acquire)) throw std::runtime_error(failure.get());
+  }
+
+  void check_connected() const
+  {
+    // the service sends nothing after the handshake, so the socket only
+    // becomes readable when it is closed
+    struct pollfd fd = {socket, POLLIN, 0};
+    if (::poll(&fd, 1, 0) > 0) throw std::runtime_error("render service: connection closed");
+  }
+
+  size_t period_size;
+  size_t latency_periods;
+  std::chrono::steady_clock::duration timeout;
+  std::vector<Sample> zeros;
+
+  int socket = -1;
+  SessionMemory session;
+  SharedMapping doorbell_mapping;
+
+  uint64_t num_submitted = 0;
+  uint32_t num_requests = 0;
+  uint32_t config_errors_seen = 0;
+
+  /// the state needed to check added blocks, as in DynamicRenderer
+  size_t sample_rate = 0;
+  Time time_offset;
+  ConfigImpl next_config;
+};
+
+RenderClient::RenderClient() {}
+
+RenderClient::RenderClient(const std::string &socket_path,
+                           size_t period_size,
+                           const RenderClientOptions &options)
+    : impl(std::make_unique<RenderClientImpl>(socket_path, period_size, options))
+{
+}
+
+RenderClient::RenderClient(RenderClient &&c) = default;
+
+RenderClient &RenderClient::operator=(RenderClient &&c) = default;
+
+RenderClient::~RenderClient() = default;
+
+void RenderClient::set_config(const Config &config) { impl->set_config(config); }
+
+void RenderClient::set_config_blocking(const Config &config) { impl->set_config_blocking(config); }
+
+std::exception_ptr RenderClient::get_error() { return impl->get_error(); }
+
+bool RenderClient::is_running() { return impl->is_running(); }
+
+void RenderClient::process(size_t num_objects_channels,
+                           const Sample *const *objects_input,
+                           size_t num_direct_speakers_channels,
+                           const Sample *const *direct_speakers_input,
+                           size_t num_hoa_channels,
+                           const Sample *const *hoa_input,
+                           Sample *const *output)
+{
+  impl->process(num_objects_channels,
+                objects_input,
+                num_direct_speakers_channels,
+                direct_speakers_input,
+                num_hoa_channels,
+                hoa_input,
+                output);
+}
+
+bool RenderClient::add_objects_block(size_t channel, ObjectsInput metadata)
+{
+  return impl->add_objects_block(channel, metadata);
+}
+
+bool RenderClient::add_direct_speakers_block(size_t channel, DirectSpeakersInput metadata)
+{
+  return impl->add_direct_speakers_block(channel, metadata);
+}
+
+bool RenderClient::add_hoa_block(size_t stream, HOAInput metadata)
+{
+  return impl->add_hoa_block(stream, metadata);
+}
+
+Time RenderClient::get_block_start_time() const { return impl->get_block_start_time(); }
+
+void RenderClient::set_block_start_time(const Time &time) { impl->set_block_start_time(time); }
+
+void RenderClient::set_listener(const Listener &l, const boost::optional<Time> &interpolation_time)
+{
+  impl->set_listener(l, interpolation_time);
+}
+
+Sample *RenderClient::objects_input_buffer(size_t channel) { return impl->input_buffer(0, channel); }
+
+Sample *RenderClient::direct_speakers_input_buffer(size_t channel) { return impl->input_buffer(1, channel); }
+
+Sample *RenderClient::hoa_input_buffer(size_t channel) { return impl->input_buffer(2, channel); }
+
+void RenderClient::process_buffers(size_t num_objects_channels,
+                                   size_t num_direct_speakers_channels,
+                                   size_t num_hoa_channels)
+{
+  impl->process_buffers(num_objects_channels, num_direct_speakers_channels, num_hoa_channels);
+}
+
+const Sample *RenderClient::output_buffer(size_t ear) const { return impl->output_buffer(ear); }
+
+}  // namespace bear
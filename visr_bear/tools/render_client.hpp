@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "bear/api.hpp"
+
+namespace bear {
+
+class RenderClientImpl;
+
+struct RenderClientOptions {
+  /// maximum number of channels of each type passed to process; set_config
+  /// throws if a configuration has more channels than this
+  size_t max_objects_channels = 64;
+  size_t max_direct_speakers_channels = 64;
+  size_t max_hoa_channels = 64;
+
+  /// number of periods by which the output of process is delayed. With 0,
+  /// process waits for the service to render each period; with n, the
+  /// service can render up to n periods while the client prepares the next
+  /// ones, and the first n outputs are silent.
+  size_t latency_periods = 0;
+
+  /// size in bytes of the buffer for calls made between process calls
+  /// (metadata, listener changes, etc.); must be a power of two
+  size_t message_buffer_size = 1 << 20;
+
+  /// time in seconds to wait for the service before throwing an exception
+  double timeout = 10.0;
+};
+
+/// Client for a RenderService, with an interface like DynamicRenderer.
+///
+/// Each client has its own session in the service, which renders with a
+/// DynamicRenderer given the same sequence of calls made to the client, so
+/// the output is the same as a local DynamicRenderer (delayed by
+/// latency_periods). The differences are:
+///
+/// - data paths in the configuration are opened by the service, so should be
+///   absolute
+/// - distance_behaviour can not be used in ObjectsInput, and only the
+///   metadata parameters which the renderer supports are sent
+/// - errors from set_config are returned from get_error as
+///   std::runtime_error containing the original message
+/// - is_running and get_error reflect the output of the last process call
+/// - get_delay, the load governor, and the other DynamicRenderer options
+///   (set_reconfigure_mode etc.) are not available, so the session always
+///   renders with the defaults
+///
+/// Metadata timing is checked by the client, so add_*_block returns
+/// immediately. Errors in the service (and loss of the connection) are
+/// thrown from the next call which waits for the service.
+///
+/// Like DynamicRenderer, methods must not be called concurrently.
+class RenderClient {
+ public:
+  /// connect to a service listening on socket_path; period_size is the
+  /// number of samples in each block
+  RenderClient(const std::string &socket_path,
+               size_t period_size,
+               const RenderClientOptions &options = RenderClientOptions());
+
+  RenderClient(RenderClient &&c);
+  RenderClient();
+  ~RenderClient();
+
+  RenderClient &operator=(RenderClient &&c);
+
+  // these methods behave like the DynamicRenderer methods with the same
+  // names, except as described above
+
+  void set_config(const Config &config);
+  void set_config_blocking(const Config &config);
+  std::exception_ptr get_error();
+  bool is_running();
+
+  void process(size_t num_objects_channels,
+               const Sample *const *objects_input,
+               size_t num_direct_speakers_channels,
+               const Sample *const *direct_speakers_input,
+               size_t num_hoa_channels,
+               const Sample *const *hoa_input,
+               Sample *const *output);
+
+  bool add_objects_block(size_t channel, ObjectsInput metadata);
+  bool add_direct_speakers_block(size_t channel, DirectSpeakersInput metadata);
+  bool add_hoa_block(size_t stream, HOAInput metadata);
+  Time get_block_start_time() const;
+  void set_block_start_time(const Time &time);
+  void set_listener(const Listener &l, const boost::optional<Time> &interpolation_time = {});
+
+  // zero-copy interface: rather than passing buffers to process, write the
+  // input directly into shared memory with the *_input_buffer pointers, call
+  // process_buffers, then read the output from output_buffer
+
+  /// buffers of period_size samples for the input to the next
+  /// process_buffers call; channel must be less than the corresponding
+  /// max_*_channels option
+  Sample *objects_input_buffer(size_t channel);
+  Sample *direct_speakers_input_buffer(size_t channel);
+  Sample *hoa_input_buffer(size_t channel);
+
+  /// process the data in the input buffers; the num_* arguments are the
+  /// same as process
+  void process_buffers(size_t num_objects_channels,
+                       size_t num_direct_speakers_channels,
+                       size_t num_hoa_channels);
+
+  /// output of the last process or process_buffers call for one ear (0 for
+  /// left, 1 for right), which is valid until the next call
+  const Sample *output_buffer(size_t ear) const;
+
+ private:
+  std::unique_ptr<RenderClientImpl> impl;
+};
+
+}  // namespace bear
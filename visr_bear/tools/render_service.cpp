@@ -0,0 +1,536 @@
+#include "render_service.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "config_impl.hpp"
+#include "dynamic_renderer.hpp"
+#include "panner_cache.hpp"
+#include "render_service_protocol.hpp"
+
+namespace bear {
+
+using namespace render_service;
+
+namespace {
+  /// time to wait for a new client to send its handshake
+  constexpr int handshake_timeout_seconds = 5;
+  /// maximum time that workers sleep for before checking whether to stop
+  constexpr std::chrono::milliseconds worker_poll_interval{100};
+
+  using Clock = std::chrono::steady_clock;
+
+  std::string error_message(std::exception_ptr error)
+  {
+    try {
+      std::rethrow_exception(error);
+    } catch (std::exception &e) {
+      return e.what();
+    } catch (...) {
+      return "unknown error";
+    }
+  }
+
+  /// one client session, rendered by a worker
+  class Session {
+   public:
+    Session(const Handshake &handshake, std::shared_ptr<PannerCache> panner_cache)
+        : memory(handshake),
+          renderer(handshake.period_size,
+                   std::max({handshake.max_objects_channels,
+                             handshake.max_direct_speakers_channels,
+                             handshake.max_hoa_channels})),
+          panner_cache(std::move(panner_cache)),
+          config_blocking_output(2 * handshake.period_size)
+    {
+      for (size_t type = 0; type < 3; type++) input_pointers[type].resize(memory.max_channels(type));
+    }
+
+    int get_fd() const { return memory.get_fd(); }
+
+    /// apply messages and process periods submitted by the client; returns
+    /// true if anything was done
+    bool poll()
+    {
+      if (failed) return false;
+
+      SessionHeader &header = memory.header();
+      bool did_work = false;
+      try {
+        while (true) {
+          // nothing after a CONFIG_BLOCKING message is handled until it has
+          // been replied to
+          if (config_blocking_pending) {
+            if (poll_config_blocking()) did_work = true;
+            if (config_blocking_pending) break;
+          }
+
+          // read submitted before the messages: the messages for a period
+          // are written before it is submitted
+          uint32_t submitted = header.submitted.value.load(std::memory_order_acquire);
+          uint32_t completed = header.completed.value.load(std::memory_order_relaxed);
+
+          for (boost::optional<uint32_t> period = memory.next_message_period();
+               period && reached(completed, *period) && !config_blocking_pending;
+               period = memory.next_message_period()) {
+            memory.pop_message(message);
+            apply_message();
+            did_work = true;
+          }
+
+          if (config_blocking_pending) continue;
+          if (reached(completed, submitted)) break;
+
+          process_period(completed % memory.num_slots());
+          header.completed.value.store(completed + 1, std::memory_order_release);
+          futex_wake(header.completed.value);
+          did_work = true;
+        }
+      } catch (std::exception &e) {
+        fail(e.what());
+      }
+      return did_work;
+    }
+
+    /// time by which poll must be called again even if the client does not
+    /// ring the doorbell, if any
+    boost::optional<Clock::time_point> next_poll_time() const
+    {
+      if (config_blocking_pending && !failed)
+        return config_blocking_next_period;
+      else
+        return boost::none;
+    }
+
+   private:
+    void process_period(size_t slot)
+    {
+      // the client is not trusted to write valid channel counts
+      const uint32_t *num_channels = memory.num_channels(slot);
+      size_t n[3];
+      for (size_t type = 0; type < 3; type++) {
+        n[type] = std::min<size_t>(num_channels[type], memory.max_channels(type));
+        for (size_t channel = 0; channel < n[type]; channel++)
+          input_pointers[type][channel] = memory.input(slot, type, channel);
+      }
+      Sample *output[2] = {memory.output(slot, 0), memory.output(slot, 1)};
+
+      renderer.process(n[0],
+                       input_pointers[0].data(),
+                       n[1],
+                       input_pointers[1].data(),
+                       n[2],
+                       input_pointers[2].data(),
+                       output);
+
+      SessionHeader &header = memory.header();
+      header.running.store(renderer.is_running(), std::memory_order_relaxed);
+      std::exception_ptr error = renderer.get_error();
+      if (error) header.config_error.set(error_message(error));
+    }
+
+    void apply_message()
+    {
+      size_t index;
+      switch (message.type) {
+        case MessageType::OBJECTS_BLOCK: {
+          ObjectsInput metadata;
+          decode_block(message.payload, index, metadata);
+          check_added(renderer.add_objects_block(index, std::move(metadata)));
+        } break;
+        case MessageType::DIRECT_SPEAKERS_BLOCK: {
+          DirectSpeakersInput metadata;
+          decode_block(message.payload, index, metadata);
+          check_added(renderer.add_direct_speakers_block(index, std::move(metadata)));
+        } break;
+        case MessageType::HOA_BLOCK: {
+          HOAInput metadata;
+          decode_block(message.payload, index, metadata);
+          check_added(renderer.add_hoa_block(index, std::move(metadata)));
+        } break;
+        case MessageType::LISTENER: {
+          Listener listener;
+          boost::optional<Time> interpolation_time;
+          decode_listener(message.payload, listener, interpolation_time);
+          renderer.set_listener(listener, interpolation_time);
+        } break;
+        case MessageType::BLOCK_START_TIME: {
+          Time time;
+          decode_time(message.payload, time);
+          renderer.set_block_start_time(time);
+        } break;
+        case MessageType::CONFIG: renderer.set_config(decode_message_config()); break;
+        case MessageType::CONFIG_BLOCKING: {
+          // constructing the renderer here would hold up the other sessions
+          // on this worker, so it is constructed in the background, and the
+          // reply is sent by poll_config_blocking
+          Config config = decode_message_config();
+          config_blocking_start_time = renderer.get_block_start_time();
+          renderer.set_config(config);
+          config_blocking_pending = true;
+          config_blocking_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+              static_cast<double>(config.get_period_size()) / config.get_sample_rate()));
+          config_blocking_next_period = Clock::now();
+        } break;
+      }
+    }
+
+    /// process one period of silence while waiting for the configuration
+    /// from a CONFIG_BLOCKING message, and reply once the renderer is
+    /// running or has failed; returns true if the reply was sent
+    ///
+    /// Silent periods are processed at most once per period length, as
+    /// construction may take seconds, and the worker should sleep meanwhile.
+    /// The block start time is then restored, so to the client this looks
+    /// like set_config_blocking, which takes no time.
+    bool poll_config_blocking()
+    {
+      Clock::time_point now = Clock::now();
+      if (now < config_blocking_next_period) return false;
+      config_blocking_next_period = now + config_blocking_period;
+
+      Sample *output[2] = {config_blocking_output.data(),
+                           config_blocking_output.data() + config_blocking_output.size() / 2};
+      renderer.process(0, nullptr, 0, nullptr, 0, nullptr, output);
+
+      SessionHeader &header = memory.header();
+      std::exception_ptr error = renderer.get_error();
+      if (error)
+        header.request_error.set(error_message(error));
+      else if (renderer.is_running())
+        renderer.set_block_start_time(config_blocking_start_time);
+      else
+        return false;
+
+      config_blocking_pending = false;
+      header.running.store(renderer.is_running(), std::memory_order_relaxed);
+      header.replies.value.fetch_add(1, std::memory_order_release);
+      futex_wake(header.replies.value);
+      return true;
+    }
+
+    Config decode_message_config()
+    {
+      Config config;
+      decode_config(message.payload, config.get_impl());
+      config.get_impl().panner_cache = panner_cache;
+      return config;
+    }
+
+    /// the client checks the timing of blocks before sending them, so this
+    /// should never fail
+    static void check_added(bool added)
+    {
+      if (!added) throw std::runtime_error("render service: metadata block was not accepted");
+    }
+
+    /// stop processing this session, and make the client throw message
+    void fail(const std::string &message)
+    {
+      failed = true;
+      SessionHeader &header = memory.header();
+      header.failure.set(message);
+      futex_wake(header.completed.value);
+      futex_wake(header.replies.value);
+    }
+
+    SessionMemory memory;
+    DynamicRenderer renderer;
+    std::shared_ptr<PannerCache> panner_cache;
+
+    Message message;
+    std::vector<const Sample *> input_pointers[3];
+    bool failed = false;
+
+    /// state while a CONFIG_BLOCKING message is waiting for a reply
+    bool config_blocking_pending = false;
+    Time config_blocking_start_time;
+    Clock::duration config_blocking_period;
+    /// time at which the next silent period should be processed
+    Clock::time_point config_blocking_next_period;
+    std::vector<Sample> config_blocking_output;
+  };
+
+  /// thread which renders some sessions, woken through a doorbell shared
+  /// with their clients
+  class Worker {
+   public:
+    Worker()
+        : panner_cache(std::make_shared<PannerCache>()),
+          doorbell_mapping(SharedMapping::create("bear-render-doorbell", sizeof(Doorbell)))
+    {
+      new (doorbell_mapping.get_data()) Doorbell();
+      thread = std::thread(&Worker::thread_fn, this);
+    }
+
+    ~Worker()
+    {
+      should_exit = true;
+      doorbell().rings.value.fetch_add(1, std::memory_order_release);
+      futex_wake(doorbell().rings.value);
+      thread.join();
+    }
+
+    void add(std::unique_ptr<Session> session)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      sessions.push_back(std::move(session));
+    }
+
+    void remove(const Session *session)
+    {
+      std::unique_ptr<Session> removed;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(sessions.begin(), sessions.end(), [&](const std::unique_ptr<Session> &s) {
+          return s.get() == session;
+        });
+        if (it == sessions.end()) return;
+        removed = std::move(*it);
+        sessions.erase(it);
+      }
+      // removed is destroyed here, without holding the lock, as this may
+      // wait for its renderer to be constructed
+    }
+
+    size_t get_num_sessions()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return sessions.size();
+    }
+
+    int get_doorbell_fd() const { return doorbell_mapping.get_fd(); }
+
+    const std::shared_ptr<PannerCache> panner_cache;
+
+   private:
+    Doorbell &doorbell() { return *reinterpret_cast<Doorbell *>(doorbell_mapping.get_data()); }
+
+    void thread_fn()
+    {
+      while (!should_exit) {
+        uint32_t rings = doorbell().rings.value.load(std::memory_order_acquire);
+
+        bool did_work = false;
+        Clock::time_point wake_time = Clock::now() + worker_poll_interval;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          for (auto &session : sessions) {
+            if (session->poll()) did_work = true;
+            boost::optional<Clock::time_point> poll_time = session->next_poll_time();
+            if (poll_time) wake_time = std::min(wake_time, *poll_time);
+          }
+        }
+
+        if (!did_work) {
+          Clock::duration timeout = std::max(wake_time - Clock::now(), Clock::duration::zero());
+          futex_wait(doorbell().rings.value, rings, timeout);
+        }
+      }
+    }
+
+    SharedMapping doorbell_mapping;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::atomic<bool> should_exit{false};
+    std::thread thread;
+  };
+
+  /// a client connection, and the session it controls
+  struct Connection {
+    int socket;
+    Worker *worker;
+    const Session *session;
+  };
+}  // namespace
+
+class RenderServiceImpl {
+ public:
+  RenderServiceImpl(const RenderServiceOptions &options) : socket_path(options.socket_path)
+  {
+    if (options.num_workers == 0) throw std::invalid_argument("render service needs at least one worker");
+
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+      throw std::invalid_argument("invalid render service socket path: " + socket_path);
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    try {
+      if (pipe2(stop_pipe, O_CLOEXEC) != 0) throw_system_error("could not create pipe");
+
+      listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if (listen_socket < 0) throw_system_error("could not create socket");
+
+      unlink(socket_path.c_str());
+      if (bind(listen_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0)
+        throw_system_error("could not bind to " + socket_path);
+      bound = true;
+      if (listen(listen_socket, 16) != 0) throw_system_error("could not listen on " + socket_path);
+
+      for (size_t i = 0; i < options.num_workers; i++) workers.push_back(std::make_unique<Worker>());
+
+      thread = std::thread(&RenderServiceImpl::thread_fn, this);
+    } catch (...) {
+      close_all();
+      throw;
+    }
+  }
+
+  ~RenderServiceImpl()
+  {
+    if (thread.joinable()) {
+      char c = 0;
+      while (write(stop_pipe[1], &c, 1) < 0 && errno == EINTR) {
+      }
+      thread.join();
+    }
+
+    close_all();
+  }
+
+  size_t get_num_sessions() const
+  {
+    size_t n = 0;
+    for (auto &worker : workers) n += worker->get_num_sessions();
+    return n;
+  }
+
+  size_t get_num_panners() const
+  {
+    size_t n = 0;
+    for (auto &worker : workers) n += worker->panner_cache->size();
+    return n;
+  }
+
+ private:
+  void close_all()
+  {
+    for (Connection &connection : connections) close(connection.socket);
+    connections.clear();
+    workers.clear();
+
+    if (listen_socket >= 0) close(listen_socket);
+    if (bound) unlink(socket_path.c_str());
+    for (int fd : stop_pipe)
+      if (fd >= 0) close(fd);
+  }
+
+  [[noreturn]] static void throw_system_error(const std::string &what)
+  {
+    throw std::runtime_error("render service: " + what + ": " + std::strerror(errno));
+  }
+
+  /// accept new connections, and end sessions when their connection closes
+  void thread_fn()
+  {
+    std::vector<struct pollfd> fds;
+    while (true) {
+      fds.clear();
+      fds.push_back({stop_pipe[0], POLLIN, 0});
+      fds.push_back({listen_socket, POLLIN, 0});
+      for (Connection &connection : connections) fds.push_back({connection.socket, POLLIN, 0});
+
+      if (::poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) continue;
+        return;
+      }
+
+      if (fds[0].revents) return;
+
+      // clients send nothing after the handshake, so any event means the
+      // connection was closed (or the client is misbehaving)
+      for (size_t i = connections.size(); i > 0; i--)
+        if (fds[i + 1].revents) {
+          Connection &connection = connections[i - 1];
+          connection.worker->remove(connection.session);
+          close(connection.socket);
+          connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(i - 1));
+        }
+
+      if (fds[1].revents & POLLIN) accept_connection();
+    }
+  }
+
+  void accept_connection()
+  {
+    int client = accept4(listen_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) return;
+
+    struct timeval timeout = {handshake_timeout_seconds, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    try {
+      Handshake handshake;
+      if (!receive_all(client, &handshake, sizeof(handshake))) {
+        close(client);
+        return;
+      }
+
+      HandshakeReply reply;
+      Worker *worker = nullptr;
+      std::unique_ptr<Session> session;
+      try {
+        check_handshake(handshake);
+        worker = std::min_element(workers.begin(),
+                                  workers.end(),
+                                  [](const std::unique_ptr<Worker> &a, const std::unique_ptr<Worker> &b) {
+                                    return a->get_num_sessions() < b->get_num_sessions();
+                                  })
+                     ->get();
+        session = std::make_unique<Session>(handshake, worker->panner_cache);
+        reply.ok = 1;
+      } catch (std::exception &e) {
+        std::strncpy(reply.error, e.what(), error_length - 1);
+      }
+
+      if (session) {
+        send_all(client, &reply, sizeof(reply), {session->get_fd(), worker->get_doorbell_fd()});
+        connections.push_back({client, worker, session.get()});
+        worker->add(std::move(session));
+      } else {
+        send_all(client, &reply, sizeof(reply));
+        close(client);
+      }
+    } catch (std::exception &) {
+      // the client went away during the handshake
+      close(client);
+    }
+  }
+
+  std::string socket_path;
+  int listen_socket = -1;
+  bool bound = false;
+  /// written to to stop thread
+  int stop_pipe[2] = {-1, -1};
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  /// only used by thread
+  std::vector<Connection> connections;
+  std::thread thread;
+};
+
+RenderService::RenderService(const RenderServiceOptions &options)
+    : impl(std::make_unique<RenderServiceImpl>(options))
+{
+}
+
+RenderService::~RenderService() = default;
+
+size_t RenderService::get_num_sessions() const { return impl->get_num_sessions(); }
+
+size_t RenderService::get_num_panners() const { return impl->get_num_panners(); }
+
+}  // namespace bear
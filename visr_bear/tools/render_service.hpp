@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace bear {
+
+class RenderServiceImpl;
+
+struct RenderServiceOptions {
+  /// path of the Unix domain socket to listen on; an existing socket at this
+  /// path is replaced
+  std::string socket_path;
+  /// number of threads which render sessions
+  size_t num_workers = 1;
+};
+
+/// Service which renders for clients in other processes (see RenderClient).
+///
+/// Each client session is rendered by a DynamicRenderer on one of the worker
+/// threads, with audio and calls exchanged through shared memory. New
+/// sessions are given to the worker with the fewest sessions.
+///
+/// All sessions on a worker which use the same data file share one Panner,
+/// so each data file is loaded at most once per worker rather than once per
+/// session. Panner can not be used by more than one thread at once, so it is
+/// not shared between workers.
+///
+/// The service runs on background threads between construction and
+/// destruction; destroying it ends all sessions.
+class RenderService {
+ public:
+  explicit RenderService(const RenderServiceOptions &options);
+  ~RenderService();
+
+  /// number of connected sessions
+  size_t get_num_sessions() const;
+  /// number of Panners loaded over all workers
+  size_t get_num_panners() const;
+
+ private:
+  std::unique_ptr<RenderServiceImpl> impl;
+};
+
+}  // namespace bear
@@ -0,0 +1,724 @@
+#include "render_service_protocol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace bear {
+namespace render_service {
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain integers");
+
+  namespace {
+    constexpr size_t alignment = 64;
+    constexpr size_t slot_header_size = 64;
+    /// size, type, period and padding
+    constexpr size_t message_header_size = 16;
+    /// maximum number of file descriptors sent in one message
+    constexpr size_t max_fds_per_message = 4;
+
+    size_t round_up(size_t n, size_t multiple) { return (n + multiple - 1) / multiple * multiple; }
+
+    std::runtime_error system_error(const std::string &what)
+    {
+      return std::runtime_error("render service: " + what + ": " + std::strerror(errno));
+    }
+
+    void check(bool x, const std::string &message)
+    {
+      if (!x) throw std::runtime_error("render service: " + message);
+    }
+
+    class Encoder {
+     public:
+      void write(uint64_t x) { write_value(x); }
+      void write(int64_t x) { write_value(x); }
+      void write(int32_t x) { write_value(x); }
+      void write(double x) { write_value(x); }
+      void write(bool x) { write_value<uint8_t>(x); }
+
+      void write(const std::string &s)
+      {
+        write(static_cast<uint64_t>(s.size()));
+        data.insert(data.end(), s.begin(), s.end());
+      }
+
+      void write(const Time &t)
+      {
+        write(static_cast<int64_t>(t.numerator()));
+        write(static_cast<int64_t>(t.denominator()));
+      }
+
+      template <typename T>
+      void write(const boost::optional<T> &x)
+      {
+        write(static_cast<bool>(x));
+        if (x) write(*x);
+      }
+
+      template <typename T>
+      void write(const std::vector<T> &v)
+      {
+        write(static_cast<uint64_t>(v.size()));
+        for (const T &x : v) write(x);
+      }
+
+      std::vector<char> data;
+
+     private:
+      template <typename T>
+      void write_value(T value)
+      {
+        static_assert(std::is_trivially_copyable<T>::value, "can only copy plain values");
+        const char *p = reinterpret_cast<const char *>(&value);
+        data.insert(data.end(), p, p + sizeof(T));
+      }
+    };
+
+    class Decoder {
+     public:
+      Decoder(const std::vector<char> &data) : data(data) {}
+
+      void read(uint64_t &x) { read_value(x); }
+      void read(int64_t &x) { read_value(x); }
+      void read(int32_t &x) { read_value(x); }
+      void read(double &x) { read_value(x); }
+
+      void read(bool &x)
+      {
+        uint8_t value;
+        read_value(value);
+        x = value != 0;
+      }
+
+      void read(std::string &s)
+      {
+        size_t size = read_size(1);
+        s.assign(data.data() + pos, size);
+        pos += size;
+      }
+
+      void read(Time &t)
+      {
+        int64_t numerator, denominator;
+        read(numerator);
+        read(denominator);
+        check(denominator > 0, "invalid time in message");
+        t = Time{numerator, denominator};
+      }
+
+      template <typename T>
+      void read(boost::optional<T> &x)
+      {
+        bool has_value;
+        read(has_value);
+        if (has_value) {
+          T value;
+          read(value);
+          x = value;
+        } else
+          x = boost::none;
+      }
+
+      template <typename T>
+      void read(std::vector<T> &v)
+      {
+        v.resize(read_size(1));
+        for (T &x : v) read(x);
+      }
+
+      template <typename T>
+      T read()
+      {
+        T x;
+        read(x);
+        return x;
+      }
+
+      /// check that the whole payload was used
+      void finish() { check(pos == data.size(), "unexpected data at the end of message"); }
+
+     private:
+      /// read a size of something with each element taking at least
+      /// element_size bytes, checking that it fits in the remaining data
+      size_t read_size(size_t element_size)
+      {
+        uint64_t size;
+        read(size);
+        check(size <= (data.size() - pos) / element_size, "truncated message");
+        return static_cast<size_t>(size);
+      }
+
+      template <typename T>
+      void read_value(T &value)
+      {
+        check(sizeof(T) <= data.size() - pos, "truncated message");
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+      }
+
+      const std::vector<char> &data;
+      size_t pos = 0;
+    };
+
+    // positions are sent as a tag followed by three coordinates; the
+    // speaker position bounds are not used by the renderer
+
+    template <typename Polar, typename Cartesian, typename Position>
+    void write_position(Encoder &e, const Position &position)
+    {
+      if (const Polar *polar = boost::get<Polar>(&position)) {
+        e.write(false);
+        e.write(polar->azimuth);
+        e.write(polar->elevation);
+        e.write(polar->distance);
+      } else {
+        const Cartesian &cart = boost::get<Cartesian>(position);
+        e.write(true);
+        e.write(cart.X);
+        e.write(cart.Y);
+        e.write(cart.Z);
+      }
+    }
+
+    template <typename Polar, typename Cartesian, typename Position>
+    void read_position(Decoder &d, Position &position)
+    {
+      if (!d.read<bool>()) {
+        Polar polar;
+        d.read(polar.azimuth);
+        d.read(polar.elevation);
+        d.read(polar.distance);
+        position = polar;
+      } else {
+        Cartesian cart;
+        d.read(cart.X);
+        d.read(cart.Y);
+        d.read(cart.Z);
+        position = cart;
+      }
+    }
+
+    void write_common(Encoder &e, size_t index, const MetadataInput &metadata)
+    {
+      e.write(static_cast<uint64_t>(index));
+      e.write(metadata.rtime);
+      e.write(metadata.duration);
+      e.write(metadata.audioPackFormat_data.absoluteDistance);
+    }
+
+    void read_common(Decoder &d, size_t &index, MetadataInput &metadata)
+    {
+      index = static_cast<size_t>(d.read<uint64_t>());
+      d.read(metadata.rtime);
+      d.read(metadata.duration);
+      d.read(metadata.audioPackFormat_data.absoluteDistance);
+    }
+  }  // namespace
+
+  void check_handshake(const Handshake &handshake)
+  {
+    if (handshake.magic != protocol_magic || handshake.version != protocol_version)
+      throw std::invalid_argument("render service protocol version mismatch");
+    if (handshake.period_size == 0 || handshake.period_size > 65536)
+      throw std::invalid_argument("render service period size out of range");
+    if (handshake.max_objects_channels > 4096 || handshake.max_direct_speakers_channels > 4096 ||
+        handshake.max_hoa_channels > 4096)
+      throw std::invalid_argument("render service channel count out of range");
+    if (handshake.num_slots == 0 || handshake.num_slots > 64)
+      throw std::invalid_argument("render service number of slots out of range");
+    uint32_t ring_size = handshake.message_ring_size;
+    if (ring_size < 4096 || ring_size > (1u << 30) || (ring_size & (ring_size - 1)) != 0)
+      throw std::invalid_argument("render service message ring size must be a power of two of at least 4096");
+  }
+
+  void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::nanoseconds timeout)
+  {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(seconds.count());
+    ts.tv_nsec = static_cast<long>((timeout - seconds).count());
+    // not FUTEX_PRIVATE_FLAG, as the word may be shared with another process
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+  }
+
+  void futex_wake(std::atomic<uint32_t> &word)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  void SharedError::set(const std::string &message)
+  {
+    size_t length = std::min(message.size(), error_length - 1);
+    std::memcpy(text, message.data(), length);
+    text[length] = '\0';
+    count.fetch_add(1, std::memory_order_release);
+  }
+
+  std::string SharedError::get() const { return std::string(text, strnlen(text, error_length)); }
+
+  SharedMapping::SharedMapping(int _fd, size_t _size) : fd(_fd), size(_size)
+  {
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      std::runtime_error error = system_error("could not map shared memory");
+      close(fd);
+      throw error;
+    }
+    data = static_cast<char *>(p);
+  }
+
+  SharedMapping::SharedMapping(SharedMapping &&other) { *this = std::move(other); }
+
+  SharedMapping &SharedMapping::operator=(SharedMapping &&other)
+  {
+    std::swap(fd, other.fd);
+    std::swap(size, other.size);
+    std::swap(data, other.data);
+    return *this;
+  }
+
+  SharedMapping::~SharedMapping()
+  {
+    if (data) munmap(data, size);
+    if (fd >= 0) close(fd);
+  }
+
+  SharedMapping SharedMapping::create(const std::string &name, size_t size)
+  {
+    int fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+    if (fd < 0) throw system_error("could not create shared memory");
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      std::runtime_error error = system_error("could not resize shared memory");
+      close(fd);
+      throw error;
+    }
+    return SharedMapping(fd, size);
+  }
+
+  size_t SessionMemory::size(const Handshake &handshake)
+  {
+    size_t num_buffers = handshake.max_objects_channels + handshake.max_direct_speakers_channels +
+                         handshake.max_hoa_channels + 2;
+    size_t slot_size =
+        slot_header_size + num_buffers * round_up(handshake.period_size * sizeof(Sample), alignment);
+    return round_up(sizeof(SessionHeader), alignment) + round_up(handshake.message_ring_size, alignment) +
+           handshake.num_slots * slot_size;
+  }
+
+  SessionMemory::SessionMemory(const Handshake &handshake)
+  {
+    check_handshake(handshake);
+    mapping = SharedMapping::create("bear-render-session", size(handshake));
+    new (mapping.get_data()) SessionHeader();
+    header().sizes = handshake;
+    init_layout();
+  }
+
+  SessionMemory::SessionMemory(int fd, const Handshake &handshake)
+  {
+    check_handshake(handshake);
+
+    // mapping a file which is too short would result in SIGBUS on access
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      std::runtime_error error = system_error("could not check shared memory");
+      close(fd);
+      throw error;
+    }
+    if (static_cast<size_t>(st.st_size) < size(handshake)) {
+      close(fd);
+      throw std::runtime_error("render service: shared memory is too small");
+    }
+
+    mapping = SharedMapping(fd, size(handshake));
+
+    const Handshake &sizes = header().sizes;
+    check(header().magic == protocol_magic && header().version == protocol_version &&
+              sizes.period_size == handshake.period_size &&
+              sizes.max_objects_channels == handshake.max_objects_channels &&
+              sizes.max_direct_speakers_channels == handshake.max_direct_speakers_channels &&
+              sizes.max_hoa_channels == handshake.max_hoa_channels &&
+              sizes.num_slots == handshake.num_slots &&
+              sizes.message_ring_size == handshake.message_ring_size,
+          "session does not match handshake");
+    init_layout();
+  }
+
+  void SessionMemory::init_layout()
+  {
+    const Handshake &sizes = header().sizes;
+    ring_offset = round_up(sizeof(SessionHeader), alignment);
+    slots_offset = ring_offset + round_up(sizes.message_ring_size, alignment);
+    channel_stride = round_up(sizes.period_size * sizeof(Sample), alignment);
+    size_t num_buffers =
+        sizes.max_objects_channels + sizes.max_direct_speakers_channels + sizes.max_hoa_channels + 2;
+    slot_size = slot_header_size + num_buffers * channel_stride;
+  }
+
+  size_t SessionMemory::max_channels(size_t type) const
+  {
+    const Handshake &sizes = header().sizes;
+    switch (type) {
+      case 0: return sizes.max_objects_channels;
+      case 1: return sizes.max_direct_speakers_channels;
+      case 2: return sizes.max_hoa_channels;
+      default: throw std::invalid_argument("unknown channel type");
+    }
+  }
+
+  uint32_t *SessionMemory::num_channels(size_t slot) const
+  {
+    return reinterpret_cast<uint32_t *>(mapping.get_data() + slots_offset + slot * slot_size);
+  }
+
+  Sample *SessionMemory::input(size_t slot, size_t type, size_t channel) const
+  {
+    size_t buffer = channel;
+    for (size_t i = 0; i < type; i++) buffer += max_channels(i);
+    char *slot_start = mapping.get_data() + slots_offset + slot * slot_size;
+    return reinterpret_cast<Sample *>(slot_start + slot_header_size + buffer * channel_stride);
+  }
+
+  Sample *SessionMemory::output(size_t slot, size_t ear) const { return input(slot, 3, ear); }
+
+  void SessionMemory::read_ring(uint64_t pos, char *out, size_t n) const
+  {
+    const char *ring = mapping.get_data() + ring_offset;
+    size_t ring_size = header().sizes.message_ring_size;
+    size_t offset = static_cast<size_t>(pos & (ring_size - 1));
+    size_t first = std::min(n, ring_size - offset);
+    std::memcpy(out, ring + offset, first);
+    std::memcpy(out + first, ring, n - first);
+  }
+
+  void SessionMemory::write_ring(uint64_t pos, const char *in, size_t n)
+  {
+    char *ring = mapping.get_data() + ring_offset;
+    size_t ring_size = header().sizes.message_ring_size;
+    size_t offset = static_cast<size_t>(pos & (ring_size - 1));
+    size_t first = std::min(n, ring_size - offset);
+    std::memcpy(ring + offset, in, first);
+    std::memcpy(ring, in + first, n - first);
+  }
+
+  bool SessionMemory::push_message(MessageType type, uint32_t period, const std::vector<char> &payload)
+  {
+    SessionHeader &h = header();
+    uint64_t total = message_header_size + round_up(payload.size(), 8);
+
+    uint64_t write_pos = h.message_write.load(std::memory_order_relaxed);
+    uint64_t read_pos = h.message_read.load(std::memory_order_acquire);
+    if (h.sizes.message_ring_size - (write_pos - read_pos) < total) return false;
+
+    uint32_t message_header[4] = {
+        static_cast<uint32_t>(payload.size()), static_cast<uint32_t>(type), period, 0};
+    write_ring(write_pos, reinterpret_cast<const char *>(message_header), message_header_size);
+    write_ring(write_pos + message_header_size, payload.data(), payload.size());
+
+    h.message_write.store(write_pos + total, std::memory_order_release);
+    return true;
+  }
+
+  boost::optional<uint32_t> SessionMemory::next_message_period() const
+  {
+    SessionHeader &h = header();
+    uint64_t read_pos = h.message_read.load(std::memory_order_relaxed);
+    uint64_t write_pos = h.message_write.load(std::memory_order_acquire);
+    if (read_pos == write_pos) return boost::none;
+
+    uint32_t message_header[4];
+    read_ring(read_pos, reinterpret_cast<char *>(message_header), message_header_size);
+    return message_header[2];
+  }
+
+  void SessionMemory::pop_message(Message &message)
+  {
+    SessionHeader &h = header();
+    uint64_t read_pos = h.message_read.load(std::memory_order_relaxed);
+    uint64_t write_pos = h.message_write.load(std::memory_order_acquire);
+
+    // the other side is not trusted to write valid messages
+    uint32_t message_header[4];
+    check(write_pos - read_pos >= message_header_size, "corrupt message ring");
+    read_ring(read_pos, reinterpret_cast<char *>(message_header), message_header_size);
+    uint64_t total = message_header_size + round_up(message_header[0], 8);
+    check(total <= write_pos - read_pos, "corrupt message ring");
+    check(message_header[1] <= static_cast<uint32_t>(MessageType::CONFIG_BLOCKING), "unknown message type");
+
+    message.type = static_cast<MessageType>(message_header[1]);
+    message.period = message_header[2];
+    message.payload.resize(message_header[0]);
+    read_ring(read_pos + message_header_size, message.payload.data(), message.payload.size());
+
+    h.message_read.store(read_pos + total, std::memory_order_release);
+  }
+
+  std::vector<char> encode_block(size_t index, const ObjectsInput &metadata)
+  {
+    if (metadata.distance_behaviour)
+      throw std::invalid_argument("distance_behaviour can not be used with the render service");
+
+    Encoder e;
+    write_common(e, index, metadata);
+    e.write(metadata.interpolationLength);
+    const ear::ObjectsTypeMetadata &tm = metadata.type_metadata;
+    write_position<ear::PolarPosition, ear::CartesianPosition>(e, tm.position);
+    e.write(tm.width);
+    e.write(tm.height);
+    e.write(tm.depth);
+    e.write(tm.gain);
+    e.write(tm.diffuse);
+    return std::move(e.data);
+  }
+
+  void decode_block(const std::vector<char> &payload, size_t &index, ObjectsInput &metadata)
+  {
+    Decoder d(payload);
+    read_common(d, index, metadata);
+    d.read(metadata.interpolationLength);
+    ear::ObjectsTypeMetadata &tm = metadata.type_metadata;
+    read_position<ear::PolarPosition, ear::CartesianPosition>(d, tm.position);
+    d.read(tm.width);
+    d.read(tm.height);
+    d.read(tm.depth);
+    d.read(tm.gain);
+    d.read(tm.diffuse);
+    d.finish();
+  }
+
+  std::vector<char> encode_block(size_t index, const DirectSpeakersInput &metadata)
+  {
+    Encoder e;
+    write_common(e, index, metadata);
+    const ear::DirectSpeakersTypeMetadata &tm = metadata.type_metadata;
+    write_position<ear::PolarSpeakerPosition, ear::CartesianSpeakerPosition>(e, tm.position);
+    e.write(tm.speakerLabels);
+    e.write(tm.channelFrequency.lowPass);
+    e.write(tm.channelFrequency.highPass);
+    e.write(tm.audioPackFormatID);
+    return std::move(e.data);
+  }
+
+  void decode_block(const std::vector<char> &payload, size_t &index, DirectSpeakersInput &metadata)
+  {
+    Decoder d(payload);
+    read_common(d, index, metadata);
+    ear::DirectSpeakersTypeMetadata &tm = metadata.type_metadata;
+    read_position<ear::PolarSpeakerPosition, ear::CartesianSpeakerPosition>(d, tm.position);
+    d.read(tm.speakerLabels);
+    d.read(tm.channelFrequency.lowPass);
+    d.read(tm.channelFrequency.highPass);
+    d.read(tm.audioPackFormatID);
+    d.finish();
+  }
+
+  std::vector<char> encode_block(size_t index, const HOAInput &metadata)
+  {
+    Encoder e;
+    write_common(e, index, metadata);
+    e.write(metadata.type_metadata.orders);
+    e.write(metadata.type_metadata.degrees);
+    e.write(metadata.type_metadata.normalization);
+    e.write(metadata.channels);
+    return std::move(e.data);
+  }
+
+  void decode_block(const std::vector<char> &payload, size_t &index, HOAInput &metadata)
+  {
+    Decoder d(payload);
+    read_common(d, index, metadata);
+    d.read(metadata.type_metadata.orders);
+    d.read(metadata.type_metadata.degrees);
+    d.read(metadata.type_metadata.normalization);
+    d.read(metadata.channels);
+    d.finish();
+  }
+
+  std::vector<char> encode_listener(const Listener &listener,
+                                    const boost::optional<Time> &interpolation_time)
+  {
+    Encoder e;
+    for (double x : listener.get_position_cart()) e.write(x);
+    for (double x : listener.get_orientation_quaternion()) e.write(x);
+    e.write(interpolation_time);
+    return std::move(e.data);
+  }
+
+  void decode_listener(const std::vector<char> &payload,
+                       Listener &listener,
+                       boost::optional<Time> &interpolation_time)
+  {
+    Decoder d(payload);
+    std::array<double, 3> position;
+    for (double &x : position) d.read(x);
+    std::array<double, 4> orientation;
+    for (double &x : orientation) d.read(x);
+    d.read(interpolation_time);
+    d.finish();
+
+    listener.set_position_cart(position);
+    listener.set_orientation_quaternion(orientation);
+  }
+
+  std::vector<char> encode_time(const Time &time)
+  {
+    Encoder e;
+    e.write(time);
+    return std::move(e.data);
+  }
+
+  void decode_time(const std::vector<char> &payload, Time &time)
+  {
+    Decoder d(payload);
+    d.read(time);
+    d.finish();
+  }
+
+  std::vector<char> encode_config(const ConfigImpl &config)
+  {
+    Encoder e;
+    e.write(static_cast<uint64_t>(config.num_objects_channels));
+    e.write(static_cast<uint64_t>(config.num_direct_speakers_channels));
+    e.write(static_cast<uint64_t>(config.num_hoa_channels));
+    e.write(static_cast<uint64_t>(config.period_size));
+    e.write(static_cast<uint64_t>(config.sample_rate));
+    e.write(config.data_path);
+    e.write(config.fft_implementation);
+    e.write(static_cast<uint64_t>(config.brir_view_cache_size));
+    e.write(config.listener_update_rate);
+    e.write(config.listener_orientation_hysteresis);
+    e.write(config.listener_position_hysteresis);
+    e.write(static_cast<int32_t>(config.max_hoa_order));
+    e.write(config.binaural_convolver);
+    e.write(config.data_file_advice);
+    e.write(config.data_file_huge_pages);
+    e.write(config.data_file_lock);
+    e.write(config.data_file_prefault);
+    e.write(static_cast<uint64_t>(config.max_brir_length));
+    e.write(config.enable_gain_norm);
+    e.write(config.enable_extent);
+    return std::move(e.data);
+  }
+
+  void decode_config(const std::vector<char> &payload, ConfigImpl &config)
+  {
+    Decoder d(payload);
+    config.num_objects_channels = static_cast<size_t>(d.read<uint64_t>());
+    config.num_direct_speakers_channels = static_cast<size_t>(d.read<uint64_t>());
+    config.num_hoa_channels = static_cast<size_t>(d.read<uint64_t>());
+    config.period_size = static_cast<size_t>(d.read<uint64_t>());
+    config.sample_rate = static_cast<size_t>(d.read<uint64_t>());
+    d.read(config.data_path);
+    d.read(config.fft_implementation);
+    config.brir_view_cache_size = static_cast<size_t>(d.read<uint64_t>());
+    d.read(config.listener_update_rate);
+    d.read(config.listener_orientation_hysteresis);
+    d.read(config.listener_position_hysteresis);
+    config.max_hoa_order = d.read<int32_t>();
+    d.read(config.binaural_convolver);
+    d.read(config.data_file_advice);
+    d.read(config.data_file_huge_pages);
+    d.read(config.data_file_lock);
+    d.read(config.data_file_prefault);
+    config.max_brir_length = static_cast<size_t>(d.read<uint64_t>());
+    d.read(config.enable_gain_norm);
+    d.read(config.enable_extent);
+    d.finish();
+  }
+
+  void send_all(int socket, const void *data, size_t size, const std::vector<int> &fds)
+  {
+    if (fds.size() > max_fds_per_message) throw std::invalid_argument("too many file descriptors to send");
+
+    const char *p = static_cast<const char *>(data);
+    bool send_fds = !fds.empty();
+    while (size > 0) {
+      struct iovec iov;
+      iov.iov_base = const_cast<char *>(p);
+      iov.iov_len = size;
+
+      struct msghdr msg = {};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+
+      alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_fds_per_message)];
+      if (send_fds) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+      }
+
+      ssize_t n = sendmsg(socket, &msg, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        throw system_error("could not send");
+      }
+      send_fds = false;
+      p += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+
+  bool receive_all(int socket, void *data, size_t size, std::vector<int> *fds, size_t max_fds)
+  {
+    char *p = static_cast<char *>(data);
+    size_t received = 0;
+    while (received < size) {
+      struct iovec iov;
+      iov.iov_base = p + received;
+      iov.iov_len = size - received;
+
+      alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_fds_per_message)];
+      struct msghdr msg = {};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+
+      ssize_t n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        throw system_error("could not receive");
+      }
+      if (n == 0) {
+        if (received == 0) return false;
+        throw std::runtime_error("render service: connection closed");
+      }
+
+      for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+          size_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+          for (size_t i = 0; i < num_fds; i++) {
+            int fd;
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            // don't leak descriptors which were not expected
+            if (fds && fds->size() < max_fds)
+              fds->push_back(fd);
+            else
+              close(fd);
+          }
+        }
+
+      received += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+}  // namespace render_service
+}  // namespace bear
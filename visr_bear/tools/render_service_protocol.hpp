@@ -0,0 +1,252 @@
+#pragma once
+#include <atomic>
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bear/api.hpp"
+#include "config_impl.hpp"
+
+namespace bear {
+
+/// Definitions shared by RenderService and RenderClient.
+///
+/// A client connects to the service over a Unix domain socket and sends a
+/// Handshake. The service creates a session, and replies with a
+/// HandshakeReply along with two file descriptors: the shared memory for the
+/// session, and the doorbell of the worker thread which processes it. The
+/// socket then stays open without further traffic; closing it ends the
+/// session.
+///
+/// The session memory contains a SessionHeader, a ring of messages, and
+/// num_slots audio slots, each holding the input and output for one period.
+/// To process period n, the client fills slot n % num_slots, increments
+/// submitted and rings the doorbell; the worker renders the slot in place
+/// and increments completed.
+///
+/// Other calls are sent as messages through the ring, each tagged with the
+/// number of periods submitted before it was sent. The worker applies
+/// messages before processing the period they are tagged with, so its
+/// DynamicRenderer sees the same sequence of calls that the client made.
+namespace render_service {
+
+  constexpr uint32_t protocol_magic = 0x52414542;  // "BEAR"
+  constexpr uint32_t protocol_version = 1;
+
+  /// length of error messages in shared structures, including the terminator
+  constexpr size_t error_length = 256;
+
+  struct Handshake {
+    uint32_t magic = protocol_magic;
+    uint32_t version = protocol_version;
+    uint32_t period_size = 0;
+    uint32_t max_objects_channels = 0;
+    uint32_t max_direct_speakers_channels = 0;
+    uint32_t max_hoa_channels = 0;
+    uint32_t num_slots = 0;
+    /// size in bytes of the message ring; must be a power of two
+    uint32_t message_ring_size = 0;
+  };
+
+  struct HandshakeReply {
+    uint32_t magic = protocol_magic;
+    uint32_t version = protocol_version;
+    uint32_t ok = 0;
+    char error[error_length] = {};
+  };
+
+  /// check the values in a handshake; throws std::invalid_argument
+  void check_handshake(const Handshake &handshake);
+
+  /// 32 bit counter which can be waited on with futex_wait, on its own cache
+  /// line to avoid false sharing between the client and worker
+  struct alignas(64) Counter {
+    std::atomic<uint32_t> value{0};
+  };
+
+  /// has counter reached target, allowing for wrapping
+  inline bool reached(uint32_t counter, uint32_t target)
+  {
+    return static_cast<int32_t>(counter - target) >= 0;
+  }
+
+  /// wait while word contains expected, or until timeout; this may also
+  /// return early
+  void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::nanoseconds timeout);
+  /// wake all threads waiting on word, in any process
+  void futex_wake(std::atomic<uint32_t> &word);
+
+  /// error message written by one side and read by the other; the text is
+  /// written before count is incremented
+  struct SharedError {
+    std::atomic<uint32_t> count{0};
+    char text[error_length] = {};
+
+    void set(const std::string &message);
+    std::string get() const;
+  };
+
+  /// start of the session shared memory
+  struct SessionHeader {
+    uint32_t magic = protocol_magic;
+    uint32_t version = protocol_version;
+    Handshake sizes;
+
+    /// number of periods submitted by the client
+    Counter submitted;
+    /// number of periods processed by the worker
+    Counter completed;
+
+    /// number of blocking requests (CONFIG_BLOCKING messages) answered by
+    /// the worker
+    Counter replies;
+
+    /// total bytes written to and read from the message ring
+    alignas(64) std::atomic<uint64_t> message_write{0};
+    alignas(64) std::atomic<uint64_t> message_read{0};
+
+    alignas(64) std::atomic<uint32_t> running{0};
+    /// errors from reconfiguration, returned by DynamicRenderer::get_error
+    SharedError config_error;
+    /// errors from blocking requests; count is not incremented if a request
+    /// was successful
+    SharedError request_error;
+    /// set if the session has failed; the client throws this from process
+    SharedError failure;
+  };
+
+  /// shared memory for a worker doorbell, incremented and woken by clients
+  /// when they submit work
+  struct Doorbell {
+    Counter rings;
+  };
+
+  enum class MessageType : uint32_t {
+    OBJECTS_BLOCK,
+    DIRECT_SPEAKERS_BLOCK,
+    HOA_BLOCK,
+    LISTENER,
+    BLOCK_START_TIME,
+    CONFIG,
+    CONFIG_BLOCKING,
+  };
+
+  struct Message {
+    MessageType type;
+    /// the message is applied before processing this period
+    uint32_t period;
+    std::vector<char> payload;
+  };
+
+  /// a shared memory mapping of a file descriptor, which is closed on
+  /// destruction
+  class SharedMapping {
+   public:
+    SharedMapping() = default;
+    SharedMapping(int fd, size_t size);
+    SharedMapping(SharedMapping &&other);
+    SharedMapping &operator=(SharedMapping &&other);
+    SharedMapping(const SharedMapping &) = delete;
+    SharedMapping &operator=(const SharedMapping &) = delete;
+    ~SharedMapping();
+
+    /// create a new anonymous shared memory file of size bytes, filled with
+    /// zeros, and map it
+    static SharedMapping create(const std::string &name, size_t size);
+
+    int get_fd() const { return fd; }
+    size_t get_size() const { return size; }
+    char *get_data() const { return data; }
+
+   private:
+    int fd = -1;
+    size_t size = 0;
+    char *data = nullptr;
+  };
+
+  /// the layout of the session shared memory, for accessing the header,
+  /// message ring and slots
+  class SessionMemory {
+   public:
+    SessionMemory() = default;
+    /// map an existing session, checking that its size and header match
+    /// handshake
+    SessionMemory(int fd, const Handshake &handshake);
+    /// create a new session, initialising the header
+    explicit SessionMemory(const Handshake &handshake);
+
+    /// bytes needed for a session
+    static size_t size(const Handshake &handshake);
+
+    SessionHeader &header() const { return *reinterpret_cast<SessionHeader *>(mapping.get_data()); }
+    int get_fd() const { return mapping.get_fd(); }
+
+    size_t period_size() const { return header().sizes.period_size; }
+    size_t num_slots() const { return header().sizes.num_slots; }
+    size_t max_channels(size_t type) const;
+
+    /// number of channels of each type (objects, direct speakers, HOA) in a
+    /// slot, written by the client
+    uint32_t *num_channels(size_t slot) const;
+    Sample *input(size_t slot, size_t type, size_t channel) const;
+    Sample *output(size_t slot, size_t ear) const;
+
+    /// add a message to the ring; returns false if there is not enough space
+    bool push_message(MessageType type, uint32_t period, const std::vector<char> &payload);
+    /// get the period of the next message, or none if the ring is empty
+    boost::optional<uint32_t> next_message_period() const;
+    /// remove the next message from the ring, which must not be empty;
+    /// message.payload is reused to avoid allocation
+    void pop_message(Message &message);
+
+   private:
+    void init_layout();
+    void read_ring(uint64_t pos, char *out, size_t n) const;
+    void write_ring(uint64_t pos, const char *in, size_t n);
+
+    SharedMapping mapping;
+    size_t ring_offset = 0;
+    size_t slots_offset = 0;
+    size_t slot_size = 0;
+    size_t channel_stride = 0;
+  };
+
+  /// serialisation of message payloads; the decode functions throw
+  /// std::runtime_error if the payload is malformed
+  ///
+  /// Only the metadata parameters supported by the renderer (those in the
+  /// python bindings) are sent; distance_behaviour can not be sent to another
+  /// process, so encode_block throws std::invalid_argument if it is set.
+  std::vector<char> encode_block(size_t index, const ObjectsInput &metadata);
+  std::vector<char> encode_block(size_t index, const DirectSpeakersInput &metadata);
+  std::vector<char> encode_block(size_t index, const HOAInput &metadata);
+  void decode_block(const std::vector<char> &payload, size_t &index, ObjectsInput &metadata);
+  void decode_block(const std::vector<char> &payload, size_t &index, DirectSpeakersInput &metadata);
+  void decode_block(const std::vector<char> &payload, size_t &index, HOAInput &metadata);
+
+  std::vector<char> encode_listener(const Listener &listener,
+                                    const boost::optional<Time> &interpolation_time);
+  void decode_listener(const std::vector<char> &payload,
+                       Listener &listener,
+                       boost::optional<Time> &interpolation_time);
+
+  std::vector<char> encode_time(const Time &time);
+  void decode_time(const std::vector<char> &payload, Time &time);
+
+  /// all ConfigImpl fields except panner_cache
+  std::vector<char> encode_config(const ConfigImpl &config);
+  void decode_config(const std::vector<char> &payload, ConfigImpl &config);
+
+  /// send a whole buffer over a socket, with optional file descriptors;
+  /// throws std::runtime_error on failure
+  void send_all(int socket, const void *data, size_t size, const std::vector<int> &fds = {});
+  /// receive a whole buffer from a socket, storing up to max_fds received
+  /// file descriptors in fds; returns false if the socket was closed before
+  /// any data was received, and throws std::runtime_error for other errors
+  bool receive_all(int socket, void *data, size_t size, std::vector<int> *fds = nullptr, size_t max_fds = 0);
+
+}  // namespace render_service
+}  // namespace bear